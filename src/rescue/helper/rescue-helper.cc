@@ -32,6 +32,7 @@
 #include "ns3/rescue-channel.h"
 #include "ns3/rescue-remote-station-manager.h"
 #include "ns3/rescue-arq-manager.h"
+#include "ns3/rescue-qos-scheduler.h"
 #include "rescue-helper.h"
 
 #include <sstream>
@@ -47,7 +48,8 @@ namespace ns3 {
     RescuePhyHelper::~RescuePhyHelper() {
     }
 
-    RescueHelper::RescueHelper() {
+    RescueHelper::RescueHelper()
+    : m_useQosScheduler(false) {
         //m_mac.SetTypeId ("ns3::RescueMacCsma");
         m_mac.SetTypeId("ns3::AdhocRescueMac");
         m_phy.SetTypeId("ns3::RescuePhy");
@@ -116,6 +118,21 @@ namespace ns3 {
         m_arqManager.Set(n9, v9);
     }
 
+    void
+    RescueHelper::SetQosScheduler(std::string type,
+            std::string n0, const AttributeValue &v0,
+            std::string n1, const AttributeValue &v1,
+            std::string n2, const AttributeValue &v2,
+            std::string n3, const AttributeValue &v3) {
+        m_qosScheduler = ObjectFactory();
+        m_qosScheduler.SetTypeId(type);
+        m_qosScheduler.Set(n0, v0);
+        m_qosScheduler.Set(n1, v1);
+        m_qosScheduler.Set(n2, v2);
+        m_qosScheduler.Set(n3, v3);
+        m_useQosScheduler = true;
+    }
+
     NetDeviceContainer
     RescueHelper::Install(NodeContainer c, Ptr<RescueChannel> channel, const RescuePhyHelper &phyHelper, const RescueMacHelper &macHelper) const {
         NS_LOG_FUNCTION("");
@@ -134,6 +151,8 @@ namespace ns3 {
             device->SetChannel(channel);
             device->SetRemoteStationManager(manager);
             device->SetArqManager(arq);
+            if (m_useQosScheduler)
+                device->SetQosScheduler(m_qosScheduler.Create<RescueQosScheduler> ());
 
             node->AddDevice(device);
             devices.Add(device);
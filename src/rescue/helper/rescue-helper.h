@@ -99,7 +99,9 @@ namespace ns3 {
                 std::string n7 = "", const AttributeValue &v7 = EmptyAttributeValue());
 
         /**
-         * \param type the type of ns3::RescueArqManager to create.
+         * \param type the type of ns3::RescueArqManager to create: ns3::RescueArqManager (full ARQ),
+         *        ns3::RescueArqManagerSimple (stop-and-wait) or ns3::RescueArqManagerNone (no ACKs,
+         *        no per-frame state).
          * \param n0 the name of the attribute to set
          * \param v0 the value of the attribute to set
          * \param n1 the name of the attribute to set
@@ -136,6 +138,27 @@ namespace ns3 {
                 std::string n8 = "", const AttributeValue &v8 = EmptyAttributeValue(),
                 std::string n9 = "", const AttributeValue &v9 = EmptyAttributeValue());
 
+        /**
+         * \param type the type of ns3::RescueQosScheduler to create.
+         * \param n0 the name of the attribute to set
+         * \param v0 the value of the attribute to set
+         * \param n1 the name of the attribute to set
+         * \param v1 the value of the attribute to set
+         * \param n2 the name of the attribute to set
+         * \param v2 the value of the attribute to set
+         * \param n3 the name of the attribute to set
+         * \param v3 the value of the attribute to set
+         *
+         * All the attributes specified in this method should exist
+         * in the requested scheduler. If this method is not invoked,
+         * devices are installed without QoS scheduling.
+         */
+        void SetQosScheduler(std::string type,
+                std::string n0 = "", const AttributeValue &v0 = EmptyAttributeValue(),
+                std::string n1 = "", const AttributeValue &v1 = EmptyAttributeValue(),
+                std::string n2 = "", const AttributeValue &v2 = EmptyAttributeValue(),
+                std::string n3 = "", const AttributeValue &v3 = EmptyAttributeValue());
+
         /**
          * \param c the set of nodes on which a rescue device must be created
          * \param channel the channel for transmission of the rescue devices
@@ -164,6 +187,8 @@ namespace ns3 {
     protected:
         ObjectFactory m_stationManager;
         ObjectFactory m_arqManager;
+        ObjectFactory m_qosScheduler;
+        bool m_useQosScheduler;
 
     private:
         ObjectFactory m_mac;
@@ -107,6 +107,11 @@ namespace ns3 {
         m_csmaMac->EnqueueRetry(pkt, dst);
     }
 
+    void
+    AdhocRescueMac::EnqueueRelay(Ptr<Packet> pkt, RescuePhyHeader phyHdr) {
+        m_csmaMac->EnqueueRelay(pkt, phyHdr);
+    }
+
     void
     AdhocRescueMac::EnqueueAck(Ptr<Packet> pkt, RescuePhyHeader ackHdr) {
         m_csmaMac->EnqueueAck(pkt, ackHdr);
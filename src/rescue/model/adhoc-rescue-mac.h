@@ -77,6 +77,14 @@ namespace ns3 {
          */
         virtual void EnqueueRetry(Ptr<Packet> pkt, Mac48Address dest);
 
+        /**
+         * \param pkt the packet to send.
+         * \param phyHdr the header to send.
+         *
+         * Should be used to enqueue locally retransmitted relayed packets by ARQ manager
+         */
+        virtual void EnqueueRelay(Ptr<Packet> pkt, RescuePhyHeader phyHdr);
+
         /**
          * \param pkt the packet to send.
          * \param phyHdr the header to send.
@@ -27,6 +27,7 @@
 #include "ns3/log.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/node.h"
+#include "ns3/pointer.h"
 
 #include "ap-rescue-mac.h"
 #include "rescue-mac-csma.h"
@@ -34,6 +35,9 @@
 #include "rescue-phy.h"
 #include "rescue-remote-station-manager.h"
 #include "rescue-arq-manager.h"
+#include "rescue-tdma-scheduler.h"
+
+#include <cmath>
 
 NS_LOG_COMPONENT_DEFINE("ApRescueMac");
 
@@ -45,7 +49,13 @@ namespace ns3 {
     NS_OBJECT_ENSURE_REGISTERED(ApRescueMac);
 
     ApRescueMac::ApRescueMac()
-    : RescueMac() {
+    : RescueMac(),
+    m_compressedSchedule(false),
+    m_scheduleRefreshInterval(10),
+    m_stationIdAnnouncements(3),
+    m_nextStationId(AP_STATION_ID + 1),
+    m_scheduleSequence(0),
+    m_beaconsSinceRefresh(0) {
         NS_LOG_INFO("");
         SetTypeOfStation(AP);
         m_tdmaMac = CreateObject<RescueMacTdma> ();
@@ -58,6 +68,8 @@ namespace ns3 {
     void
     ApRescueMac::DoInitialize() {
         NS_LOG_FUNCTION("");
+        if (m_tdmaScheduler == 0)
+            m_tdmaScheduler = CreateObject<RescueTdmaScheduler> ();
         m_phy->NotifyCFP();
         m_csmaMac->StopOperation();
         m_tdmaMac->StartOperation();
@@ -74,6 +86,7 @@ namespace ns3 {
         m_tdmaMac = 0;
         m_remoteStationManager = 0;
         m_arqManager = 0;
+        m_tdmaScheduler = 0;
     }
 
     void
@@ -88,6 +101,10 @@ namespace ns3 {
                 it->second.Cancel();
 
         m_schedules.clear();
+        m_lastRuns.clear();
+        m_beaconsSinceRefresh = 0;
+        if (m_tdmaScheduler != 0)
+            m_tdmaScheduler->Clear();
     }
 
     TypeId
@@ -126,12 +143,44 @@ namespace ns3 {
                 TimeValue(MilliSeconds(10)),
                 MakeTimeAccessor(&ApRescueMac::m_tdmaTimeSlot),
                 MakeTimeChecker())
+                .AddAttribute("TdmaScheduler",
+                "The scheduler distributing TDMA time slots between stations",
+                PointerValue(),
+                MakePointerAccessor(&ApRescueMac::SetTdmaScheduler,
+                &ApRescueMac::GetTdmaScheduler),
+                MakePointerChecker<RescueTdmaScheduler> ())
+                .AddAttribute("CompressedSchedule",
+                "If true, beacons carry compressed schedule (short station IDs, run-length encoded slots, delta against the previous beacon)",
+                BooleanValue(false),
+                MakeBooleanAccessor(&ApRescueMac::m_compressedSchedule),
+                MakeBooleanChecker())
+                .AddAttribute("ScheduleRefreshInterval",
+                "The number of beacons after which compressed schedule is sent in full (without delta encoding)",
+                UintegerValue(10),
+                MakeUintegerAccessor(&ApRescueMac::m_scheduleRefreshInterval),
+                MakeUintegerChecker<uint32_t> (1))
+                .AddAttribute("StationIdAnnouncements",
+                "The number of beacons announcing a newly assigned short station ID",
+                UintegerValue(3),
+                MakeUintegerAccessor(&ApRescueMac::m_stationIdAnnouncements),
+                MakeUintegerChecker<uint32_t> (1))
                 ;
         return tid;
     }
 
     // ------------------------ Set Functions -----------------------------
 
+    void
+    ApRescueMac::SetTdmaScheduler(Ptr<RescueTdmaScheduler> scheduler) {
+        NS_LOG_FUNCTION(scheduler);
+        m_tdmaScheduler = scheduler;
+    }
+
+    Ptr<RescueTdmaScheduler>
+    ApRescueMac::GetTdmaScheduler(void) const {
+        return m_tdmaScheduler;
+    }
+
 
 
     // ------------------------ Get Functions -----------------------------
@@ -164,6 +213,12 @@ namespace ns3 {
         m_tdmaMac->EnqueueRetry(pkt, dst);
     }
 
+    void
+    ApRescueMac::EnqueueRelay(Ptr<Packet> pkt, RescuePhyHeader phyHdr) {
+        NS_LOG_FUNCTION("");
+        m_tdmaMac->EnqueueRelay(pkt, phyHdr);
+    }
+
     void
     ApRescueMac::EnqueueAck(Ptr<Packet> pkt, RescuePhyHeader ackHdr) {
         NS_LOG_FUNCTION("");
@@ -195,28 +250,27 @@ namespace ns3 {
         phyHdr.SetChannel(m_channel);
         phyHdr.SetTxPower(m_txPower);
 
-        m_schedulesNumber = uint8_t(std::min((int) m_schedules.size(), int(m_cfpDuration.GetMicroSeconds() / m_tdmaTimeSlot.GetMicroSeconds())));
-        phyHdr.SetSchedulesListSize(m_schedulesNumber);
+        //slots shared by non-conflicting stations take the AP neighbourhood into account
+        m_tdmaScheduler->SetNeighbours(m_address, GetNeighbours());
+        uint32_t nSlots = std::min(uint32_t(m_cfpDuration.GetMicroSeconds() / m_tdmaTimeSlot.GetMicroSeconds()), uint32_t(MAX_SCHEDULES_LIST_SIZE));
+        m_schedules = m_tdmaScheduler->Schedule(nSlots, m_tdmaTimeSlot, MAX_SCHEDULES_LIST_SIZE);
+        m_schedulesNumber = uint8_t(m_schedules.size());
+        uint32_t usedSlots = m_schedules.empty() ? 0 : m_schedules.back().slot + 1;
 
         phyHdr.SetTimestamp(ns3::Simulator::Now().GetMicroSeconds());
         phyHdr.SetSource(m_address);
         phyHdr.SetBeaconInterval(m_beaconInterval.GetMicroSeconds());
         //phyHdr.SetCfpPeriod (m_cfpDuration.GetMicroSeconds ());
-        phyHdr.SetCfpPeriod(m_schedulesNumber * m_tdmaTimeSlot.GetMicroSeconds());
+        phyHdr.SetCfpPeriod(usedSlots * m_tdmaTimeSlot.GetMicroSeconds());
         phyHdr.SetTdmaTimeSlot(m_tdmaTimeSlot.GetMicroSeconds());
 
-        std::list<Mac48Address>::iterator it = m_schedules.begin();
-        if (it != m_schedules.end())
-            for (uint8_t i = 0; i < m_schedulesNumber; i++) {
-                phyHdr.SetScheduleEntry(i, *it);
-                it = m_schedules.erase(it);
-
-                std::map<Mac48Address, Time>::iterator it2 = m_reservedTime.find(*it);
-                if (it2->second > m_tdmaTimeSlot)
-                    it2->second = it2->second - m_tdmaTimeSlot;
-                else
-                    it2->second = Seconds(0);
-            }
+        if (!m_compressedSchedule || !EncodeCompressedSchedule(phyHdr)) {
+            phyHdr.SetSchedulesListSize(m_schedulesNumber);
+            for (uint8_t i = 0; i < m_schedulesNumber; i++)
+                phyHdr.SetScheduleEntry(i, m_schedules[i].address, m_schedules[i].slot);
+            m_lastRuns.clear();
+            m_beaconsSinceRefresh = 0;
+        }
 
         NS_LOG_INFO("GENERATE BEACON");
 
@@ -227,6 +281,7 @@ namespace ns3 {
                 "cfpDuration: " << phyHdr.GetCfpPeriod() <<
                 "tdmaTimeSlot: " << phyHdr.GetTdmaTimeSlot() <<
                 "schedules: " << (int) m_schedulesNumber <<
+                "slots: " << usedSlots <<
                 "beacon TX duration: " << beaconTxDuration);
 
         //start timers
@@ -235,26 +290,114 @@ namespace ns3 {
         m_beaconTimer.Schedule();
 
         //m_cfpTimer.SetDelay (beaconTxDuration + m_cfpDuration);
-        m_cfpTimer.SetDelay(beaconTxDuration + m_tdmaMac->GetSifsTime() + MicroSeconds(m_schedulesNumber * m_tdmaTimeSlot.GetMicroSeconds()));
+        m_cfpTimer.SetDelay(beaconTxDuration + m_tdmaMac->GetSifsTime() + MicroSeconds(usedSlots * m_tdmaTimeSlot.GetMicroSeconds()));
         m_cfpTimer.SetFunction(&ApRescueMac::CfpEnd, this);
         m_cfpTimer.Schedule();
 
         for (uint8_t i = 0; i < m_schedulesNumber; i++)
-            if (phyHdr.GetScheduleEntry(i) == m_address) {
-                NS_LOG_INFO("TDMA TIME SLOT (no. " << (int) i << ") OBTAINED!");
+            if (m_schedules[i].address == m_address) {
+                uint8_t slot = m_schedules[i].slot;
+                NS_LOG_INFO("TDMA TIME SLOT (no. " << (int) slot << ") OBTAINED!");
                 //TDMA time slot was assigned, start awaiting counter
-                std::pair<uint8_t, Timer> newTimer(i, Timer(Timer::CANCEL_ON_DESTROY));
+                std::pair<uint8_t, Timer> newTimer(slot, Timer(Timer::CANCEL_ON_DESTROY));
                 std::pair < std::map<uint8_t, Timer>::iterator, bool> newIns = m_slotAwaitingTimers.insert(newTimer);
 
                 if (newIns.first->second.IsRunning())
                     newIns.first->second.Cancel();
 
-                newIns.first->second.SetDelay(beaconTxDuration + m_tdmaMac->GetSifsTime() + i * m_tdmaTimeSlot);
+                newIns.first->second.SetDelay(beaconTxDuration + m_tdmaMac->GetSifsTime() + slot * m_tdmaTimeSlot);
                 newIns.first->second.SetFunction(&ApRescueMac::StartTDMAtimeSlot, this);
                 newIns.first->second.Schedule();
             }
     }
 
+    bool
+    ApRescueMac::EncodeCompressedSchedule(RescuePhyHeader &phyHdr) {
+        NS_LOG_FUNCTION("");
+
+        //runs of consecutive slots of each station (the schedule is ordered by slots)
+        std::vector<RescueScheduleRun> runs;
+        std::map<Mac48Address, uint32_t> lastRun;
+        for (std::vector<RescueTdmaScheduler::Assignment>::iterator it = m_schedules.begin(); it != m_schedules.end(); it++) {
+            uint8_t id = GetStationId(it->address);
+            if (id == NO_STATION_ID)
+                return false; //short IDs exhausted - send plain schedule
+            std::map<Mac48Address, uint32_t>::iterator it2 = lastRun.find(it->address);
+            if (it2 != lastRun.end() && runs[it2->second].start + runs[it2->second].length == it->slot)
+                runs[it2->second].length++;
+            else {
+                RescueScheduleRun run;
+                run.id = id;
+                run.start = it->slot;
+                run.length = 1;
+                lastRun[it->address] = runs.size();
+                runs.push_back(run);
+            }
+        }
+        if (runs.size() > MAX_SCHEDULE_RUNS)
+            return false;
+
+        //without concurrent slots each run starts at the end of the previous one
+        bool withStart = false;
+        for (uint32_t i = 1; i < runs.size(); i++)
+            if (runs[i].start != runs[i - 1].start + runs[i - 1].length)
+                withStart = true;
+
+        //delta encoding - repeat the common beginning of the previous schedule (full schedule sent periodically)
+        bool refresh = (m_lastRuns.empty() || ++m_beaconsSinceRefresh >= m_scheduleRefreshInterval);
+        uint8_t kept = 0;
+        if (refresh)
+            m_beaconsSinceRefresh = 0;
+        else
+            while (kept < runs.size() && kept < m_lastRuns.size()
+                    && runs[kept].id == m_lastRuns[kept].id
+                    && runs[kept].start == m_lastRuns[kept].start
+                    && runs[kept].length == m_lastRuns[kept].length)
+                kept++;
+
+        m_scheduleSequence++;
+        phyHdr.SetCompressedSchedule(m_scheduleSequence, kept, withStart);
+        phyHdr.SetScheduleRunsListSize(runs.size() - kept);
+        for (uint32_t i = kept; i < runs.size(); i++)
+            phyHdr.SetScheduleRun(i - kept, runs[i]);
+
+        //announce short IDs of newly scheduled stations (and of all scheduled stations in full schedule)
+        uint8_t announced = 0;
+        for (std::map<Mac48Address, uint32_t>::iterator it = lastRun.begin(); it != lastRun.end() && announced < MAX_STATION_IDS_LIST_SIZE; it++) {
+            if (it->first == m_address)
+                continue;
+            std::map<Mac48Address, uint32_t>::iterator it2 = m_pendingIdAnnouncements.find(it->first);
+            bool pending = (it2 != m_pendingIdAnnouncements.end() && it2->second > 0);
+            if (!refresh && !pending)
+                continue;
+            phyHdr.SetStationIdEntry(announced++, runs[it->second].id, it->first);
+            if (pending)
+                it2->second--;
+        }
+        phyHdr.SetStationIdsListSize(announced);
+
+        NS_LOG_DEBUG("compressed schedule: sequence: " << (int) m_scheduleSequence << ", runs: " << runs.size()
+                << ", kept runs: " << (int) kept << ", announced IDs: " << (int) announced);
+
+        m_lastRuns = runs;
+        return true;
+    }
+
+    uint8_t
+    ApRescueMac::GetStationId(Mac48Address address) {
+        if (address == m_address)
+            return AP_STATION_ID;
+        std::map<Mac48Address, uint8_t>::iterator it = m_stationIds.find(address);
+        if (it != m_stationIds.end())
+            return it->second;
+        if (m_nextStationId == NO_STATION_ID)
+            return NO_STATION_ID;
+        NS_LOG_INFO("NEW SHORT ID: " << (int) m_nextStationId << " FOR: " << address);
+        m_stationIds[address] = m_nextStationId;
+        m_pendingIdAnnouncements[address] = m_stationIdAnnouncements;
+        return m_nextStationId++;
+    }
+
     /*void
     ApRescueMac::GenerateAggregateResourceReservation ()
     {
@@ -286,31 +429,18 @@ namespace ns3 {
 
         NS_LOG_DEBUG("data mode: " << nextMode << " tx time: " << m_tdmaMac->GetDataDuration(pktData, nextMode));
 
-        bool newSlot = MakeResourceReservation(m_tdmaMac->GetDataDuration(pktData, nextMode), m_address);
+        MakeResourceReservation(m_tdmaMac->GetDataDuration(pktData, nextMode), m_address);
 
-        //reserve slot for ACKs
+        //reserve slot for ACKs (the scheduler places it after DATA, as it was reserved later)
         RescueMode ackMode = m_remoteStationManager->GetAckTxMode(dataHdr.GetDestination());
-        bool newAckSlot = MakeResourceReservation(m_tdmaMac->GetCtrlDuration(RESCUE_PHY_PKT_TYPE_E2E_ACK, ackMode), dataHdr.GetDestination());
-
-        //if new data slot was reserved but acks dont need new slot, change order of slots to send ACK after DATA
-        NS_LOG_DEBUG("newSlot: " << (newSlot ? "YES" : "NO") << ", newACKslot: " << (newAckSlot ? "YES" : "NO"));
-        if (newSlot && !newAckSlot) {
-            for (std::list<Mac48Address>::iterator it = m_schedules.end(); it != m_schedules.begin(); it--) {
-                NS_LOG_DEBUG("current dst: " << *it);
-                if (*it == dataHdr.GetDestination()) {
-                    NS_LOG_INFO("MOVE TDMA SLOT for: " << dataHdr.GetDestination() << " to the end");
-                    m_schedules.splice(m_schedules.end(), m_schedules, it);
-                    break;
-                }
-            }
-        }
+        MakeResourceReservation(m_tdmaMac->GetCtrlDuration(RESCUE_PHY_PKT_TYPE_E2E_ACK, ackMode), dataHdr.GetDestination());
     }
 
     void
     ApRescueMac::GenerateTdmaTimeSlotReservation() {
         NS_LOG_FUNCTION("");
-        //this stations shouldn't send Resource Reservation frame, just put reservation to internal list
-        m_schedules.push_back(m_address);
+        //this stations shouldn't send Resource Reservation frame, just report the whole queue to the scheduler
+        MakeResourceReservation(m_tdmaMac->GetTotalTxSifsDuration(), m_address);
     }
 
     void
@@ -331,14 +461,14 @@ namespace ns3 {
 
         m_phy->NotifyCFP();
         m_tdmaMac->StartOperation();
-        if (m_tdmaMac->GetNextTxSifsDuration() < m_tdmaTimeSlot)
+        if (FitsInTdmaSlot(m_tdmaTimeSlot))
             m_tdmaMac->ChannelAccessGranted();
     }
 
     void
     ApRescueMac::NotifySendPacketDone() {
         NS_LOG_FUNCTION("");
-        if (m_tdmaMac->GetNextTxSifsDuration() < m_currentSlotTimer.GetDelayLeft())
+        if (FitsInTdmaSlot(m_currentSlotTimer.GetDelayLeft()))
             m_tdmaMac->ChannelAccessGranted();
     }
 
@@ -363,63 +493,56 @@ namespace ns3 {
         NS_LOG_FUNCTION("");
         NS_LOG_INFO("RECEIVE RESOURCE RESERVATION FRAME from: " << phyHdr.GetSource() << ", reserved time: " << phyHdr.GetNextDuration());
 
-        bool newSlot = MakeResourceReservation(MicroSeconds(phyHdr.GetNextDuration()), phyHdr.GetSource());
-
-        //reserve slot for ACKs
-        RescueMode ackMode = m_remoteStationManager->GetAckTxMode(phyHdr.GetDestination());
-        bool newAckSlot = MakeResourceReservation(m_tdmaMac->GetCtrlDuration(RESCUE_PHY_PKT_TYPE_E2E_ACK, ackMode), phyHdr.GetDestination());
-
-        //if new data slot was reserved but acks dont need new slot, change order of slots to send ACK after DATA
-        NS_LOG_DEBUG("newSlot: " << (newSlot ? "YES" : "NO") << ", newACKslot: " << (newAckSlot ? "YES" : "NO"));
-        if (newSlot && !newAckSlot
-                && (m_schedules.size() * m_tdmaTimeSlot <= m_cfpDuration)) {
-            for (std::list<Mac48Address>::iterator it = m_schedules.end(); it != m_schedules.begin(); it--) {
-                NS_LOG_DEBUG("current dst: " << *it);
-                if (*it == phyHdr.GetDestination()) {
-                    NS_LOG_INFO("MOVE TDMA SLOT for: " << phyHdr.GetDestination() << " to the end");
-                    m_schedules.splice(m_schedules.end(), m_schedules, it);
-                    break;
-                }
+        if (phyHdr.HasReservationsList()) {
+            //cumulative reservation - TX time (including SIFS) per destination, ACK slots of each destination follow DATA
+            for (uint8_t i = 0; i < phyHdr.GetReservationsListSize(); i++) {
+                Mac48Address dst = phyHdr.GetReservationDestination(i);
+                AddReservedTime(MicroSeconds(phyHdr.GetReservationDuration(i)), phyHdr.GetSource());
+                RescueMode ackMode = m_remoteStationManager->GetAckTxMode(dst);
+                Time ackDuration = m_tdmaMac->GetCtrlDuration(RESCUE_PHY_PKT_TYPE_E2E_ACK, ackMode) + m_tdmaMac->GetSifsTime();
+                AddReservedTime(phyHdr.GetReservationFrames(i) * ackDuration, dst);
             }
-        }
-    }
-
-    bool
-    ApRescueMac::MakeResourceReservation(Time duration, Mac48Address address) {
-        NS_LOG_FUNCTION("");
-
-        bool retval = false;
-        uint32_t scheduledTdmaSlots = 0;
-        //uint32_t newTdmaSlotsNeeded = 0;
-
-        duration += m_tdmaMac->GetSifsTime();
+        } else {
+            MakeResourceReservation(MicroSeconds(phyHdr.GetNextDuration()), phyHdr.GetSource());
 
-        std::map<Mac48Address, Time>::iterator it = m_reservedTime.find(address);
-        if (it != m_reservedTime.end()) {
-            //it->second = it->second + duration;
+            //reserve slot for ACKs (the scheduler places it after DATA, as it was reserved later)
+            RescueMode ackMode = m_remoteStationManager->GetAckTxMode(phyHdr.GetDestination());
+            MakeResourceReservation(m_tdmaMac->GetCtrlDuration(RESCUE_PHY_PKT_TYPE_E2E_ACK, ackMode), phyHdr.GetDestination());
+        }
 
-            for (std::list<Mac48Address>::iterator it2 = m_schedules.begin(); it2 != m_schedules.end(); it2++)
-                if (*it2 == address)
-                    scheduledTdmaSlots++;
-        } else {
-            //new destination
-            std::pair<Mac48Address, Time> newAdd(address, Seconds(0));
-            std::pair < std::map<Mac48Address, Time>::iterator, bool> newIns = m_reservedTime.insert(newAdd);
-            it = newIns.first;
+        if (phyHdr.HasNeighboursList()) {
+            //AP itself is not protected as a receiver of CFP transmissions, its own conflicts follow from its neighbourhood
+            std::vector<Mac48Address> neighbours;
+            for (uint8_t i = 0; i < phyHdr.GetNeighboursListSize(); i++)
+                if (phyHdr.GetNeighbourEntry(i) != m_address)
+                    neighbours.push_back(phyHdr.GetNeighbourEntry(i));
+            m_tdmaScheduler->SetNeighbours(phyHdr.GetSource(), neighbours);
         }
+    }
 
-        NS_LOG_FUNCTION(scheduledTdmaSlots << " scheduled tdma slots for: " << address << ", duration of scheduled TX: " << duration << ", expected previous TX time: " << it->second);
+    void
+    ApRescueMac::MakeResourceReservation(Time duration, Mac48Address address) {
+        NS_LOG_FUNCTION(address << duration);
+        AddReservedTime(duration + m_tdmaMac->GetSifsTime(), address);
+    }
 
-        while (scheduledTdmaSlots * m_tdmaTimeSlot < duration + it->second) {
-            NS_LOG_INFO("NEW TDMA SLOT FOR: " << address);
-            m_schedules.push_back(address);
-            scheduledTdmaSlots++;
-            retval = true;
-        }
+    void
+    ApRescueMac::AddReservedTime(Time duration, Mac48Address address) {
+        m_tdmaScheduler->AddDemand(address, duration);
+        m_tdmaScheduler->SetLinkRate(address, GetLinkRate(address));
 
-        it->second = it->second + duration;
+        NS_LOG_FUNCTION("reserved TX time for: " << address << ": " << m_tdmaScheduler->GetDemand(address));
+    }
 
-        return retval;
+    double
+    ApRescueMac::GetLinkRate(Mac48Address address) {
+        if (address == m_address)
+            return 1;
+        RescueRemoteStationInfo info = m_remoteStationManager->GetInfo(address);
+        if (!info.HasRxSnr())
+            return 1;
+        //Shannon spectral efficiency of the link (SNR in dB)
+        return std::log(1 + std::pow(10.0, info.GetRxSnr() / 10)) / std::log(2.0);
     }
 
     void
@@ -31,8 +31,10 @@
 
 #include "rescue-mac.h"
 #include "rescue-mac-header.h"
+#include "rescue-tdma-scheduler.h"
 
 #include <list>
+#include <vector>
 
 namespace ns3 {
 
@@ -79,6 +81,14 @@ namespace ns3 {
          */
         virtual void EnqueueRetry(Ptr<Packet> pkt, Mac48Address dest);
 
+        /**
+         * \param pkt the packet to send.
+         * \param phyHdr the header to send.
+         *
+         * Should be used to enqueue locally retransmitted relayed packets by ARQ manager
+         */
+        virtual void EnqueueRelay(Ptr<Packet> pkt, RescuePhyHeader phyHdr);
+
         //virtual void NotifyEnqueueRelay (Ptr<Packet> pkt, Mac48Address dest);
 
         virtual void NotifyEnqueuedPacket(Ptr<Packet> pkt, Mac48Address dest);
@@ -120,12 +130,47 @@ namespace ns3 {
 
         virtual void NotifySendPacketDone(void);
 
+        /**
+         * \param scheduler RescueTdmaScheduler used to build the schedule of CFP (default one is created at initialization)
+         */
+        void SetTdmaScheduler(Ptr<RescueTdmaScheduler> scheduler);
+        /**
+         * \return RescueTdmaScheduler used to build the schedule of CFP
+         */
+        Ptr<RescueTdmaScheduler> GetTdmaScheduler(void) const;
+
     private:
         void GenerateBeacon(void);
         void GenerateResourceReservationFor(Ptr<Packet> pktData);
         void GenerateTdmaTimeSlotReservation();
 
-        bool MakeResourceReservation(Time duration, Mac48Address address);
+        /**
+         * \param duration the reserved TX time (SIFS is added)
+         * \param address the transmitter
+         */
+        void MakeResourceReservation(Time duration, Mac48Address address);
+        /**
+         * \param duration the reserved TX time (including SIFS)
+         * \param address the transmitter
+         */
+        void AddReservedTime(Time duration, Mac48Address address);
+        /**
+         * \param address the station
+         * \return the estimated rate of the link between the station and AP (spectral efficiency)
+         */
+        double GetLinkRate(Mac48Address address);
+        /**
+         * Puts compressed schedule of current CFP into the beacon
+         *
+         * \param phyHdr PHY header of the beacon
+         * \return false if the schedule cannot be compressed (plain schedules list should be used)
+         */
+        bool EncodeCompressedSchedule(RescuePhyHeader &phyHdr);
+        /**
+         * \param address the station
+         * \return the short ID of the station (assigned at first scheduling, NO_STATION_ID if IDs are exhausted)
+         */
+        uint8_t GetStationId(Mac48Address address);
 
         void SendNow(void);
 
@@ -148,9 +193,19 @@ namespace ns3 {
         Timer m_currentSlotTimer;
 
         uint8_t m_schedulesNumber; //<! Number of schedules in current CFP
-        std::list<Mac48Address> m_schedules; //<! list of scheduled stations
-
-        std::map<Mac48Address, Time> m_reservedTime; //<! keeps the time reserved for each transmitter
+        std::vector<RescueTdmaScheduler::Assignment> m_schedules; //<! slot assignments of current CFP
+
+        Ptr<RescueTdmaScheduler> m_tdmaScheduler; //<! scheduler distributing TDMA time slots between stations
+
+        bool m_compressedSchedule; //<! true if beacons carry compressed schedule
+        uint32_t m_scheduleRefreshInterval; //<! number of beacons between full compressed schedules
+        uint32_t m_stationIdAnnouncements; //<! number of beacons announcing a new short station ID
+        std::map<Mac48Address, uint8_t> m_stationIds; //<! short IDs assigned to stations
+        std::map<Mac48Address, uint32_t> m_pendingIdAnnouncements; //<! remaining announcements of short IDs
+        uint8_t m_nextStationId; //<! next free short ID
+        uint8_t m_scheduleSequence; //<! sequence number of the last compressed schedule
+        std::vector<RescueScheduleRun> m_lastRuns; //<! runs of the last compressed schedule (empty - plain schedule sent)
+        uint32_t m_beaconsSinceRefresh; //<! beacons sent since the last full compressed schedule
 
     protected:
         virtual void DoInitialize();
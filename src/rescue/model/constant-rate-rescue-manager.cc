@@ -97,7 +97,7 @@ namespace ns3 {
     void
     ConstantRateRescueManager::DoReportDataOk(RescueRemoteStation *st,
             double ackSnr, RescueMode ackMode,
-            double dataSnr, double dataPer) {
+            double dataSnr, bool dataSnrValid, double dataPer) {
         NS_LOG_FUNCTION(this << st << ackSnr << ackMode << dataSnr);
     }
 
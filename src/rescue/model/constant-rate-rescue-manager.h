@@ -53,7 +53,7 @@ namespace ns3 {
         virtual void DoReportDataFailed(RescueRemoteStation *station);
         virtual void DoReportDataOk(RescueRemoteStation *station,
                 double ackSnr, RescueMode ackMode,
-                double dataSnr, double dataPer);
+                double dataSnr, bool dataSnrValid, double dataPer);
         virtual void DoReportFinalDataFailed(RescueRemoteStation *station);
         virtual RescueMode DoGetDataTxMode(RescueRemoteStation *station,
                 Ptr<const Packet> packet,
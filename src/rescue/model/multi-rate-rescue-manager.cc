@@ -24,10 +24,18 @@
 
 #include "ns3/string.h"
 #include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/boolean.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
 
 #include "rescue-mac-header.h"
+#include "rescue-phy.h"
+#include "blackbox_no1.h"
+#include "snr-per-tag.h"
+
+#include <cmath>
+#include <algorithm>
 
 NS_LOG_COMPONENT_DEFINE("MultiRateRescueManager");
 
@@ -40,6 +48,15 @@ NS_LOG_COMPONENT_DEFINE("MultiRateRescueManager");
 
 namespace ns3 {
 
+    /**
+     * Remote station with the state of rate selection
+     */
+    struct MultiRateRescueStation : public RescueRemoteStation {
+        bool m_update; //!< True if the mode should be reevaluated (new SNR sample)
+        uint32_t m_mode; //!< Index of current mode
+        uint32_t m_failures; //!< Consecutive failed transmissions
+    };
+
     NS_OBJECT_ENSURE_REGISTERED(MultiRateRescueManager);
 
     TypeId
@@ -66,11 +83,37 @@ namespace ns3 {
                 UintegerValue(8),
                 MakeUintegerAccessor(&MultiRateRescueManager::m_ctlCw),
                 MakeUintegerChecker<uint32_t> ())
+                .AddAttribute("Hysteresis", "The relative gain of predicted goodput required to switch to faster mode.",
+                DoubleValue(0.1),
+                MakeDoubleAccessor(&MultiRateRescueManager::m_hysteresis),
+                MakeDoubleChecker<double> (0))
+                .AddAttribute("MaxFrameErrorRate", "The maximal observed frame error rate of the link allowing to switch to faster mode.",
+                DoubleValue(0.3),
+                MakeDoubleAccessor(&MultiRateRescueManager::m_maxFer),
+                MakeDoubleChecker<double> (0, 1))
+                .AddAttribute("FailureThreshold", "The number of consecutive failed transmissions stepping the mode down.",
+                UintegerValue(2),
+                MakeUintegerAccessor(&MultiRateRescueManager::m_failureThreshold),
+                MakeUintegerChecker<uint32_t> (1))
+                .AddAttribute("RelayPrioritisation", "If true, the contention window of relayed DATA frames depends on"
+                " the end-to-end quality of source-relay-destination links (relays with better links access the channel first).",
+                BooleanValue(true),
+                MakeBooleanAccessor(&MultiRateRescueManager::m_relayPrioritisation),
+                MakeBooleanChecker())
+                .AddAttribute("RelayReferenceRate", "The capacity (bit/s) of the relay route for which the contention window of relayed frame equals DataCw.",
+                DoubleValue(36.0e6),
+                MakeDoubleAccessor(&MultiRateRescueManager::m_relayReferenceRate),
+                MakeDoubleChecker<double> (0))
+                .AddAttribute("RelayDefaultSnr", "The SNR (dB) assumed for the link of unknown quality (in relay prioritisation).",
+                DoubleValue(20),
+                MakeDoubleAccessor(&MultiRateRescueManager::m_relayDefaultSnr),
+                MakeDoubleChecker<double> ())
                 ;
         return tid;
     }
 
-    MultiRateRescueManager::MultiRateRescueManager() {
+    MultiRateRescueManager::MultiRateRescueManager()
+    : m_initialMode(0) {
         m_dataModeHi = RescueModeFactory::CreateRescueMode("Ofdm36Mbps", RESCUE_MOD_CLASS_OFDM, 20000000, 36000000, RESCUE_CODE_RATE_3_4, 16);
         m_dataModeLo = RescueModeFactory::CreateRescueMode("Ofdm12Mbps", RESCUE_MOD_CLASS_OFDM, 20000000, 12000000, RESCUE_CODE_RATE_1_2, 4);
         m_ctlMode = RescueModeFactory::CreateRescueMode("Ofdm12Mbps", RESCUE_MOD_CLASS_OFDM, 20000000, 12000000, RESCUE_CODE_RATE_1_2, 4);
@@ -81,18 +124,95 @@ namespace ns3 {
         NS_LOG_FUNCTION(this);
     }
 
+    void
+    MultiRateRescueManager::SetupPhy(Ptr<RescuePhy> phy) {
+        RescueRemoteStationManager::SetupPhy(phy);
+        m_modes.clear();
+        for (uint32_t i = 0; i < phy->GetNModes(); i++) {
+            RescueMode mode = phy->GetMode(i);
+            std::vector<RescueMode>::iterator it = m_modes.begin();
+            while (it != m_modes.end() && it->GetDataRate() <= mode.GetDataRate())
+                it++;
+            m_modes.insert(it, mode);
+        }
+        m_initialMode = 0;
+        for (uint32_t i = 0; i < m_modes.size(); i++) {
+            if (m_modes[i] == m_dataModeLo)
+                m_initialMode = i;
+        }
+    }
+
     RescueRemoteStation *
     MultiRateRescueManager::DoCreateStation(void) const {
         NS_LOG_FUNCTION(this);
-        RescueRemoteStation *station = new RescueRemoteStation();
+        MultiRateRescueStation *station = new MultiRateRescueStation();
+        station->m_update = false;
+        station->m_mode = m_initialMode;
+        station->m_failures = 0;
         return station;
     }
 
+    bool
+    MultiRateRescueManager::GetTxLinkSnr(const RescueRemoteStation *station, double &snr) const {
+        const RescueRemoteStationInfo &info = station->m_state->m_info;
+        if (info.HasTxSnr())
+            snr = info.GetTxSnr();
+        else if (info.HasRxSnr())
+            snr = info.GetRxSnr();
+        else
+            return false;
+        return true;
+    }
+
+    double
+    MultiRateRescueManager::GetGoodput(uint32_t mode, double snr, uint32_t size) const {
+        const RescueModeDescriptor &desc = m_modes[mode].GetDescriptor();
+        std::vector<double> snr_db(1, snr);
+        std::vector<double> linkBER(1, 0.0);
+        double ber = BlackBox_no1::CalculateRescueBitErrorRate(snr_db, linkBER,
+                desc.constellationSize,
+                desc.spectralEfficiency);
+        double successProbability = std::pow(1.0 - ber, 8.0 * size);
+        return desc.dataRate * successProbability;
+    }
+
+    void
+    MultiRateRescueManager::UpdateRate(MultiRateRescueStation *station, uint32_t size) {
+        double snr;
+        if (!GetTxLinkSnr(station, snr))
+            return;
+        uint32_t current = station->m_mode;
+        double currentGoodput = GetGoodput(current, snr, size);
+        uint32_t best = current;
+        double bestGoodput = currentGoodput;
+        for (uint32_t i = 0; i < m_modes.size(); i++) {
+            double goodput = GetGoodput(i, snr, size);
+            if (goodput > bestGoodput) {
+                best = i;
+                bestGoodput = goodput;
+            }
+        }
+
+        if (best > current
+                && (bestGoodput < currentGoodput * (1 + m_hysteresis)
+                || station->m_state->m_info.GetFrameErrorRate() > m_maxFer)) {
+            return;
+        }
+        if (best != current) {
+            NS_LOG_INFO("mode for " << station->m_state->m_address << ": " << m_modes[current] << " -> " << m_modes[best]
+                    << " (snr: " << snr << ", goodput: " << currentGoodput << " -> " << bestGoodput << ")");
+            station->m_mode = best;
+            station->m_failures = 0;
+        }
+    }
+
     void
     MultiRateRescueManager::DoReportRxOk(RescueRemoteStation *senderStation,
             RescueRemoteStation *sourceStation,
             double rxSnr, RescueMode txMode, bool wasReconstructed) {
         NS_LOG_FUNCTION(this << senderStation << sourceStation << rxSnr << txMode << ((wasReconstructed) ? "joint decoder was used" : ""));
+        //SNR of the link from sender is averaged in RescueRemoteStationInfo
+        ((MultiRateRescueStation *) senderStation)->m_update = true;
     }
 
     void
@@ -100,18 +220,31 @@ namespace ns3 {
             RescueRemoteStation *sourceStation,
             double rxSnr, RescueMode txMode, bool wasReconstructed) {
         NS_LOG_FUNCTION(this << senderStation << sourceStation << rxSnr << txMode << ((wasReconstructed) ? "joint decoder was used" : ""));
+        //PHY header was received - SNR of the link is known even if the payload is damaged
+        ((MultiRateRescueStation *) senderStation)->m_update = true;
     }
 
     void
-    MultiRateRescueManager::DoReportDataFailed(RescueRemoteStation *station) {
-        NS_LOG_FUNCTION(this << station);
+    MultiRateRescueManager::DoReportDataFailed(RescueRemoteStation *st) {
+        NS_LOG_FUNCTION(this << st);
+        MultiRateRescueStation *station = (MultiRateRescueStation *) st;
+        station->m_failures++;
+        if (station->m_failures >= m_failureThreshold && station->m_mode > 0) {
+            station->m_mode--;
+            station->m_failures = 0;
+            NS_LOG_INFO("mode for " << station->m_state->m_address << " stepped down to " << m_modes[station->m_mode]);
+        }
     }
 
     void
     MultiRateRescueManager::DoReportDataOk(RescueRemoteStation *st,
             double ackSnr, RescueMode ackMode,
-            double dataSnr, double dataPer) {
+            double dataSnr, bool dataSnrValid, double dataPer) {
         NS_LOG_FUNCTION(this << st << ackSnr << ackMode << dataSnr);
+        MultiRateRescueStation *station = (MultiRateRescueStation *) st;
+        station->m_failures = 0;
+        //SNR of the route is averaged in RescueRemoteStationInfo
+        station->m_update = true;
     }
 
     void
@@ -122,43 +255,51 @@ namespace ns3 {
     RescueMode
     MultiRateRescueManager::DoGetDataTxMode(RescueRemoteStation *st, Ptr<const Packet> packet, uint32_t size) {
         NS_LOG_FUNCTION(GetAddress() << "get data tx mode" << st->m_state->m_address);
-        return m_dataModeLo;
+        if (m_modes.empty())
+            return m_dataModeLo;
+        MultiRateRescueStation *station = (MultiRateRescueStation *) st;
+        if (station->m_update) {
+            UpdateRate(station, size);
+            station->m_update = false;
+        }
+        return m_modes[station->m_mode];
+    }
+
+    double
+    MultiRateRescueManager::GetRxLinkSnr(Mac48Address address) {
+        //SNR of all frames sent by the station
+        RescueRemoteStationInfo info = GetInfo(address);
+        return info.HasRxSnr() ? info.GetRxSnr() : m_relayDefaultSnr;
     }
 
     uint32_t
     MultiRateRescueManager::DoGetDataCw(RescueRemoteStation *st, Ptr<const Packet> packet, uint32_t size) {
+        if (!m_relayPrioritisation)
+            return m_dataCw;
+
         RescueMacHeader hdr;
         packet->PeekHeader(hdr);
-        double snrSR = 20, snrRD = 20, snrAll; //zakladamy ze jak nie mamy zadnych danych to trzeba je probowac zdobyc czyli normalny priorytet
-        double newCW = 0;
-        relayMap::iterator iRel = m_relays.find(st->m_state->m_address);
-
-
-        if (hdr.GetSource() != GetAddress()) {//nasza rola to relay tylko tutaj przeliczamy CW
-            relayMap::iterator iRel = m_relays.find(st->m_state->m_address);
-            if (iRel != m_relays.end()) {
-                if (iRel->second.count(st->m_state->m_address)) snrRD = iRel->second[st->m_state->m_address];
-            }
-
-            iRel = m_relays.find(hdr.GetSource());
-            if (iRel != m_relays.end()) {
-                if (iRel->second.count(hdr.GetSource())) snrSR = iRel->second[hdr.GetSource()];
-            }
-
-            //dokonjemy przeliczenia z dB na wartosc liniowa
-            snrSR = pow(10.0, -0.1 * snrSR);
-            snrRD = pow(10.0, -0.1 * snrRD);
-            snrAll = 1.0 / (snrSR + snrRD);
-            newCW = ceil(36.0e6 * (m_dataCw + 1) / (2.0e7 * log2(1.0 + 0.29 * snrAll))); //dobrane tak aby dla snr=9.31 lacze osiagalo 36e6mbps
-            newCW = newCW <= m_dataCw ? m_dataCw : newCW;
-            NS_LOG_FUNCTION("calculated new CW at " << GetAddress() << ":" << newCW);
-
-
-        }
-
-
-        // NS_LOG_FUNCTION (this << st << size);
-        return m_dataCw;
+        if (hdr.GetSource() == GetAddress())
+            return m_dataCw;
+
+        //relayed frame - the route quality is known from the tag (minimal SNR of previous hops)
+        //or from frames received directly from the source
+        double snrSR, snrRD;
+        SnrPerTag tag;
+        if (packet->PeekPacketTag(tag) && tag.IsSNRValid())
+            snrSR = tag.GetSNR();
+        else
+            snrSR = GetRxLinkSnr(hdr.GetSource());
+        snrRD = GetRxLinkSnr(st->m_state->m_address);
+
+        //end-to-end SNR (linear) of two-hop route, capacity-based scaling of CW
+        double snrAll = 1.0 / (std::pow(10.0, -0.1 * snrSR) + std::pow(10.0, -0.1 * snrRD));
+        double capacity = 2.0e7 * log2(1.0 + 0.29 * snrAll); //0.29 fitted so that for snr=9.31 the link achieves 36e6 bit/s
+        uint32_t cwMax = std::max<uint32_t> (GetCwMax(), m_dataCw);
+        double newCW = (capacity > 0) ? std::ceil(m_relayReferenceRate * (m_dataCw + 1) / capacity) : cwMax;
+        uint32_t cw = (newCW <= m_dataCw) ? m_dataCw : (newCW >= cwMax ? cwMax : (uint32_t) newCW);
+        NS_LOG_FUNCTION("calculated new CW at " << GetAddress() << ":" << cw << " (snrSR: " << snrSR << ", snrRD: " << snrRD << ")");
+        return cw;
     }
 
     RescueMode
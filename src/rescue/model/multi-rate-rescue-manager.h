@@ -48,27 +48,20 @@ namespace ns3 {
 
     //-------------------------------sikor
 
-    struct macComp {
-
-        bool operator()(const Mac48Address& a, const Mac48Address& b) const {
-            return a < b;
-        }
-    };
-
-
-    typedef std::map<Mac48Address, double, macComp> snrMap;
-    typedef std::map<Mac48Address, snrMap, macComp> relayMap;
-
-
-
-    //-------------------------------sikor
+    struct MultiRateRescueStation;
 
     /**
      * \ingroup rescue
      * \brief use multi rates for data and control transmissions
      *
-     * This class uses always the same transmission rate for every
-     * packet sent.
+     * DATA frames are sent with the PHY mode of the highest goodput predicted for
+     * the link to the destination: the SNR of the link (RescueRemoteStationInfo: averaged
+     * SNR of TX link or, until it is known, of RX link) is mapped to bit error rate of each mode
+     * with BlackBox_no1 (MI model), goodput is the data rate scaled by the success
+     * probability of the frame. Faster mode is selected only if its goodput exceeds
+     * the current one by the hysteresis margin and the observed frame error rate
+     * (RescueRemoteStationInfo) is acceptable; consecutive failures step the mode down.
+     * Control frames are always sent with the same mode.
      */
     class MultiRateRescueManager : public RescueRemoteStationManager {
     public:
@@ -76,6 +69,8 @@ namespace ns3 {
         MultiRateRescueManager();
         virtual ~MultiRateRescueManager();
 
+        virtual void SetupPhy(Ptr<RescuePhy> phy);
+
     private:
         // overriden from base class
         virtual RescueRemoteStation* DoCreateStation(void) const;
@@ -88,7 +83,7 @@ namespace ns3 {
         virtual void DoReportDataFailed(RescueRemoteStation *station);
         virtual void DoReportDataOk(RescueRemoteStation *station,
                 double ackSnr, RescueMode ackMode,
-                double dataSnr, double dataPer);
+                double dataSnr, bool dataSnrValid, double dataPer);
         virtual void DoReportFinalDataFailed(RescueRemoteStation *station);
         virtual RescueMode DoGetDataTxMode(RescueRemoteStation *station,
                 Ptr<const Packet> packet,
@@ -103,11 +98,45 @@ namespace ns3 {
         virtual uint32_t DoGetAckCw(RescueRemoteStation *station);
         virtual bool IsLowLatency(void) const;
 
+        /**
+         * Selects the mode of the highest predicted goodput (with hysteresis)
+         *
+         * \param station the remote station
+         * \param size the size of the frame
+         */
+        void UpdateRate(MultiRateRescueStation *station, uint32_t size);
+        /**
+         * \param mode the index of the mode in m_modes
+         * \param snr the SNR (dB) of the link
+         * \param size the size of the frame
+         * \return the predicted goodput (bit/s)
+         */
+        double GetGoodput(uint32_t mode, double snr, uint32_t size) const;
+        /**
+         * \param station the remote station
+         * \param snr the SNR (dB) of the link to the station
+         * \return true if the SNR of the link is known
+         */
+        bool GetTxLinkSnr(const RescueRemoteStation *station, double &snr) const;
+        /**
+         * \param address the address of the station
+         * \return the SNR (dB) of the link from the station (or RelayDefaultSnr if unknown)
+         */
+        double GetRxLinkSnr(Mac48Address address);
+
+        std::vector<RescueMode> m_modes; //!< Modes supported by PHY (in ascending data rate order)
+        uint32_t m_initialMode; //!< Index of the mode used before the SNR of link is known
+        double m_hysteresis; //!< Relative goodput gain required to switch to faster mode
+        double m_maxFer; //!< Maximal observed frame error rate allowing to switch to faster mode
+        uint32_t m_failureThreshold; //!< Consecutive failures stepping the mode down
+        bool m_relayPrioritisation; //!< True if CW of relayed frames depends on the quality of relay route
+        double m_relayReferenceRate; //!< Route capacity for which CW of relayed frame equals m_dataCw
+        double m_relayDefaultSnr; //!< SNR assumed for the link of unknown quality
+
         RescueMode m_dataModeHi, m_dataModeLo; //!< Rescue mode for unicast DATA frames
         RescueMode m_ctlMode; //!< Rescue mode for control frames and ACK
         uint32_t m_dataCw; //!< Contention window for unicast DATA frames
         uint32_t m_ctlCw; //!< Contention window for control frames and ACK
-        relayMap m_relays;
         Mac48Address m_lastDest;
     };
 
@@ -0,0 +1,182 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 AGH Univeristy of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/assert.h"
+#include "ns3/make-event.h"
+
+#include "rescue-ack-cache.h"
+
+NS_LOG_COMPONENT_DEFINE("RescueAckCache");
+
+namespace ns3 {
+
+    RescueAckCache::RescueAckCache()
+    : m_free(NO_ENTRY),
+    m_size(0) {
+        m_timers.SetResolution(MilliSeconds(1));
+        SetCapacity(128);
+    }
+
+    void
+    RescueAckCache::SetCapacity(uint32_t capacity) {
+        NS_ASSERT(capacity > 0);
+        m_entries.resize(capacity);
+        uint32_t buckets = 1;
+        while (buckets < capacity)
+            buckets <<= 1;
+        m_buckets.resize(buckets);
+        Clear();
+    }
+
+    uint32_t
+    RescueAckCache::GetCapacity(void) const {
+        return m_entries.size();
+    }
+
+    void
+    RescueAckCache::SetResolution(Time resolution) {
+        Clear();
+        m_timers.SetResolution(resolution);
+    }
+
+    Time
+    RescueAckCache::GetResolution(void) const {
+        return m_timers.GetResolution();
+    }
+
+    void
+    RescueAckCache::SetCompareCallback(CompareCallback cb) {
+        m_compare = cb;
+    }
+
+    void
+    RescueAckCache::Clear(void) {
+        m_timers.CancelAll();
+        m_free = NO_ENTRY;
+        for (int32_t i = m_entries.size() - 1; i >= 0; i--) {
+            m_entries[i].pkt = 0;
+            m_entries[i].timer = 0;
+            m_entries[i].hashNext = m_free;
+            m_free = i;
+        }
+        for (uint32_t i = 0; i < m_buckets.size(); i++)
+            m_buckets[i] = NO_ENTRY;
+        m_size = 0;
+    }
+
+    uint32_t
+    RescueAckCache::GetSize(void) const {
+        return m_size;
+    }
+
+    bool
+    RescueAckCache::Find(const RescuePhyHeader &ackHdr) {
+        //expired entries are already removed by the timer wheel
+        for (int32_t idx = m_buckets[Hash(ackHdr)]; idx != NO_ENTRY; idx = m_entries[idx].hashNext) {
+            Entry &e = m_entries[idx];
+            if ((e.hdr.GetSource() == ackHdr.GetSource())
+                    && (e.hdr.GetDestination() == ackHdr.GetDestination())
+                    && (e.hdr.GetSequence() == ackHdr.GetSequence())
+                    && (m_compare.IsNull() || m_compare(&e.hdr, &ackHdr)))
+                return true;
+        }
+        return false;
+    }
+
+    void
+    RescueAckCache::Insert(Ptr<Packet> ackPkt, const RescuePhyHeader &ackHdr, Time lifetime) {
+        if (m_free == NO_ENTRY)
+            Evict();
+        NS_ASSERT(m_free != NO_ENTRY);
+
+        int32_t idx = m_free;
+        Entry &e = m_entries[idx];
+        m_free = e.hashNext;
+
+        e.pkt = ackPkt;
+        e.hdr = ackHdr;
+        e.expires = Simulator::Now() + lifetime;
+        e.timer = m_timers.Arm(lifetime, Ptr<EventImpl> (MakeEvent(&RescueAckCache::Expire, this, idx), false));
+        e.bucket = Hash(ackHdr);
+        e.hashPrev = NO_ENTRY;
+        e.hashNext = m_buckets[e.bucket];
+        if (e.hashNext != NO_ENTRY)
+            m_entries[e.hashNext].hashPrev = idx;
+        m_buckets[e.bucket] = idx;
+        m_size++;
+    }
+
+    uint32_t
+    RescueAckCache::Hash(const RescuePhyHeader &hdr) const {
+        uint8_t buf[6];
+        uint32_t hash = 2166136261u; //FNV-1a
+        hdr.GetSource().CopyTo(buf);
+        for (uint8_t i = 0; i < 6; i++)
+            hash = (hash ^ buf[i]) * 16777619u;
+        hdr.GetDestination().CopyTo(buf);
+        for (uint8_t i = 0; i < 6; i++)
+            hash = (hash ^ buf[i]) * 16777619u;
+        hash = (hash ^ (hdr.GetSequence() & 0xff)) * 16777619u;
+        hash = (hash ^ (hdr.GetSequence() >> 8)) * 16777619u;
+        return hash & (m_buckets.size() - 1);
+    }
+
+    void
+    RescueAckCache::Expire(int32_t idx) {
+        NS_LOG_INFO("Expired ACK in cache - erase!");
+        Remove(idx);
+    }
+
+    void
+    RescueAckCache::Remove(int32_t idx) {
+        Entry &e = m_entries[idx];
+        NS_ASSERT(e.timer != 0);
+        m_timers.Cancel(e.timer);
+        if (e.hashPrev != NO_ENTRY)
+            m_entries[e.hashPrev].hashNext = e.hashNext;
+        else
+            m_buckets[e.bucket] = e.hashNext;
+        if (e.hashNext != NO_ENTRY)
+            m_entries[e.hashNext].hashPrev = e.hashPrev;
+
+        e.pkt = 0;
+        e.timer = 0;
+        e.hashNext = m_free;
+        m_free = idx;
+        m_size--;
+    }
+
+    void
+    RescueAckCache::Evict(void) {
+        //eviction happens only when the cache is full, so the pool is scanned instead of the wheel
+        int32_t oldest = NO_ENTRY;
+        for (int32_t idx = 0; idx < int32_t(m_entries.size()); idx++)
+            if ((m_entries[idx].timer != 0)
+                    && ((oldest == NO_ENTRY) || (m_entries[idx].expires < m_entries[oldest].expires)))
+                oldest = idx;
+        if (oldest != NO_ENTRY) {
+            NS_LOG_DEBUG("ACK cache full - evict entry: " << m_entries[oldest].expires);
+            Remove(oldest);
+        }
+    }
+
+} // namespace ns3
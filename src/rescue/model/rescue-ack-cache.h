@@ -0,0 +1,140 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 AGH Univeristy of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+
+#ifndef RESCUE_ACK_CACHE_H
+#define RESCUE_ACK_CACHE_H
+
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/callback.h"
+
+#include "rescue-phy-header.h"
+#include "rescue-timer-wheel.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+    /**
+     * \ingroup rescue
+     *
+     * Cache of recently forwarded ACK frames used by lower MAC to detect duplicated ACKs.
+     * Entries are stored in a bounded pool and indexed by a hash of (source, destination,
+     * sequence number), so the lookup does not depend on the number of cached ACKs.
+     * Lifetime of entries is handled by RescueTimerWheel, which removes each entry at its
+     * expiry. When the pool is full, the entry closest to expiry is evicted.
+     */
+    class RescueAckCache {
+    public:
+        typedef Callback<bool, const RescuePhyHeader*, const RescuePhyHeader*> CompareCallback;
+
+        RescueAckCache();
+
+        /**
+         * \param capacity the maximal number of cached ACKs (the cache is cleared)
+         */
+        void SetCapacity(uint32_t capacity);
+        /**
+         * \return the maximal number of cached ACKs
+         */
+        uint32_t GetCapacity(void) const;
+        /**
+         * \param resolution the duration of a single tick of the timer wheel (the cache is cleared)
+         */
+        void SetResolution(Time resolution);
+        /**
+         * \return the duration of a single tick of the timer wheel
+         */
+        Time GetResolution(void) const;
+        /**
+         * \param cb the callback used to compare ACK headers with the same (source, destination, sequence)
+         */
+        void SetCompareCallback(CompareCallback cb);
+
+        /**
+         * \param ackHdr the PHY header of received ACK
+         * \return true if the same ACK is stored in cache and has not expired yet
+         */
+        bool Find(const RescuePhyHeader &ackHdr);
+        /**
+         * \param ackPkt the received ACK
+         * \param ackHdr the PHY header of received ACK
+         * \param lifetime the time to keep this ACK in cache
+         */
+        void Insert(Ptr<Packet> ackPkt, const RescuePhyHeader &ackHdr, Time lifetime);
+        /**
+         * Removes all cached ACKs
+         */
+        void Clear(void);
+        /**
+         * \return the number of cached ACKs
+         */
+        uint32_t GetSize(void) const;
+
+    private:
+
+        enum {
+            NO_ENTRY = -1 //!< Index of non-existing entry
+        };
+
+        struct Entry {
+            Ptr<Packet> pkt; //!< The ACK packet
+            RescuePhyHeader hdr; //!< The PHY header of ACK
+            Time expires; //!< Lifetime of this ACK packet
+            RescueTimerWheel::Handle timer; //!< Expiry timeout of this entry (0 - free entry)
+            uint32_t bucket; //!< Hash bucket of this entry
+            int32_t hashPrev; //!< Previous entry in hash bucket
+            int32_t hashNext; //!< Next entry in hash bucket (or in free list)
+        };
+
+        /**
+         * \param hdr the PHY header of ACK
+         * \return the hash bucket for (source, destination, sequence) of this ACK
+         */
+        uint32_t Hash(const RescuePhyHeader &hdr) const;
+        /**
+         * Invoked by the timer wheel when the entry expires
+         *
+         * \param idx the index of entry
+         */
+        void Expire(int32_t idx);
+        /**
+         * Removes the entry from the cache and returns it to the pool
+         *
+         * \param idx the index of entry
+         */
+        void Remove(int32_t idx);
+        /**
+         * Removes the entry which is the closest to expiry
+         */
+        void Evict(void);
+
+        std::vector<Entry> m_entries; //!< The pool of entries
+        std::vector<int32_t> m_buckets; //!< Heads of hash buckets
+        int32_t m_free; //!< Head of the list of free entries
+        uint32_t m_size; //!< Number of cached ACKs
+        RescueTimerWheel m_timers; //!< Expiry timeouts of entries
+        CompareCallback m_compare; //!< ACK headers comparison
+    };
+
+} // namespace ns3
+
+#endif /* RESCUE_ACK_CACHE_H */
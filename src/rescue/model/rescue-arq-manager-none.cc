@@ -0,0 +1,239 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 AGH Univeristy of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+#include "rescue-arq-manager-none.h"
+#include "rescue-mac.h"
+#include "rescue-mac-header.h"
+#include "rescue-utils.h"
+
+NS_LOG_COMPONENT_DEFINE("RescueArqManagerNone");
+
+#undef NS_LOG_APPEND_CONTEXT
+#define NS_LOG_APPEND_CONTEXT std::clog << "[time=" << ns3::Simulator::Now().GetMicroSeconds() << "] [addr=" << ((m_mac != 0) ? compressMac(m_mac->GetAddress ()) : 0) << "] [ARQ none] "
+
+namespace ns3 {
+
+    NS_OBJECT_ENSURE_REGISTERED(RescueArqManagerNone);
+
+    TypeId
+    RescueArqManagerNone::GetTypeId(void) {
+        static TypeId tid = TypeId("ns3::RescueArqManagerNone")
+                .SetParent<RescueArqManager> ()
+                .AddConstructor<RescueArqManagerNone> ()
+                ;
+        return tid;
+    }
+
+    RescueArqManagerNone::RescueArqManagerNone() {
+        NS_LOG_FUNCTION("");
+    }
+
+    RescueArqManagerNone::~RescueArqManagerNone() {
+        NS_LOG_FUNCTION("");
+    }
+
+
+    // ---------------------- Transmitter Functions ----------------------------
+
+    bool
+    RescueArqManagerNone::IsTxAllowed(Mac48Address dst) {
+        return true;
+    }
+
+    uint16_t
+    RescueArqManagerNone::GetTxAllowance(Mac48Address dst) {
+        return MAX_WINDOW_SIZE;
+    }
+
+    uint16_t
+    RescueArqManagerNone::AllocateSequence(Mac48Address dst) {
+        std::pair < std::map<Mac48Address, uint16_t>::iterator, bool> newIns = m_sequences.insert(std::pair<Mac48Address, uint16_t> (dst, 0));
+        return newIns.first->second++;
+    }
+
+    uint16_t
+    RescueArqManagerNone::GetNextSequenceNumber(const RescuePhyHeader *hdr) {
+        return AllocateSequence(hdr->GetDestination());
+    }
+
+    uint16_t
+    RescueArqManagerNone::GetNextSequenceNumber(const RescueMacHeader *hdr) {
+        return AllocateSequence(hdr->GetDestination());
+    }
+
+    uint16_t
+    RescueArqManagerNone::GetNextSeqNumberByAddress(Mac48Address dst) const {
+        std::map<Mac48Address, uint16_t>::const_iterator it = m_sequences.find(dst);
+        return (it != m_sequences.end()) ? it->second : 0;
+    }
+
+    void
+    RescueArqManagerNone::ReportNewDataFrame(Mac48Address dst, uint16_t seq) {
+    }
+
+    void
+    RescueArqManagerNone::ConfigurePhyHeader(RescuePhyHeader *phyHdr) {
+        phyHdr->SetSendWindow(0);
+        phyHdr->SetBlockAckDisabled();
+        phyHdr->SetContinousAckDisabled();
+    }
+
+    void
+    RescueArqManagerNone::ReportDataTx(Ptr<Packet> pkt) {
+    }
+
+    int
+    RescueArqManagerNone::ReceiveAck(const RescuePhyHeader *ackHdr) {
+        NS_LOG_INFO("ACK ERROR (ARQ disabled)");
+        return -1;
+    }
+
+    void
+    RescueArqManagerNone::AckTimeout(Ptr<Packet> pkt) {
+        RescueMacHeader hdr;
+        pkt->PeekHeader(hdr);
+        NS_LOG_INFO("DATA TX FAIL! (no retransmissions) dst: " << hdr.GetDestination() << ", seq: " << hdr.GetSequence());
+        NotifyFinalDataFailed(hdr.GetDestination());
+    }
+
+    bool
+    RescueArqManagerNone::NeedDataRetransmission(Mac48Address dst, uint16_t seq) {
+        return false;
+    }
+
+    void
+    RescueArqManagerNone::RelayingStopAck(Mac48Address dst, uint16_t seq) {
+    }
+
+    bool
+    RescueArqManagerNone::IsRetryACKed(const RescueMacHeader *hdr) {
+        return false;
+    }
+
+
+    // ---------------------- Receiver Functions ----------------------------
+
+    bool
+    RescueArqManagerNone::CheckRxSequence(Mac48Address src, uint16_t seq, bool useContinousACK) {
+        std::map<Mac48Address, SeqHistory>::iterator it = m_rxSeqs.find(src);
+        return (it == m_rxSeqs.end()) || IsNewInHistory(it->second, seq);
+    }
+
+    bool
+    RescueArqManagerNone::CheckRxFrame(const RescuePhyHeader *phyHdr, RescuePhyHeader *ackHdr) {
+        bool isNewSequence = CheckRxSequence(phyHdr->GetSource(), phyHdr->GetSequence(), false);
+        if (isNewSequence) {
+            std::pair < std::map<Mac48Address, SeqHistory>::iterator, bool> newIns = m_rxSeqs.insert(std::make_pair(phyHdr->GetSource(), NewHistory(phyHdr->GetSequence())));
+            if (!newIns.second)
+                MarkInHistory(newIns.first->second, phyHdr->GetSequence());
+        }
+        //never acknowledge
+        ackHdr->SetDestination("00:00:00:00:00:00");
+        return isNewSequence;
+    }
+
+    void
+    RescueArqManagerNone::ReportDamagedFrame(const RescuePhyHeader *phyHdr) {
+    }
+
+    void
+    RescueArqManagerNone::ReportDataRx(Ptr<const Packet> pkt, const RescuePhyHeader *phyHdr, bool coded) {
+        //no payloads are kept as there are no (coded) retransmissions
+        if (coded)
+            NS_LOG_INFO("CODED frame received, but coded retransmissions are not supported - DROP!");
+    }
+
+
+    // ---------------------- Relay Functions ----------------------------
+
+    std::pair<RelayBehavior, RescuePhyHeader>
+    RescueArqManagerNone::ReportRelayFrameRx(const RescuePhyHeader *phyHdr, double ber) {
+        FwdSeqList::iterator it = m_txSeqs.find(std::make_pair(phyHdr->GetSource(), phyHdr->GetDestination()));
+        if ((it != m_txSeqs.end()) && !IsNewInHistory(it->second, phyHdr->GetSequence()))
+            //there are no retransmissions - it is a copy of already relayed frame
+            return std::pair<RelayBehavior, RescuePhyHeader> (DROP, RescuePhyHeader(RESCUE_PHY_PKT_TYPE_E2E_ACK));
+        //queued copies of the same frame are merged by lower MAC
+        return std::pair<RelayBehavior, RescuePhyHeader> (FORWARD, RescuePhyHeader(RESCUE_PHY_PKT_TYPE_E2E_ACK));
+    }
+
+    bool
+    RescueArqManagerNone::ReportAckToFwd(const RescuePhyHeader *ackHdr) {
+        return false;
+    }
+
+    bool
+    RescueArqManagerNone::IsFwdACKed(const RescuePhyHeader *phyHdr) {
+        return false;
+    }
+
+    void
+    RescueArqManagerNone::ReportRelayDataTx(const RescuePhyHeader *phyHdr) {
+        std::pair < FwdSeqList::iterator, bool> newIns = m_txSeqs.insert(std::make_pair(std::make_pair(phyHdr->GetSource(), phyHdr->GetDestination()), NewHistory(phyHdr->GetSequence())));
+        if (!newIns.second)
+            MarkInHistory(newIns.first->second, phyHdr->GetSequence());
+    }
+
+    Time
+    RescueArqManagerNone::GetTimeoutFor(const RescuePhyHeader *ackHdr) {
+        return m_longAckTimeout;
+    }
+
+    bool
+    RescueArqManagerNone::IsHopAckEnabled(void) const {
+        return false;
+    }
+
+
+    // ---------------------- Sequence history ----------------------------
+
+    bool
+    RescueArqManagerNone::IsNewInHistory(const SeqHistory &history, uint16_t seq) {
+        if (SeqComp(seq, history.last))
+            return true;
+        uint16_t age = history.last - seq;
+        //frames older than the history are treated as duplicates
+        return (age < SEQ_HISTORY_SIZE) && !(history.seen & (uint64_t(1) << age));
+    }
+
+    void
+    RescueArqManagerNone::MarkInHistory(SeqHistory &history, uint16_t seq) {
+        if (SeqComp(seq, history.last)) {
+            uint16_t shift = seq - history.last;
+            history.seen = (shift < SEQ_HISTORY_SIZE) ? ((history.seen << shift) | 1) : 1;
+            history.last = seq;
+        } else {
+            uint16_t age = history.last - seq;
+            if (age < SEQ_HISTORY_SIZE)
+                history.seen |= (uint64_t(1) << age);
+        }
+    }
+
+    RescueArqManagerNone::SeqHistory
+    RescueArqManagerNone::NewHistory(uint16_t seq) {
+        SeqHistory history;
+        history.last = seq;
+        history.seen = 1;
+        return history;
+    }
+
+} // namespace ns3
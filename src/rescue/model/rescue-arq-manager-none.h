@@ -0,0 +1,118 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 AGH Univeristy of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+
+#ifndef RESCUE_ARQ_MANAGER_NONE_H
+#define RESCUE_ARQ_MANAGER_NONE_H
+
+#include "ns3/mac48-address.h"
+
+#include "rescue-arq-manager.h"
+
+#include <stdint.h>
+#include <map>
+
+#define SEQ_HISTORY_SIZE 64 //number of recent sequence numbers tracked for duplicate detection
+
+namespace ns3 {
+
+    /**
+     * \ingroup rescue
+     *
+     * ARQ strategy for operation without acknowledgements: frames are never retransmitted
+     * and no ACKs are sent. No per-frame state is kept, only sequence counters of destinations,
+     * the recently received sequence numbers of each source (duplicate detection) and the recently
+     * transmitted sequence numbers of each relayed flow (to drop copies of already relayed frames).
+     * Recent sequence numbers are kept as a bitmap below the highest one, so frames reordered
+     * by different relays are still accepted.
+     */
+    class RescueArqManagerNone : public RescueArqManager {
+    public:
+        static TypeId GetTypeId(void);
+
+        RescueArqManagerNone();
+        virtual ~RescueArqManagerNone();
+
+        virtual bool IsTxAllowed(Mac48Address dst);
+        virtual uint16_t GetTxAllowance(Mac48Address dst);
+        virtual uint16_t GetNextSequenceNumber(const RescuePhyHeader *hdr);
+        virtual uint16_t GetNextSequenceNumber(const RescueMacHeader *hdr);
+        virtual uint16_t GetNextSeqNumberByAddress(Mac48Address dst) const;
+        virtual void ReportNewDataFrame(Mac48Address dst, uint16_t seq);
+        virtual void ConfigurePhyHeader(RescuePhyHeader *phyHdr);
+        virtual void ReportDataTx(Ptr<Packet> pkt);
+        virtual int ReceiveAck(const RescuePhyHeader *ackHdr);
+        virtual void AckTimeout(Ptr<Packet> pkt);
+        virtual bool NeedDataRetransmission(Mac48Address dst, uint16_t seq);
+        virtual void RelayingStopAck(Mac48Address dst, uint16_t seq);
+        virtual bool CheckRxSequence(Mac48Address src, uint16_t seq, bool useContinousACK);
+        virtual bool CheckRxFrame(const RescuePhyHeader *phyHdr, RescuePhyHeader *ackHdr);
+        virtual void ReportDamagedFrame(const RescuePhyHeader *phyHdr);
+        virtual void ReportDataRx(Ptr<const Packet> pkt, const RescuePhyHeader *phyHdr, bool coded);
+        virtual std::pair<RelayBehavior, RescuePhyHeader> ReportRelayFrameRx(const RescuePhyHeader *phyHdr, double ber);
+        virtual bool ReportAckToFwd(const RescuePhyHeader *ackHdr);
+        virtual bool IsRetryACKed(const RescueMacHeader *hdr);
+        virtual bool IsFwdACKed(const RescuePhyHeader *phyHdr);
+        virtual void ReportRelayDataTx(const RescuePhyHeader *phyHdr);
+        virtual Time GetTimeoutFor(const RescuePhyHeader *ackHdr);
+        virtual bool IsHopAckEnabled(void) const;
+
+    private:
+        /**
+         * \param dst the destination address
+         * \return the next sequence number for given destination
+         */
+        uint16_t AllocateSequence(Mac48Address dst);
+
+        /**
+         * Recently seen sequence numbers: the highest one and the bitmap of SEQ_HISTORY_SIZE
+         * sequence numbers up to it (bit k stands for sequence number last - k)
+         */
+        struct SeqHistory {
+            uint16_t last; //!< The highest sequence number seen
+            uint64_t seen; //!< Bitmap of seen sequence numbers below the highest one
+        };
+
+        /**
+         * \param history the recently seen sequence numbers
+         * \param seq the sequence number
+         * \return true if the sequence number was not seen yet and is not older than the history
+         */
+        bool IsNewInHistory(const SeqHistory &history, uint16_t seq);
+        /**
+         * \param history the recently seen sequence numbers to update
+         * \param seq the sequence number to mark as seen
+         */
+        void MarkInHistory(SeqHistory &history, uint16_t seq);
+        /**
+         * \param seq the sequence number
+         * \return the history containing only given sequence number
+         */
+        static SeqHistory NewHistory(uint16_t seq);
+
+        typedef std::map<std::pair<Mac48Address, Mac48Address>, SeqHistory> FwdSeqList;
+
+        std::map<Mac48Address, uint16_t> m_sequences; //!< Next sequence numbers of destinations
+        std::map<Mac48Address, SeqHistory> m_rxSeqs; //!< Recently received sequence numbers of sources
+        FwdSeqList m_txSeqs; //!< Recently transmitted sequence numbers of relayed flows
+    };
+
+} // namespace ns3
+
+#endif /* RESCUE_ARQ_MANAGER_NONE_H */
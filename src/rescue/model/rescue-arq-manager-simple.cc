@@ -16,368 +16,305 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
  *
  * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
- *
  */
 
-#include "ns3/attribute.h"
-#include "ns3/uinteger.h"
-#include "ns3/boolean.h"
-#include "ns3/double.h"
-#include "ns3/nstime.h"
-#include "ns3/assert.h"
 #include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/assert.h"
 
-#include "rescue-arq-manager.h"
+#include "rescue-arq-manager-simple.h"
 #include "rescue-mac.h"
 #include "rescue-mac-header.h"
+#include "rescue-utils.h"
 
-NS_LOG_COMPONENT_DEFINE("RescueArqManager");
+NS_LOG_COMPONENT_DEFINE("RescueArqManagerSimple");
 
 #undef NS_LOG_APPEND_CONTEXT
-#define NS_LOG_APPEND_CONTEXT if (m_mac != 0) { std::clog << "[time=" << ns3::Simulator::Now() << "] [addr=" << m_mac->GetAddress () << "] [ARQ] "; }
+#define NS_LOG_APPEND_CONTEXT std::clog << "[time=" << ns3::Simulator::Now().GetMicroSeconds() << "] [addr=" << ((m_mac != 0) ? compressMac(m_mac->GetAddress ()) : 0) << "] [ARQ simple] "
 
 namespace ns3 {
 
-    NS_OBJECT_ENSURE_REGISTERED(RescueArqManager);
+    NS_OBJECT_ENSURE_REGISTERED(RescueArqManagerSimple);
 
     TypeId
-    RescueArqManager::GetTypeId(void) {
-        static TypeId tid = TypeId("ns3::RescueArqManager")
-                .SetParent<Object> ()
-                .AddConstructor<RescueArqManager> ()
-                .AddAttribute("MaxRetryCount", "The maximum number of retransmission attempts for a DATA packet. This value"
-                " will not have any effect on some rate control algorithms.",
-                UintegerValue(7),
-                MakeUintegerAccessor(&RescueArqManager::m_maxRetryCount),
-                MakeUintegerChecker<uint32_t> ())
-                .AddAttribute("BasicAckTimeout",
-                "ACK awaiting time",
-                TimeValue(MicroSeconds(3000)),
-                MakeTimeAccessor(&RescueArqManager::m_basicAckTimeout),
-                MakeTimeChecker())
-
-                .AddTraceSource("MacTxDataFailed",
-                "The transmission of a data packet by the MAC layer has failed",
-                MakeTraceSourceAccessor(&RescueArqManager::m_macTxDataFailed))
-                .AddTraceSource("MacTxFinalDataFailed",
-                "The transmission of a data packet has exceeded the maximum number of attempts",
-                MakeTraceSourceAccessor(&RescueArqManager::m_macTxFinalDataFailed))
+    RescueArqManagerSimple::GetTypeId(void) {
+        static TypeId tid = TypeId("ns3::RescueArqManagerSimple")
+                .SetParent<RescueArqManager> ()
+                .AddConstructor<RescueArqManagerSimple> ()
                 ;
         return tid;
     }
 
-    RescueArqManager::RescueArqManager()
-    : m_txAllowed(true),
-    m_ackTimeoutEvent() {
-        NS_LOG_FUNCTION(m_basicAckTimeout);
-    }
-
-    RescueArqManager::~RescueArqManager() {
+    RescueArqManagerSimple::RescueArqManagerSimple() {
         NS_LOG_FUNCTION("");
     }
 
-    void
-    RescueArqManager::DoDispose() {
+    RescueArqManagerSimple::~RescueArqManagerSimple() {
         NS_LOG_FUNCTION("");
-        if (m_ackTimeoutEvent.IsRunning())
-            m_ackTimeoutEvent.Cancel();
     }
 
     void
-    RescueArqManager::SetupMac(Ptr<RescueMac> mac) {
-        m_mac = mac;
-    }
-
-    void
-    RescueArqManager::SetBasicAckTimeout(Time duration) {
-        NS_LOG_FUNCTION(duration);
-        m_basicAckTimeout = duration;
-    }
-
-    Time
-    RescueArqManager::GetBasicAckTimeout(void) const {
-        return m_basicAckTimeout;
+    RescueArqManagerSimple::DoDispose() {
+        NS_LOG_FUNCTION("");
+        for (SendStateList::iterator it = m_sendStates.begin(); it != m_sendStates.end(); it++)
+            it->second.ackTimeoutEvent.Cancel();
+        m_sendStates.clear();
+        RescueArqManager::DoDispose();
     }
 
-    uint16_t
-    RescueArqManager::GetMaxRetryCount(void) const {
-        return m_maxRetryCount;
-    }
 
-    void
-    RescueArqManager::SetMaxRetryCount(uint16_t maxRetryCount) {
-        m_maxRetryCount = maxRetryCount;
-    }
+    // ---------------------- Transmitter Functions ----------------------------
 
     bool
-    RescueArqManager::IsTxAllowed() {
-        return m_txAllowed;
+    RescueArqManagerSimple::IsTxAllowed(Mac48Address dst) {
+        SendStateList::iterator it = m_sendStates.find(dst);
+        return (it == m_sendStates.end()) || !it->second.pending;
     }
 
-    void
-    RescueArqManager::EnableDataTx() {
-        m_txAllowed = true;
-        m_mac->NotifyTxAllowed();
+    uint16_t
+    RescueArqManagerSimple::GetTxAllowance(Mac48Address dst) {
+        return IsTxAllowed(dst) ? 1 : 0;
     }
 
-    void
-    RescueArqManager::DisableDataTx() {
-        m_txAllowed = false;
+    uint16_t
+    RescueArqManagerSimple::AllocateSequence(Mac48Address dst) {
+        std::pair < std::map<Mac48Address, uint16_t>::iterator, bool> newIns = m_sequences.insert(std::pair<Mac48Address, uint16_t> (dst, 0));
+        return newIns.first->second++;
     }
 
     uint16_t
-    RescueArqManager::GetNextSequenceNumber(const RescuePhyHeader *hdr) {
+    RescueArqManagerSimple::GetNextSequenceNumber(const RescuePhyHeader *hdr) {
         NS_LOG_FUNCTION("");
-        uint16_t retval;
-        std::map<Mac48Address, uint16_t>::iterator it = m_sequences.find(hdr->GetDestination());
-        if (it != m_sequences.end()) {
-            retval = it->second;
-            it->second++;
-        } else {
-            retval = 0;
-            std::pair <Mac48Address, uint16_t> newSeq(hdr->GetDestination(), 0);
-            std::pair < std::map<Mac48Address, uint16_t>::iterator, bool> newIns = m_sequences.insert(newSeq);
-            NS_ASSERT(newIns.second == true);
-            newIns.first->second++;
-        }
-
-        return retval;
+        return AllocateSequence(hdr->GetDestination());
     }
 
     uint16_t
-    RescueArqManager::GetNextSequenceNumber(const RescueMacHeader *hdr) {
+    RescueArqManagerSimple::GetNextSequenceNumber(const RescueMacHeader *hdr) {
         NS_LOG_FUNCTION("");
-        uint16_t retval;
-        std::map<Mac48Address, uint16_t>::iterator it = m_sequences.find(hdr->GetDestination());
-        if (it != m_sequences.end()) {
-            retval = it->second;
-            it->second++;
-        } else {
-            retval = 0;
-            std::pair <Mac48Address, uint16_t> newSeq(hdr->GetDestination(), 0);
-            std::pair < std::map<Mac48Address, uint16_t>::iterator, bool> newIns = m_sequences.insert(newSeq);
-            NS_ASSERT(newIns.second == true);
-            newIns.first->second++;
-        }
-
-        return retval;
+        return AllocateSequence(hdr->GetDestination());
     }
 
     uint16_t
-    RescueArqManager::GetNextSeqNumberByAddress(Mac48Address addr) const {
-        NS_LOG_FUNCTION("");
-        uint16_t seq = 0;
-        std::map <Mac48Address, uint16_t>::const_iterator it = m_sequences.find(addr);
-        if (it != m_sequences.end()) {
-            return it->second;
-        }
-        return seq;
+    RescueArqManagerSimple::GetNextSeqNumberByAddress(Mac48Address dst) const {
+        std::map<Mac48Address, uint16_t>::const_iterator it = m_sequences.find(dst);
+        return (it != m_sequences.end()) ? it->second : 0;
     }
 
     void
-    RescueArqManager::ReportNewDataFrame(Mac48Address dst, uint16_t seq) {
+    RescueArqManagerSimple::ReportNewDataFrame(Mac48Address dst, uint16_t seq) {
+        NS_LOG_FUNCTION("dst:" << dst << "seq:" << seq);
+        SendState &state = m_sendStates[dst];
+        state.ackTimeoutEvent.Cancel();
+        state.seq = seq;
+        state.retryCount = 0;
+        state.pending = true;
+    }
+
+    void
+    RescueArqManagerSimple::ConfigurePhyHeader(RescuePhyHeader *phyHdr) {
         NS_LOG_FUNCTION("");
-        //store info about sended packet
-        SendSeqList::iterator it = m_createdFrames.find(dst);
-        if (it != m_createdFrames.end()) {
-            //found destination
-            SeqList::iterator it2 = dstSeqList(it).seqList.find(seq);
-            if (it2 != dstSeqList(it).seqList.end()) {
-                //found TXed frame with given SEQ - seq. numbers reuse - overwrite
-                seqAck(it2).ACKed = false;
-                seqAck(it2).retryCount = 0;
-            } else {
-                //new SEQ number for given destination
-                std::pair <bool, uint16_t > ACKedRetryCount(false, 0);
-                dstSeqList(it).seqList.insert(std::pair <uint16_t, std::pair <bool, uint16_t> > (seq, ACKedRetryCount));
-            }
-        } else {
-            //new destination
-            SeqList newSeqList;
-            std::pair <bool, uint16_t > ACKedRetryCount(false, 0);
-            newSeqList.insert(std::pair <uint16_t, std::pair <bool, uint16_t> > (seq, ACKedRetryCount));
-            m_createdFrames.insert(std::pair <Mac48Address, SeqList> (dst, newSeqList));
-        }
+        phyHdr->SetSendWindow(0);
+        phyHdr->SetBlockAckDisabled();
+        phyHdr->SetContinousAckDisabled();
     }
 
     void
-    RescueArqManager::ReportDataTx(Ptr<Packet> pkt) {
+    RescueArqManagerSimple::ReportDataTx(Ptr<Packet> pkt) {
         NS_LOG_FUNCTION("");
-        DisableDataTx();
-        NS_LOG_DEBUG("ACK TIMEOUT TIMER START");
-        m_ackTimeoutEvent = Simulator::Schedule(m_basicAckTimeout, &RescueArqManager::AckTimeout, this, pkt);
+        RescueMacHeader hdr;
+        pkt->PeekHeader(hdr);
+
+        SendStateList::iterator it = m_sendStates.find(hdr.GetDestination());
+        if ((it == m_sendStates.end()) || (it->second.seq != hdr.GetSequence()) || !it->second.pending) {
+            NS_LOG_INFO("TX of frame not awaiting acknowledgement, dst: " << hdr.GetDestination() << ", seq: " << hdr.GetSequence());
+            return;
+        }
+
+        NS_LOG_DEBUG("ACK TIMEOUT TIMER START for dst: " << hdr.GetDestination() << ", seq: " << hdr.GetSequence());
+        it->second.ackTimeoutEvent.Cancel();
+        it->second.ackTimeoutEvent = Simulator::Schedule(m_basicAckTimeout, &RescueArqManagerSimple::AckTimeout, this, pkt);
     }
 
     void
-    RescueArqManager::AckTimeout(Ptr<Packet> pkt) {
+    RescueArqManagerSimple::AckTimeout(Ptr<Packet> pkt) {
         NS_LOG_FUNCTION("");
         RescueMacHeader hdr;
         pkt->RemoveHeader(hdr);
+        Mac48Address dst = hdr.GetDestination();
 
-        NS_LOG_INFO("!!! ACK TIMEOUT !!!");
-        //m_state = IDLE;
-        //m_remoteStationManager->ReportDataFailed (hdr.GetDestination ());
-        //m_traceAckTimeout (m_device->GetNode ()->GetId (), m_device->GetIfIndex (), pkt, hdr);
+        NS_LOG_INFO("!!! ACK TIMEOUT !!! for dst: " << dst << ", seq: " << hdr.GetSequence());
 
-        if (NeedDataRetransmission(hdr.GetDestination(), hdr.GetSequence())) {
+        if (NeedDataRetransmission(dst, hdr.GetSequence())) {
             NS_LOG_INFO("RETRANSMISSION");
+            NotifyDataFailed(dst);
+            m_sendStates[dst].retryCount++;
             hdr.SetRetry();
             pkt->AddHeader(hdr);
-            m_mac->EnqueueRetry(pkt, hdr.GetDestination());
-            //SendData ();
+            m_mac->EnqueueRetry(pkt, dst);
         } else {
-            // Retransmission is over the limit. Drop it!
             NS_LOG_INFO("DATA TX FAIL!");
-            EnableDataTx();
-            //m_remoteStationManager->ReportFinalDataFailed (hdr.GetDestination ());
-            //m_traceSendDataDone (m_device->GetNode ()->GetId (), m_device->GetIfIndex (), hdr.GetDestination (), false);
-            //SendDataDone ();
+            SendStateList::iterator it = m_sendStates.find(dst);
+            if ((it != m_sendStates.end()) && (it->second.seq == hdr.GetSequence()) && it->second.pending) {
+                NotifyFinalDataFailed(dst);
+                it->second.pending = false;
+                m_mac->NotifyTxAllowed();
+            }
         }
     }
 
     bool
-    RescueArqManager::NeedDataRetransmission(Mac48Address dst, uint16_t seq) {
-        NS_LOG_FUNCTION("");
-        NS_ASSERT(!dst.IsGroup());
-
-        //search for checked frame
-        SendSeqList::iterator it = m_createdFrames.find(dst);
-        if (it != m_createdFrames.end()) {
-            //found destination
-            SeqList::iterator it2 = dstSeqList(it).seqList.find(seq);
-            if (it2 != dstSeqList(it).seqList.end()) {
-                //found TXed frame with given SEQ - check retry counter
-                NS_LOG_FUNCTION("try: " << seqAck(it2).retryCount);
-                return (seqAck(it2).retryCount < GetMaxRetryCount());
-            } else {
-                //new SEQ number for given destination???
-                NS_ASSERT("frame with given seq. no. was not originated here");
-            }
-        } else {
-            //ACK for other
-            NS_ASSERT("ACK ERROR (acknowledged frame was not originated here)");
+    RescueArqManagerSimple::NeedDataRetransmission(Mac48Address dst, uint16_t seq) {
+        SendStateList::iterator it = m_sendStates.find(dst);
+        return (it != m_sendStates.end())
+                && (it->second.seq == seq)
+                && it->second.pending
+                && (it->second.retryCount < m_maxRetryCount);
+    }
+
+    void
+    RescueArqManagerSimple::RelayingStopAck(Mac48Address dst, uint16_t seq) {
+        SendStateList::iterator it = m_sendStates.find(dst);
+        if ((it != m_sendStates.end()) && (it->second.seq == seq) && it->second.pending) {
+            NS_LOG_INFO("frame " << seq << " to " << dst << " ACKED by successful relaying");
+            it->second.ackTimeoutEvent.Cancel();
+            it->second.pending = false;
         }
-        return false;
     }
 
     int
-    RescueArqManager::ReceiveAck(RescuePhyHeader phyHdr) {
+    RescueArqManagerSimple::ReceiveAck(const RescuePhyHeader *ackHdr) {
         NS_LOG_FUNCTION("");
-        //check - have I recently transmitted frame which is acknowledged?
-        SendSeqList::iterator it = m_createdFrames.find(phyHdr.GetSource());
-        if (it != m_createdFrames.end()) {
-            //found destination
-            SeqList::iterator it2 = dstSeqList(it).seqList.find(phyHdr.GetSequence());
-            if (it2 != dstSeqList(it).seqList.end()) {
-                //found TXed frame with given SEQ - notify frame ACK
-                if (!seqAck(it2).ACKed) {
-                    NS_LOG_INFO("GOT ACK - DATA TX OK!");
-                    seqAck(it2).ACKed = true;
-                    EnableDataTx();
-                    m_ackTimeoutEvent.Cancel();
-                    //m_traceSendDataDone (m_device->GetNode ()->GetId (), m_device->GetIfIndex (), phyHdr.GetSource (), true);
-                    return (int) seqAck(it2).retryCount;
-                } else
-                    NS_LOG_INFO("DUPLICATED ACK");
-            } else {
-                //new SEQ number for given destination???
-                NS_LOG_INFO("ACK ERROR (frame with given seq. no. was not originated here)");
-            }
-        } else {
-            //ACK for other
+        SendStateList::iterator it = m_sendStates.find(ackHdr->GetSource());
+        if (it == m_sendStates.end()) {
             NS_LOG_INFO("ACK ERROR (acknowledged frame was not originated here)");
+            return -1;
+        }
+        if ((it->second.seq != ackHdr->GetSequence()) || !it->second.pending) {
+            NS_LOG_INFO("DUPLICATED ACK (or corrupted)");
+            return -1;
+        }
+        if (!ackHdr->IsACK()) {
+            NS_LOG_INFO("BASIC NACK for src: " << ackHdr->GetSource() << ", seq: " << ackHdr->GetSequence());
+            return -1;
         }
-        return -1;
-    }
 
-    uint16_t
-    RescueArqManager::CheckRxSequenceFor(Mac48Address src) {
-        NS_LOG_FUNCTION("");
-        RecvSeqList::iterator it = m_receivedFrames.find(src);
-        if (it != m_receivedFrames.end())
-            return srcSeq(it).seq;
-        else
-            return 0;
+        NS_LOG_INFO("GOT ACK - DATA TX OK! for dst: " << ackHdr->GetSource() << ", seq: " << ackHdr->GetSequence());
+        it->second.ackTimeoutEvent.Cancel();
+        it->second.pending = false;
+        return (int) it->second.retryCount;
     }
 
     bool
-    RescueArqManager::CheckRxSequence(Mac48Address src, uint16_t seq) {
-        NS_LOG_FUNCTION("");
+    RescueArqManagerSimple::IsRetryACKed(const RescueMacHeader *hdr) {
+        SendStateList::iterator it = m_sendStates.find(hdr->GetDestination());
+        return (it != m_sendStates.end())
+                && ((it->second.seq != hdr->GetSequence()) || !it->second.pending);
+    }
 
-        RecvSeqList::iterator it = m_receivedFrames.find(src);
-        if (it != m_receivedFrames.end()) {
-            //found source
-            if ((seq < 100) && (srcSeq(it).seq >= (65435))) //65535 - 100
-            {
-                //reuse seq. numbers
-                NS_LOG_INFO("NEW - reuse seq. numbers");
-                return true;
-            } else if (seq > srcSeq(it).seq) {
-                //new seq. number
-                NS_LOG_INFO("NEW - new seq. number");
-                return true;
-            } else {
-                //old seq. number (duplicate or reorder)
-                NS_LOG_INFO("OLD - old seq. number (duplicate or reorder)");
-                return false;
-            }
-        } else {
-            //new source
-            NS_LOG_INFO("NEW - new source");
-            return true;
-        }
-        return true;
+
+    // ---------------------- Receiver Functions ----------------------------
+
+    bool
+    RescueArqManagerSimple::CheckRxSequence(Mac48Address src, uint16_t seq, bool useContinousACK) {
+        std::map<Mac48Address, uint16_t>::iterator it = m_lastRxSeq.find(src);
+        return (it == m_lastRxSeq.end()) || SeqComp(seq, it->second);
     }
 
     bool
-    RescueArqManager::CheckRxFrame(Mac48Address src, uint16_t seq) {
+    RescueArqManagerSimple::CheckRxFrame(const RescuePhyHeader *phyHdr, RescuePhyHeader *ackHdr) {
         NS_LOG_FUNCTION("");
-
-        bool isNewSequence = false;
-        RecvSeqList::iterator it = m_receivedFrames.find(src);
-        if (it != m_receivedFrames.end()) {
-            //found source
-            if ((seq < 100) && (srcSeq(it).seq >= (65435))) //65535 - 100
-            {
-                //reuse seq. numbers
-                NS_LOG_INFO("reuse seq. numbers");
-                srcSeq(it).seq = seq;
-                isNewSequence = true;
-            } else if (seq > srcSeq(it).seq) {
-                //new seq. number
-                NS_LOG_INFO("new seq. number");
-                srcSeq(it).seq = seq;
-                isNewSequence = true;
-            } else {
-                //old seq. number (duplicate or reorder)
-                NS_LOG_INFO("old seq. number (duplicate or reorder)");
-                isNewSequence = false;
-            }
-        } else {
-            //new source
-            NS_LOG_INFO("new source");
-            m_receivedFrames.insert(std::pair<Mac48Address, uint16_t> (src, seq));
-            isNewSequence = true;
-        }
+        Mac48Address src = phyHdr->GetSource();
+        uint16_t seq = phyHdr->GetSequence();
+
+        bool isNewSequence = CheckRxSequence(src, seq, false);
+        if (isNewSequence)
+            m_lastRxSeq[src] = seq;
+        NS_LOG_INFO("SEQ: " << seq << " from: " << src << (isNewSequence ? " NEW" : " OLD"));
+
+        //ACK new frames and retransmissions of the last frame (previous ACK could be lost)
+        if (isNewSequence || (phyHdr->IsRetry() && (m_lastRxSeq[src] == seq))) {
+            ackHdr->SetSource(phyHdr->GetDestination());
+            ackHdr->SetDestination(src);
+            ackHdr->SetSequence(seq);
+            ackHdr->SetACK();
+            ackHdr->SetBlockAckDisabled();
+            ackHdr->SetContinousAckDisabled();
+            ackHdr->SetNACKedFrames(0);
+        } else
+            ackHdr->SetDestination("00:00:00:00:00:00");
 
         return isNewSequence;
     }
 
-    bool
-    RescueArqManager::CheckRxFrame(Mac48Address src, uint16_t seq, RescuePhyHeader *ackHdr) {
+    void
+    RescueArqManagerSimple::ReportDamagedFrame(const RescuePhyHeader *phyHdr) {
+        //no NACKs in stop-and-wait operation
+    }
+
+    void
+    RescueArqManagerSimple::ReportDataRx(Ptr<const Packet> pkt, const RescuePhyHeader *phyHdr, bool coded) {
+        //no payloads are kept as lost frames are retransmitted uncoded
+        if (coded)
+            NS_LOG_INFO("CODED frame received, but coded retransmissions are not supported - DROP!");
+    }
+
+
+    // ---------------------- Relay Functions ----------------------------
+
+    std::pair<RelayBehavior, RescuePhyHeader>
+    RescueArqManagerSimple::ReportRelayFrameRx(const RescuePhyHeader *phyHdr, double ber) {
         NS_LOG_FUNCTION("");
+        FwdStateList::iterator it = m_fwdStates.find(std::make_pair(phyHdr->GetSource(), phyHdr->GetDestination()));
+        if ((it != m_fwdStates.end()) && it->second.ACKed && (it->second.ACKedSeq == phyHdr->GetSequence())) {
+            //frame was already ACKed - drop this copy
+            return std::pair<RelayBehavior, RescuePhyHeader> (DROP, RescuePhyHeader(RESCUE_PHY_PKT_TYPE_E2E_ACK));
+        }
+        if ((it != m_fwdStates.end()) && it->second.TXed && !SeqComp(phyHdr->GetSequence(), it->second.TXedSeq) && !phyHdr->IsRetry()) {
+            //copy of already transmitted frame
+            return std::pair<RelayBehavior, RescuePhyHeader> (DROP, RescuePhyHeader(RESCUE_PHY_PKT_TYPE_E2E_ACK));
+        }
+        //queued copies of the same frame are merged by lower MAC
+        return std::pair<RelayBehavior, RescuePhyHeader> (FORWARD, RescuePhyHeader(RESCUE_PHY_PKT_TYPE_E2E_ACK));
+    }
 
-        bool isNewSequence = CheckRxFrame(src, seq);
+    bool
+    RescueArqManagerSimple::ReportAckToFwd(const RescuePhyHeader *ackHdr) {
+        NS_LOG_FUNCTION("");
+        //ACK is sent by the destination of the data flow
+        FwdStateList::iterator it = m_fwdStates.find(std::make_pair(ackHdr->GetDestination(), ackHdr->GetSource()));
+        if (it == m_fwdStates.end() || !ackHdr->IsACK())
+            return false;
+        if (it->second.ACKed && (it->second.ACKedSeq == ackHdr->GetSequence()))
+            return false;
+        it->second.ACKedSeq = ackHdr->GetSequence();
+        it->second.ACKed = true;
+        return true;
+    }
 
-        bool txACK = isNewSequence;
+    bool
+    RescueArqManagerSimple::IsFwdACKed(const RescuePhyHeader *phyHdr) {
+        FwdStateList::iterator it = m_fwdStates.find(std::make_pair(phyHdr->GetSource(), phyHdr->GetDestination()));
+        return (it != m_fwdStates.end()) && it->second.ACKed && (it->second.ACKedSeq == phyHdr->GetSequence());
+    }
 
-        if (txACK) {
-            ackHdr->SetSequence(seq);
-        } else {
-            ackHdr->SetDestination("00:00:00:00:00:00");
+    void
+    RescueArqManagerSimple::ReportRelayDataTx(const RescuePhyHeader *phyHdr) {
+        FwdState &state = m_fwdStates[std::make_pair(phyHdr->GetSource(), phyHdr->GetDestination())];
+        if (!state.TXed || SeqComp(phyHdr->GetSequence(), state.TXedSeq)) {
+            state.TXedSeq = phyHdr->GetSequence();
+            state.TXed = true;
         }
+    }
 
-        return isNewSequence;
+    Time
+    RescueArqManagerSimple::GetTimeoutFor(const RescuePhyHeader *ackHdr) {
+        return m_basicAckTimeout;
+    }
+
+    bool
+    RescueArqManagerSimple::IsHopAckEnabled(void) const {
+        //stop-and-wait operation relies on end-to-end ACKs only
+        return false;
     }
 
 } // namespace ns3
@@ -18,240 +18,101 @@
  * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
  */
 
-#ifndef RESCUE_ARQ_MANAGER_H
-#define RESCUE_ARQ_MANAGER_H
+#ifndef RESCUE_ARQ_MANAGER_SIMPLE_H
+#define RESCUE_ARQ_MANAGER_SIMPLE_H
 
 #include "ns3/mac48-address.h"
-#include "ns3/traced-callback.h"
-#include "ns3/packet.h"
 #include "ns3/event-id.h"
 
-#include "rescue-phy-header.h"
-#include "rescue-mac-header.h"
+#include "rescue-arq-manager.h"
 
 #include <stdint.h>
 #include <map>
 
 namespace ns3 {
 
-    class RescueMac;
-
     /**
      * \ingroup rescue
      *
-     * Handles advanced ARQ functions
+     * Simple (stop-and-wait) ARQ strategy: a single unacknowledged frame per destination,
+     * basic end-to-end ACK / retransmission after Basic ACK Timeout, duplicates are detected
+     * with the last sequence number received from each source. Only per-flow state is kept.
      */
-    class RescueArqManager : public Object {
+    class RescueArqManagerSimple : public RescueArqManager {
     public:
         static TypeId GetTypeId(void);
 
-        RescueArqManager();
-        ~RescueArqManager();
-
-        /**
-         * \param phy the MAC of this device
-         */
-        void SetupMac(Ptr<RescueMac> mac);
-        /**
-         * \param duration the Basic ACK Timeout duration
-         */
-        void SetBasicAckTimeout(Time duration);
-
-        /**
-         * \return duration the Basic ACK Timeout duration
-         */
-        Time GetBasicAckTimeout(void) const;
-        /**
-         * \return the maximum retry count
-         */
-        uint16_t GetMaxRetryCount(void) const;
-        /**
-         * \param maxRetryCount the maximum retry count
-         */
-        void SetMaxRetryCount(uint16_t maxRetryCount);
-        /**
-         * \return true if ARQ allows for next data transmission
-         */
-        bool IsTxAllowed();
-
-        /**
-         * sets next data transmission enabled
-         */
-        void EnableDataTx();
-        /**
-         * sets next data transmission disabled
-         */
-        void DisableDataTx();
-
-        /**
-         * Return the next sequence number for the given header.
-         *
-         * \param hdr rescue PHY header
-         * \return the next sequence number
-         */
-        uint16_t GetNextSequenceNumber(const RescuePhyHeader *hdr);
-        /**
-         * Return the next sequence number for the given header.
-         *
-         * \param hdr rescue MAC header
-         * \return the next sequence number
-         */
-        uint16_t GetNextSequenceNumber(const RescueMacHeader *hdr);
-        /**
-         * Return the next sequence number for the given destination.
-         *
-         * \param addr destination address
-         * \return the next sequence number
-         */
-        uint16_t GetNextSeqNumberByAddress(Mac48Address addr) const;
-
-        /**
-         * Used to store info about sended packet
-         *
-         * \param dst destination address
-         * \param seq sequence number of the frame
-         */
-        void ReportNewDataFrame(Mac48Address dst, uint16_t seq);
-
-        /**
-         * Used to inform about data frame tx (new or retry)
-         *
-         * \param pkt transmitted packet
-         */
-        void ReportDataTx(Ptr<Packet> pkt);
-
-        /**
-         * Used to process ACK frame
-         *
-         * \param phyHdr header of the ACK frame (in fact whole frame)
-         * \return the retry counter value or -1 in case of unsuccessful ACK reception
-         *         (duplicated ACK etc.)
-         */
-        int ReceiveAck(RescuePhyHeader phyHdr);
-
-        /**
-         * invoked when ACK Timoeut counter expires
-         *
-         * \param pkt packet for which the timeout has expired (including header)
-         */
-        void AckTimeout(Ptr<Packet> pkt);
-
-        /**
-         * \param address remote address
-         * \param packet the packet to send
-         * \return true if we want to resend a packet
-         *          after a failed transmission attempt, false otherwise.
-         */
-        bool NeedDataRetransmission(Mac48Address dst, uint16_t seq);
-
-        /**
-         * used to check recent sequence number from given source
-         *
-         * \param src address of frame originator
-         * \return sequence number of recently received frame
-         */
-        uint16_t CheckRxSequenceFor(Mac48Address src);
-
-        /**
-         * used to check sequence number of incoming frame to prevent
-         * unnecessary frame copies reception
-         *
-         * \param addr address of frame originator
-         * \param seq sequence number of a given frame
-         * \return false if frame is duplicated
-         */
-        bool CheckRxSequence(Mac48Address src, uint16_t seq);
-
-        /**
-         * used to notify and check sequence number of incoming frame
-         * to prevent duplicated frame reception
-         *
-         * \param addr address of frame originator
-         * \param seq sequence number of a given frame
-         * \return false if frame is duplicated
-         */
-        bool CheckRxFrame(Mac48Address src, uint16_t seq);
-
-        /**
-         * used to check sequence number of incoming frame to prevent
-         * duplicated frame reception
-         *
-         * \param addr address of frame originator
-         * \param seq sequence number of a given frame
-         * \param ackHdr ack header to configure in case of ACK transmission after this packet reception
-         * \return false if frame is duplicated
-         */
-        bool CheckRxFrame(Mac48Address src, uint16_t seq, RescuePhyHeader *ackHdr);
+        RescueArqManagerSimple();
+        virtual ~RescueArqManagerSimple();
+
+        virtual bool IsTxAllowed(Mac48Address dst);
+        virtual uint16_t GetTxAllowance(Mac48Address dst);
+        virtual uint16_t GetNextSequenceNumber(const RescuePhyHeader *hdr);
+        virtual uint16_t GetNextSequenceNumber(const RescueMacHeader *hdr);
+        virtual uint16_t GetNextSeqNumberByAddress(Mac48Address dst) const;
+        virtual void ReportNewDataFrame(Mac48Address dst, uint16_t seq);
+        virtual void ConfigurePhyHeader(RescuePhyHeader *phyHdr);
+        virtual void ReportDataTx(Ptr<Packet> pkt);
+        virtual int ReceiveAck(const RescuePhyHeader *ackHdr);
+        virtual void AckTimeout(Ptr<Packet> pkt);
+        virtual bool NeedDataRetransmission(Mac48Address dst, uint16_t seq);
+        virtual void RelayingStopAck(Mac48Address dst, uint16_t seq);
+        virtual bool CheckRxSequence(Mac48Address src, uint16_t seq, bool useContinousACK);
+        virtual bool CheckRxFrame(const RescuePhyHeader *phyHdr, RescuePhyHeader *ackHdr);
+        virtual void ReportDamagedFrame(const RescuePhyHeader *phyHdr);
+        virtual void ReportDataRx(Ptr<const Packet> pkt, const RescuePhyHeader *phyHdr, bool coded);
+        virtual std::pair<RelayBehavior, RescuePhyHeader> ReportRelayFrameRx(const RescuePhyHeader *phyHdr, double ber);
+        virtual bool ReportAckToFwd(const RescuePhyHeader *ackHdr);
+        virtual bool IsRetryACKed(const RescueMacHeader *hdr);
+        virtual bool IsFwdACKed(const RescuePhyHeader *phyHdr);
+        virtual void ReportRelayDataTx(const RescuePhyHeader *phyHdr);
+        virtual Time GetTimeoutFor(const RescuePhyHeader *ackHdr);
+        virtual bool IsHopAckEnabled(void) const;
 
     protected:
         void DoDispose(void);
 
     private:
-        std::map <Mac48Address, uint16_t> m_sequences;
-
-        bool m_txAllowed; //!< Allowance for next data frame transmission
-        Time m_basicAckTimeout; //!< The maximal duration of ACK awaiting
-        uint16_t m_maxRetryCount; //!< Maximum Retry Count
-
-        Ptr<RescueMac> m_mac; //!< Pointer to associated RescueMac
-
-        EventId m_ackTimeoutEvent; //!< End-to-end ACK timeout event
+        /**
+         * \param dst the destination address
+         * \return the next sequence number for given destination
+         */
+        uint16_t AllocateSequence(Mac48Address dst);
 
         /*
-         * List to keep information about transmitted frames
+         * State of the frame awaiting acknowledgement (one per destination)
          */
-        typedef std::map<uint16_t, std::pair<bool, uint16_t> > SeqList;
+        struct SendState {
+            uint16_t seq; //!< Sequence number of the frame
+            uint16_t retryCount; //!< Retry counter of the frame
+            bool pending; //!< True while the frame awaits acknowledgement
+            EventId ackTimeoutEvent; //!< End-to-end ACK timeout event
 
-        struct seqAck {
-
-            seqAck(SeqList::iterator& it)
-            : seq(it->first),
-            ACKed(it->second.first),
-            retryCount(it->second.second) {
+            SendState() : seq(0), retryCount(0), pending(false) {
             }
-            const uint16_t& seq;
-            bool& ACKed;
-            uint16_t& retryCount;
         };
-        typedef std::map<Mac48Address, SeqList> SendSeqList;
-
-        struct dstSeqList {
-
-            dstSeqList(SendSeqList::iterator& it)
-            : dst(it->first),
-            seqList(it->second) {
-            }
-            const Mac48Address& dst;
-            SeqList& seqList;
-        };
-        SendSeqList m_createdFrames; //!< List of originated frames
+        typedef std::map<Mac48Address, SendState> SendStateList;
 
         /*
-         * List to keep information about transmitted frames in order to eliminate duplicates
+         * State of relayed flow (source, destination)
          */
-        typedef std::map<Mac48Address, uint16_t> RecvSeqList;
-
-        struct srcSeq {
+        struct FwdState {
+            uint16_t TXedSeq; //!< Sequence number of the last transmitted frame copy
+            bool TXed; //!< True if any frame copy was transmitted
+            uint16_t ACKedSeq; //!< Sequence number of the last forwarded ACK
+            bool ACKed; //!< True if any ACK was forwarded
 
-            srcSeq(RecvSeqList::iterator& it)
-            : src(it->first), seq(it->second) {
+            FwdState() : TXedSeq(0), TXed(false), ACKedSeq(0), ACKed(false) {
             }
-            const Mac48Address& src;
-            uint16_t& seq;
         };
-        RecvSeqList m_receivedFrames; //!< List of received frames seq. numbers - to eliminate duplicates
+        typedef std::map<std::pair<Mac48Address, Mac48Address>, FwdState> FwdStateList;
 
-        /**
-         * The trace source fired when the transmission of a single data packet has failed
-         */
-        TracedCallback<Mac48Address> m_macTxDataFailed;
-        /**
-         * The trace source fired when the transmission of a data packet has
-         * exceeded the maximum number of attempts
-         */
-        TracedCallback<Mac48Address> m_macTxFinalDataFailed;
+        std::map<Mac48Address, uint16_t> m_sequences; //!< Next sequence numbers of destinations
+        SendStateList m_sendStates; //!< Frames awaiting acknowledgement
+        std::map<Mac48Address, uint16_t> m_lastRxSeq; //!< Last sequence numbers received from sources
+        FwdStateList m_fwdStates; //!< State of relayed flows
     };
 
 } // namespace ns3
 
-#endif /* RESCUE_ARQ_MANAGER_H */
+#endif /* RESCUE_ARQ_MANAGER_SIMPLE_H */
@@ -26,17 +26,25 @@
 #include "ns3/nstime.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include "ns3/make-event.h"
+#include "ns3/simulator.h"
 
 #include "rescue-arq-manager.h"
 #include "rescue-mac.h"
 #include "rescue-mac-header.h"
+#include "rescue-mac-trailer.h"
+#include "rescue-remote-station-manager.h"
 
 #include "rescue-utils.h"
 
 #include <algorithm>
+#include <functional>
 
 NS_LOG_COMPONENT_DEFINE("RescueArqManager");
 
+//the maximal reception time delta (microseconds) before the base is moved forward
+#define RX_TIME_DELTA_MAX 0xffffffffLL
+
 #undef NS_LOG_APPEND_CONTEXT
 //#define NS_LOG_APPEND_CONTEXT if (m_mac != 0) { std::clog << "[time=" << ns3::Simulator::Now () << "] [addr=" << m_mac->GetAddress () << "] [ARQ] "; }
 #define NS_LOG_APPEND_CONTEXT std::clog << "[time=" << ns3::Simulator::Now().GetMicroSeconds() << "] [addr=" << ((m_mac != 0) ? compressMac(m_mac->GetAddress ()) : 0) << "] [ARQ] "
@@ -82,6 +90,12 @@ namespace ns3 {
                 BooleanValue(false),
                 MakeBooleanAccessor(&RescueArqManager::m_useBlockACK),
                 MakeBooleanChecker())
+                .AddAttribute("BlockAckSize",
+                "The maximal number of frames acknowledged by selective block ACK field "
+                "(the length used for given flow is adjusted to the span of frames awaiting acknowledgement)",
+                UintegerValue(MAX_BLOCK_ACK_SIZE),
+                MakeUintegerAccessor(&RescueArqManager::m_blockAckSize),
+                MakeUintegerChecker<uint16_t> (DEFAULT_BLOCK_ACK_SIZE, MAX_BLOCK_ACK_SIZE))
                 .AddAttribute("BlockAckTimeout",
                 "Bock ACK timeout",
                 TimeValue(MicroSeconds(15000)),
@@ -95,6 +109,107 @@ namespace ns3 {
                 BooleanValue(false),
                 MakeBooleanAccessor(&RescueArqManager::m_useContinousACK),
                 MakeBooleanChecker())
+                .AddAttribute("UseCodedRetransmission", "If true, frames lost in the send window are retransmitted "
+                "as network-coded (XOR) combinations, which can be decoded by the destination",
+                BooleanValue(false),
+                MakeBooleanAccessor(&RescueArqManager::m_codedRetransmission),
+                MakeBooleanChecker())
+                .AddAttribute("CodingRedundancy",
+                "The number of random combinations sent in addition to the combination of all lost frames "
+                "(limited by the number of lost frames)",
+                UintegerValue(1),
+                MakeUintegerAccessor(&RescueArqManager::m_codingRedundancy),
+                MakeUintegerChecker<uint8_t> ())
+                .AddAttribute("CodingDelay",
+                "The time of collecting ACK timeouts of a destination before coded retransmission",
+                TimeValue(MicroSeconds(0)),
+                MakeTimeAccessor(&RescueArqManager::m_codingDelay),
+                MakeTimeChecker())
+                .AddAttribute("UseHopAck", "If true, each hop of DATA frame is acknowledged with PART ACK "
+                "and unacknowledged hops are retransmitted locally (end-to-end ACK only confirms delivery)",
+                BooleanValue(false),
+                MakeBooleanAccessor(&RescueArqManager::m_useHopAck),
+                MakeBooleanChecker())
+                .AddAttribute("HopAckTimeout",
+                "PART ACK awaiting time",
+                TimeValue(MicroSeconds(2000)),
+                MakeTimeAccessor(&RescueArqManager::m_hopAckTimeout),
+                MakeTimeChecker())
+                .AddAttribute("MaxHopRetryCount", "The maximum number of local retransmissions of a single hop "
+                "(afterwards the frame is left to end-to-end ARQ)",
+                UintegerValue(3),
+                MakeUintegerAccessor(&RescueArqManager::m_maxHopRetryCount),
+                MakeUintegerChecker<uint8_t> ())
+                .AddAttribute("AdaptiveAckTimeout", "If true, ACK timeout of each destination is estimated from "
+                "round trip times of its frames (LongAckTimeout is used until the first estimation)",
+                BooleanValue(false),
+                MakeBooleanAccessor(&RescueArqManager::m_adaptiveAckTimeout),
+                MakeBooleanChecker())
+                .AddAttribute("MinAckTimeout",
+                "The lower bound of estimated ACK timeout",
+                TimeValue(MicroSeconds(1000)),
+                MakeTimeAccessor(&RescueArqManager::m_minAckTimeout),
+                MakeTimeChecker())
+                .AddAttribute("MaxAckTimeout",
+                "The upper bound of estimated ACK timeout (including backoff)",
+                TimeValue(MicroSeconds(60000)),
+                MakeTimeAccessor(&RescueArqManager::m_maxAckTimeout),
+                MakeTimeChecker())
+                .AddAttribute("StatsInterval",
+                "The period of ARQ state sampling reported by ArqStats trace source (0 - disabled)",
+                TimeValue(Seconds(0)),
+                MakeTimeAccessor(&RescueArqManager::m_statsInterval),
+                MakeTimeChecker())
+                .AddAttribute("TrackedDestinations", "The number of destinations of originated frames",
+                TypeId::ATTR_GET,
+                UintegerValue(0),
+                MakeUintegerAccessor(&RescueArqManager::GetTrackedDestinations),
+                MakeUintegerChecker<uint32_t> ())
+                .AddAttribute("TrackedSources", "The number of sources of received frames",
+                TypeId::ATTR_GET,
+                UintegerValue(0),
+                MakeUintegerAccessor(&RescueArqManager::GetTrackedSources),
+                MakeUintegerChecker<uint32_t> ())
+                .AddAttribute("TrackedRelayedFlows", "The number of relayed (source, destination) flows",
+                TypeId::ATTR_GET,
+                UintegerValue(0),
+                MakeUintegerAccessor(&RescueArqManager::GetTrackedRelayedFlows),
+                MakeUintegerChecker<uint32_t> ())
+                .AddAttribute("OutstandingFrames", "The number of originated frames awaiting acknowledgement",
+                TypeId::ATTR_GET,
+                UintegerValue(0),
+                MakeUintegerAccessor(&RescueArqManager::GetOutstandingFrames),
+                MakeUintegerChecker<uint32_t> ())
+                .AddAttribute("MemoryUsage", "The approximate number of bytes used by ARQ state (without frame buffers)",
+                TypeId::ATTR_GET,
+                UintegerValue(0),
+                MakeUintegerAccessor(&RescueArqManager::GetMemoryUsage),
+                MakeUintegerChecker<uint32_t> ())
+                .AddAttribute("Retransmissions", "The number of end-to-end retransmissions",
+                TypeId::ATTR_GET,
+                UintegerValue(0),
+                MakeUintegerAccessor(&RescueArqManager::GetRetransmissions),
+                MakeUintegerChecker<uint64_t> ())
+                .AddAttribute("HopRetransmissions", "The number of local (hop) retransmissions",
+                TypeId::ATTR_GET,
+                UintegerValue(0),
+                MakeUintegerAccessor(&RescueArqManager::GetHopRetransmissions),
+                MakeUintegerChecker<uint64_t> ())
+                .AddAttribute("TimersArmed", "The number of armed ARQ timeouts",
+                TypeId::ATTR_GET,
+                UintegerValue(0),
+                MakeUintegerAccessor(&RescueArqManager::GetTimersArmed),
+                MakeUintegerChecker<uint64_t> ())
+                .AddAttribute("TimersCancelled", "The number of ARQ timeouts cancelled before expiry",
+                TypeId::ATTR_GET,
+                UintegerValue(0),
+                MakeUintegerAccessor(&RescueArqManager::GetTimersCancelled),
+                MakeUintegerChecker<uint64_t> ())
+                .AddAttribute("SeqRecycles", "The number of recycling events of a half of sequence space",
+                TypeId::ATTR_GET,
+                UintegerValue(0),
+                MakeUintegerAccessor(&RescueArqManager::GetSeqRecycles),
+                MakeUintegerChecker<uint64_t> ())
 
                 .AddTraceSource("MacTxDataFailed",
                 "The transmission of a data packet by the MAC layer has failed",
@@ -102,13 +217,23 @@ namespace ns3 {
                 .AddTraceSource("MacTxFinalDataFailed",
                 "The transmission of a data packet has exceeded the maximum number of attempts",
                 MakeTraceSourceAccessor(&RescueArqManager::m_macTxFinalDataFailed))
+                .AddTraceSource("AckTimeoutEstimate",
+                "The ACK timeout estimation of a destination has changed (destination, smoothed RTT, ACK timeout)",
+                MakeTraceSourceAccessor(&RescueArqManager::m_ackTimeoutEstimate))
+                .AddTraceSource("ArqStats",
+                "The snapshot of ARQ state size and activity, sampled every StatsInterval",
+                MakeTraceSourceAccessor(&RescueArqManager::m_statsTrace))
                 ;
         return tid;
     }
 
     RescueArqManager::RescueArqManager()
-    : m_txAllowed(true) {
+    : m_txAllowed(true),
+    m_retransmissions(0),
+    m_hopRetransmissions(0),
+    m_seqRecycles(0) {
         NS_LOG_FUNCTION("");
+        m_codingRandom = CreateObject<UniformRandomVariable> ();
     }
 
     RescueArqManager::~RescueArqManager() {
@@ -119,18 +244,9 @@ namespace ns3 {
     RescueArqManager::DoDispose() {
         NS_LOG_FUNCTION("");
 
-        for (TimersList::iterator it = m_ackTimeoutTimers.begin(); it != m_ackTimeoutTimers.end(); ++it) {
-            if (it->second.IsRunning())
-                it->second.Cancel();
-        }
-        for (TimersList::iterator it = m_nackTimeoutTimers.begin(); it != m_nackTimeoutTimers.end(); ++it) {
-            if (it->second.IsRunning())
-                it->second.Cancel();
-        }
-        for (TimersList::iterator it = m_blockAckTimeoutTimers.begin(); it != m_blockAckTimeoutTimers.end(); ++it) {
-            if (it->second.IsRunning())
-                it->second.Cancel();
-        }
+        m_statsEvent.Cancel();
+        m_timers.CancelAll();
+        m_hopFrames.clear();
     }
 
 
@@ -140,6 +256,8 @@ namespace ns3 {
     void
     RescueArqManager::SetupMac(Ptr<RescueMac> mac) {
         m_mac = mac;
+        if (m_statsInterval > Seconds(0) && !m_statsEvent.IsRunning())
+            m_statsEvent = Simulator::Schedule(m_statsInterval, &RescueArqManager::SampleStats, this);
     }
 
     void
@@ -198,6 +316,21 @@ namespace ns3 {
             return true;
     }
 
+    uint16_t
+    RescueArqManager::GetTxAllowance(Mac48Address dst) {
+        SendSeqList::iterator it = m_createdFrames.find(dst);
+        if (it == m_createdFrames.end())
+            return m_sendWindow;
+
+        uint16_t allowance = (it->second.unACKedFrames < m_sendWindow) ? m_sendWindow - it->second.unACKedFrames : 0;
+        if (m_useContinousACK) {
+            uint16_t contAllowance = (it->second.contACKed + MAX_WINDOW_SIZE > it->second.nextSequence) ?
+                    it->second.contACKed + MAX_WINDOW_SIZE - it->second.nextSequence : 0;
+            allowance = std::min(allowance, contAllowance);
+        }
+        return allowance;
+    }
+
     uint16_t
     RescueArqManager::GetNextSequenceNumber(const RescuePhyHeader *hdr) {
         NS_LOG_FUNCTION("");
@@ -211,23 +344,11 @@ namespace ns3 {
         } else {
             retval = 0;
 
-            //new destination
-            SendList newSendList;
-            for (uint16_t i = 0; i < ARRAY_END; i++) {
-                newSendList.ACKed[i] = false;
-                newSendList.retryCount[i] = 0;
-            }
-            newSendList.ACKed[ARRAY_END] = false;
-            newSendList.retryCount[ARRAY_END] = 0;
-            newSendList.nextSequence = 0;
-            newSendList.unACKedFrames = 0;
-            newSendList.rxedUnACKedFrames = 0;
-            newSendList.contACKed = 0;
-
-            std::pair < SendSeqList::iterator, bool> newIns = m_createdFrames.insert(std::pair <Mac48Address, SendList> (dst, newSendList));
-            NS_ASSERT(newIns.second == true);
+            //new destination (created in place, the sequence window is initially empty)
+            SendList &newSendList = m_createdFrames[dst];
+            InitSendList(newSendList);
 
-            newIns.first->second.nextSequence++;
+            newSendList.nextSequence++;
         }
         NS_LOG_INFO("SET SEQ: " << retval);
         return retval;
@@ -246,23 +367,11 @@ namespace ns3 {
         } else {
             retval = 0;
 
-            //new destination
-            SendList newSendList;
-            for (uint16_t i = 0; i < ARRAY_END; i++) {
-                newSendList.ACKed[i] = false;
-                newSendList.retryCount[i] = 0;
-            }
-            newSendList.ACKed[ARRAY_END] = false;
-            newSendList.retryCount[ARRAY_END] = 0;
-            newSendList.nextSequence = 0;
-            newSendList.unACKedFrames = 0;
-            newSendList.rxedUnACKedFrames = 0;
-            newSendList.contACKed = 0;
-
-            std::pair < SendSeqList::iterator, bool> newIns = m_createdFrames.insert(std::pair <Mac48Address, SendList> (dst, newSendList));
-            NS_ASSERT(newIns.second == true);
+            //new destination (created in place, the sequence window is initially empty)
+            SendList &newSendList = m_createdFrames[dst];
+            InitSendList(newSendList);
 
-            newIns.first->second.nextSequence++;
+            newSendList.nextSequence++;
         }
         NS_LOG_INFO("SET SEQ: " << retval);
         return retval;
@@ -285,16 +394,30 @@ namespace ns3 {
         SendSeqList::iterator it = m_createdFrames.find(dst);
         if (it != m_createdFrames.end()) {
             //found destination
-            it->second.ACKed[seq] = false;
-            it->second.retryCount[seq] = 0;
+            SendSeqState &state = GetSendState(it->second, seq);
+            state.ACKed = false;
+            state.retryCount = 0;
         } else
             NS_ASSERT("SendSeqList record should be already created!");
     }
 
+    RescueArqManager::SendSeqState &
+    RescueArqManager::GetSendState(SendList &list, uint16_t seq) {
+        SendSeqState *old = list.seqState.GetTakenOver(seq);
+        if ((old != 0) && (old->ackTimerPkt != 0)) {
+            //the timer of overwritten frame would fire on the state of given frame
+            NS_LOG_DEBUG("Cancel ACK timeout of frame overwritten by seq: " << seq);
+            m_timers.Cancel(old->ackTimer);
+            old->ackTimer = 0;
+            old->ackTimerPkt = 0;
+        }
+        return list.seqState[seq];
+    }
+
     void
     RescueArqManager::ConfigurePhyHeader(RescuePhyHeader *phyHdr) {
         NS_LOG_FUNCTION("");
-        phyHdr->SetSendWindow(m_sendWindow - 1);
+        phyHdr->SetSendWindow(std::min<uint16_t> (m_sendWindow, 16) - 1); //4-bit field
 
         if (m_useBlockACK) {
             NS_LOG_FUNCTION("BLOCK ACK enabled");
@@ -322,9 +445,9 @@ namespace ns3 {
         pkt->PeekHeader(hdr);
         Mac48Address dst = hdr.GetDestination();
 
+        SendSeqList::iterator it = m_createdFrames.find(dst);
         if (!hdr.IsRetry()) {
             //increase unACKEd frames counter
-            SendSeqList::iterator it = m_createdFrames.find(dst);
             if (it != m_createdFrames.end()) {
                 it->second.unACKedFrames++;
                 NS_LOG_INFO("total number of transmissions to " << dst << " is: " << (int) it->second.unACKedFrames);
@@ -334,16 +457,16 @@ namespace ns3 {
 
         NS_LOG_DEBUG("ACK TIMEOUT TIMER START for dst: " << hdr.GetDestination() << ", seq: " << hdr.GetSequence());
 
-        std::pair <Mac48Address, uint16_t> frameId(hdr.GetDestination(), hdr.GetSequence());
-        std::pair < TimersList::iterator, bool> newIns = m_ackTimeoutTimers.insert(std::pair <std::pair <Mac48Address, uint16_t>, Timer> (frameId, Timer(Timer::CANCEL_ON_DESTROY)));
-
-        if (newIns.first->second.IsRunning())
-            newIns.first->second.Cancel();
-
-        newIns.first->second.SetDelay(m_longAckTimeout);
-        newIns.first->second.SetFunction(&RescueArqManager::AckTimeout, this);
-        newIns.first->second.SetArguments(pkt);
-        newIns.first->second.Schedule();
+        if (it != m_createdFrames.end()) {
+            //ACK timer is kept with the state of the frame
+            SendSeqState &state = GetSendState(it->second, hdr.GetSequence());
+            m_timers.Cancel(state.ackTimer);
+            state.ackTimerPkt = pkt;
+            //retransmitted frames give ambiguous RTT samples (Karn's algorithm)
+            state.txTime = hdr.IsRetry() ? Seconds(0) : Simulator::Now();
+            state.ackTimer = m_timers.Arm(GetAckTimeout(dst), Ptr<EventImpl> (MakeEvent(&RescueArqManager::AckTimeout, this, pkt), false));
+        } else
+            NS_ASSERT("SendSeqList record should be already created!");
     }
 
     void
@@ -357,19 +480,51 @@ namespace ns3 {
 
         if (NeedDataRetransmission(hdr.GetDestination(), hdr.GetSequence())) {
             NS_LOG_INFO("RETRANSMISSION");
+            m_retransmissions++;
+            NotifyDataFailed(hdr.GetDestination());
+            SendSeqList::iterator it = m_createdFrames.find(hdr.GetDestination());
+            if ((it != m_createdFrames.end()) && it->second.seqState.IsStored(hdr.GetSequence())
+                    && (it->second.seqState.Get(hdr.GetSequence()).retryCount < 255))
+                it->second.seqState[hdr.GetSequence()].retryCount++;
             hdr.SetRetry();
+            if (hdr.IsCoded()) {
+                //the lost combination is resent empty (just to deliver its SEQ number),
+                //covered frames are repaired after their own ACK timeouts
+                RescueCodedHeader ncHdr;
+                pkt->PeekHeader(ncHdr);
+                pkt = Create<Packet> (0);
+                pkt->AddHeader(RescueCodedHeader(ncHdr.GetBase(), 0));
+                pkt->AddTrailer(RescueMacTrailer());
+            }
             pkt->AddHeader(hdr);
-            m_mac->EnqueueRetry(pkt, hdr.GetDestination());
+
+            if (m_adaptiveAckTimeout && (it != m_createdFrames.end())
+                    && (Simulator::Now() - it->second.lastBackoff >= it->second.rtt.GetRto())) {
+                //back off once per timeout period, not for every frame lost in the send window
+                it->second.rtt.Backoff();
+                it->second.lastBackoff = Simulator::Now();
+                m_ackTimeoutEstimate(hdr.GetDestination(), it->second.rtt.GetSrtt(), it->second.rtt.GetRto());
+            }
+            if (m_codedRetransmission && !hdr.IsCoded() && (it != m_createdFrames.end())) {
+                //collect lost frames of this destination for coded retransmission
+                it->second.codingSet.push_back(hdr.GetSequence());
+                if (!m_timers.IsRunning(it->second.codingTimer))
+                    it->second.codingTimer = m_timers.Arm(m_codingDelay, Ptr<EventImpl> (MakeEvent(&RescueArqManager::SendCodedRetransmission, this, hdr.GetDestination()), false));
+            } else
+                m_mac->EnqueueRetry(pkt, hdr.GetDestination());
         } else {
             // Retransmission is over the limit. Drop it!
             NS_LOG_INFO("DATA TX FAIL!");
             //EnableDataTx ();
 
             //erase ACK timer
-            std::pair <Mac48Address, uint16_t> frameId(hdr.GetDestination(), hdr.GetSequence());
-            TimersList::iterator it2 = m_ackTimeoutTimers.find(std::pair <Mac48Address, uint16_t> (frameId));
-            if (it2 != m_ackTimeoutTimers.end())
-                m_ackTimeoutTimers.erase(it2);
+            SendSeqList::iterator it2 = m_createdFrames.find(hdr.GetDestination());
+            if ((it2 != m_createdFrames.end()) && it2->second.seqState.IsStored(hdr.GetSequence())) {
+                SendSeqState &state = it2->second.seqState[hdr.GetSequence()];
+                m_timers.Cancel(state.ackTimer);
+                state.ackTimer = 0;
+                state.ackTimerPkt = 0;
+            }
 
             //decrease unACKEd frames counter
             /*SendSeqList::iterator it = m_createdFrames.find (hdr.GetDestination ());
@@ -381,6 +536,138 @@ namespace ns3 {
         }
     }
 
+    void
+    RescueArqManager::ReportDataDrop(Mac48Address dst, uint16_t seq) {
+        NS_LOG_FUNCTION("dst: " << dst << ", seq: " << seq);
+        NotifyFinalDataFailed(dst);
+        RelayingStopAck(dst, seq);
+    }
+
+    void
+    RescueArqManager::NotifyDataFailed(Mac48Address dst) {
+        m_macTxDataFailed(dst);
+        Ptr<RescueRemoteStationManager> manager = m_mac->GetRemoteStationManager();
+        if (manager != 0)
+            manager->ReportDataFailed(dst);
+    }
+
+    void
+    RescueArqManager::NotifyFinalDataFailed(Mac48Address dst) {
+        m_macTxFinalDataFailed(dst);
+        Ptr<RescueRemoteStationManager> manager = m_mac->GetRemoteStationManager();
+        if (manager != 0)
+            manager->ReportFinalDataFailed(dst);
+    }
+
+    /**
+     * \param basis the basis of coding vectors (sorted in descending order)
+     * \param mask the coding vector
+     * \return true if the coding vector is linearly independent of the basis (it is added to the basis)
+     */
+    static bool
+    AddToCodingBasis(std::vector<uint32_t> &basis, uint32_t mask) {
+        for (std::vector<uint32_t>::iterator it = basis.begin(); it != basis.end(); it++)
+            mask = std::min(mask, mask ^ *it);
+        if (mask == 0)
+            return false;
+        basis.push_back(mask);
+        std::sort(basis.begin(), basis.end(), std::greater<uint32_t> ());
+        return true;
+    }
+
+    void
+    RescueArqManager::SendCodedRetransmission(Mac48Address dst) {
+        NS_LOG_FUNCTION("dst: " << dst);
+
+        SendSeqList::iterator it = m_createdFrames.find(dst);
+        if (it == m_createdFrames.end())
+            return;
+
+        //frames still awaiting retransmission
+        std::vector<uint16_t> lost;
+        for (std::vector<uint16_t>::iterator i = it->second.codingSet.begin(); i != it->second.codingSet.end(); i++)
+            if (it->second.seqState.IsStored(*i)
+                    && !it->second.seqState.Get(*i).ACKed
+                    && (it->second.seqState.Get(*i).ackTimerPkt != 0)
+                    && (std::find(lost.begin(), lost.end(), *i) == lost.end()))
+                lost.push_back(*i);
+        it->second.codingSet.clear();
+        if (lost.empty())
+            return;
+
+        //the oldest lost frame starts the coding vector, frames out of its span are resent uncoded
+        uint16_t base = lost.front();
+        for (std::vector<uint16_t>::iterator i = lost.begin(); i != lost.end(); i++)
+            if (SeqComp(base, *i))
+                base = *i;
+
+        std::vector<uint16_t> covered;
+        for (std::vector<uint16_t>::iterator i = lost.begin(); i != lost.end(); i++)
+            if (uint16_t(*i - base) < MAX_CODED_SPAN)
+                covered.push_back(*i);
+        if (covered.size() < 2)
+            covered.clear();
+
+        std::vector<RescueNetworkCoding::Block> blocks;
+        RescueMacHeader hdr;
+        for (std::vector<uint16_t>::iterator i = lost.begin(); i != lost.end(); i++) {
+            SendSeqState &state = GetSendState(it->second, *i);
+            if (std::find(covered.begin(), covered.end(), *i) == covered.end()) {
+                NS_LOG_INFO("UNCODED RETRANSMISSION for dst: " << dst << ", seq: " << *i);
+                m_mac->EnqueueRetry(state.ackTimerPkt, dst);
+                continue;
+            }
+            Ptr<Packet> payload = state.ackTimerPkt->Copy();
+            payload->RemoveHeader(hdr);
+            RescueMacTrailer fcs;
+            payload->RemoveTrailer(fcs);
+            blocks.push_back(RescueNetworkCoding::ToBlock(payload));
+
+            //the frame itself is not retransmitted - restart its ACK timer here
+            m_timers.Cancel(state.ackTimer);
+            state.ackTimer = m_timers.Arm(GetAckTimeout(dst), Ptr<EventImpl> (MakeEvent(&RescueArqManager::AckTimeout, this, state.ackTimerPkt), false));
+        }
+        if (covered.empty())
+            return;
+
+        //XOR of all lost frames repairs any single loss, random combinations repair further losses
+        uint32_t full = 0;
+        for (std::vector<uint16_t>::iterator i = covered.begin(); i != covered.end(); i++)
+            full |= (uint32_t) 1 << uint16_t(*i - base);
+        std::vector<uint32_t> masks;
+        std::vector<uint32_t> basis;
+        masks.push_back(full);
+        AddToCodingBasis(basis, full);
+        uint32_t nCoded = std::min<uint32_t> (covered.size(), 1 + m_codingRedundancy);
+        for (uint32_t attempts = 0; (masks.size() < nCoded) && (attempts < 8 * MAX_CODED_SPAN); attempts++) {
+            uint32_t mask = ((m_codingRandom->GetInteger(0, 0xffff) << 16) | m_codingRandom->GetInteger(0, 0xffff)) & full;
+            if (AddToCodingBasis(basis, mask))
+                masks.push_back(mask);
+        }
+
+        for (std::vector<uint32_t>::iterator m = masks.begin(); m != masks.end(); m++) {
+            RescueNetworkCoding::Block block;
+            for (uint32_t i = 0; i < covered.size(); i++)
+                if (*m & ((uint32_t) 1 << uint16_t(covered[i] - base)))
+                    RescueNetworkCoding::XorBlock(block, blocks[i]);
+
+            Ptr<Packet> pkt = RescueNetworkCoding::ToCodedPayload(block);
+            pkt->AddHeader(RescueCodedHeader(base, *m));
+
+            //coded frame gets its own SEQ number and is sent as retry (no new data for the send window)
+            hdr.SetSequence(GetNextSequenceNumber(&hdr));
+            hdr.SetRetry();
+            hdr.SetCoded();
+            ReportNewDataFrame(dst, hdr.GetSequence());
+            it->second.unACKedFrames++;
+            pkt->AddHeader(hdr);
+            pkt->AddTrailer(RescueMacTrailer());
+
+            NS_LOG_INFO("CODED RETRANSMISSION for dst: " << dst << ", seq: " << hdr.GetSequence() << ", base: " << base << ", mask: " << std::hex << *m << std::dec);
+            m_mac->EnqueueRetry(pkt, dst);
+        }
+    }
+
     bool
     RescueArqManager::NeedDataRetransmission(Mac48Address dst, uint16_t seq) {
         NS_LOG_FUNCTION("");
@@ -391,7 +678,7 @@ namespace ns3 {
         if (it != m_createdFrames.end()) {
             //found destination
             //return (!it->second.ACKed[seq] && ((it->second.retryCount[seq] < GetMaxRetryCount ()) || m_useContinousACK));
-            return (!it->second.ACKed[seq]);
+            return (!it->second.seqState.Get(seq).ACKed);
         } else {
             //ACK for other
             NS_ASSERT("ACK ERROR (acknowledged frame was not originated here)");
@@ -404,16 +691,20 @@ namespace ns3 {
     void RescueArqManager::RelayingStopAck(Mac48Address dst, uint16_t seq) {
 
 
-        TimersList::iterator it = m_ackTimeoutTimers.find(std::pair <Mac48Address, uint16_t> (std::make_pair(dst, seq)));
-        if (it != m_ackTimeoutTimers.end()) {
-            m_ackTimeoutTimers.erase(it);
+        SendSeqList::iterator it2 = m_createdFrames.find(dst);
+        if ((it2 != m_createdFrames.end())
+                && it2->second.seqState.IsStored(seq)
+                && (it2->second.seqState.Get(seq).ackTimerPkt != 0)) {
+            SendSeqState &state = it2->second.seqState[seq];
+            m_timers.Cancel(state.ackTimer);
+            state.ackTimer = 0;
+            state.ackTimerPkt = 0;
             NS_LOG_INFO("\t\t\t\t RETRANSMISSION HAS BEEN CANCELED !!!!!!!!!!!!!!!!!!!!!! :) ");
         } else
             NS_LOG_INFO("\t\t\t\t COULD NOT FIND ACK TIMEOUT EVENT");
 
-        SendSeqList::iterator it2 = m_createdFrames.find(dst);
         if (it2 != m_createdFrames.end()) {
-            if (!it2->second.ACKed[seq]) {
+            if (!it2->second.seqState.Get(seq).ACKed) {
                 NS_LOG_INFO("\t\t\t\t frame " << seq << " from " << dst << " should be ACKED NOW ");
                 AcknowledgeFrame(it2, seq);
             } else
@@ -429,7 +720,7 @@ namespace ns3 {
         uint16_t seq = ackHdr->GetSequence();
 
         int retval = -1;
-        int8_t tempUnACKedFrames = 0;
+        int16_t tempUnACKedFrames = 0;
 
         SendSeqList::iterator it = m_createdFrames.find(src);
         if (it != m_createdFrames.end()) {
@@ -441,7 +732,7 @@ namespace ns3 {
                 //     || ( ((seq - ackHdr->GetContinousAck ()) < MAX_WINDOW_SIZE) && (it->second.contACKed > ARRAY_END - MAX_WINDOW_SIZE) ) )
                 if (!SeqComp(it->second.contACKed, seq - ackHdr->GetContinousAck())) {
                     for (uint16_t i = it->second.contACKed; SeqComp(seq - ackHdr->GetContinousAck() + 1, i); i++)
-                        if (!it->second.ACKed[i]) {
+                        if (!it->second.seqState.Get(i).ACKed) {
                             NS_LOG_INFO("CONTINOUS ACK for src: " << src << ", seq: " << i << " RECEIVED");
                             AcknowledgeFrame(it, i);
                             retval = 0;
@@ -450,20 +741,21 @@ namespace ns3 {
                 }
             } else if (m_useContinousACK && !ackHdr->IsContinousAckEnabled())
                 //first frame not received? - try to unacknowledge it!
-                if (!it->second.ACKed[0])
+                if (!it->second.seqState.Get(0).ACKed)
                     UnacknowledgeFrame(it, 0);
 
             //check Block ACK
             if (m_useBlockACK && ackHdr->IsBlockAckEnabled()) {
+                uint16_t blockSize = ackHdr->GetBlockAckSize();
                 uint16_t start_seq = seq;
                 if (m_useContinousACK && ackHdr->IsContinousAckEnabled())
-                    start_seq = SeqComp(seq - ackHdr->GetContinousAck() + 17, seq) ? seq : seq - ackHdr->GetContinousAck() + 17;
+                    start_seq = SeqComp(seq - ackHdr->GetContinousAck() + blockSize + 1, seq) ? seq : seq - ackHdr->GetContinousAck() + blockSize + 1;
 
-                uint16_t start_i = 15;
+                uint16_t start_i = blockSize - 1;
                 /*if ( ((start_seq - 16) <= it->second.contACKed)
                      && (it->second.contACKed < HALF_OF_ARRAY) )
                   start_i = start_seq - it->second.contACKed;*/
-                if (((start_seq - 16) < 0)
+                if (((start_seq - blockSize) < 0)
                         && (it->second.contACKed < HALF_OF_ARRAY))
                     start_i = start_seq - 1;
 
@@ -473,26 +765,26 @@ namespace ns3 {
                 for (int i = start_i; i >= 0; i--) {
                     uint16_t seq_temp = start_seq - i - 1;
                     NS_LOG_INFO("i: " << i << " BLOCK ACK for src: " << src << ", seq: " << seq_temp << " " << (ackHdr->IsBlockAckFrameReceived(i) ? "RECEIVED" : "MISSED"));
-                    if (!it->second.ACKed[seq_temp]) {
+                    if (!it->second.seqState.Get(seq_temp).ACKed) {
                         if (ackHdr->IsBlockAckFrameReceived(i)) {
                             AcknowledgeFrame(it, seq_temp);
                             retval = 0;
                         } else
                             UnacknowledgeFrame(it, seq_temp);
                     }
-                    if (!ackHdr->IsBlockAckFrameReceived(i))
-                        tempUnACKedFrames++;
                 }
+                tempUnACKedFrames += ackHdr->GetBlockAckMissed(start_i + 1);
             }
 
             //process basic ACK/NACK
             if (!ackHdr->IsACK())
                 tempUnACKedFrames++;
-            if (!it->second.ACKed[seq]) {
+            if (!it->second.seqState.Get(seq).ACKed) {
                 if (ackHdr->IsACK()) {
                     NS_LOG_INFO("BASIC ACK for src: " << src << ", seq: " << seq);
+                    SampleRtt(it, seq);
                     AcknowledgeFrame(it, seq);
-                    retval = (int) it->second.retryCount[seq];
+                    retval = (int) it->second.seqState.Get(seq).retryCount;
                 } else {
                     NS_LOG_INFO("BASIC NACK for src: " << src << ", seq: " << seq);
                     UnacknowledgeFrame(it, seq);
@@ -509,8 +801,8 @@ namespace ns3 {
             uint8_t NewUnACKedFrames = 0;
             if (seq + 1 < it->second.nextSequence)
                 for (uint16_t i = seq + 1; SeqComp(it->second.nextSequence, i); i++) {
-                    NS_LOG_DEBUG("i: " << i << "it->second.ACKed[i]: " << ((it->second.ACKed[i]) ? "YES" : "NO"));
-                    if (!it->second.ACKed[i])
+                    NS_LOG_DEBUG("i: " << i << "it->second.ACKed[i]: " << ((it->second.seqState.Get(i).ACKed) ? "YES" : "NO"));
+                    if (!it->second.seqState.Get(i).ACKed)
                         NewUnACKedFrames++;
                 }
             if ((it->second.unACKedFrames - NewUnACKedFrames) > ackHdr->GetNACKedFrames())
@@ -521,7 +813,8 @@ namespace ns3 {
                     && (m_useContinousACK && ackHdr->IsContinousAckEnabled())) {
                 NS_LOG_DEBUG("tempUnACKedFrames: " << (int) tempUnACKedFrames);
                 if (ackHdr->GetNACKedFrames() > tempUnACKedFrames) {
-                    uint16_t last_block_seq = SeqComp(seq - ackHdr->GetContinousAck() + 17, seq) ? seq : seq - ackHdr->GetContinousAck() + 17;
+                    uint16_t last_block_seq = SeqComp(seq - ackHdr->GetContinousAck() + ackHdr->GetBlockAckSize() + 1, seq) ?
+                            seq : seq - ackHdr->GetContinousAck() + ackHdr->GetBlockAckSize() + 1;
                     NS_LOG_DEBUG("last_block_seq: " << last_block_seq);
                     //some frames were received but not ACKed by this ACK frame
                     it->second.rxedUnACKedFrames = (seq - last_block_seq) - (ackHdr->GetNACKedFrames() - tempUnACKedFrames);
@@ -540,18 +833,18 @@ namespace ns3 {
         NS_LOG_FUNCTION("");
         Mac48Address src = (*it).first;
         NS_LOG_INFO("GOT ACK - DATA TX OK! for dst: " << src << ", seq: " << seq);
-        (*it).second.ACKed[seq] = true;
+        GetSendState((*it).second, seq).ACKed = true;
         //m_traceSendDataDone (m_device->GetNode ()->GetId (), m_device->GetIfIndex (), phyHdr.GetSource (), true);
         //EnableDataTx ();
         //m_ackTimeoutEvent.Cancel ();
 
         //cancel ACK timer
-        std::pair <Mac48Address, uint16_t> frameId(src, seq);
-        TimersList::iterator it2 = m_ackTimeoutTimers.find(std::pair <Mac48Address, uint16_t> (frameId));
-        if (it2 != m_ackTimeoutTimers.end()) {
+        SendSeqState &state = GetSendState((*it).second, seq);
+        if (state.ackTimerPkt != 0) {
             NS_LOG_INFO("CANCEL ACK TIMEOUT COUNTER for dst: " << src << ", seq: " << seq);
-            it2->second.Cancel();
-            m_ackTimeoutTimers.erase(it2);
+            m_timers.Cancel(state.ackTimer);
+            state.ackTimer = 0;
+            state.ackTimerPkt = 0;
         }
 
         /*//cancel NACK timer
@@ -574,6 +867,40 @@ namespace ns3 {
         NS_LOG_INFO("total number of transmissions (unACKedFrames) to " << src << " is: " << (int) (*it).second.unACKedFrames);
     }
 
+    void
+    RescueArqManager::InitSendList(SendList &list) {
+        list.nextSequence = 0;
+        list.unACKedFrames = 0;
+        list.rxedUnACKedFrames = 0;
+        list.contACKed = 0;
+        list.codingTimer = 0;
+        list.rtt.SetInitialRto(m_longAckTimeout);
+        list.rtt.SetBounds(m_minAckTimeout, m_maxAckTimeout);
+        list.lastBackoff = Seconds(0);
+    }
+
+    Time
+    RescueArqManager::GetAckTimeout(Mac48Address dst) const {
+        if (!m_adaptiveAckTimeout)
+            return m_longAckTimeout;
+        SendSeqList::const_iterator it = m_createdFrames.find(dst);
+        if (it != m_createdFrames.end())
+            return it->second.rtt.GetRto();
+        return m_longAckTimeout;
+    }
+
+    void
+    RescueArqManager::SampleRtt(SendSeqList::iterator it, uint16_t seq) {
+        if (!m_adaptiveAckTimeout || !it->second.seqState.IsStored(seq))
+            return;
+        Time txTime = it->second.seqState.Get(seq).txTime;
+        if (txTime == Seconds(0))
+            return;
+        it->second.rtt.Update(Simulator::Now() - txTime);
+        it->second.seqState[seq].txTime = Seconds(0);
+        m_ackTimeoutEstimate(it->first, it->second.rtt.GetSrtt(), it->second.rtt.GetRto());
+    }
+
     void
     RescueArqManager::UnacknowledgeFrame(SendSeqList::iterator it, uint16_t seq) {
         NS_LOG_FUNCTION("");
@@ -581,13 +908,12 @@ namespace ns3 {
         Mac48Address src = (*it).first;
         NS_LOG_INFO("GOT NACK - FORCE ACK TIMEOUT! for src: " << src << ", seq: " << seq);
 
-        std::pair <Mac48Address, uint16_t> frameId(src, seq);
-        TimersList::iterator it2 = m_ackTimeoutTimers.find(std::pair <Mac48Address, uint16_t> (frameId));
-        if (it2 != m_ackTimeoutTimers.end()) {
-            if (it2->second.IsRunning())
-                it2->second.Cancel();
-            it2->second.SetDelay(Seconds(0));
-            it2->second.Schedule();
+        if ((*it).second.seqState.IsStored(seq)
+                && ((*it).second.seqState.Get(seq).ackTimerPkt != 0)) {
+            //force ACK timeout of the frame immediately
+            SendSeqState &state = (*it).second.seqState[seq];
+            m_timers.Cancel(state.ackTimer);
+            state.ackTimer = m_timers.Arm(Seconds(0), Ptr<EventImpl> (MakeEvent(&RescueArqManager::AckTimeout, this, state.ackTimerPkt), false));
 
             NS_LOG_INFO("CANCEL ACK TIMEOUT COUNTER for dst: " << src << ", seq: " << seq);
         } else
@@ -601,7 +927,7 @@ namespace ns3 {
 
         SendSeqList::iterator it = m_createdFrames.find(dst);
         if (it != m_createdFrames.end())
-            return it->second.ACKed[seq];
+            return it->second.seqState.Get(seq).ACKed;
         else
             return false;
     }
@@ -624,24 +950,16 @@ namespace ns3 {
             if (!it->second.seq1stHalfCleaned
                     && (seq > (ARRAY_END - MAX_WINDOW_SIZE))) {
                 //first half of sequence numbers should be reused
-                for (uint16_t i = 0; i <= HALF_OF_ARRAY; i++) {
-                    //std::cout << "seq: " << seq << ", i: " << i << std::endl;
-                    it->second.copyRXed[i] = false;
-                    it->second.RXed[i] = false;
-                    it->second.RXtime[i] = Seconds(0);
-                }
+                it->second.seqState.ForgetRange(0, HALF_OF_ARRAY);
+                m_seqRecycles++;
                 it->second.seq1stHalfCleaned = true;
                 it->second.seq2ndHalfCleaned = false;
             } else if (!it->second.seq2ndHalfCleaned
                     && (seq > (HALF_OF_ARRAY - MAX_WINDOW_SIZE))
                     && (seq <= HALF_OF_ARRAY)) {
                 //second half of sequence numbers should be reused
-                for (uint16_t i = HALF_OF_ARRAY + 1; i > HALF_OF_ARRAY; i++) {
-                    //std::cout << "seq: " << seq << ", i: " << i << std::endl;
-                    it->second.copyRXed[i] = false;
-                    it->second.RXed[i] = false;
-                    it->second.RXtime[i] = Seconds(0);
-                }
+                it->second.seqState.ForgetRange(HALF_OF_ARRAY + 1, ARRAY_END);
+                m_seqRecycles++;
                 it->second.seq1stHalfCleaned = false;
                 it->second.seq2ndHalfCleaned = true;
             }
@@ -651,28 +969,23 @@ namespace ns3 {
             //     || ((seq < MAX_WINDOW_SIZE) && (it->second.maxSeqCopyRXed > ARRAY_END - MAX_WINDOW_SIZE)) )
             if (SeqComp(seq, it->second.maxSeqCopyRXed))
                 it->second.maxSeqCopyRXed = seq;
-            NS_LOG_INFO("SEQ: " << (it->second.RXed[seq] ? "OLD" : "NEW"));
-            return !it->second.RXed[seq];
+            NS_LOG_INFO("SEQ: " << (it->second.seqState.Get(seq).RXed ? "OLD" : "NEW"));
+            return !it->second.seqState.Get(seq).RXed;
         } else {
             //new source
             NS_LOG_INFO("new source");
-            RecvList newIns;
-            for (uint16_t i = 0; i < ARRAY_END; i++) {
-                newIns.copyRXed[i] = false;
-                newIns.RXed[i] = false;
-                newIns.RXtime[i] = Seconds(0);
-            }
-            newIns.copyRXed[ARRAY_END] = false;
-            newIns.RXed[ARRAY_END] = false;
-            newIns.copyRXed[0] = true;
+            RecvList &newIns = m_receivedFrames[src];
+            newIns.seqState[0].copyRXed = true;
             newIns.maxSeqCopyRXed = 0;
             newIns.expectedSeq = 0;
             newIns.receivedFirstFrame = false;
+            newIns.blockAckTimer = 0;
+            newIns.payloadBase = uint16_t(0 - MAX_CODED_SPAN + 1);
             newIns.newestHeader = RescuePhyHeader(RESCUE_PHY_PKT_TYPE_E2E_ACK);
+            newIns.rxTimeBase = Simulator::Now();
+            std::fill(newIns.rxTimeDelta, newIns.rxTimeDelta + SEQ_WINDOW_SIZE, 0);
             newIns.seq1stHalfCleaned = true;
             newIns.seq2ndHalfCleaned = false;
-
-            m_receivedFrames.insert(std::pair<Mac48Address, RecvList> (src, newIns));
             return true;
         }
         return true;
@@ -691,8 +1004,8 @@ namespace ns3 {
         if (isNewSequence) {
             //mark received frame
             if (it != m_receivedFrames.end()) {
-                it->second.RXed[seq] = true;
-                it->second.RXtime[seq] = Simulator::Now();
+                it->second.seqState[seq].RXed = true;
+                SetRxTime(it->second, seq);
 
                 if (SeqComp(phyHdr->GetSequence(), it->second.newestHeader.GetSequence())) {
                     NS_LOG_DEBUG("store newest header for src: " << src << ", seq: " << seq);
@@ -711,30 +1024,22 @@ namespace ns3 {
 
         bool txACK = isNewSequence;
 
-        if (m_sendNACK) {
-            std::pair <Mac48Address, uint16_t> frameId(src, seq);
-            TimersList::iterator it3 = m_nackTimeoutTimers.find(frameId);
-            if (it3 != m_nackTimeoutTimers.end()) {
-                if (it3->second.IsRunning())
-                    it3->second.Cancel();
+        if (m_sendNACK && it->second.seqState.IsStored(seq)) {
+            RecvSeqState &state = it->second.seqState[seq];
+            if (state.nackTimer != 0) {
+                m_timers.Cancel(state.nackTimer);
                 NS_LOG_INFO("CANCEL NACK TIMER for dst: " << src << ", seq: " << seq);
-                m_nackTimeoutTimers.erase(it3);
+                state.nackTimer = 0;
             }
         }
 
         if (m_useBlockACK && phyHdr->IsBlockAckEnabled())
             //if (m_useContinousACK && phyHdr->IsContinousAckEnabled ())
         {
-            std::pair <Mac48Address, uint16_t> frameId(phyHdr->GetSource(), 0);
-            std::pair < TimersList::iterator, bool> newIns = m_blockAckTimeoutTimers.insert(std::pair <std::pair <Mac48Address, uint16_t>, Timer> (frameId, Timer(Timer::CANCEL_ON_DESTROY)));
-
-            if (!newIns.first->second.IsRunning()) {
+            if (!m_timers.IsRunning(it->second.blockAckTimer)) {
                 NS_LOG_DEBUG("BLOCK ACK TIMEOUT TIMER START for src: " << phyHdr->GetSource());
 
-                newIns.first->second.SetDelay(m_blockAckTimeout);
-                newIns.first->second.SetFunction(&RescueArqManager::BlockAckTimeout, this);
-                newIns.first->second.SetArguments(src);
-                newIns.first->second.Schedule();
+                it->second.blockAckTimer = m_timers.Arm(m_blockAckTimeout, Ptr<EventImpl> (MakeEvent(&RescueArqManager::BlockAckTimeout, this, src), false));
             } else
                 NS_LOG_DEBUG("BLOCK ACK TIMEOUT TIMER for src: " << phyHdr->GetSource() << " ALREADY RUNNING");
             txACK = false;
@@ -742,7 +1047,7 @@ namespace ns3 {
 
         if (!txACK
                 && phyHdr->IsRetry()
-                && ((Simulator::Now() - m_longAckTimeout) > it->second.RXtime[seq])) {
+                && ((Simulator::Now() - m_longAckTimeout) > GetRxTime(it->second, seq))) {
             NS_LOG_INFO("UNNECESSARY RETRANSMISSION DETECTED! resend ACK!");
             txACK = true;
         }
@@ -755,6 +1060,125 @@ namespace ns3 {
         return isNewSequence;
     }
 
+    void
+    RescueArqManager::ReportDataRx(Ptr<const Packet> pkt, const RescuePhyHeader *phyHdr, bool coded) {
+        NS_LOG_FUNCTION("");
+        if (!m_codedRetransmission) {
+            if (coded)
+                NS_LOG_INFO("CODED frame received, but coded retransmissions are disabled - DROP!");
+            return;
+        }
+
+        Mac48Address src = phyHdr->GetSource();
+        uint16_t seq = phyHdr->GetSequence();
+        RecvSeqList::iterator it = m_receivedFrames.find(src);
+        if (it == m_receivedFrames.end())
+            return;
+
+        RescueCodedDecoder::DecodedList decoded;
+        if (!coded) {
+            KeepPayload(it->second, seq, pkt);
+            if (it->second.decoder.GetRank() > 0)
+                it->second.decoder.AddReceived(seq, RescueNetworkCoding::ToBlock(pkt), decoded);
+        } else {
+            Ptr<Packet> payload = pkt->Copy();
+            RescueCodedHeader ncHdr;
+            payload->RemoveHeader(ncHdr);
+            RescueNetworkCoding::Block block = RescueNetworkCoding::FromCodedPayload(payload);
+
+            //eliminate already received frames
+            std::vector<uint16_t> unknown;
+            for (uint16_t i = 0; i < MAX_CODED_SPAN; i++) {
+                if (!(ncHdr.GetMask() & ((uint32_t) 1 << i)))
+                    continue;
+                const RecvSeqState &state = it->second.seqState.Get(uint16_t(ncHdr.GetBase() + i));
+                if (!state.RXed)
+                    unknown.push_back(uint16_t(ncHdr.GetBase() + i));
+                else if (state.payload != 0)
+                    RescueNetworkCoding::XorBlock(block, RescueNetworkCoding::ToBlock(state.payload));
+                else {
+                    NS_LOG_INFO("payload of seq: " << ncHdr.GetBase() + i << " is not kept, CODED frame cannot be used - DROP!");
+                    return;
+                }
+            }
+            NS_LOG_INFO("CODED frame from: " << src << ", seq: " << seq << ", base: " << ncHdr.GetBase() << ", unknown frames: " << unknown.size());
+            if (!unknown.empty())
+                it->second.decoder.AddCoded(unknown, block, decoded);
+            NS_LOG_INFO("decoder rank: " << it->second.decoder.GetRank() << ", decoded frames: " << decoded.size());
+        }
+        DeliverDecoded(it, phyHdr, decoded);
+    }
+
+    void
+    RescueArqManager::KeepPayload(RecvList &list, uint16_t seq, Ptr<const Packet> pkt) {
+        uint16_t base = uint16_t(seq - MAX_CODED_SPAN + 1);
+        if (SeqComp(base, list.payloadBase)) {
+            //coded frames do not combine frames older than the span of the newest one
+            uint16_t count = std::min<uint16_t> (uint16_t(base - list.payloadBase), SEQ_WINDOW_SIZE);
+            for (uint16_t s = uint16_t(base - count); s != base; s++)
+                if (list.seqState.IsStored(s))
+                    list.seqState[s].payload = 0;
+            list.payloadBase = base;
+        }
+        if (SeqComp(list.payloadBase, seq))
+            return;
+        list.seqState[seq].payload = pkt->Copy();
+    }
+
+    void
+    RescueArqManager::DeliverDecoded(RecvSeqList::iterator it, const RescuePhyHeader *phyHdr, const RescueCodedDecoder::DecodedList &decoded) {
+        NS_LOG_FUNCTION("");
+        Mac48Address src = it->first;
+
+        for (RescueCodedDecoder::DecodedList::const_iterator d = decoded.begin(); d != decoded.end(); d++) {
+            uint16_t seq = d->first;
+            if (it->second.seqState.Get(seq).RXed)
+                continue;
+            Ptr<Packet> pkt = RescueNetworkCoding::FromBlock(d->second);
+            if (pkt == 0)
+                continue;
+
+            NS_LOG_INFO("DECODED frame from: " << src << ", seq: " << seq);
+            RecvSeqState &state = it->second.seqState[seq];
+            state.copyRXed = true;
+            state.RXed = true;
+            SetRxTime(it->second, seq);
+            KeepPayload(it->second, seq, pkt);
+
+            RescuePhyHeader hdr = *phyHdr;
+            hdr.SetSequence(seq);
+            m_mac->ReceivePacket(pkt, hdr);
+
+            //with block ACK the decoded frames are reported by Block ACK timeout
+            if (ACK_ENABLED && !(m_useBlockACK && phyHdr->IsBlockAckEnabled())) {
+                RescuePhyHeader ackHdr = RescuePhyHeader(m_mac->GetAddress(), src, RESCUE_PHY_PKT_TYPE_E2E_ACK);
+                ConfigureAckHeader(&hdr, &ackHdr);
+                m_mac->EnqueueAck(Create<Packet> (0), ackHdr);
+            }
+        }
+    }
+
+    void
+    RescueArqManager::SetRxTime(RecvList &list, uint16_t seq) {
+        int64_t delta = (Simulator::Now() - list.rxTimeBase).GetMicroSeconds();
+        if (delta > RX_TIME_DELTA_MAX) {
+            //move the base forward, reception times older than the new base are clamped to it
+            uint32_t shift = (uint32_t) (delta - RX_TIME_DELTA_MAX / 2);
+            for (uint16_t i = 0; i < SEQ_WINDOW_SIZE; i++)
+                list.rxTimeDelta[i] = (list.rxTimeDelta[i] > shift) ? list.rxTimeDelta[i] - shift : 0;
+            list.rxTimeBase += MicroSeconds(shift);
+            delta -= shift;
+        }
+        list.rxTimeDelta[seq & (SEQ_WINDOW_SIZE - 1)] = (uint32_t) delta;
+    }
+
+    Time
+    RescueArqManager::GetRxTime(const RecvList &list, uint16_t seq) const {
+        if (!list.seqState.Get(seq).RXed)
+            return Seconds(0);
+        return list.rxTimeBase + MicroSeconds(list.rxTimeDelta[seq & (SEQ_WINDOW_SIZE - 1)]);
+    }
+
     void
     RescueArqManager::ReportDamagedFrame(const RescuePhyHeader *phyHdr) {
         NS_LOG_FUNCTION("");
@@ -765,58 +1189,52 @@ namespace ns3 {
 
         RecvSeqList::iterator it = m_receivedFrames.find(src);
         if (it != m_receivedFrames.end()) {
-            it->second.copyRXed[seq] = true;
+            it->second.seqState[seq].copyRXed = true;
             if (it->second.maxSeqCopyRXed < seq)
                 seq = it->second.maxSeqCopyRXed;
         }
 
+        //NACKs and Block ACKs are prepared from the state of source, kept since its first frame copy
+        if (it == m_receivedFrames.end())
+            return;
+
         if (m_sendNACK) {
             NS_LOG_DEBUG("NACK TIMEOUT TIMER START for src: " << src << ", seq: " << seq);
-
-            std::pair <Mac48Address, uint16_t> frameId(src, seq);
-            std::pair < TimersList::iterator, bool> newIns = m_nackTimeoutTimers.insert(std::pair <std::pair <Mac48Address, uint16_t>, Timer> (frameId, Timer(Timer::CANCEL_ON_DESTROY)));
-
-            if (newIns.first->second.IsRunning())
-                newIns.first->second.Cancel();
-
-            RescuePhyHeader phyHdr_ = *phyHdr;
-
-            newIns.first->second.SetDelay(m_nackTimeout);
-            newIns.first->second.SetFunction(&RescueArqManager::NackTimeout, this);
-            newIns.first->second.SetArguments(phyHdr_);
-            newIns.first->second.Schedule();
+            ArmNackTimer(it->second, seq, *phyHdr, m_nackTimeout);
         }
         if (m_useBlockNACK && m_useBlockACK && phyHdr->IsBlockAckEnabled())
             //if (m_useContinousACK && phyHdr->IsContinousAckEnabled ())
         {
             //store header of damaged frame for Block ACK
 
-            if (it != m_receivedFrames.end()) {
-                if (seq > it->second.newestHeader.GetSequence()) {
-                    NS_LOG_DEBUG("store newest header for src: " << src << ", seq: " << seq);
-                    RescuePhyHeader phyHdr_ = *phyHdr;
-                    it->second.newestHeader = phyHdr_;
-                } else if ((it->second.newestHeader.GetSequence() == 0) && !it->second.receivedFirstFrame) {
-                    NS_LOG_DEBUG("store newest header for src: " << src << ", seq: " << seq);
-                    RescuePhyHeader phyHdr_ = *phyHdr;
-                    it->second.newestHeader = phyHdr_;
-                }
+            if (seq > it->second.newestHeader.GetSequence()) {
+                NS_LOG_DEBUG("store newest header for src: " << src << ", seq: " << seq);
+                RescuePhyHeader phyHdr_ = *phyHdr;
+                it->second.newestHeader = phyHdr_;
+            } else if ((it->second.newestHeader.GetSequence() == 0) && !it->second.receivedFirstFrame) {
+                NS_LOG_DEBUG("store newest header for src: " << src << ", seq: " << seq);
+                RescuePhyHeader phyHdr_ = *phyHdr;
+                it->second.newestHeader = phyHdr_;
             }
 
-            std::pair <Mac48Address, uint16_t> frameId(src, 0);
-            std::pair < TimersList::iterator, bool> newIns = m_blockAckTimeoutTimers.insert(std::pair <std::pair <Mac48Address, uint16_t>, Timer> (frameId, Timer(Timer::CANCEL_ON_DESTROY)));
-
-            if (!newIns.first->second.IsRunning()) {
+            if (!m_timers.IsRunning(it->second.blockAckTimer)) {
                 NS_LOG_DEBUG("BLOCK ACK TIMEOUT TIMER START for src: " << src);
 
-                newIns.first->second.SetDelay(m_blockAckTimeout);
-                newIns.first->second.SetFunction(&RescueArqManager::BlockAckTimeout, this);
-                newIns.first->second.SetArguments(src);
-                newIns.first->second.Schedule();
+                it->second.blockAckTimer = m_timers.Arm(m_blockAckTimeout, Ptr<EventImpl> (MakeEvent(&RescueArqManager::BlockAckTimeout, this, src), false));
             } else
                 NS_LOG_DEBUG("BLOCK ACK TIMEOUT TIMER for src: " << src << " ALREADY RUNNING");
-        } else
-            NS_ASSERT("receivedFrames record not created!");
+        }
+    }
+
+    void
+    RescueArqManager::ArmNackTimer(RecvList &list, uint16_t seq, const RescuePhyHeader &phyHdr, Time delay) {
+        //the timer of older frame which used the same slot of sequence window is not needed anymore
+        RecvSeqState *old = list.seqState.GetTakenOver(seq);
+        if (old != 0)
+            m_timers.Cancel(old->nackTimer);
+        RecvSeqState &state = list.seqState[seq];
+        m_timers.Cancel(state.nackTimer);
+        state.nackTimer = m_timers.Arm(delay, Ptr<EventImpl> (MakeEvent(&RescueArqManager::NackTimeout, this, phyHdr), false));
     }
 
     void
@@ -828,6 +1246,13 @@ namespace ns3 {
 
         NS_LOG_INFO("!!! NACK TIMEOUT !!! for src: " << src << ", seq: " << seq);
 
+        RecvSeqList::iterator it = m_receivedFrames.find(src);
+        if ((it == m_receivedFrames.end()) || !it->second.seqState.IsStored(seq)) {
+            NS_LOG_DEBUG("state of seq: " << seq << " already released, stop NACK TIMER");
+            return;
+        }
+        it->second.seqState[seq].nackTimer = 0;
+
         Ptr<Packet> pkt = Create<Packet> (0);
         RescuePhyHeader ackHdr = RescuePhyHeader(m_mac->GetAddress(), src, RESCUE_PHY_PKT_TYPE_E2E_ACK);
 
@@ -837,17 +1262,7 @@ namespace ns3 {
 
         //reschedule
         NS_LOG_DEBUG("NACK TIMEOUT TIMER START for src: " << src << ", seq: " << seq);
-
-        std::pair <Mac48Address, uint16_t> frameId(src, seq);
-        std::pair < TimersList::iterator, bool> newIns = m_nackTimeoutTimers.insert(std::pair <std::pair <Mac48Address, uint16_t>, Timer> (frameId, Timer(Timer::CANCEL_ON_DESTROY)));
-
-        if (newIns.first->second.IsRunning())
-            newIns.first->second.Cancel();
-
-        newIns.first->second.SetDelay(m_longAckTimeout);
-        newIns.first->second.SetFunction(&RescueArqManager::NackTimeout, this);
-        newIns.first->second.SetArguments(phyHdr);
-        newIns.first->second.Schedule();
+        ArmNackTimer(it->second, seq, phyHdr, m_longAckTimeout);
     }
 
     void
@@ -866,16 +1281,10 @@ namespace ns3 {
         m_mac->EnqueueAck(pkt, ackHdr);
 
         //reschedule
-        std::pair <Mac48Address, uint16_t> frameId(src, 0);
-        std::pair < TimersList::iterator, bool> newIns = m_blockAckTimeoutTimers.insert(std::pair <std::pair <Mac48Address, uint16_t>, Timer> (frameId, Timer(Timer::CANCEL_ON_DESTROY)));
-
-        if (!newIns.first->second.IsRunning()) {
+        if (!m_timers.IsRunning(it->second.blockAckTimer)) {
             NS_LOG_DEBUG("BLOCK ACK TIMEOUT TIMER START for src: " << src);
 
-            newIns.first->second.SetDelay(m_blockAckTimeout);
-            newIns.first->second.SetFunction(&RescueArqManager::BlockAckTimeout, this);
-            newIns.first->second.SetArguments(src);
-            newIns.first->second.Schedule();
+            it->second.blockAckTimer = m_timers.Arm(m_blockAckTimeout, Ptr<EventImpl> (MakeEvent(&RescueArqManager::BlockAckTimeout, this, src), false));
         } else
             NS_LOG_DEBUG("BLOCK ACK TIMEOUT TIMER for src: " << src << " ALREADY RUNNING");
     }
@@ -891,17 +1300,17 @@ namespace ns3 {
         ackHdr->SetSource(phyHdr->GetDestination());
         ackHdr->SetDestination(src);
         ackHdr->SetSequence(seq);
-        if (it->second.RXed[seq]) {
+        if (it->second.seqState.Get(seq).RXed) {
             ackHdr->SetACK();
             //if (seq > it->second.maxSeqACKed)
             if (SeqComp(seq, it->second.maxSeqACKed))
                 it->second.maxSeqACKed = seq;
         } else
             ackHdr->SetNACK();
-        NS_LOG_INFO((it->second.RXed[seq] ? "ACK" : "NACK") << " for: " << ackHdr->GetDestination() << ", from: " << ackHdr->GetSource() << ", seq: " << ackHdr->GetSequence());
+        NS_LOG_INFO((it->second.seqState.Get(seq).RXed ? "ACK" : "NACK") << " for: " << ackHdr->GetDestination() << ", from: " << ackHdr->GetSource() << ", seq: " << ackHdr->GetSequence());
 
         //actualize expected SEQ number for given source station
-        while (it->second.RXed[it->second.expectedSeq])
+        while (it->second.seqState.Get(it->second.expectedSeq).RXed)
             it->second.expectedSeq++; //increment for all already ACKed frames
 
         if (m_useContinousACK && phyHdr->IsContinousAckEnabled()) {
@@ -929,14 +1338,19 @@ namespace ns3 {
         if (m_useBlockACK && phyHdr->IsBlockAckEnabled()) {
             NS_LOG_INFO("SET BLOCK ACK");
             ackHdr->SetBlockAckEnabled();
+            //bitmap covers the frames awaiting acknowledgement (at least the send window of the source)
+            uint16_t span = SeqComp(seq + 1, it->second.expectedSeq) ? uint16_t(seq + 1 - it->second.expectedSeq) : 0;
+            uint16_t blockSize = std::max<uint16_t> (span, phyHdr->GetSendWindow() + 1);
+            ackHdr->SetBlockAckSize(std::min(blockSize, m_blockAckSize));
+            blockSize = ackHdr->GetBlockAckSize();
             uint16_t start_seq = seq;
             if (m_useContinousACK && ackHdr->IsContinousAckEnabled())
-                start_seq = SeqComp(it->second.expectedSeq + 16, seq) ? seq : it->second.expectedSeq + 16;
+                start_seq = SeqComp(it->second.expectedSeq + blockSize, seq) ? seq : it->second.expectedSeq + blockSize;
             //start_seq = std::min (seq, uint16_t(it->second.expectedSeq + 16));
-            for (int i = 0; i < 16; i++) {
+            for (int i = 0; i < blockSize; i++) {
                 uint16_t seq_temp = start_seq - 1 - i;
 
-                ackHdr->SetBlockAckFlagFor(it->second.RXed[seq_temp], i);
+                ackHdr->SetBlockAckFlagFor(it->second.seqState.Get(seq_temp).RXed, i);
                 NS_LOG_INFO("SET BLOCK ACK for src: " << src << ", seq: " << (seq_temp) << " " << (ackHdr->IsBlockAckFrameReceived(i) ? "RECEIVED" : "MISSED"));
 
                 if (ackHdr->IsBlockAckFrameReceived(i) && (seq_temp > it->second.maxSeqACKed))
@@ -951,8 +1365,8 @@ namespace ns3 {
         //for (uint16_t i = it->second.expectedSeq; i != it->second.maxSeqCopyRXed + 1; i++)
         NS_LOG_DEBUG("it->second.expectedSeq: " << it->second.expectedSeq << ", seq + 1: " << seq + 1);
         for (uint16_t i = it->second.expectedSeq; SeqComp(seq + 1, i); i++) {
-            NS_LOG_DEBUG("i: " << i << "it->second.RXed[i]: " << ((it->second.RXed[i]) ? "YES" : "NO"));
-            if (!it->second.RXed[i])
+            NS_LOG_DEBUG("i: " << i << "it->second.RXed[i]: " << ((it->second.seqState.Get(i).RXed) ? "YES" : "NO"));
+            if (!it->second.seqState.Get(i).RXed)
                 NACKedFrames++;
         }
 
@@ -977,6 +1391,7 @@ namespace ns3 {
         FwdSeqList::iterator it = m_forwardedFrames.find(std::pair<Mac48Address, Mac48Address> (src, dst));
         if (it != m_forwardedFrames.end()) {
             //found source and destination
+            NoteFlowRelay(it->second, phyHdr);
 
             //check if sequence should be reused
 
@@ -988,40 +1403,26 @@ namespace ns3 {
             if (!it->second.seq1stHalfCleaned
                     && (seq > (ARRAY_END - MAX_WINDOW_SIZE))) {
                 //first half of sequence numbers should be reused
-                for (uint16_t i = 0; i <= HALF_OF_ARRAY; i++) {
-                    //std::cout << "seq: " << seq << ", i: " << i << std::endl;
-                    it->second.RXed[i] = false;
-                    it->second.TXed[i] = false;
-                    it->second.IL[i] = 0;
-                    it->second.ber[i] = 0.0;
-                    it->second.ACKed[i] = false;
-                    it->second.retried[i] = false;
-                }
+                it->second.seqState.ForgetRange(0, HALF_OF_ARRAY);
+                m_seqRecycles++;
                 it->second.seq1stHalfCleaned = true;
                 it->second.seq2ndHalfCleaned = false;
             } else if (!it->second.seq2ndHalfCleaned
                     && (seq > (HALF_OF_ARRAY - MAX_WINDOW_SIZE))
                     && (seq <= HALF_OF_ARRAY)) {
                 //second half of sequence numbers should be reused
-                for (uint16_t i = HALF_OF_ARRAY + 1; i > HALF_OF_ARRAY; i++) {
-                    //std::cout << "seq: " << seq << ", i: " << i << std::endl;
-                    it->second.RXed[i] = false;
-                    it->second.TXed[i] = false;
-                    it->second.IL[i] = 0;
-                    it->second.ber[i] = 0.0;
-                    it->second.ACKed[i] = false;
-                    it->second.retried[i] = false;
-                }
+                it->second.seqState.ForgetRange(HALF_OF_ARRAY + 1, ARRAY_END);
+                m_seqRecycles++;
                 it->second.seq1stHalfCleaned = false;
                 it->second.seq2ndHalfCleaned = true;
             }
 
 
-            if (it->second.ACKed[seq] //ACKed?
+            if (it->second.seqState.Get(seq).ACKed //ACKed?
                     && (!phyHdr->IsRetry())) {
                 //frame was already ACKed and this copy is not needed - drop it!
                 return std::pair<RelayBehavior, RescuePhyHeader> (DROP, RescuePhyHeader(RESCUE_PHY_PKT_TYPE_E2E_ACK));
-            } else if (it->second.ACKed[seq] //ACKed?
+            } else if (it->second.seqState.Get(seq).ACKed //ACKed?
                     && (phyHdr->IsRetry())) {
                 //frame was already ACKed and unnecessary retransmission is detected
                 RescuePhyHeader ackHdr;
@@ -1030,7 +1431,7 @@ namespace ns3 {
                 uint16_t i_stop = seq;
 
                 if (phyHdr->IsBlockAckEnabled() && !phyHdr->IsContinousAckEnabled()) //Block ACK, no Cont ACK
-                    i_start = SeqComp(it->second.maxSeqACKed, seq + 16) ? seq + 16 : it->second.maxSeqACKed;
+                    i_start = SeqComp(it->second.maxSeqACKed, seq + m_blockAckSize) ? seq + m_blockAckSize : it->second.maxSeqACKed;
                     //i_start = std::min (uint16_t(seq + 16), it->second.maxSeqACKed);
                 else if (!phyHdr->IsBlockAckEnabled() && phyHdr->IsContinousAckEnabled()) //no Block ACK, Cont ACK
                 {
@@ -1040,70 +1441,67 @@ namespace ns3 {
                 } else if (phyHdr->IsBlockAckEnabled() && phyHdr->IsContinousAckEnabled()) //Block ACK, Cont ACK
                 {
                     //i_start = ((seq > it->second.contACKed) ? it->second.maxSeqACKed : std::min (uint16_t(seq + 16), it->second.maxSeqACKed));
-                    i_start = SeqComp(seq, it->second.contACKed) ? it->second.maxSeqACKed : (SeqComp(seq + 16, it->second.maxSeqACKed) ? it->second.maxSeqACKed : seq + 16);
+                    i_start = SeqComp(seq, it->second.contACKed) ? it->second.maxSeqACKed : (SeqComp(seq + m_blockAckSize, it->second.maxSeqACKed) ? it->second.maxSeqACKed : seq + m_blockAckSize);
                     i_stop = std::max(seq, it->second.contACKed);
                 }
 
-                for (uint16_t i = i_start; i >= i_stop; i--)
-                    if (it->second.ACKed[i] && IsSeqACKed(seq, &(it->second.ackHdr[i]))) {
-                        ackHdr = it->second.ackHdr[i];
+                for (uint16_t i = i_start; i >= i_stop; i--) {
+                    const RescuePhyHeader *storedHdr = GetFwdAckHeader(it, it->second.seqState.Get(i).ackHdrId);
+                    if (it->second.seqState.Get(i).ACKed && (storedHdr != 0) && IsSeqACKed(seq, storedHdr)) {
+                        ackHdr = *storedHdr;
                         break;
                     }
+                }
                 return std::pair<RelayBehavior, RescuePhyHeader> (RESEND_ACK, ackHdr);
-            } else if (it->second.TXed[seq] && (it->second.IL[seq] == phyHdr->GetInterleaver())) {
+            } else if (it->second.seqState.Get(seq).TXed && (it->second.seqState.Get(seq).IL == phyHdr->GetInterleaver())) {
                 //frame was not already ACKed but the copy of given frame was transmitted, just break
                 return std::pair<RelayBehavior, RescuePhyHeader> (DROP, RescuePhyHeader(RESCUE_PHY_PKT_TYPE_E2E_ACK));
                 /*if (it->second.ber[seq] > ber)
                   {
-                    it->second.ber[seq] = ber;
+                    it->second.seqState[seq].ber = ber;
                     return std::pair<RelayBehavior, RescuePhyHeader> (FORWARD, RescuePhyHeader (RESCUE_PHY_PKT_TYPE_E2E_ACK));
                   }
                 else
                   return std::pair<RelayBehavior, RescuePhyHeader> (DROP, RescuePhyHeader (RESCUE_PHY_PKT_TYPE_E2E_ACK));*/
-            } else if (it->second.RXed[seq] && !it->second.TXed[seq]) {
+            } else if (it->second.seqState.Get(seq).RXed && !it->second.seqState.Get(seq).TXed) {
                 //frame copy was received but still awaits for transmission
-                if (it->second.ber[seq] > ber) {
-                    it->second.ber[seq] = ber;
+                if (it->second.seqState.Get(seq).ber > ber) {
+                    it->second.seqState[seq].ber = ber;
                     return std::pair<RelayBehavior, RescuePhyHeader> (REPLACE_COPY, RescuePhyHeader(RESCUE_PHY_PKT_TYPE_E2E_ACK));
                 } else
                     return std::pair<RelayBehavior, RescuePhyHeader> (DROP, RescuePhyHeader(RESCUE_PHY_PKT_TYPE_E2E_ACK));
             }//otherwise - it is new TX try, forward it!
             else {
                 //new or another retry detected, update interleaver
-                it->second.RXed[seq] = true;
-                it->second.TXed[seq] = false;
-                it->second.IL[seq] = phyHdr->GetInterleaver();
-                it->second.ber[seq] = ber;
-                it->second.ACKed[seq] = false;
-                it->second.retried[seq] = phyHdr->IsRetry();
+                it->second.seqState[seq].RXed = true;
+                it->second.seqState[seq].TXed = false;
+                it->second.seqState[seq].IL = phyHdr->GetInterleaver();
+                it->second.seqState[seq].ber = ber;
+                it->second.seqState[seq].ACKed = false;
+                it->second.seqState[seq].retried = phyHdr->IsRetry();
 
                 return std::pair<RelayBehavior, RescuePhyHeader> (FORWARD, RescuePhyHeader(RESCUE_PHY_PKT_TYPE_E2E_ACK));
             }
         } else {
             //new source and destination
             NS_LOG_INFO("new source and destination");
-            FwdList newIns;
-            newIns.RXed[seq] = true;
-            newIns.TXed[seq] = false;
-            newIns.IL[seq] = phyHdr->GetInterleaver();
-            newIns.ber[seq] = ber;
-            newIns.ACKed[seq] = false;
-            //newIns.ackHdr[seq] = RescuePhyHeader (RESCUE_PHY_PKT_TYPE_E2E_ACK);
-            newIns.retried[seq] = phyHdr->IsRetry();
+            std::pair<Mac48Address, Mac48Address> srcDst(src, dst);
+            FwdList &newIns = m_forwardedFrames[srcDst];
+            newIns.seqState[seq].RXed = true;
+            newIns.seqState[seq].TXed = false;
+            newIns.seqState[seq].IL = phyHdr->GetInterleaver();
+            newIns.seqState[seq].ber = ber;
+            newIns.seqState[seq].ACKed = false;
+            newIns.seqState[seq].retried = phyHdr->IsRetry();
             //newIns.lastNACKrx[seq] = Seconds (0);
 
-            newIns.ackHdr = std::vector<RescuePhyHeader> (ARRAY_END + 1, RescuePhyHeader(RESCUE_PHY_PKT_TYPE_E2E_ACK));
-
-            for (uint16_t i = seq + 1; i != seq; i++) {
-                newIns.RXed[i] = false;
-                newIns.TXed[i] = false;
-                newIns.IL[i] = 0;
-                newIns.ber[i] = 0;
-                newIns.ACKed[i] = false;
-                //newIns.ackHdr[i] = RescuePhyHeader (RESCUE_PHY_PKT_TYPE_E2E_ACK);
-                newIns.retried[i] = false;
-                //newIns.lastNACKrx[i] = Seconds (0);
-            }
+            newIns.contACKed = 0;
+            newIns.maxSeqACKed = 0;
+            for (uint16_t i = 0; i < FWD_ACK_HEADERS; i++)
+                newIns.ackHdrId[i] = 0;
+            newIns.nextAckHdrId = 1;
+            newIns.nRelays = 0;
+            NoteFlowRelay(newIns, phyHdr);
 
             if (seq < HALF_OF_ARRAY) {
                 newIns.seq1stHalfCleaned = true;
@@ -1113,8 +1511,6 @@ namespace ns3 {
                 newIns.seq2ndHalfCleaned = true;
             }
 
-            std::pair<Mac48Address, Mac48Address> srcDst(src, dst);
-            m_forwardedFrames.insert(std::pair<std::pair<Mac48Address, Mac48Address>, FwdList> (srcDst, newIns));
             return std::pair<RelayBehavior, RescuePhyHeader> (FORWARD, RescuePhyHeader(RESCUE_PHY_PKT_TYPE_E2E_ACK));
         }
     }
@@ -1131,6 +1527,8 @@ namespace ns3 {
         FwdSeqList::iterator it = m_forwardedFrames.find(std::pair<Mac48Address, Mac48Address> (dst, src));
         if (it != m_forwardedFrames.end()) {
             //found source and destination - process ACK frame and check if it should be forwarded
+            uint32_t ackHdrId = 0; //stored on first use only
+
 
             //check Continous ACK
             if (m_useContinousACK && ackHdr->IsContinousAckEnabled()) {
@@ -1139,12 +1537,13 @@ namespace ns3 {
                 if (SeqComp(seq - ackHdr->GetContinousAck(), it->second.contACKed)) {
                     NS_LOG_INFO("RELAY: CONTINOUS ACK for dst: " << dst << ", from src: " << src << ", contACK: " << (int) ackHdr->GetContinousAck() << ", new continously acknowledged seq: " << uint16_t(seq - ackHdr->GetContinousAck()) << ", previously acknowledged seq: " << (int) it->second.contACKed);
                     for (uint16_t i = it->second.contACKed; SeqComp(seq - ackHdr->GetContinousAck() + 1, i); i++) {
-                        RescuePhyHeader ackHdr_ = *ackHdr;
-                        it->second.ackHdr[i] = ackHdr_;
-                        if (!it->second.ACKed[i]) {
+                        if (ackHdrId == 0)
+                            ackHdrId = StoreFwdAckHeader(it, ackHdr);
+                        it->second.seqState[i].ackHdrId = ackHdrId;
+                        if (!it->second.seqState.Get(i).ACKed) {
                             NS_LOG_INFO("RELAY: CONTINOUS ACK for dst: " << dst << ", from src: " << src << ", seq: " << i << " RECEIVED");
                             fwd = true;
-                            it->second.ACKed[i] = true;
+                            it->second.seqState[i].ACKed = true;
                             //RescuePhyHeader ackHdr_ = *ackHdr;
                             //it->second.ackHdr[i] = ackHdr_;
                         }
@@ -1158,17 +1557,18 @@ namespace ns3 {
 
             //check Block ACK
             if (m_useBlockACK && ackHdr->IsBlockAckEnabled()) {
+                uint16_t blockSize = ackHdr->GetBlockAckSize();
                 uint16_t start_seq = seq;
                 NS_LOG_DEBUG("useContinousACK: " << (m_useContinousACK ? "TRUE" : "FALSE") << "ackHdr->IsContinousAckEnabled: " << (ackHdr->IsContinousAckEnabled() ? "TRUE" : "FALSE"));
                 if (m_useContinousACK && ackHdr->IsContinousAckEnabled())
-                    start_seq = SeqComp(seq - ackHdr->GetContinousAck() + 17, seq) ? seq : seq - ackHdr->GetContinousAck() + 17;
+                    start_seq = SeqComp(seq - ackHdr->GetContinousAck() + blockSize + 1, seq) ? seq : seq - ackHdr->GetContinousAck() + blockSize + 1;
                 //start_seq = std::min (seq, uint16_t(it->second.contACKed + 17));
 
-                uint16_t start_i = 15;
+                uint16_t start_i = blockSize - 1;
                 /*if ( ((start_seq - 16) <= it->second.contACKed)
                        && (it->second.contACKed < HALF_OF_ARRAY) )
                   start_i = start_seq - it->second.contACKed;*/
-                if (((start_seq - 16) < 0)
+                if (((start_seq - blockSize) < 0)
                         && (it->second.contACKed < HALF_OF_ARRAY))
                     start_i = start_seq - 1;
 
@@ -1179,35 +1579,37 @@ namespace ns3 {
                 for (int i = start_i; i >= 0; i--) {
                     uint16_t seq_temp = start_seq - i - 1;
                     NS_LOG_INFO("RELAY: BLOCK ACK for dst: " << dst << ", from src: " << src << ", seq: " << seq_temp << " " << (ackHdr->IsBlockAckFrameReceived(i) ? "RECEIVED" : "MISSED"));
-                    if (!it->second.ACKed[seq_temp]
+                    if (!it->second.seqState.Get(seq_temp).ACKed
                             && ackHdr->IsBlockAckFrameReceived(i)) {
                         //RescuePhyHeader ackHdr_ = *ackHdr;
                         //it->second.ackHdr[seq_temp] = ackHdr_;
                         fwd = true;
-                        it->second.ACKed[seq_temp] = true;
+                        it->second.seqState[seq_temp].ACKed = true;
                         if (seq_temp > it->second.maxSeqACKed)
                             it->second.maxSeqACKed = seq_temp;
-                    } else if (!it->second.ACKed[seq_temp]
+                    } else if (!it->second.seqState.Get(seq_temp).ACKed
                             && !ackHdr->IsBlockAckFrameReceived(i))
                         fwd = true; //forward NACK if the given frame copy was not transmitted recently
                     if (ackHdr->IsBlockAckFrameReceived(i)) {
-                        RescuePhyHeader ackHdr_ = *ackHdr;
-                        it->second.ackHdr[seq_temp] = ackHdr_;
+                        if (ackHdrId == 0)
+                            ackHdrId = StoreFwdAckHeader(it, ackHdr);
+                        it->second.seqState[seq_temp].ackHdrId = ackHdrId;
                     }
                 }
             }
 
             //process basic ACK/NACK
-            if (!it->second.ACKed[seq]) {
+            if (!it->second.seqState.Get(seq).ACKed) {
                 if (ackHdr->IsACK()) {
                     NS_LOG_INFO("RELAY: BASIC ACK for dst: " << dst << ", from src: " << src << ", seq: " << ackHdr->GetSequence());
                     fwd = true;
-                    it->second.ACKed[seq] = true;
+                    it->second.seqState[seq].ACKed = true;
                     //if (seq > it->second.maxSeqACKed)
                     if (SeqComp(seq, it->second.maxSeqACKed))
                         it->second.maxSeqACKed = seq;
-                    RescuePhyHeader ackHdr_ = *ackHdr;
-                    it->second.ackHdr[seq] = ackHdr_;
+                    if (ackHdrId == 0)
+                        ackHdrId = StoreFwdAckHeader(it, ackHdr);
+                    it->second.seqState[seq].ackHdrId = ackHdrId;
                 }//else if ( (!ackHdr->IsBlockAckEnabled () && (ns3::Simulator::Now () - it->second.lastNACKrx[seq] > m_nackTimeout)) //NACK
                     //          || (ackHdr->IsBlockAckEnabled () && (ns3::Simulator::Now () - it->second.lastNACKrx[seq] > m_blockAckTimeout)) ) //BLOCK NACK
                 else {
@@ -1222,7 +1624,7 @@ namespace ns3 {
             //check if it should be forwarded - dont forward ACKs for frames which were not transmitted here
             //fwd = fwd && it->second.RXed[seq];
 
-            if (!it->second.RXed[seq])
+            if (!it->second.seqState.Get(seq).RXed)
                 //new SEQ number for given destination???
                 NS_LOG_INFO("ACK for frame seq which was not relayed here - forward to cancel unnecessary copies!");
         } else
@@ -1230,7 +1632,7 @@ namespace ns3 {
             NS_LOG_INFO("(ACK for tx stream which was not relayed here) DROP!");
 
         if (!ackHdr->IsACK() && !ackHdr->IsBlockAckEnabled() && !ackHdr->IsContinousAckEnabled())
-            fwd = fwd && (it->second.RXed[seq] == it->second.TXed[seq]); //special rule for pure NACK frames
+            fwd = fwd && (it->second.seqState.Get(seq).RXed == it->second.seqState.Get(seq).TXed); //special rule for pure NACK frames
         else
             /* Forward ACKs only if:
              * - retry frame was detected - links may be corrupted so multipath ACK forwarding may be more reliable
@@ -1240,19 +1642,38 @@ namespace ns3 {
              *       - if the copy was never received - probably it will be received i nthe future - forward ACK to cancel this transmission
              */
             fwd = fwd
-                && (it->second.retried[seq] //retry frame was detected
+                && (it->second.seqState.Get(seq).retried //retry frame was detected
                 //|| (it->second.RXed[seq] && it->second.TXed[seq]) );
-                || (it->second.RXed[seq] == it->second.TXed[seq]));
+                || (it->second.seqState.Get(seq).RXed == it->second.seqState.Get(seq).TXed));
         //fwd = fwd && (it->second.RXed[seq] == it->second.TXed[seq]); //special rule for pure NACK frames
 
         NS_LOG_INFO("fwd: " << (fwd ? "YES" : "NO") <<
-                ", it->second.retried[seq]: " << (it->second.retried[seq] ? "YES" : "NO") <<
-                ", it->second.RXed[seq]: " << (it->second.RXed[seq] ? "YES" : "NO") <<
-                ", it->second.TXed[seq]: " << (it->second.TXed[seq] ? "YES" : "NO"));
+                ", it->second.retried[seq]: " << (it->second.seqState.Get(seq).retried ? "YES" : "NO") <<
+                ", it->second.RXed[seq]: " << (it->second.seqState.Get(seq).RXed ? "YES" : "NO") <<
+                ", it->second.TXed[seq]: " << (it->second.seqState.Get(seq).TXed ? "YES" : "NO"));
 
         return fwd;
     }
 
+    uint32_t
+    RescueArqManager::StoreFwdAckHeader(FwdSeqList::iterator it, const RescuePhyHeader *ackHdr) {
+        uint32_t id = it->second.nextAckHdrId++;
+        if (it->second.nextAckHdrId == 0)
+            it->second.nextAckHdrId = 1; //0 is reserved for "no header"
+        uint16_t slot = id % FWD_ACK_HEADERS;
+        it->second.ackHdr[slot] = *ackHdr;
+        it->second.ackHdrId[slot] = id;
+        return id;
+    }
+
+    const RescuePhyHeader*
+    RescueArqManager::GetFwdAckHeader(FwdSeqList::iterator it, uint32_t id) const {
+        uint16_t slot = id % FWD_ACK_HEADERS;
+        if ((id == 0) || (it->second.ackHdrId[slot] != id))
+            return 0; //never stored or already overwritten by newer ACK header
+        return &(it->second.ackHdr[slot]);
+    }
+
     bool
     RescueArqManager::IsFwdACKed(const RescuePhyHeader *phyHdr) {
         NS_LOG_FUNCTION("");
@@ -1262,7 +1683,7 @@ namespace ns3 {
 
         FwdSeqList::iterator it = m_forwardedFrames.find(std::pair<Mac48Address, Mac48Address> (src, dst));
         if (it != m_forwardedFrames.end())
-            return it->second.ACKed[seq];
+            return it->second.seqState.Get(seq).ACKed;
         else
             return false;
     }
@@ -1272,7 +1693,7 @@ namespace ns3 {
         NS_LOG_FUNCTION("");
         FwdSeqList::iterator it = m_forwardedFrames.find(std::pair<Mac48Address, Mac48Address> (phyHdr->GetSource(), phyHdr->GetDestination()));
         if (it != m_forwardedFrames.end())
-            it->second.TXed[phyHdr->GetSequence()] = true;
+            it->second.seqState[phyHdr->GetSequence()].TXed = true;
         else
             NS_ASSERT("TX of unnotified frame!");
     }
@@ -1285,23 +1706,24 @@ namespace ns3 {
             return false;
 
         bool retval = ((seq == ackHdr->GetSequence()) && ackHdr->IsACK());
+        uint16_t blockSize = ackHdr->GetBlockAckSize();
 
         if (!retval && ackHdr->IsContinousAckEnabled())
             retval = !SeqComp(seq, ackHdr->GetSequence() - ackHdr->GetContinousAck());
         //retval = (seq <= (ackHdr->GetSequence() - ackHdr->GetContinousAck ()));
 
         if (!retval && ackHdr->IsBlockAckEnabled() && !ackHdr->IsContinousAckEnabled())
-            //if (ackHdr->GetSequence () - seq < 17)
-            if (SeqComp(seq + 17, ackHdr->GetSequence()))
+            //if (ackHdr->GetSequence () - seq < blockSize + 1)
+            if (SeqComp(seq + blockSize + 1, ackHdr->GetSequence()))
                 retval = (ackHdr->IsBlockAckFrameReceived(ackHdr->GetSequence() - seq - 1));
 
         if (!retval && ackHdr->IsBlockAckEnabled() && ackHdr->IsContinousAckEnabled()) {
-            //if (ackHdr->GetSequence () - seq < 17)
-            if (SeqComp(seq + 17, ackHdr->GetSequence()))
+            //if (ackHdr->GetSequence () - seq < blockSize + 1)
+            if (SeqComp(seq + blockSize + 1, ackHdr->GetSequence()))
                 retval = (ackHdr->IsBlockAckFrameReceived(ackHdr->GetSequence() - seq - 1));
-                //else if (seq - (ackHdr->GetSequence() - ackHdr->GetContinousAck ()) < 17)
-            else if (SeqComp(ackHdr->GetSequence() - ackHdr->GetContinousAck(), seq - 17))
-                retval = (ackHdr->IsBlockAckFrameReceived(ackHdr->GetSequence() - ackHdr->GetContinousAck() + 16 - seq - 1));
+                //else if (seq - (ackHdr->GetSequence() - ackHdr->GetContinousAck ()) < blockSize + 1)
+            else if (SeqComp(ackHdr->GetSequence() - ackHdr->GetContinousAck(), seq - blockSize - 1))
+                retval = (ackHdr->IsBlockAckFrameReceived(ackHdr->GetSequence() - ackHdr->GetContinousAck() + blockSize - seq - 1));
         }
 
         return retval;
@@ -1317,7 +1739,7 @@ namespace ns3 {
                 && (ackHdr1->IsACK() == ackHdr2->IsACK());
 
         if (ackHdr1->IsBlockAckEnabled() && ackHdr2->IsBlockAckEnabled())
-            retval = retval && (ackHdr1->GetBlockAck() == ackHdr2->GetBlockAck());
+            retval = retval && ackHdr1->IsBlockAckEqual(*ackHdr2);
         else
             retval = retval && (ackHdr1->IsBlockAckEnabled() == ackHdr2->IsBlockAckEnabled());
 
@@ -1336,6 +1758,219 @@ namespace ns3 {
                 || ((seq2 > ARRAY_END - MAX_WINDOW_SIZE) && (seq1 < MAX_WINDOW_SIZE)));
     }
 
+    bool
+    RescueArqManager::IsHopAckEnabled(void) const {
+        return m_useHopAck;
+    }
+
+    RescuePhyHeader
+    RescueArqManager::GetHopAckHeader(const RescuePhyHeader *phyHdr) const {
+        //the same orientation as E2E ACK (from destination to source of the flow), sender is the acknowledging node,
+        //transmitter is the node whose transmission is acknowledged
+        RescuePhyHeader ackHdr = RescuePhyHeader(phyHdr->GetDestination(), m_mac->GetAddress(), phyHdr->GetSource(), RESCUE_PHY_PKT_TYPE_PART_ACK);
+        ackHdr.SetTransmitter(phyHdr->GetSender());
+        ackHdr.SetSequence(phyHdr->GetSequence());
+        ackHdr.SetACK();
+        return ackHdr;
+    }
+
+    uint8_t
+    RescueArqManager::GetRelayIndex(const RescuePhyHeader *phyHdr) const {
+        FwdSeqList::const_iterator it = m_forwardedFrames.find(std::pair<Mac48Address, Mac48Address> (phyHdr->GetSource(), phyHdr->GetDestination()));
+        if (it == m_forwardedFrames.end())
+            return 0;
+        uint8_t index = 0;
+        for (uint8_t i = 0; i < it->second.nRelays; i++)
+            if (it->second.relays[i] < m_mac->GetAddress())
+                index++;
+        return index;
+    }
+
+    void
+    RescueArqManager::NoteFlowRelay(FwdList &list, const RescuePhyHeader *phyHdr) {
+        Mac48Address relay = phyHdr->GetSender();
+        if ((relay == phyHdr->GetSource()) || (relay == m_mac->GetAddress()))
+            return;
+        for (uint8_t i = 0; i < list.nRelays; i++)
+            if (list.relays[i] == relay)
+                return;
+        if (list.nRelays < FWD_RELAYS)
+            list.relays[list.nRelays++] = relay;
+    }
+
+    void
+    RescueArqManager::ReportHopTx(Ptr<const Packet> pkt, const RescuePhyHeader *phyHdr) {
+        NS_LOG_FUNCTION("src: " << phyHdr->GetSource() << ", dst: " << phyHdr->GetDestination() << ", seq: " << phyHdr->GetSequence());
+        if (!IsHopAckEnabled())
+            return;
+
+        HopKey key(std::pair<Mac48Address, Mac48Address> (phyHdr->GetSource(), phyHdr->GetDestination()), phyHdr->GetSequence());
+        HopState &state = m_hopFrames[key];
+        state.pkt = pkt->Copy();
+        state.phyHdr = *phyHdr;
+        m_timers.Cancel(state.hopTimer);
+        state.hopTimer = m_timers.Arm(m_hopAckTimeout, Ptr<EventImpl> (MakeEvent(&RescueArqManager::HopAckTimeout, this, key), false));
+    }
+
+    bool
+    RescueArqManager::ReceiveHopAck(const RescuePhyHeader *ackHdr) {
+        NS_LOG_FUNCTION("src: " << ackHdr->GetSource() << ", dst: " << ackHdr->GetDestination() << ", seq: " << ackHdr->GetSequence());
+        if (m_hopFrames.empty())
+            return false;
+
+        //ACK frames are sent from destination to source of the flow
+        std::pair<Mac48Address, Mac48Address> srcDst(ackHdr->GetDestination(), ackHdr->GetSource());
+
+        if (ackHdr->IsPartialAckFrame()) {
+            if (ackHdr->GetSender() == m_mac->GetAddress() || !ackHdr->IsACK())
+                return false;
+            //PART ACK of another node's transmission (e.g. of upstream hop overheard here) does not confirm our hop
+            if (ackHdr->GetTransmitter() != m_mac->GetAddress())
+                return false;
+            HopStateList::iterator it = m_hopFrames.find(HopKey(srcDst, ackHdr->GetSequence()));
+            if (it == m_hopFrames.end())
+                return false;
+            NS_LOG_INFO("GOT PART ACK from: " << ackHdr->GetSender() << ", src: " << srcDst.first << ", dst: " << srcDst.second << ", seq: " << ackHdr->GetSequence());
+            m_timers.Cancel(it->second.hopTimer);
+            m_hopFrames.erase(it);
+            return true;
+        }
+
+        //E2E ACK confirms all hops of acknowledged frames
+        bool retval = false;
+        for (HopStateList::iterator it = m_hopFrames.lower_bound(HopKey(srcDst, 0));
+                (it != m_hopFrames.end()) && (it->first.first == srcDst);) {
+            if (IsSeqACKed(it->first.second, ackHdr)) {
+                m_timers.Cancel(it->second.hopTimer);
+                m_hopFrames.erase(it++);
+                retval = true;
+            } else
+                it++;
+        }
+        return retval;
+    }
+
+    void
+    RescueArqManager::HopAckTimeout(HopKey key) {
+        NS_LOG_FUNCTION("src: " << key.first.first << ", dst: " << key.first.second << ", seq: " << key.second);
+        HopStateList::iterator it = m_hopFrames.find(key);
+        if (it == m_hopFrames.end())
+            return;
+        HopState &state = it->second;
+        state.hopTimer = 0;
+
+        bool own = (key.first.first == m_mac->GetAddress());
+        bool acked = own ? !NeedDataRetransmission(key.first.second, key.second) : IsFwdACKed(&state.phyHdr);
+        if (acked) {
+            m_hopFrames.erase(it);
+            return;
+        }
+        if (state.retryCount >= m_maxHopRetryCount) {
+            NS_LOG_INFO("HOP TX FAIL! left to end-to-end ARQ, src: " << key.first.first << ", dst: " << key.first.second << ", seq: " << key.second);
+            m_hopFrames.erase(it);
+            return;
+        }
+
+        NS_LOG_INFO("!!! HOP ACK TIMEOUT !!! LOCAL RETRANSMISSION for src: " << key.first.first << ", dst: " << key.first.second << ", seq: " << key.second);
+        state.retryCount++;
+        m_hopRetransmissions++;
+        Ptr<Packet> pkt = state.pkt->Copy();
+        if (own) {
+            RescueMacHeader hdr;
+            pkt->RemoveHeader(hdr);
+            hdr.SetRetry();
+            pkt->AddHeader(hdr);
+            m_mac->EnqueueRetry(pkt, key.first.second);
+        } else {
+            RescuePhyHeader phyHdr = state.phyHdr;
+            phyHdr.SetRetry();
+            m_mac->EnqueueRelay(pkt, phyHdr);
+        }
+    }
+
+    RescueArqStats
+    RescueArqManager::GetStats(void) const {
+        RescueArqStats stats;
+        stats.destinations = GetTrackedDestinations();
+        stats.sources = GetTrackedSources();
+        stats.relayedFlows = GetTrackedRelayedFlows();
+        stats.outstandingFrames = GetOutstandingFrames();
+        stats.hopFrames = m_hopFrames.size();
+        stats.runningTimers = m_timers.GetSize();
+        stats.memoryUsage = GetMemoryUsage();
+        stats.retransmissions = m_retransmissions;
+        stats.hopRetransmissions = m_hopRetransmissions;
+        stats.timersArmed = GetTimersArmed();
+        stats.timersCancelled = GetTimersCancelled();
+        stats.seqRecycles = m_seqRecycles;
+        return stats;
+    }
+
+    uint32_t
+    RescueArqManager::GetTrackedDestinations(void) const {
+        return m_createdFrames.size();
+    }
+
+    uint32_t
+    RescueArqManager::GetTrackedSources(void) const {
+        return m_receivedFrames.size();
+    }
+
+    uint32_t
+    RescueArqManager::GetTrackedRelayedFlows(void) const {
+        return m_forwardedFrames.size();
+    }
+
+    uint32_t
+    RescueArqManager::GetOutstandingFrames(void) const {
+        uint32_t frames = 0;
+        for (SendSeqList::const_iterator it = m_createdFrames.begin(); it != m_createdFrames.end(); it++)
+            frames += it->second.unACKedFrames;
+        return frames;
+    }
+
+    uint32_t
+    RescueArqManager::GetMemoryUsage(void) const {
+        //map nodes keep about four pointers besides the stored pair
+        const uint32_t node = 4 * sizeof (void *);
+        return m_createdFrames.size() * (sizeof (SendSeqList::value_type) + node)
+                + m_receivedFrames.size() * (sizeof (RecvSeqList::value_type) + node)
+                + m_forwardedFrames.size() * (sizeof (FwdSeqList::value_type) + node)
+                + m_hopFrames.size() * (sizeof (HopStateList::value_type) + node)
+                + m_timers.GetMemoryUsage();
+    }
+
+    uint64_t
+    RescueArqManager::GetRetransmissions(void) const {
+        return m_retransmissions;
+    }
+
+    uint64_t
+    RescueArqManager::GetHopRetransmissions(void) const {
+        return m_hopRetransmissions;
+    }
+
+    uint64_t
+    RescueArqManager::GetTimersArmed(void) const {
+        return m_timers.GetArmedCount();
+    }
+
+    uint64_t
+    RescueArqManager::GetTimersCancelled(void) const {
+        return m_timers.GetCancelledCount();
+    }
+
+    uint64_t
+    RescueArqManager::GetSeqRecycles(void) const {
+        return m_seqRecycles;
+    }
+
+    void
+    RescueArqManager::SampleStats(void) {
+        m_statsTrace(GetStats());
+        m_statsEvent = Simulator::Schedule(m_statsInterval, &RescueArqManager::SampleStats, this);
+    }
+
     Time
     RescueArqManager::GetTimeoutFor(const RescuePhyHeader *ackHdr) {
         if (ackHdr->IsBlockAckEnabled()) {
@@ -1343,7 +1978,8 @@ namespace ns3 {
             return m_blockAckTimeout;
         } else {
             NS_LOG_FUNCTION("normal ACK");
-            return m_longAckTimeout;
+            //the estimation of the flow destination (ACK frames are sent by the destination)
+            return GetAckTimeout(ackHdr->IsDataFrame() ? ackHdr->GetDestination() : ackHdr->GetSource());
         }
     }
 
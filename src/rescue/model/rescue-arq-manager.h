@@ -24,19 +24,27 @@
 #define MAX_WINDOW_SIZE 255
 #define ARRAY_END 65535
 #define HALF_OF_ARRAY 32767
+#define FWD_ACK_HEADERS 32
+#define FWD_RELAYS 16
 
 #include "ns3/mac48-address.h"
 #include "ns3/traced-callback.h"
 #include "ns3/packet.h"
 #include "ns3/event-id.h"
-#include "ns3/timer.h"
+#include "ns3/event-impl.h"
+#include "ns3/random-variable-stream.h"
 
 #include "rescue-phy-header.h"
 #include "rescue-mac-header.h"
 #include "rescue-mac.h"
+#include "rescue-seq-window.h"
+#include "rescue-timer-wheel.h"
+#include "rescue-network-coding.h"
+#include "rescue-rtt-estimator.h"
 
 #include <stdint.h>
 #include <map>
+#include <vector>
 
 namespace ns3 {
 
@@ -45,19 +53,41 @@ namespace ns3 {
     /**
      * \ingroup rescue
      *
-     * Handles advanced ARQ functions
+     * Snapshot of the size and activity of ARQ state (see RescueArqManager::GetStats)
+     */
+    struct RescueArqStats {
+        uint32_t destinations; //!< Number of destinations of originated frames
+        uint32_t sources; //!< Number of sources of received frames
+        uint32_t relayedFlows; //!< Number of relayed (source, destination) flows
+        uint32_t outstandingFrames; //!< Number of originated frames awaiting acknowledgement
+        uint32_t hopFrames; //!< Number of frames awaiting hop acknowledgement
+        uint32_t runningTimers; //!< Number of armed ARQ timeouts
+        uint32_t memoryUsage; //!< Approximate number of bytes used by ARQ state
+        uint64_t retransmissions; //!< End-to-end retransmissions since start
+        uint64_t hopRetransmissions; //!< Local (hop) retransmissions since start
+        uint64_t timersArmed; //!< ARQ timeouts armed since start
+        uint64_t timersCancelled; //!< ARQ timeouts cancelled since start
+        uint64_t seqRecycles; //!< Recycling events of a half of sequence space since start
+    };
+
+    /**
+     * \ingroup rescue
+     *
+     * Handles advanced ARQ functions (full ARQ strategy). Lower MACs use ARQ through
+     * the virtual methods of this class, simpler strategies (RescueArqManagerSimple,
+     * RescueArqManagerNone) override them.
      */
     class RescueArqManager : public Object {
     public:
 
         //MODIF 3
-        void RelayingStopAck(Mac48Address, uint16_t);
+        virtual void RelayingStopAck(Mac48Address, uint16_t);
 
 
         static TypeId GetTypeId(void);
 
         RescueArqManager();
-        ~RescueArqManager();
+        virtual ~RescueArqManager();
 
         /**
          * \param phy the MAC of this device
@@ -87,7 +117,12 @@ namespace ns3 {
         /**
          * \return true if ARQ allows for next data transmission to given destination
          */
-        bool IsTxAllowed(Mac48Address dst);
+        virtual bool IsTxAllowed(Mac48Address dst);
+        /**
+         * \return the number of new data frames which can be transmitted to given destination
+         *         before the send window is exhausted
+         */
+        virtual uint16_t GetTxAllowance(Mac48Address dst);
 
         /**
          * sets next data transmission enabled
@@ -104,21 +139,21 @@ namespace ns3 {
          * \param hdr rescue PHY header
          * \return the next sequence number
          */
-        uint16_t GetNextSequenceNumber(const RescuePhyHeader *hdr);
+        virtual uint16_t GetNextSequenceNumber(const RescuePhyHeader *hdr);
         /**
          * Return the next sequence number for the given header.
          *
          * \param hdr rescue MAC header
          * \return the next sequence number
          */
-        uint16_t GetNextSequenceNumber(const RescueMacHeader *hdr);
+        virtual uint16_t GetNextSequenceNumber(const RescueMacHeader *hdr);
         /**
          * Return the next sequence number for the given destination.
          *
          * \param addr destination address
          * \return the next sequence number
          */
-        uint16_t GetNextSeqNumberByAddress(Mac48Address dst) const;
+        virtual uint16_t GetNextSeqNumberByAddress(Mac48Address dst) const;
 
         /**
          * Used to store info about sended packet
@@ -126,16 +161,16 @@ namespace ns3 {
          * \param dst destination address
          * \param seq sequence number of the frame
          */
-        void ReportNewDataFrame(Mac48Address dst, uint16_t seq);
+        virtual void ReportNewDataFrame(Mac48Address dst, uint16_t seq);
 
-        void ConfigurePhyHeader(RescuePhyHeader *phyHdr);
+        virtual void ConfigurePhyHeader(RescuePhyHeader *phyHdr);
 
         /**
          * Used to inform about data frame tx (new or retry)
          *
          * \param pkt transmitted packet
          */
-        void ReportDataTx(Ptr<Packet> pkt);
+        virtual void ReportDataTx(Ptr<Packet> pkt);
 
         /**
          * Used to process ACK frame
@@ -144,14 +179,23 @@ namespace ns3 {
          * \return the retry counter value or -1 in case of unsuccessful ACK reception
          *         (duplicated ACK etc.)
          */
-        int ReceiveAck(const RescuePhyHeader *ackHdr);
+        virtual int ReceiveAck(const RescuePhyHeader *ackHdr);
 
         /**
          * invoked when ACK Timoeut counter expires
          *
          * \param pkt packet for which the timeout has expired (including header)
          */
-        void AckTimeout(Ptr<Packet> pkt);
+        virtual void AckTimeout(Ptr<Packet> pkt);
+
+        /**
+         * Used to inform about the drop of originated frame (e.g. by AQM) after it got its
+         * sequence number - ARQ state of the frame is released and the final failure is reported
+         *
+         * \param dst destination address
+         * \param seq sequence number of dropped frame
+         */
+        virtual void ReportDataDrop(Mac48Address dst, uint16_t seq);
 
         /**
          * \param address remote address
@@ -159,7 +203,7 @@ namespace ns3 {
          * \return true if we want to resend a packet
          *          after a failed transmission attempt, false otherwise.
          */
-        bool NeedDataRetransmission(Mac48Address dst, uint16_t seq);
+        virtual bool NeedDataRetransmission(Mac48Address dst, uint16_t seq);
 
         /**
          * used to check sequence number of incoming frame to prevent
@@ -170,7 +214,7 @@ namespace ns3 {
          * \param useContinousACK true if Continous ACK should be used
          * \return false if frame is duplicated
          */
-        bool CheckRxSequence(Mac48Address src, uint16_t seq, bool useContinousACK);
+        virtual bool CheckRxSequence(Mac48Address src, uint16_t seq, bool useContinousACK);
 
         /**
          * used to notify and check sequence number of incoming frame
@@ -190,25 +234,43 @@ namespace ns3 {
          * \param ackHdr ACK header to configure in case of ACK transmission after this packet reception
          * \return false if frame is duplicated
          */
-        bool CheckRxFrame(const RescuePhyHeader *phyHdr, RescuePhyHeader *ackHdr);
+        virtual bool CheckRxFrame(const RescuePhyHeader *phyHdr, RescuePhyHeader *ackHdr);
 
-        void ReportDamagedFrame(const RescuePhyHeader *phyHdr);
+        virtual void ReportDamagedFrame(const RescuePhyHeader *phyHdr);
+
+        /**
+         * Used to pass the payload of new, correctly received DATA frame (after CheckRxFrame).
+         * With coded retransmissions enabled, payloads of originals are kept for decoding,
+         * coded frames are decoded and the recovered frames are forwarded up by ARQ.
+         *
+         * \param pkt the payload of received frame (without MAC header and trailer)
+         * \param phyHdr PHY header of received DATA frame
+         * \param coded true if the frame carries a coded combination (it must not be forwarded up)
+         */
+        virtual void ReportDataRx(Ptr<const Packet> pkt, const RescuePhyHeader *phyHdr, bool coded);
 
         void NackTimeout(RescuePhyHeader phyHdr);
 
         void BlockAckTimeout(Mac48Address src);
 
+        /**
+         * Sends coded retransmissions of the frames to given destination collected after ACK timeouts
+         *
+         * \param dst the destination address
+         */
+        void SendCodedRetransmission(Mac48Address dst);
+
         void ConfigureAckHeader(const RescuePhyHeader *phyHdr, RescuePhyHeader *ackHdr);
 
-        std::pair<RelayBehavior, RescuePhyHeader> ReportRelayFrameRx(const RescuePhyHeader *phyHdr, double ber);
+        virtual std::pair<RelayBehavior, RescuePhyHeader> ReportRelayFrameRx(const RescuePhyHeader *phyHdr, double ber);
 
-        bool ReportAckToFwd(const RescuePhyHeader *ackHdr);
+        virtual bool ReportAckToFwd(const RescuePhyHeader *ackHdr);
 
-        bool IsRetryACKed(const RescueMacHeader *hdr);
+        virtual bool IsRetryACKed(const RescueMacHeader *hdr);
 
-        bool IsFwdACKed(const RescuePhyHeader *phyHdr);
+        virtual bool IsFwdACKed(const RescuePhyHeader *phyHdr);
 
-        void ReportRelayDataTx(const RescuePhyHeader *phyHdr);
+        virtual void ReportRelayDataTx(const RescuePhyHeader *phyHdr);
 
         bool IsSeqACKed(uint16_t seq, const RescuePhyHeader *ackHdr);
 
@@ -216,12 +278,89 @@ namespace ns3 {
 
         bool SeqComp(uint16_t seq1, uint16_t seq2);
 
-        Time GetTimeoutFor(const RescuePhyHeader *ackHdr);
+        virtual Time GetTimeoutFor(const RescuePhyHeader *ackHdr);
+
+        /**
+         * \return true if each hop of DATA frames is acknowledged with PART ACK and retransmitted locally
+         */
+        virtual bool IsHopAckEnabled(void) const;
+        /**
+         * \param phyHdr PHY header of received DATA frame
+         * \return the PART ACK header acknowledging the hop of given frame
+         */
+        RescuePhyHeader GetHopAckHeader(const RescuePhyHeader *phyHdr) const;
+        /**
+         * Relays of a flow are ranked by their addresses among the relays of the flow heard so far,
+         * so that each of them acknowledges the hop in its own slot.
+         *
+         * \param phyHdr PHY header of received DATA frame
+         * \return the index of this station among the relays of the flow of given frame
+         */
+        uint8_t GetRelayIndex(const RescuePhyHeader *phyHdr) const;
+        /**
+         * Used to inform about DATA frame transmission (own or relayed), starts hop ACK timeout of the frame
+         *
+         * \param pkt transmitted frame (including MAC header, without PHY header)
+         * \param phyHdr PHY header of transmitted frame
+         */
+        virtual void ReportHopTx(Ptr<const Packet> pkt, const RescuePhyHeader *phyHdr);
+        /**
+         * Used to process PART ACK frames and E2E ACK frames (E2E ACK confirms all hops of acknowledged frames)
+         *
+         * \param ackHdr header of the ACK frame
+         * \return true if hop ACK timeout of any frame was cancelled
+         */
+        virtual bool ReceiveHopAck(const RescuePhyHeader *ackHdr);
+
+        /**
+         * \return the snapshot of the size and activity of ARQ state
+         */
+        RescueArqStats GetStats(void) const;
+        /**
+         * \return the number of destinations of originated frames
+         */
+        uint32_t GetTrackedDestinations(void) const;
+        /**
+         * \return the number of sources of received frames
+         */
+        uint32_t GetTrackedSources(void) const;
+        /**
+         * \return the number of relayed (source, destination) flows
+         */
+        uint32_t GetTrackedRelayedFlows(void) const;
+        /**
+         * \return the number of originated frames awaiting acknowledgement (all destinations)
+         */
+        uint32_t GetOutstandingFrames(void) const;
+        /**
+         * \return the approximate number of bytes used by ARQ state
+         *         (lists, timers and the wheel; frame buffers are not included)
+         */
+        uint32_t GetMemoryUsage(void) const;
+        /**
+         * \return the number of end-to-end retransmissions
+         */
+        uint64_t GetRetransmissions(void) const;
+        /**
+         * \return the number of local (hop) retransmissions
+         */
+        uint64_t GetHopRetransmissions(void) const;
+        /**
+         * \return the number of armed ARQ timeouts
+         */
+        uint64_t GetTimersArmed(void) const;
+        /**
+         * \return the number of ARQ timeouts cancelled before expiry
+         */
+        uint64_t GetTimersCancelled(void) const;
+        /**
+         * \return the number of recycling events of a half of sequence space
+         */
+        uint64_t GetSeqRecycles(void) const;
 
     protected:
         void DoDispose(void);
 
-    private:
         bool m_txAllowed; //!< Allowance for next data frame transmission
         Time m_basicAckTimeout; //!< The maximal duration of ACK awaiting
         Time m_longAckTimeout; //!< The maximal duration of ACK awaiting
@@ -232,30 +371,129 @@ namespace ns3 {
         bool m_useContinousACK; //!< Enable/disable use of continous ACK
         bool m_useBlockACK; //!< Enable/disable use of continous ACK
         Time m_blockAckTimeout; //!< After this period Block ACK will be send
+        uint16_t m_blockAckSize; //!< Maximal number of frames in block ACK field
         bool m_useBlockNACK; //!< If true, BlockACK can be started with unsuccessfully received frame
+        bool m_codedRetransmission; //!< If true, lost frames are retransmitted as network-coded combinations
+        uint8_t m_codingRedundancy; //!< Number of coded frames sent in addition to the XOR of all lost frames
+        Time m_codingDelay; //!< The time of collecting ACK timeouts before coded retransmission
+        bool m_useHopAck; //!< If true, each hop is acknowledged with PART ACK and retransmitted locally
+        Time m_hopAckTimeout; //!< The maximal duration of PART ACK awaiting
+        uint8_t m_maxHopRetryCount; //!< Maximum number of local retransmissions of a single hop
+        bool m_adaptiveAckTimeout; //!< If true, ACK timeouts are estimated from RTT of each destination
+        Time m_minAckTimeout; //!< Lower bound of estimated ACK timeout
+        Time m_maxAckTimeout; //!< Upper bound of estimated ACK timeout (also limits the backoff)
 
         Ptr<RescueMac> m_mac; //!< Pointer to associated RescueMac
 
-        typedef std::map<std::pair <Mac48Address, uint16_t>, Timer> TimersList;
-        TimersList m_ackTimeoutTimers; //!< End-to-end ACK timeout events
-        TimersList m_nackTimeoutTimers; //!< End-to-end NACK timeout events
-        TimersList m_blockAckTimeoutTimers; //!< End-to-end BLOCK ACK timeout events
+        /**
+         * The trace source fired when the transmission of a single data packet has failed
+         */
+        TracedCallback<Mac48Address> m_macTxDataFailed;
+        /**
+         * The trace source fired when the transmission of a data packet has
+         * exceeded the maximum number of attempts
+         */
+        TracedCallback<Mac48Address> m_macTxFinalDataFailed;
+        /**
+         * The trace source fired when the ACK timeout estimation of a destination changes
+         * (destination, smoothed RTT, ACK timeout)
+         */
+        TracedCallback<Mac48Address, Time, Time> m_ackTimeoutEstimate;
+        /**
+         * The trace source fired periodically (StatsInterval) with the snapshot of ARQ state
+         */
+        TracedCallback<const RescueArqStats &> m_statsTrace;
+
+        Time m_statsInterval; //!< Period of ARQ state sampling (0 - disabled)
+        EventId m_statsEvent; //!< Next ARQ state sampling
+        uint64_t m_retransmissions; //!< Number of end-to-end retransmissions
+        uint64_t m_hopRetransmissions; //!< Number of local (hop) retransmissions
+        uint64_t m_seqRecycles; //!< Number of recycling events of a half of sequence space
+
+        /**
+         * Fires the ARQ state trace and schedules next sampling
+         */
+        void SampleStats(void);
+        /**
+         * Reports failed transmission attempt of a frame (trace and rate control of the destination)
+         *
+         * \param dst destination address
+         */
+        void NotifyDataFailed(Mac48Address dst);
+        /**
+         * Reports the final failure of a frame (trace and rate control of the destination)
+         *
+         * \param dst destination address
+         */
+        void NotifyFinalDataFailed(Mac48Address dst);
+
+    private:
+        RescueTimerWheel m_timers; //!< Timing wheel of all ARQ timeouts (single simulator event)
+        Ptr<UniformRandomVariable> m_codingRandom; //!< Provides random coding vectors
+
+        /*
+         * List to keep frames transmitted on the current hop until they are acknowledged by PART ACK
+         */
+        typedef std::pair<std::pair<Mac48Address, Mac48Address>, uint16_t> HopKey; //!< (source, destination) and SEQ number of a frame
+
+        struct HopState {
+            Ptr<Packet> pkt; //!< Copy of transmitted frame, for local retransmission
+            RescuePhyHeader phyHdr; //!< PHY header of transmitted frame
+            uint8_t retryCount; //!< Local retransmissions counter of given frame
+            RescueTimerWheel::Handle hopTimer; //!< Hop ACK timeout of given frame
+
+            HopState() : pkt(0), retryCount(0), hopTimer(0) {
+            }
+        };
+        typedef std::map<HopKey, HopState> HopStateList;
+        HopStateList m_hopFrames; //!< Frames awaiting hop acknowledgement
+
+        /**
+         * invoked when hop ACK timeout expires - the frame is retransmitted locally
+         *
+         * \param key the flow and SEQ number of the frame
+         */
+        void HopAckTimeout(HopKey key);
 
         /*
          * List to keep information about transmitted and ACKed frames
          */
+        struct SendSeqState {
+            bool ACKed; //!< Indicates that the frame was correctly acknowledged
+            uint8_t retryCount; //!< Retry counter for given frame
+            RescueTimerWheel::Handle ackTimer; //!< End-to-end ACK timeout of given frame
+            Ptr<Packet> ackTimerPkt; //!< The frame passed to ACK timeout (0 - no ACK timer for given frame)
+            Time txTime; //!< The time of the only transmission of given frame (0 - retransmitted, no RTT sample)
+
+            SendSeqState() : ACKed(false), retryCount(0), ackTimer(0), ackTimerPkt(0), txTime(Seconds(0)) {
+            }
+        };
+
         struct SendList {
-            bool ACKed [ARRAY_END + 1]; //!< Indicates that the frame was correctly acknowledged
-            uint8_t retryCount [ARRAY_END + 1]; //!< Retry counter for given frame
+            RescueSeqWindow<SendSeqState> seqState; //!< State of recently transmitted frames
             uint16_t nextSequence; //!< Stores the next sequence number to be send
             uint8_t unACKedFrames; //!< Unacknowledged frames counter
             uint8_t rxedUnACKedFrames; //!< Number of frames that are received by remote station but were not acknowledged (because of blockACK limitation)
             uint16_t contACKed; //!< Indicates last SEQ number acknowledged by Continous ACK
+            std::vector<uint16_t> codingSet; //!< Frames awaiting coded retransmission
+            RescueTimerWheel::Handle codingTimer; //!< Timer of coded retransmission
+            RescueRttEstimator rtt; //!< Round trip time and ACK timeout estimation
+            Time lastBackoff; //!< The time of last ACK timeout backoff
         };
         typedef std::map<Mac48Address, SendList> SendSeqList;
 
         SendSeqList m_createdFrames; //!< List of originated frames
 
+        /**
+         * Returns the state of given sent frame to modify. If the ring slot of the frame
+         * is taken over from another sequence number, the ACK timeout of that frame is cancelled.
+         *
+         * \param list the send list of destination
+         * \param seq sequence number of a given frame
+         * \return the state of the frame
+         */
+        SendSeqState &GetSendState(SendList &list, uint16_t seq);
+
         /**
          * Used to acknowledge given sended frame
          *
@@ -266,19 +504,51 @@ namespace ns3 {
 
         void UnacknowledgeFrame(SendSeqList::iterator it, uint16_t seq);
 
+        /**
+         * \param dst the destination address
+         * \return the ACK timeout of frames sent to given destination
+         */
+        Time GetAckTimeout(Mac48Address dst) const;
+        /**
+         * Initializes the state of new destination
+         *
+         * \param list the send list of new destination
+         */
+        void InitSendList(SendList &list);
+        /**
+         * Updates RTT estimation of destination with acknowledged frame (if it was transmitted once)
+         *
+         * \param it the send list entry
+         * \param seq the SEQ number of acknowledged frame
+         */
+        void SampleRtt(SendSeqList::iterator it, uint16_t seq);
+
         /*
          * List to keep information about received frames in order to prepare ACKs
          */
+        struct RecvSeqState {
+            bool copyRXed; //!< Indicates that almost one copy of the given frame was received
+            bool RXed; //!< Indicates that the frame was correctly received
+            Ptr<Packet> payload; //!< Payload of received frame, kept for decoding of coded frames
+            RescueTimerWheel::Handle nackTimer; //!< End-to-end NACK timeout of given frame
+
+            RecvSeqState() : copyRXed(false), RXed(false), payload(0), nackTimer(0) {
+            }
+        };
+
         struct RecvList {
-            bool copyRXed [ARRAY_END + 1]; //!< Indicates that almost one copy of the given frame was received
-            bool RXed [ARRAY_END + 1]; //!< Indicates that the frame was correctly received
-            Time RXtime [ARRAY_END + 1]; //!< Stores the time of frame correct reception
+            RescueSeqWindow<RecvSeqState> seqState; //!< State of recently received frames
             uint16_t expectedSeq; //!< First expected SEQ number, for Continous ACK preparation
             bool receivedFirstFrame; //!< Indicates if the first frame was received from given source, important for continous ACK
             uint16_t maxSeqACKed; //!< Indicates last SEQ number for which ACK was sent
             uint16_t maxSeqCopyRXed; //!< Indicates last SEQ number for which almost one frame copy was received
             //uint8_t NACKedFrames;          //!< Unsuccessfully received frames counter
             RescuePhyHeader newestHeader; //!< Stores the header of recently received frame
+            RescueCodedDecoder decoder; //!< Not yet decoded combinations of coded frames
+            RescueTimerWheel::Handle blockAckTimer; //!< End-to-end BLOCK ACK timeout of given source
+            uint16_t payloadBase; //!< Oldest SEQ number whose payload may be kept (the coding span ends at the newest kept one)
+            Time rxTimeBase; //!< Base of reception times of in-window frames
+            uint32_t rxTimeDelta [SEQ_WINDOW_SIZE]; //!< Reception times of correctly received in-window frames (microseconds since rxTimeBase, same ring index as seqState)
 
             /* We cannot reuse all sequences at once because in advanced ARQ operation some frames with high seq. number
              * may be transmitted at the same time with low seq. numbers. (E.g. SEQ=0 is the next seq for SEQ=65535)
@@ -292,20 +562,72 @@ namespace ns3 {
         typedef std::map<Mac48Address, RecvList> RecvSeqList;
         RecvSeqList m_receivedFrames; //!< List of originated frames
 
+        /**
+         * Marks decoded frames as received, forwards them up and acknowledges them
+         *
+         * \param it the received frames list entry
+         * \param phyHdr PHY header of the frame which allowed for decoding
+         * \param decoded the decoded frames
+         */
+        void DeliverDecoded(RecvSeqList::iterator it, const RescuePhyHeader *phyHdr, const RescueCodedDecoder::DecodedList &decoded);
+        /**
+         * Keeps the payload of received frame for decoding of coded frames and releases
+         * the payloads which fell out of the coding span of the newest kept one
+         *
+         * \param list the received frames list entry
+         * \param seq the SEQ number of received frame
+         * \param pkt the payload of received frame
+         */
+        void KeepPayload(RecvList &list, uint16_t seq, Ptr<const Packet> pkt);
+        /**
+         * (Re)starts the NACK timeout of given frame
+         *
+         * \param list the received frames list entry
+         * \param seq the SEQ number of damaged frame
+         * \param phyHdr the PHY header used to prepare NACK
+         * \param delay the timeout
+         */
+        void ArmNackTimer(RecvList &list, uint16_t seq, const RescuePhyHeader &phyHdr, Time delay);
+        /**
+         * Stores current time as the reception time of given frame
+         *
+         * \param list the received frames list entry
+         * \param seq the SEQ number of correctly received frame
+         */
+        void SetRxTime(RecvList &list, uint16_t seq);
+        /**
+         * \param list the received frames list entry
+         * \param seq the SEQ number of the frame
+         * \return the reception time of given frame (0 if it was not correctly received)
+         */
+        Time GetRxTime(const RecvList &list, uint16_t seq) const;
+
         /*
          * List to keep information about forwarded frames and ACKs - to prevent loops and to reduce traffic intensity
          * while flooding mechanism is in use
          */
+        struct FwdSeqState {
+            bool RXed; //!< Indicates that the copy of the given frame is enqueued and awiats for transmission
+            bool TXed; //!< Indicates that the frame copy was transmitted
+            uint8_t IL; //!< Stores the InterLeaver number of last transmitted copy
+            double ber; //!< Stores the BER of last received/transmitted copy
+            bool ACKed; //!< Indicates that the frame copy was acknowledged
+            bool retried; //!< Indicates that the frame copy was retransmitted
+            uint32_t ackHdrId; //!< Identifier of stored ACK header for ACK retransmission (0 - none)
+
+            FwdSeqState() : RXed(false), TXed(false), IL(0), ber(0.0), ACKed(false), retried(false), ackHdrId(0) {
+            }
+        };
+
         struct FwdList {
-            bool RXed [ARRAY_END + 1]; //!< Indicates that the copy of the given frame is enqueued and awiats for transmission
-            bool TXed [ARRAY_END + 1]; //!< Indicates that the frame copy was transmitted
-            uint8_t IL [ARRAY_END + 1]; //!< Stores the InterLeaver number of last transmitted copy
-            double ber [ARRAY_END + 1]; //!< Stores the BER of last received/transmitted copy
-            bool ACKed [ARRAY_END + 1]; //!< Indicates that the frame copy was acknowledged
-            bool retried [ARRAY_END + 1]; //!< Indicates that the frame copy was retransmitted
+            RescueSeqWindow<FwdSeqState> seqState; //!< State of recently relayed frames
             uint16_t contACKed; //!< Indicates last SEQ number acknowledged by Continous ACK
             uint16_t maxSeqACKed; //!< Indicates last ACKed SEQ number
-            std::vector<RescuePhyHeader> ackHdr; //!< Stores ACK header for ACK retransmission
+            RescuePhyHeader ackHdr [FWD_ACK_HEADERS]; //!< Recently received ACK headers, stored for ACK retransmission
+            uint32_t ackHdrId [FWD_ACK_HEADERS]; //!< Identifiers of stored ACK headers
+            uint32_t nextAckHdrId; //!< Identifier of next stored ACK header
+            Mac48Address relays [FWD_RELAYS]; //!< Other relays of the flow (senders of relayed copies)
+            uint8_t nRelays; //!< Number of known relays of the flow
             //RescuePhyHeader ackHdr[ARRAY_END + 1];   //!< Stores ACK header for ACK retransmission
             //Time lastNACKrx [ARRAY_END + 1];          //!< Stores the time of last NACK reception
 
@@ -323,17 +645,26 @@ namespace ns3 {
 
         FwdSeqList m_forwardedFrames; //!< List of recently transmitted / relayed frames - to prevent loops
 
-
-
         /**
-         * The trace source fired when the transmission of a single data packet has failed
+         * \param it the forwarded frames list entry
+         * \param ackHdr the ACK header to store
+         * \return the identifier of stored ACK header
          */
-        TracedCallback<Mac48Address> m_macTxDataFailed;
+        uint32_t StoreFwdAckHeader(FwdSeqList::iterator it, const RescuePhyHeader *ackHdr);
         /**
-         * The trace source fired when the transmission of a data packet has
-         * exceeded the maximum number of attempts
+         * \param it the forwarded frames list entry
+         * \param id the identifier of stored ACK header
+         * \return the stored ACK header (0 if it was already overwritten)
          */
-        TracedCallback<Mac48Address> m_macTxFinalDataFailed;
+        const RescuePhyHeader* GetFwdAckHeader(FwdSeqList::iterator it, uint32_t id) const;
+        /**
+         * Stores the sender of received DATA frame as a relay of its flow (if it is not the source)
+         *
+         * \param list the forwarded frames list entry
+         * \param phyHdr PHY header of received DATA frame
+         */
+        void NoteFlowRelay(FwdList &list, const RescuePhyHeader *phyHdr);
+
     };
 
 } // namespace ns3
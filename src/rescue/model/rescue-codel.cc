@@ -0,0 +1,205 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 AGH Univeristy of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/tag.h"
+
+#include "rescue-codel.h"
+
+#include <cmath>
+
+NS_LOG_COMPONENT_DEFINE("RescueCoDel");
+
+namespace ns3 {
+
+    /**
+     * \ingroup rescue
+     * \brief Tag keeping the time of frame enqueue in lower MAC queue
+     */
+    class RescueEnqueueTimeTag : public Tag {
+    public:
+
+        RescueEnqueueTimeTag()
+        : m_enqueueTime(0) {
+        }
+
+        RescueEnqueueTimeTag(Time enqueueTime)
+        : m_enqueueTime(enqueueTime.GetTimeStep()) {
+        }
+
+        static TypeId GetTypeId(void) {
+            static TypeId tid = TypeId("ns3::RescueEnqueueTimeTag")
+                    .SetParent<Tag> ()
+                    .AddConstructor<RescueEnqueueTimeTag> ()
+                    ;
+            return tid;
+        }
+
+        virtual TypeId GetInstanceTypeId(void) const {
+            return GetTypeId();
+        }
+
+        virtual uint32_t GetSerializedSize(void) const {
+            return sizeof (int64_t);
+        }
+
+        virtual void Serialize(TagBuffer i) const {
+            i.WriteU64(m_enqueueTime);
+        }
+
+        virtual void Deserialize(TagBuffer i) {
+            m_enqueueTime = i.ReadU64();
+        }
+
+        virtual void Print(std::ostream &os) const {
+            os << "enqueueTime=" << GetEnqueueTime();
+        }
+
+        Time GetEnqueueTime(void) const {
+            return TimeStep(m_enqueueTime);
+        }
+
+    private:
+        int64_t m_enqueueTime; //!< Enqueue time (in time steps)
+    };
+
+    NS_OBJECT_ENSURE_REGISTERED(RescueEnqueueTimeTag);
+
+    RescueCoDel::RescueCoDel()
+    : m_target(Seconds(0)),
+    m_interval(MilliSeconds(100)),
+    m_dropping(false),
+    m_count(0),
+    m_lastCount(0),
+    m_firstAboveTime(Seconds(0)),
+    m_dropNext(Seconds(0)) {
+    }
+
+    void
+    RescueCoDel::SetTarget(Time target) {
+        m_target = target;
+        Reset();
+    }
+
+    void
+    RescueCoDel::SetInterval(Time interval) {
+        m_interval = interval;
+        Reset();
+    }
+
+    Time
+    RescueCoDel::GetTarget(void) const {
+        return m_target;
+    }
+
+    Time
+    RescueCoDel::GetInterval(void) const {
+        return m_interval;
+    }
+
+    bool
+    RescueCoDel::IsEnabled(void) const {
+        return m_target > Seconds(0);
+    }
+
+    void
+    RescueCoDel::Reset(void) {
+        m_dropping = false;
+        m_count = 0;
+        m_lastCount = 0;
+        m_firstAboveTime = Seconds(0);
+        m_dropNext = Seconds(0);
+    }
+
+    bool
+    RescueCoDel::ShouldDrop(Time sojourn, uint32_t queued) {
+        if (!IsEnabled())
+            return false;
+
+        Time now = Simulator::Now();
+        bool okToDrop = OkToDrop(sojourn, queued);
+
+        if (m_dropping) {
+            if (!okToDrop) {
+                //sojourn time below target - leave dropping state
+                m_dropping = false;
+                return false;
+            }
+            if (now >= m_dropNext) {
+                m_count++;
+                m_dropNext = ControlLaw(m_dropNext);
+                NS_LOG_DEBUG("CoDel drop, count: " << m_count << ", next drop: " << m_dropNext);
+                return true;
+            }
+            return false;
+        }
+
+        if (okToDrop) {
+            //enter dropping state, start with the drop rate of previous dropping state if it was recent
+            m_dropping = true;
+            uint32_t delta = m_count - m_lastCount;
+            if (delta > 1 && now - m_dropNext < 16 * m_interval)
+                m_count = delta;
+            else
+                m_count = 1;
+            m_lastCount = m_count;
+            m_dropNext = ControlLaw(now);
+            NS_LOG_DEBUG("CoDel enters dropping state, sojourn: " << sojourn << ", count: " << m_count);
+            return true;
+        }
+        return false;
+    }
+
+    bool
+    RescueCoDel::OkToDrop(Time sojourn, uint32_t queued) {
+        Time now = Simulator::Now();
+        if (sojourn < m_target || queued <= 1) {
+            m_firstAboveTime = Seconds(0);
+            return false;
+        }
+        if (m_firstAboveTime == Seconds(0)) {
+            m_firstAboveTime = now + m_interval;
+            return false;
+        }
+        return now >= m_firstAboveTime;
+    }
+
+    Time
+    RescueCoDel::ControlLaw(Time t) const {
+        return t + Seconds(m_interval.GetSeconds() / std::sqrt((double) m_count));
+    }
+
+    void
+    RescueCoDel::SetEnqueueTime(Ptr<Packet> pkt) {
+        RescueEnqueueTimeTag tag;
+        pkt->RemovePacketTag(tag);
+        pkt->AddPacketTag(RescueEnqueueTimeTag(Simulator::Now()));
+    }
+
+    Time
+    RescueCoDel::GetSojournTime(Ptr<const Packet> pkt) {
+        RescueEnqueueTimeTag tag;
+        if (pkt->PeekPacketTag(tag))
+            return Simulator::Now() - tag.GetEnqueueTime();
+        return Seconds(0);
+    }
+
+} // namespace ns3
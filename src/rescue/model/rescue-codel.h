@@ -0,0 +1,115 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 AGH Univeristy of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+
+#ifndef RESCUE_CODEL_H
+#define RESCUE_CODEL_H
+
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+
+#include <stdint.h>
+
+namespace ns3 {
+
+    /**
+     * \ingroup rescue
+     *
+     * State of CoDel (Controlled Delay) active queue management for a single
+     * lower MAC queue. Frames are stamped with enqueue time, the decision to drop
+     * is taken for the head-of-line frame basing on its sojourn time: when sojourn time
+     * stays above the target for at least one interval, head-of-line frames are dropped
+     * with increasing frequency (interval / sqrt (count)) until sojourn time falls below
+     * the target.
+     */
+    class RescueCoDel {
+    public:
+        RescueCoDel();
+
+        /**
+         * \param target the acceptable sojourn time (0 - AQM disabled)
+         */
+        void SetTarget(Time target);
+        /**
+         * \param interval the time sojourn time may stay above the target before dropping starts
+         */
+        void SetInterval(Time interval);
+        /**
+         * \return the acceptable sojourn time
+         */
+        Time GetTarget(void) const;
+        /**
+         * \return the time sojourn time may stay above the target before dropping starts
+         */
+        Time GetInterval(void) const;
+        /**
+         * \return true if AQM is enabled (non-zero target)
+         */
+        bool IsEnabled(void) const;
+
+        /**
+         * Invoked for head-of-line frame of the queue to decide if it should be dropped
+         *
+         * \param sojourn the sojourn time of head-of-line frame
+         * \param queued the number of frames in the queue (including head-of-line frame)
+         * \return true if the frame should be dropped
+         */
+        bool ShouldDrop(Time sojourn, uint32_t queued);
+        /**
+         * Resets the dropping state (e.g. when the queue is cleared)
+         */
+        void Reset(void);
+
+        /**
+         * Stores current time in the packet as its enqueue time
+         *
+         * \param pkt the enqueued packet
+         */
+        static void SetEnqueueTime(Ptr<Packet> pkt);
+        /**
+         * \param pkt the queued packet
+         * \return the time elapsed since the packet was enqueued (0 if unknown)
+         */
+        static Time GetSojournTime(Ptr<const Packet> pkt);
+
+    private:
+        /**
+         * \param sojourn the sojourn time of head-of-line frame
+         * \param queued the number of frames in the queue
+         * \return true if sojourn time stays above the target for at least one interval
+         */
+        bool OkToDrop(Time sojourn, uint32_t queued);
+        /**
+         * \param t the time of last drop
+         * \return the time of next drop
+         */
+        Time ControlLaw(Time t) const;
+
+        Time m_target; //!< Acceptable sojourn time (0 - AQM disabled)
+        Time m_interval; //!< Interval of sojourn time observation
+        bool m_dropping; //!< True in dropping state
+        uint32_t m_count; //!< Number of drops since entering dropping state
+        uint32_t m_lastCount; //!< Number of drops in previous dropping state
+        Time m_firstAboveTime; //!< Time when sojourn time will have been above the target for one interval (0 - below target)
+        Time m_dropNext; //!< Time of next drop in dropping state
+    };
+
+} // namespace ns3
+
+#endif /* RESCUE_CODEL_H */
@@ -34,6 +34,7 @@
 #include "rescue-phy.h"
 #include "rescue-remote-station-manager.h"
 #include "rescue-arq-manager.h"
+#include "rescue-qos-scheduler.h"
 #include "rescue-mac-header.h"
 #include "rescue-mac-trailer.h"
 #include "rescue-mac-csma.h"
@@ -84,6 +85,7 @@ namespace ns3 {
         Clear();
         m_remoteStationManager = 0;
         m_arqManager = 0;
+        m_qosScheduler = 0;
     }
 
     void
@@ -95,6 +97,7 @@ namespace ns3 {
             m_backoffTimeoutEvent.Cancel();
         if (m_sendAckEvent.IsRunning())
             m_sendAckEvent.Cancel();
+        m_pendingAcks.clear();
 
         m_pktTx = 0;
         NS_LOG_DEBUG("RESET PACKET");
@@ -102,9 +105,15 @@ namespace ns3 {
         m_pktQueue.clear();
         m_pktRetryQueue.clear();
         m_pktRelayQueue.clear();
+        for (uint8_t q = 0; q <= DATA_QUEUE; q++)
+            m_classFrames[q].clear();
         m_ctrlPktQueue.clear();
         m_ackQueue.clear();
-        m_ackCache.clear();
+        m_ackCache.Clear();
+        m_pktAggregate.clear();
+        m_relayAqm.Reset();
+        m_retryAqm.Reset();
+        m_dataAqm.Reset();
     }
 
     TypeId
@@ -142,6 +151,52 @@ namespace ns3 {
                 UintegerValue(20),
                 MakeUintegerAccessor(&RescueMacCsma::m_queueLimit),
                 MakeUintegerChecker<uint32_t> ())
+                .AddAttribute("MaxAggregationAirtime",
+                "Maximum duration of aggregated transmission of DATA frames to the same destination (0 - aggregation disabled)",
+                TimeValue(Seconds(0)),
+                MakeTimeAccessor(&RescueMacCsma::m_maxAggregationAirtime),
+                MakeTimeChecker())
+                .AddAttribute("HopAckSlots",
+                "Number of slots for PART ACKs of relays after the ACK of the destination (slot of a relay is selected with its index among the relays of the flow)",
+                UintegerValue(4),
+                MakeUintegerAccessor(&RescueMacCsma::m_hopAckSlots),
+                MakeUintegerChecker<uint32_t> (1))
+                .AddAttribute("AckCacheSize",
+                "Maximum number of recently forwarded ACKs to store in ACK cache",
+                UintegerValue(128),
+                MakeUintegerAccessor(&RescueMacCsma::SetAckCacheSize,
+                &RescueMacCsma::GetAckCacheSize),
+                MakeUintegerChecker<uint32_t> (1))
+                .AddAttribute("AckCacheResolution",
+                "Resolution of ACK cache expiry (timer wheel tick)",
+                TimeValue(MilliSeconds(1)),
+                MakeTimeAccessor(&RescueMacCsma::SetAckCacheResolution,
+                &RescueMacCsma::GetAckCacheResolution),
+                MakeTimeChecker())
+                .AddAttribute("AqmTarget",
+                "Acceptable sojourn time of DATA frames in queues - CoDel target (0 - AQM disabled)",
+                TimeValue(Seconds(0)),
+                MakeTimeAccessor(&RescueMacCsma::SetAqmTarget,
+                &RescueMacCsma::GetAqmTarget),
+                MakeTimeChecker())
+                .AddAttribute("AqmInterval",
+                "Interval of sojourn time observation - CoDel interval",
+                TimeValue(MilliSeconds(100)),
+                MakeTimeAccessor(&RescueMacCsma::SetAqmInterval,
+                &RescueMacCsma::GetAqmInterval),
+                MakeTimeChecker())
+                .AddAttribute("RelayedLifetime",
+                "Maximal time a relayed DATA frame may wait in relay queue, then it is dropped as its source has noticed ACK timeout already (ACK enabled only, 0 - never dropped)",
+                TimeValue(MicroSeconds(15000)),
+                MakeTimeAccessor(&RescueMacCsma::m_relayedLifetime),
+                MakeTimeChecker())
+
+                .AddTraceSource("AqmDrop",
+                "Trace Hookup for DATA frame dropped by AQM or after ACK timeout expiration",
+                MakeTraceSourceAccessor(&RescueMacCsma::m_traceAqmDrop))
+                .AddTraceSource("QueueSojourn",
+                "Trace Hookup for the time spent in queue by transmitted DATA frame",
+                MakeTraceSourceAccessor(&RescueMacCsma::m_traceSojourn))
 
                 /*.AddTraceSource ("AckTimeout",
                                  "Trace Hookup for ACK Timeout",
@@ -208,9 +263,26 @@ namespace ns3 {
     RescueMacCsma::SetArqManager(Ptr<RescueArqManager> arqManager) {
         //NS_LOG_FUNCTION (this << arqManager);
         m_arqManager = arqManager;
+        m_ackCache.SetCompareCallback(MakeCallback(&RescueArqManager::ACKcomp, PeekPointer(arqManager)));
         //m_arqManager->SetBasicAckTimeout (m_basicAckTimeout);
     }
 
+    void
+    RescueMacCsma::SetQosScheduler(Ptr<RescueQosScheduler> scheduler) {
+        //NS_LOG_FUNCTION (this << scheduler);
+        m_qosScheduler = scheduler;
+        for (uint8_t q = 0; q <= DATA_QUEUE; q++)
+            m_classFrames[q].assign(scheduler != 0 ? scheduler->GetNClasses() : 0, 0);
+        if (scheduler == 0)
+            return;
+        for (RelayQueueI it = m_pktRelayQueue.begin(); it != m_pktRelayQueue.end(); it++)
+            CountClassFrame(*it, true);
+        for (QueueI it = m_pktRetryQueue.begin(); it != m_pktRetryQueue.end(); it++)
+            CountClassFrame(RETRY_QUEUE, *it, true);
+        for (QueueI it = m_pktQueue.begin(); it != m_pktQueue.end(); it++)
+            CountClassFrame(DATA_QUEUE, *it, true);
+    }
+
     void
     RescueMacCsma::SetCwMin(uint32_t cw) {
         m_cwMin = cw;
@@ -250,6 +322,30 @@ namespace ns3 {
         m_queueLimit = length;
     }
 
+    void
+    RescueMacCsma::SetAqmTarget(Time target) {
+        m_relayAqm.SetTarget(target);
+        m_retryAqm.SetTarget(target);
+        m_dataAqm.SetTarget(target);
+    }
+
+    void
+    RescueMacCsma::SetAqmInterval(Time interval) {
+        m_relayAqm.SetInterval(interval);
+        m_retryAqm.SetInterval(interval);
+        m_dataAqm.SetInterval(interval);
+    }
+
+    void
+    RescueMacCsma::SetAckCacheSize(uint32_t size) {
+        m_ackCache.SetCapacity(size);
+    }
+
+    void
+    RescueMacCsma::SetAckCacheResolution(Time resolution) {
+        m_ackCache.SetResolution(resolution);
+    }
+
     int64_t
     RescueMacCsma::AssignStreams(int64_t stream) {
         NS_LOG_FUNCTION(this << stream);
@@ -295,6 +391,26 @@ namespace ns3 {
         return m_queueLimit;
     }
 
+    Time
+    RescueMacCsma::GetAqmTarget(void) const {
+        return m_dataAqm.GetTarget();
+    }
+
+    Time
+    RescueMacCsma::GetAqmInterval(void) const {
+        return m_dataAqm.GetInterval();
+    }
+
+    uint32_t
+    RescueMacCsma::GetAckCacheSize(void) const {
+        return m_ackCache.GetCapacity();
+    }
+
+    Time
+    RescueMacCsma::GetAckCacheResolution(void) const {
+        return m_ackCache.GetResolution();
+    }
+
     Time
     RescueMacCsma::GetCtrlDuration(uint16_t type, RescueMode mode) {
         RescueMacHeader hdr = RescueMacHeader(m_hiMac->GetAddress(), m_hiMac->GetAddress(), type);
@@ -348,9 +464,19 @@ namespace ns3 {
             NS_LOG_DEBUG("PACKET QUEUE LIMIT REACHED - DROP FRAME!");
             return false;
         }
+        if (m_qosScheduler != 0) {
+            uint8_t tc = m_qosScheduler->Classify(pkt);
+            if (GetQueuedFrames(tc) >= m_qosScheduler->GetQueueLimit(tc, m_queueLimit)) {
+                dropped++;
+                NS_LOG_DEBUG("TC " << (uint32_t) tc << " QUEUE LIMIT REACHED - DROP FRAME!");
+                return false;
+            }
+        }
 
         //m_traceEnqueue (m_device->GetNode ()->GetId (), m_device->GetIfIndex (), pkt);
+        RescueCoDel::SetEnqueueTime(pkt);
         m_pktQueue.push_back(pkt);
+        CountClassFrame(DATA_QUEUE, pkt, true);
 
         if (m_state == IDLE) {
             CcaForLifs();
@@ -373,9 +499,18 @@ namespace ns3 {
             NS_LOG_DEBUG("PACKET RETRY QUEUE LIMIT REACHED - DROP FRAME!");
             return false;
         }
+        if (m_qosScheduler != 0) {
+            uint8_t tc = m_qosScheduler->Classify(pkt);
+            if (GetQueuedFrames(tc) >= m_qosScheduler->GetQueueLimit(tc, m_queueLimit)) {
+                NS_LOG_DEBUG("TC " << (uint32_t) tc << " QUEUE LIMIT REACHED - DROP RETRY FRAME!");
+                return false;
+            }
+        }
 
         //m_traceEnqueue (m_device->GetNode ()->GetId (), m_device->GetIfIndex (), pkt);
+        RescueCoDel::SetEnqueueTime(pkt);
         m_pktRetryQueue.push_back(pkt);
+        CountClassFrame(RETRY_QUEUE, pkt, true);
 
         if (m_state == IDLE) {
             CcaForLifs();
@@ -394,19 +529,31 @@ namespace ns3 {
                 "#ctrl queue:" << m_ctrlPktQueue.size() <<
                 "#ack queue:" << m_ackQueue.size() <<
                 "state:" << StateToString(m_state));
+        if (MergeRelayCopy(pkt, phyHdr))
+            return true;
         if (m_pktRelayQueue.size() >= m_queueLimit) {
             NS_LOG_DEBUG("PACKET RELAY QUEUE LIMIT REACHED - DROP FRAME!");
             return false;
         }
+        if (m_qosScheduler != 0) {
+            uint8_t tc = m_qosScheduler->Classify(pkt, phyHdr);
+            if (GetQueuedFrames(tc) >= m_qosScheduler->GetQueueLimit(tc, m_queueLimit)) {
+                NS_LOG_DEBUG("TC " << (uint32_t) tc << " QUEUE LIMIT REACHED - DROP RELAY FRAME!");
+                return false;
+            }
+        }
 
         //m_traceEnqueue (m_device->GetNode ()->GetId (), m_device->GetIfIndex (), pkt);
+        RescueCoDel::SetEnqueueTime(pkt);
         std::pair<Ptr<Packet>, RescuePhyHeader> relayPkt(pkt, phyHdr);
         NS_LOG_INFO("ENQUEUE RELAY DATA FRAME! from src: " << relayPkt.second.GetSource() << " to dst: " << relayPkt.second.GetDestination() << ", seq: " << relayPkt.second.GetSequence());
         m_pktRelayQueue.push_back(relayPkt);
+        CountClassFrame(relayPkt, true);
 
         if (m_state == IDLE) {
             //MODIF3
-            if (CC_ENABLED || DISTRIBUTED_ACK_ENABLED)
+            //relayed frame of lower class than other queued frames has to wait for LIFS
+            if ((CC_ENABLED || DISTRIBUTED_ACK_ENABLED) && IsRelayScheduled())
                 CcaForSifs();
             else
                 CcaForLifs();
@@ -472,6 +619,145 @@ namespace ns3 {
     }
 
 
+    RescueMacCsma::DataQueueType
+    RescueMacCsma::SelectDataQueue(uint8_t &tc, Ptr<Packet> &pkt, Mac48Address &dst, uint32_t &size, bool relayOnly) {
+        NS_ASSERT(m_qosScheduler != 0);
+        uint8_t nClasses = m_qosScheduler->GetNClasses();
+        std::vector<DataQueueType> queues(nClasses, NO_QUEUE);
+        std::vector<uint32_t> heads(nClasses, 0);
+        DataQueueType order[3] = {RELAY_QUEUE, RETRY_QUEUE, DATA_QUEUE};
+        uint8_t nQueues = relayOnly ? 1 : 3;
+
+        for (uint8_t c = 0; c < nClasses; c++) {
+            for (uint8_t i = 0; i < nQueues; i++) {
+                //the queues are searched only for classes they hold
+                if (GetClassFrames(order[i], c) == 0)
+                    continue;
+                if (FindClassHead(order[i], c, pkt, dst, size)) {
+                    queues[c] = order[i];
+                    heads[c] = size;
+                    break;
+                }
+            }
+        }
+
+        if (!m_qosScheduler->GetNextClass(heads, tc))
+            return NO_QUEUE;
+
+        FindClassHead(queues[tc], tc, pkt, dst, size);
+        return queues[tc];
+    }
+
+    bool
+    RescueMacCsma::FindClassHead(DataQueueType queue, uint8_t tc, Ptr<Packet> &pkt, Mac48Address &dst, uint32_t &size) {
+        if (queue == RELAY_QUEUE) {
+            for (RelayQueueI it = m_pktRelayQueue.begin(); it != m_pktRelayQueue.end(); it++) {
+                if (m_qosScheduler->Classify(it->first, it->second) == tc) {
+                    pkt = it->first;
+                    dst = it->second.GetDestination();
+                    size = it->first->GetSize();
+                    return true;
+                }
+            }
+        } else if (queue == RETRY_QUEUE || queue == DATA_QUEUE) {
+            Queue &pktQueue = (queue == RETRY_QUEUE) ? m_pktRetryQueue : m_pktQueue;
+            for (QueueI it = pktQueue.begin(); it != pktQueue.end(); it++) {
+                if (m_qosScheduler->Classify(*it) == tc) {
+                    RescueMacHeader hdr;
+                    (*it)->PeekHeader(hdr);
+                    //keep FIFO order within class when awaiting for ACK
+                    if (queue == DATA_QUEUE && !m_arqManager->IsTxAllowed(hdr.GetDestination()))
+                        return false;
+
+                    RescueMacTrailer fcs;
+                    pkt = *it;
+                    dst = hdr.GetDestination();
+                    size = (*it)->GetSize() + fcs.GetSerializedSize();
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void
+    RescueMacCsma::DequeueClassHead(DataQueueType queue, uint8_t tc) {
+        if (queue == RELAY_QUEUE) {
+            for (RelayQueueI it = m_pktRelayQueue.begin(); it != m_pktRelayQueue.end(); it++) {
+                if (m_qosScheduler->Classify(it->first, it->second) == tc) {
+                    m_pktRelay = *it;
+                    CountClassFrame(*it, false);
+                    m_pktRelayQueue.erase(it);
+                    return;
+                }
+            }
+        } else if (queue == RETRY_QUEUE || queue == DATA_QUEUE) {
+            Queue &pktQueue = (queue == RETRY_QUEUE) ? m_pktRetryQueue : m_pktQueue;
+            for (QueueI it = pktQueue.begin(); it != pktQueue.end(); it++) {
+                if (m_qosScheduler->Classify(*it) == tc) {
+                    m_pktData = *it;
+                    CountClassFrame(queue, *it, false);
+                    pktQueue.erase(it);
+                    return;
+                }
+            }
+        }
+        NS_FATAL_ERROR("No frame of TC " << (uint32_t) tc << " in selected queue");
+    }
+
+    bool
+    RescueMacCsma::MergeRelayCopy(Ptr<Packet> pkt, RescuePhyHeader phyHdr) {
+        for (RelayQueueI it = m_pktRelayQueue.begin(); it != m_pktRelayQueue.end(); it++) {
+            if ((it->second.GetSource() == phyHdr.GetSource())
+                    && (it->second.GetDestination() == phyHdr.GetDestination())
+                    && (it->second.GetSequence() == phyHdr.GetSequence())) {
+                //found enqueued copy, keep the better one (a copy without BER never replaces the enqueued one)
+                SnrPerTag queuedTag, rxTag;
+                bool queuedValid = it->first->PeekPacketTag(queuedTag);
+                bool rxValid = pkt->PeekPacketTag(rxTag);
+                if (rxValid && (!queuedValid || rxTag.GetBER() < queuedTag.GetBER())) {
+                    NS_LOG_INFO("MERGE: replace enqueued frame copy with the better one! from: " << phyHdr.GetSource() << " to: " << phyHdr.GetDestination() << ", seq: " << phyHdr.GetSequence() << ", BER: " << queuedTag.GetBER() << " -> " << rxTag.GetBER());
+                    RescueCoDel::SetEnqueueTime(pkt);
+                    CountClassFrame(*it, false);
+                    *it = std::pair<Ptr<Packet>, RescuePhyHeader> (pkt, phyHdr);
+                    CountClassFrame(*it, true);
+                } else
+                    NS_LOG_INFO("MERGE: drop worse frame copy! from: " << phyHdr.GetSource() << " to: " << phyHdr.GetDestination() << ", seq: " << phyHdr.GetSequence() << ", BER: " << rxTag.GetBER());
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint32_t
+    RescueMacCsma::GetQueuedFrames(uint8_t tc) {
+        return GetClassFrames(RELAY_QUEUE, tc) + GetClassFrames(RETRY_QUEUE, tc) + GetClassFrames(DATA_QUEUE, tc);
+    }
+
+    void
+    RescueMacCsma::CountClassFrame(DataQueueType queue, Ptr<const Packet> pkt, bool queued) {
+        if (m_qosScheduler == 0)
+            return;
+        uint32_t &frames = m_classFrames[queue][m_qosScheduler->Classify(pkt)];
+        NS_ASSERT(queued || frames > 0);
+        frames = queued ? frames + 1 : frames - 1;
+    }
+
+    void
+    RescueMacCsma::CountClassFrame(const std::pair<Ptr<Packet>, RescuePhyHeader> &relayPkt, bool queued) {
+        if (m_qosScheduler == 0)
+            return;
+        uint32_t &frames = m_classFrames[RELAY_QUEUE][m_qosScheduler->Classify(relayPkt.first, relayPkt.second)];
+        NS_ASSERT(queued || frames > 0);
+        frames = queued ? frames + 1 : frames - 1;
+    }
+
+    uint32_t
+    RescueMacCsma::GetClassFrames(DataQueueType queue, uint8_t tc) const {
+        return (tc < m_classFrames[queue].size()) ? m_classFrames[queue][tc] : 0;
+    }
+
+
 
     // ------------------ Channel Access Functions -------------------------
 
@@ -811,6 +1097,8 @@ namespace ns3 {
             NS_LOG_UNCOND("Should not execute ChannelAccessGrantedRelay when CC is disabled ");
         NS_LOG_FUNCTION(this);
 
+        ApplyAqm();
+
         //Try to relay ACK when DISTRIBUTED_ACK_ENABLED only
 
         if (DISTRIBUTED_ACK_ENABLED && m_ackQueue.size() != 0) {
@@ -830,6 +1118,9 @@ namespace ns3 {
             NS_LOG_INFO("FORWARD ACK to: " << m_pktRelay.second.GetDestination() << ", seq: " << m_pktRelay.second.GetSequence() << "!");
 
             SendRelayedData();
+        } else if (m_qosScheduler != 0 && m_pktRelayQueue.size() != 0) {
+            //only relayed frames are allowed to access the channel after SIFS
+            ChannelAccessGrantedQos(true);
         } else if (m_pktRelayQueue.size() != 0) {
             m_backoffStart = Seconds(0);
             m_backoffRemain = Seconds(0);
@@ -840,14 +1131,20 @@ namespace ns3 {
 
             m_pktRelay = m_pktRelayQueue.front();
             m_pktRelayQueue.pop_front();
+            CountClassFrame(m_pktRelay, false);
 
             if (m_pktRelay.first == 0)
                 NS_ASSERT("Null packet for relay tx");
 
             NS_LOG_INFO("RELAY DATA FRAME!");
-            SendRelayedData();
-        } else
+            if (CollectAggregate(m_pktRelay))
+                SendAggregate();
+            else
+                SendRelayedData();
+        } else {
             NS_LOG_INFO("WEIRD : No packet to relay ....");
+            ResumeContention();
+        }
 
     }
 
@@ -933,11 +1230,11 @@ namespace ns3 {
             //MODIF 4
             //        if ((m_state != IDLE && !CheckCCForTransmission()) || !m_phy->IsIdle()) {
             NS_LOG_FUNCTION("not idle, schedule another CcaForLifs ()");
-            m_ccaTimeoutEvent = Simulator::Schedule(GetLifsTime(), &RescueMacCsma::CcaForLifs, this);
+            m_ccaTimeoutEvent = Simulator::Schedule(GetAccessLifs(), &RescueMacCsma::CcaForLifs, this);
             return;
         }
         NS_LOG_FUNCTION("idle, schedule backoff start");
-        m_ccaTimeoutEvent = Simulator::Schedule(GetLifsTime(), &RescueMacCsma::BackoffStart, this);
+        m_ccaTimeoutEvent = Simulator::Schedule(GetAccessLifs(), &RescueMacCsma::BackoffStart, this);
     }
 
     void
@@ -957,6 +1254,13 @@ namespace ns3 {
             } else if (m_ctrlPktQueue.size() != 0) {
                 std::pair<Ptr<Packet>, RescuePhyHeader> pktRelay = m_ctrlPktQueue.front();
                 SetCw(m_remoteStationManager->GetCtrlCw(pktRelay.second.GetDestination()));
+            } else if (m_qosScheduler != 0) {
+                uint8_t tc;
+                Ptr<Packet> pktData;
+                Mac48Address dst;
+                uint32_t size;
+                if (SelectDataQueue(tc, pktData, dst, size, false) != NO_QUEUE)
+                    SetCw(m_qosScheduler->GetCw(tc, m_remoteStationManager->GetDataCw(dst, pktData, size)));
             } else if (m_pktRelayQueue.size() != 0) {
                 std::pair<Ptr<Packet>, RescuePhyHeader> pktRelay = m_pktRelayQueue.front();
                 SetCw(m_remoteStationManager->GetDataCw(pktRelay.second.GetDestination(), pktRelay.first, pktRelay.first->GetSize()));
@@ -1012,11 +1316,14 @@ namespace ns3 {
         for (RelayQueueI it2 = m_pktRelayQueue.begin(); it2 != m_pktRelayQueue.end();) {
             if (m_arqManager->IsFwdACKed(&(it2->second))) {
                 NS_LOG_INFO("Erase unnecessary frame copy! from: " << it2->second.GetSource() << " to: " << it2->second.GetDestination() << ", seq: " << it2->second.GetSequence());
+                CountClassFrame(*it2, false);
                 it2 = m_pktRelayQueue.erase(it2);
             } else
                 it2++;
         }
 
+        ApplyAqm();
+
         /*for (RelayQueueI it = m_pktRelayQueue.begin (); it != m_pktRelayQueue.end ();)
           {
             //if (m_resendAck) break;
@@ -1070,6 +1377,8 @@ namespace ns3 {
             //m_traceCtrlTx (m_device->GetNode ()->GetId (), m_device->GetIfIndex (), m_pktRelay.first, m_pktRelay.second);
 
             SendRelayedData();
+        } else if (m_qosScheduler != 0) {
+            ChannelAccessGrantedQos(false);
         } else if (m_pktRelayQueue.size() != 0) {
             //MODIF 2
             //    if (ACK_ENABLED) {
@@ -1079,6 +1388,7 @@ namespace ns3 {
 
             m_pktRelay = m_pktRelayQueue.front();
             m_pktRelayQueue.pop_front();
+            CountClassFrame(m_pktRelay, false);
 
             if (m_pktRelay.first == 0)
                 NS_ASSERT("Null packet for relay tx");
@@ -1086,7 +1396,10 @@ namespace ns3 {
             NS_LOG_INFO("RELAY DATA FRAME! from src: " << m_pktRelay.second.GetSource() << " to dst: " << m_pktRelay.second.GetDestination() << ", seq: " << m_pktRelay.second.GetSequence());
             //m_traceDataRelay (m_device->GetNode ()->GetId (), m_device->GetIfIndex (), m_pktRelay.first, m_pktRelay.second);
 
-            SendRelayedData();
+            if (CollectAggregate(m_pktRelay))
+                SendAggregate();
+            else
+                SendRelayedData();
 
             //MODIF 2
             //  } else
@@ -1101,6 +1414,7 @@ namespace ns3 {
 
             m_pktData = m_pktRetryQueue.front();
             m_pktRetryQueue.pop_front();
+            CountClassFrame(RETRY_QUEUE, m_pktData, false);
             NS_LOG_INFO("dequeue packet from retry TX queue, size: " << m_pktData->GetSize());
 
             if (m_pktData == 0)
@@ -1121,6 +1435,7 @@ namespace ns3 {
 
                 m_pktData = pkt;
                 m_pktQueue.pop_front();
+                CountClassFrame(DATA_QUEUE, m_pktData, false);
                 NS_LOG_INFO("dequeue packet from TX queue, size: " << m_pktData->GetSize());
 
                 if (m_pktData == 0)
@@ -1131,9 +1446,140 @@ namespace ns3 {
                 SendData();
             } else
                 NS_LOG_DEBUG("Awaiting for ACK");
-        } else
+        } else {
             NS_LOG_DEBUG("No queued frames for TX");
+            ResumeContention();
+        }
+
+    }
+
+    void
+    RescueMacCsma::ApplyAqm() {
+        NS_LOG_FUNCTION("");
+
+        //drop relayed frames which outlived the ACK timeout of their source
+        if (ACK_ENABLED && (m_relayedLifetime > Seconds(0))) {
+            for (RelayQueueI it = m_pktRelayQueue.begin(); it != m_pktRelayQueue.end();) {
+                Time sojourn = RescueCoDel::GetSojournTime(it->first);
+                if (sojourn > m_relayedLifetime) {
+                    NS_LOG_INFO("Drop expired frame copy! from: " << it->second.GetSource() << " to: " << it->second.GetDestination() << ", seq: " << it->second.GetSequence() << ", sojourn: " << sojourn);
+                    m_traceAqmDrop(it->first, sojourn);
+                    CountClassFrame(*it, false);
+                    it = m_pktRelayQueue.erase(it);
+                } else
+                    it++;
+            }
+        }
+
+        while (m_pktRelayQueue.size() != 0) {
+            Time sojourn = RescueCoDel::GetSojournTime(m_pktRelayQueue.front().first);
+            if (!m_relayAqm.ShouldDrop(sojourn, m_pktRelayQueue.size()))
+                break;
+            NS_LOG_INFO("AQM: drop relayed frame, sojourn: " << sojourn);
+            m_traceAqmDrop(m_pktRelayQueue.front().first, sojourn);
+            CountClassFrame(m_pktRelayQueue.front(), false);
+            m_pktRelayQueue.pop_front();
+        }
+        while (m_pktRetryQueue.size() != 0) {
+            Time sojourn = RescueCoDel::GetSojournTime(m_pktRetryQueue.front());
+            if (!m_retryAqm.ShouldDrop(sojourn, m_pktRetryQueue.size()))
+                break;
+            NS_LOG_INFO("AQM: drop retransmitted frame, sojourn: " << sojourn);
+            m_traceAqmDrop(m_pktRetryQueue.front(), sojourn);
+            ReleaseDroppedFrame(m_pktRetryQueue.front());
+            CountClassFrame(RETRY_QUEUE, m_pktRetryQueue.front(), false);
+            m_pktRetryQueue.pop_front();
+        }
+        while (m_pktQueue.size() != 0) {
+            Time sojourn = RescueCoDel::GetSojournTime(m_pktQueue.front());
+            if (!m_dataAqm.ShouldDrop(sojourn, m_pktQueue.size()))
+                break;
+            NS_LOG_INFO("AQM: drop originated frame, sojourn: " << sojourn);
+            m_traceAqmDrop(m_pktQueue.front(), sojourn);
+            ReleaseDroppedFrame(m_pktQueue.front());
+            CountClassFrame(DATA_QUEUE, m_pktQueue.front(), false);
+            m_pktQueue.pop_front();
+        }
+    }
+
+    void
+    RescueMacCsma::ReleaseDroppedFrame(Ptr<const Packet> pkt) {
+        RescueMacHeader hdr;
+        pkt->PeekHeader(hdr);
+        //frame already got its sequence number - ARQ must not await its ACK anymore
+        if (hdr.IsRetry() || (hdr.GetSequence() != 0)) {
+            NS_LOG_INFO("Release ARQ state of dropped frame to: " << hdr.GetDestination() << ", seq: " << hdr.GetSequence());
+            m_arqManager->ReportDataDrop(hdr.GetDestination(), hdr.GetSequence());
+        }
+    }
+
+    void
+    RescueMacCsma::ResumeContention() {
+        m_backoffStart = Seconds(0);
+        m_backoffRemain = Seconds(0);
+        m_state = IDLE;
+        CcaForLifs();
+    }
+
+    void
+    RescueMacCsma::ChannelAccessGrantedQos(bool relayOnly) {
+        NS_LOG_FUNCTION("relayOnly:" << relayOnly);
+
+        uint8_t tc;
+        Ptr<Packet> pkt;
+        Mac48Address dst;
+        uint32_t size;
+        DataQueueType queue = SelectDataQueue(tc, pkt, dst, size, relayOnly);
+        if (queue == NO_QUEUE) {
+            NS_LOG_DEBUG("No queued frames for TX (or awaiting for ACK)");
+            ResumeContention();
+            return;
+        }
+
+        m_backoffStart = Seconds(0);
+        m_backoffRemain = Seconds(0);
+        m_state = WAIT_TX;
+
+        m_qosScheduler->NotifyTxStart(tc, size);
+        DequeueClassHead(queue, tc);
+
+        if (queue == RELAY_QUEUE) {
+            NS_LOG_INFO("RELAY DATA FRAME (TC " << (uint32_t) tc << ")! from src: " << m_pktRelay.second.GetSource() << " to dst: " << m_pktRelay.second.GetDestination() << ", seq: " << m_pktRelay.second.GetSequence());
+
+            if (CollectAggregate(m_pktRelay))
+                SendAggregate();
+            else
+                SendRelayedData();
+        } else {
+            NS_LOG_INFO("dequeue packet from " << (queue == RETRY_QUEUE ? "retry " : "") << "TX queue (TC " << (uint32_t) tc << "), size: " << m_pktData->GetSize());
+            SendData();
+        }
+    }
 
+    Time
+    RescueMacCsma::GetAccessLifs() {
+        if (m_qosScheduler == 0 || m_ackQueue.size() != 0 || m_ctrlPktQueue.size() != 0)
+            return GetLifsTime();
+
+        uint8_t tc;
+        Ptr<Packet> pkt;
+        Mac48Address dst;
+        uint32_t size;
+        if (SelectDataQueue(tc, pkt, dst, size, false) == NO_QUEUE)
+            return GetLifsTime();
+        return m_qosScheduler->GetLifs(tc, GetLifsTime());
+    }
+
+    bool
+    RescueMacCsma::IsRelayScheduled() {
+        if (m_qosScheduler == 0)
+            return true;
+
+        uint8_t tc;
+        Ptr<Packet> pkt;
+        Mac48Address dst;
+        uint32_t size;
+        return (SelectDataQueue(tc, pkt, dst, size, false) == RELAY_QUEUE);
     }
 
 
@@ -1144,27 +1590,59 @@ namespace ns3 {
     RescueMacCsma::SendData() {
         NS_LOG_FUNCTION("");
 
+        RescuePhyHeader phyHdr = PrepareData(m_pktData);
+
         RescueMacHeader hdr;
         m_pktData->PeekHeader(hdr);
+        RescueMode mode = m_remoteStationManager->GetDataTxMode(hdr.GetDestination(), m_pktData, m_pktData->GetSize());
+
+        if (hdr.GetDestination() != m_hiMac->GetBroadcast()) // Unicast
+        {
+            if (CollectAggregate(std::pair<Ptr<Packet>, RescuePhyHeader> (m_pktData, phyHdr))) {
+                SendAggregate();
+                return;
+            }
+            NS_LOG_DEBUG("pktData total Size: " << m_pktData->GetSize());
+            NS_LOG_DEBUG("SEND DATA PACKET! to dst: " << phyHdr.GetDestination() << ", seq: " << phyHdr.GetSequence());
+            if (SendPacket(std::pair<Ptr<Packet>, RescuePhyHeader> (m_pktData->Copy(), phyHdr), mode)) {
+                m_traceSojourn(m_pktData, RescueCoDel::GetSojournTime(m_pktData));
+                m_arqManager->ReportDataTx(m_pktData->Copy());
+                m_arqManager->ReportHopTx(m_pktData, &phyHdr);
+
+            } else {
+                StartOver(m_pktData);
+            }
+        } else // Broadcast
+        {
+
+        }
+    }
+
+    RescuePhyHeader
+    RescueMacCsma::PrepareData(Ptr<Packet> pkt) {
+        NS_LOG_FUNCTION("");
+
+        RescueMacHeader hdr;
+        pkt->PeekHeader(hdr);
 
         m_interleaver++; //increment interleaver counter
 
         NS_LOG_DEBUG((hdr.IsRetry() ? "RETRY" : "NOT RETRY"));
 
         if (!hdr.IsRetry() && (hdr.GetSequence() == 0)) {
-            m_pktData->RemoveHeader(hdr);
+            pkt->RemoveHeader(hdr);
             hdr.SetSequence(m_arqManager->GetNextSequenceNumber(&hdr));
 
-            m_pktData->AddHeader(hdr);
+            pkt->AddHeader(hdr);
             RescueMacTrailer fcs;
-            m_pktData->AddTrailer(fcs);
+            pkt->AddTrailer(fcs);
 
             //store info about sended packet
             m_arqManager->ReportNewDataFrame(hdr.GetDestination(), hdr.GetSequence());
         }
 
-        m_pktData->PeekHeader(hdr);
-        uint32_t pktSize = m_pktData->GetSize();
+        pkt->PeekHeader(hdr);
+        uint32_t pktSize = pkt->GetSize();
         uint16_t seq = hdr.GetSequence();
 
         NS_LOG_FUNCTION("dst:" << hdr.GetDestination() <<
@@ -1188,25 +1666,13 @@ namespace ns3 {
 
         hdr.IsRetry() ? phyHdr.SetRetry() : phyHdr.SetNoRetry();
         phyHdr.SetDistributedMacProtocol();
+        //mark prioritized frames, so relays without QoS tag can classify them
+        if (m_qosScheduler != 0 && m_qosScheduler->Classify(pkt) > 0)
+            phyHdr.SetQosEnabled();
 
         m_arqManager->ConfigurePhyHeader(&phyHdr);
 
-        RescueMode mode = m_remoteStationManager->GetDataTxMode(hdr.GetDestination(), m_pktData, pktSize);
-
-        if (hdr.GetDestination() != m_hiMac->GetBroadcast()) // Unicast
-        {
-            NS_LOG_DEBUG("pktData total Size: " << m_pktData->GetSize());
-            NS_LOG_DEBUG("SEND DATA PACKET! to dst: " << phyHdr.GetDestination() << ", seq: " << phyHdr.GetSequence());
-            if (SendPacket(std::pair<Ptr<Packet>, RescuePhyHeader> (m_pktData->Copy(), phyHdr), mode)) {
-                m_arqManager->ReportDataTx(m_pktData->Copy());
-
-            } else {
-                StartOver(m_pktData);
-            }
-        } else // Broadcast
-        {
-
-        }
+        return phyHdr;
     }
 
     void
@@ -1235,9 +1701,17 @@ namespace ns3 {
         if (m_pktRelay.second.GetDestination() != m_hiMac->GetBroadcast()) // Unicast
         {
             m_pktRelay.second.SetSender(m_hiMac->GetAddress());
+            //PHY adds its header to transmitted packet - keep the frame for local retransmission
+            Ptr<Packet> frame = 0;
+            if (m_pktRelay.second.IsDataFrame() && m_arqManager->IsHopAckEnabled())
+                frame = m_pktRelay.first->Copy();
             if (SendPacket(m_pktRelay, mode)) {
-                if (m_pktRelay.second.IsDataFrame())
+                if (m_pktRelay.second.IsDataFrame()) {
+                    m_traceSojourn(m_pktRelay.first, RescueCoDel::GetSojournTime(m_pktRelay.first));
                     m_arqManager->ReportRelayDataTx(&(m_pktRelay.second));
+                    if (frame != 0)
+                        m_arqManager->ReportHopTx(frame, &(m_pktRelay.second));
+                }
             } else {
                 StartOver(m_pktRelay);
             }
@@ -1250,7 +1724,217 @@ namespace ns3 {
         }
     }
 
+    bool
+    RescueMacCsma::CollectAggregate(std::pair<Ptr<Packet>, RescuePhyHeader> first) {
+        NS_LOG_FUNCTION("src:" << first.second.GetSource() <<
+                "dst:" << first.second.GetDestination() <<
+                "seq:" << first.second.GetSequence());
+
+        m_pktAggregate.clear();
+
+        if ((m_maxAggregationAirtime == Seconds(0))
+                || !first.second.IsDataFrame()
+                || (first.second.GetDestination() == m_hiMac->GetBroadcast()))
+            return false;
+
+        //all subframes are sent with the same TX mode, so only frames to the same destination are aggregated
+        Mac48Address dst = first.second.GetDestination();
+        RescueMode mode = m_remoteStationManager->GetDataTxMode(dst, first.first, first.first->GetSize());
+        RescueMode basicMode = m_phy->GetPhyHeaderMode(mode);
+        uint32_t dataHdrSize = RescuePhyHeader(RESCUE_PHY_PKT_TYPE_DATA).GetSize();
+
+        //with QoS scheduling only frames of the same traffic class are aggregated
+        uint8_t tc = (m_qosScheduler != 0) ? m_qosScheduler->Classify(first.first, first.second) : 0;
+
+        Time airtime = m_phy->GetPhyPreambleDuration(mode)
+                + m_phy->CalSubframeTxDuration(first.second.GetSize(), first.first->GetSize(), basicMode, mode);
+        m_pktAggregate.push_back(first);
+
+        //relayed frames
+        for (RelayQueueI it = m_pktRelayQueue.begin(); it != m_pktRelayQueue.end();) {
+            if (it->second.IsDataFrame() && (it->second.GetDestination() == dst)
+                    && (m_qosScheduler == 0 || m_qosScheduler->Classify(it->first, it->second) == tc)) {
+                Time subframe = m_phy->CalSubframeTxDuration(it->second.GetSize(), it->first->GetSize(), basicMode, mode);
+                if (airtime + subframe > m_maxAggregationAirtime)
+                    break;
+                airtime += subframe;
+                NS_LOG_INFO("AGGREGATE RELAYED FRAME! from src: " << it->second.GetSource() << ", seq: " << it->second.GetSequence());
+                m_pktAggregate.push_back(*it);
+                CountClassFrame(*it, false);
+                it = m_pktRelayQueue.erase(it);
+            } else
+                it++;
+        }
+
+        //originated frames - retransmissions first
+        RescueMacTrailer fcs;
+        for (QueueI it = m_pktRetryQueue.begin(); it != m_pktRetryQueue.end();) {
+            RescueMacHeader hdr;
+            (*it)->PeekHeader(hdr);
+            if ((hdr.GetDestination() == dst)
+                    && (m_qosScheduler == 0 || m_qosScheduler->Classify(*it) == tc)) {
+                Time subframe = m_phy->CalSubframeTxDuration(dataHdrSize, (*it)->GetSize(), basicMode, mode);
+                if (airtime + subframe > m_maxAggregationAirtime)
+                    break;
+                airtime += subframe;
+                NS_LOG_INFO("AGGREGATE RETRANSMITTED FRAME! seq: " << hdr.GetSequence());
+                m_pktAggregate.push_back(std::pair<Ptr<Packet>, RescuePhyHeader> (*it, PrepareData(*it)));
+                CountClassFrame(RETRY_QUEUE, *it, false);
+                it = m_pktRetryQueue.erase(it);
+            } else
+                it++;
+        }
+
+        uint16_t allowance = m_arqManager->GetTxAllowance(dst);
+        for (QueueI it = m_pktQueue.begin(); (it != m_pktQueue.end()) && (allowance > 0);) {
+            RescueMacHeader hdr;
+            (*it)->PeekHeader(hdr);
+            if ((hdr.GetDestination() == dst)
+                    && (m_qosScheduler == 0 || m_qosScheduler->Classify(*it) == tc)) {
+                Time subframe = m_phy->CalSubframeTxDuration(dataHdrSize, (*it)->GetSize() + fcs.GetSerializedSize(), basicMode, mode);
+                if (airtime + subframe > m_maxAggregationAirtime)
+                    break;
+                airtime += subframe;
+                allowance--;
+                NS_LOG_INFO("AGGREGATE NEW FRAME!");
+                m_pktAggregate.push_back(std::pair<Ptr<Packet>, RescuePhyHeader> (*it, PrepareData(*it)));
+                CountClassFrame(DATA_QUEUE, *it, false);
+                it = m_pktQueue.erase(it);
+            } else
+                it++;
+        }
+
+        if (m_pktAggregate.size() < 2) {
+            m_pktAggregate.clear();
+            return false;
+        }
+
+        NS_LOG_INFO("AGGREGATED " << m_pktAggregate.size() << " FRAMES to dst: " << dst << ", airtime: " << airtime);
+        return true;
+    }
+
+    void
+    RescueMacCsma::SendAggregate() {
+        std::pair<Ptr<Packet>, RescuePhyHeader> first = m_pktAggregate.front();
+        NS_LOG_FUNCTION("dst:" << first.second.GetDestination() <<
+                "subframes:" << m_pktAggregate.size());
+
+        RescueMode mode = m_remoteStationManager->GetDataTxMode(first.second.GetDestination(), first.first, first.first->GetSize());
+
+        for (RelayQueueI it = m_pktAggregate.begin(); it != m_pktAggregate.end(); it++)
+            it->second.SetSender(m_hiMac->GetAddress());
+
+        if (SendPacket(m_pktAggregate, mode)) {
+            for (RelayQueueI it = m_pktAggregate.begin(); it != m_pktAggregate.end(); it++) {
+                m_traceSojourn(it->first, RescueCoDel::GetSojournTime(it->first));
+                if (it->second.GetSource() == m_hiMac->GetAddress())
+                    m_arqManager->ReportDataTx(it->first->Copy());
+                else
+                    m_arqManager->ReportRelayDataTx(&(it->second));
+            }
+        } else {
+            //return subframes to their queues (in reverse order to keep the queues order)
+            RelayQueue aggregate = m_pktAggregate;
+            m_pktAggregate.clear();
+            for (RelayQueueRI it = aggregate.rbegin(); it != aggregate.rend(); it++) {
+                if (it->second.GetSource() == m_hiMac->GetAddress())
+                    StartOver(it->first);
+                else
+                    StartOver(*it);
+            }
+        }
+    }
+
+    void
+    RescueMacCsma::SendAggregateDone() {
+        NS_LOG_FUNCTION("subframes:" << m_pktAggregate.size());
+
+        for (RelayQueueI it = m_pktAggregate.begin(); it != m_pktAggregate.end(); it++) {
+            if (it->second.GetSource() != m_hiMac->GetAddress())
+                continue;
+
+            RescueMacHeader hdr;
+            it->first->PeekHeader(hdr);
+            //MODIF 2
+            //Check relaying + bad hook
+            if (CC_ENABLED && !ACK_ENABLED)
+                if (Simulator::Now() > Seconds(10))
+                    Simulator::Schedule(GetSifsTime() + GetChannelDelay() + MicroSeconds(1), &RescueMacCsma::CheckRelaying, this, hdr, it->first);
+
+            //MODIF 3
+            if (!CC_ENABLED && !ACK_ENABLED) // SimpleMAC without ACK
+            {
+                NS_LOG_DEBUG("SimpleMAC without ACK. Stop ACK wait");
+                m_arqManager->RelayingStopAck(hdr.GetDestination(), hdr.GetSequence());
+            }
+        }
+        m_pktAggregate.clear();
+
+        SendDataDone();
+        CcaForLifs();
+    }
+
+    void
+    RescueMacCsma::ScheduleAck(RescuePhyHeader ackHdr, RescueMode dataTxMode, SnrPerTag tag, Time delay) {
+        NS_LOG_FUNCTION("to:" << ackHdr.GetDestination() << "seq:" << ackHdr.GetSequence() << "#pending:" << m_pendingAcks.size());
+        PendingAck ack;
+        ack.ackHdr = ackHdr;
+        ack.dataTxMode = dataTxMode;
+        ack.tag = tag;
+        m_pendingAcks.push_back(ack);
+        //the next ACK of a burst is scheduled when the previous one is transmitted
+        if (!m_sendAckEvent.IsRunning() && m_pendingAcks.size() == 1)
+            m_sendAckEvent = Simulator::Schedule(delay, &RescueMacCsma::SendPendingAck, this);
+    }
+
+    Time
+    RescueMacCsma::GetHopAckDelay(const RescuePhyHeader &phyHdr, RescueMode dataTxMode) {
+        //ACK of the destination and the slots fit frames sent with the most robust mode, so they are the same for all relays
+        RescueMode basicMode = m_phy->GetPhyHeaderMode(dataTxMode);
+        Time maxAck = m_phy->CalTxDuration(RescuePhyHeader(RESCUE_PHY_PKT_TYPE_E2E_ACK).GetMaxSize(), 0, basicMode, basicMode);
+        Time slot = GetCtrlDuration(RESCUE_PHY_PKT_TYPE_PART_ACK, basicMode) + GetSifsTime();
+        return GetSifsTime() + maxAck + GetSifsTime() + slot * (m_arqManager->GetRelayIndex(&phyHdr) % m_hopAckSlots);
+    }
+
+    void
+    RescueMacCsma::SuppressHopAcks(const RescuePhyHeader &ackHdr) {
+        for (std::list<PendingAck>::iterator it = m_pendingAcks.begin(); it != m_pendingAcks.end();) {
+            const RescuePhyHeader &hopAck = it->ackHdr;
+            bool confirmed = false;
+            if (hopAck.IsPartialAckFrame()
+                    && (hopAck.GetSource() == ackHdr.GetSource())
+                    && (hopAck.GetDestination() == ackHdr.GetDestination())) {
+                if (ackHdr.IsPartialAckFrame())
+                    confirmed = (ackHdr.GetTransmitter() == hopAck.GetTransmitter())
+                        && (ackHdr.GetSequence() == hopAck.GetSequence())
+                        && ackHdr.IsACK();
+                else
+                    confirmed = m_arqManager->IsSeqACKed(hopAck.GetSequence(), &ackHdr);
+            }
+            if (confirmed) {
+                NS_LOG_INFO("PART ACK suppressed by ACK from: " << ackHdr.GetSender() << ", seq: " << hopAck.GetSequence());
+                it = m_pendingAcks.erase(it);
+            } else
+                it++;
+        }
+        if (m_pendingAcks.empty() && m_sendAckEvent.IsRunning())
+            m_sendAckEvent.Cancel();
+    }
+
     void
+    RescueMacCsma::SendPendingAck() {
+        NS_LOG_FUNCTION("#pending:" << m_pendingAcks.size());
+        while (!m_pendingAcks.empty()) {
+            PendingAck ack = m_pendingAcks.front();
+            m_pendingAcks.pop_front();
+            if (SendAck(ack.ackHdr, ack.dataTxMode, ack.tag))
+                return;
+            NS_LOG_INFO("ACK TX FAILED! to: " << ack.ackHdr.GetDestination() << ", seq: " << ack.ackHdr.GetSequence());
+        }
+        CcaForLifs();
+    }
+
+    bool
     RescueMacCsma::SendAck(RescuePhyHeader ackHdr, RescueMode dataTxMode, SnrPerTag tag) {
         NS_LOG_INFO("SEND ACK from: " << ackHdr.GetSource() << " to: " << ackHdr.GetDestination() << ", seq: " << ackHdr.GetSequence());
         NS_LOG_FUNCTION("to:" << ackHdr.GetDestination());
@@ -1267,7 +1951,7 @@ namespace ns3 {
 
         //m_traceAckTx (m_device->GetNode ()->GetId (), m_device->GetIfIndex (), pkt, ackHdr);
 
-        SendPacket(ackPkt, mode);
+        return SendPacket(ackPkt, mode);
     }
 
     bool
@@ -1325,6 +2009,34 @@ namespace ns3 {
         return false;
     }
 
+    bool
+    RescueMacCsma::SendPacket(std::list<std::pair<Ptr<Packet>, RescuePhyHeader> > aggregate, RescueMode mode) {
+        NS_LOG_FUNCTION("state:" << StateToString(m_state) << "subframes:" << aggregate.size());
+
+        if ((m_state == IDLE || m_state == WAIT_TX)
+                && CheckCCForTransmission()
+                && ((m_opEnd == Seconds(0))
+                || (Simulator::Now() + m_phy->CalTxDuration(aggregate, mode) + GetSifsTime() < m_opEnd))) {
+            if (m_phy->SendPacket(aggregate, mode)) {
+                m_state = TX;
+
+                //MODIF
+                if (CC_ENABLED)
+                    updateLocalControlChannel();
+
+                m_pktTx = 0;
+                return true;
+            } else {
+                m_state = IDLE;
+
+                //MODIF
+                if (CC_ENABLED)
+                    updateLocalControlChannel();
+            }
+        }
+        return false;
+    }
+
     void
     RescueMacCsma::SendPacketDone(Ptr<Packet> pkt) {
         //MODIF
@@ -1332,6 +2044,31 @@ namespace ns3 {
             printTopology();
 
         NS_LOG_FUNCTION("state:" << StateToString(m_state));
+
+        if (!m_pktAggregate.empty()) {
+            //end of aggregated transmission
+            if (m_state != TX) {
+                NS_LOG_DEBUG("Something is wrong!");
+                RelayQueue aggregate = m_pktAggregate;
+                m_pktAggregate.clear();
+                for (RelayQueueRI it = aggregate.rbegin(); it != aggregate.rend(); it++) {
+                    if (it->second.GetSource() == m_hiMac->GetAddress())
+                        StartOver(it->first);
+                    else
+                        StartOver(*it);
+                }
+                return;
+            }
+            m_state = IDLE;
+
+            //MODIF
+            if (CC_ENABLED)
+                updateControlChannel();
+
+            SendAggregateDone();
+            return;
+        }
+
         RescuePhyHeader phyHdr;
         pkt->RemoveHeader(phyHdr);
 
@@ -1348,6 +2085,14 @@ namespace ns3 {
         //MODIF
         if (CC_ENABLED)
             updateControlChannel();
+
+        //continue ACK burst (ACKs of aggregated subframes)
+        if (!phyHdr.IsDataFrame() && !m_pendingAcks.empty() && !m_sendAckEvent.IsRunning()) {
+            m_state = WAIT_TX;
+            m_sendAckEvent = Simulator::Schedule(GetSifsTime(), &RescueMacCsma::SendPendingAck, this);
+            return;
+        }
+
         RescueMacHeader hdr;
 
         switch (phyHdr.GetType()) {
@@ -1389,6 +2134,7 @@ namespace ns3 {
 
                 break;
         }
+
     }
 
     void
@@ -1414,10 +2160,13 @@ namespace ns3 {
         m_pktData = 0;
         RescueMacHeader hdr;
         pkt->PeekHeader(hdr);
-        if (hdr.IsRetry())
+        if (hdr.IsRetry()) {
             m_pktRetryQueue.push_front(pkt);
-        else
+            CountClassFrame(RETRY_QUEUE, pkt, true);
+        } else {
             m_pktQueue.push_front(pkt);
+            CountClassFrame(DATA_QUEUE, pkt, true);
+        }
         m_backoffStart = Seconds(0);
         m_backoffRemain = Seconds(0);
 
@@ -1434,6 +2183,7 @@ namespace ns3 {
         switch (pktHdr.second.GetType()) {
             case RESCUE_PHY_PKT_TYPE_DATA:
                 m_pktRelayQueue.push_front(pktHdr);
+                CountClassFrame(pktHdr, true);
                 break;
             case RESCUE_PHY_PKT_TYPE_E2E_ACK:
             case RESCUE_PHY_PKT_TYPE_PART_ACK:
@@ -1497,7 +2247,10 @@ namespace ns3 {
         if (m_arqManager->CheckRxFrame(&phyHdr, &ackHdr)) {
             NS_LOG_INFO("DATA RX OK!");
             //m_forwardUpCb (pkt, phyHdr.GetSource (), phyHdr.GetDestination ());
-            m_hiMac->ReceivePacket(pkt, phyHdr);
+            Ptr<Packet> payload = pkt->Copy();
+            if (!hdr.IsCoded())
+                m_hiMac->ReceivePacket(pkt, phyHdr);
+            m_arqManager->ReportDataRx(payload, &phyHdr, hdr.IsCoded());
         } else {
             NS_LOG_DEBUG(COLOR_RED << "DUPLICATE?" << COLOR_DEFAULT);
             NS_LOG_INFO("(duplicate) DROP!");
@@ -1509,7 +2262,12 @@ namespace ns3 {
             //MODIF 2
 
             if (ACK_ENABLED)
-                m_sendAckEvent = Simulator::Schedule(GetSifsTime(), &RescueMacCsma::SendAck, this, ackHdr, mode, tag);
+                ScheduleAck(ackHdr, mode, tag, GetSifsTime());
+        } else if (ACK_ENABLED && m_arqManager->IsHopAckEnabled() && !m_phy->IsReceivingAggregate()) {
+            //E2E ACK is postponed (e.g. block ACK) - acknowledge the last hop (subframes are not retransmitted locally)
+            SnrPerTag tag;
+            pkt->PeekPacketTag(tag);
+            ScheduleAck(m_arqManager->GetHopAckHeader(&phyHdr), mode, tag, GetSifsTime());
         }
     }
 
@@ -1526,6 +2284,15 @@ namespace ns3 {
 
         std::pair<RelayBehavior, RescuePhyHeader> txAck = m_arqManager->ReportRelayFrameRx(&phyHdr, tag.GetBER());
 
+        //acknowledge the hop of frames taken for relaying, and of retried copies of frames already held
+        //(the previous PART ACK was probably lost), subframes of aggregates are not retransmitted locally
+        if (ACK_ENABLED && m_arqManager->IsHopAckEnabled() && !m_phy->IsReceivingAggregate()
+                && ((txAck.first == FORWARD) || (txAck.first == REPLACE_COPY)
+                || ((txAck.first == DROP) && phyHdr.IsRetry()))) {
+            m_state = WAIT_TX;
+            ScheduleAck(m_arqManager->GetHopAckHeader(&phyHdr), mode, tag, GetHopAckDelay(phyHdr, mode));
+        }
+
 
         switch (txAck.first) {
             case FORWARD:
@@ -1534,21 +2301,12 @@ namespace ns3 {
                 break;
             case REPLACE_COPY:
                 NS_LOG_INFO("FRAME TO RELAY! (instead of the worse copy) src: " << phyHdr.GetSource() << " dst: " << phyHdr.GetDestination() << ", seq: " << phyHdr.GetSequence());
-                for (RelayQueueI it = m_pktRelayQueue.begin(); it != m_pktRelayQueue.end(); it++)
-                    if ((it->second.GetSource() == phyHdr.GetSource())
-                            && (it->second.GetDestination() == phyHdr.GetDestination())
-                            && (it->second.GetSequence() == phyHdr.GetSequence())
-                            && (it->second.GetInterleaver() == phyHdr.GetInterleaver())) {
-                        //found enqueued copy, switch with better one
-                        NS_LOG_INFO("Erase unnecessary frame copy! from: " << it->second.GetSource() << " to: " << it->second.GetDestination() << ", seq: " << it->second.GetSequence());
-                        it = m_pktRelayQueue.erase(it);
-                        it = m_pktRelayQueue.insert(it, std::pair<Ptr<Packet>, RescuePhyHeader> (pkt, phyHdr));
-                        break;
-                    }
+                //merged with enqueued copy (or enqueued again if the worse copy was already dropped)
+                EnqueueRelay(pkt, phyHdr);
                 break;
             case RESEND_ACK:
                 NS_LOG_INFO("UNNECESSARY RETRANSMISSION DETECTED! DROP and resend ACK! src: " << txAck.second.GetSource() << " dst: " << txAck.second.GetDestination() << ", seq: " << txAck.second.GetSequence());
-                m_sendAckEvent = Simulator::Schedule(GetSifsTime(), &RescueMacCsma::SendAck, this, txAck.second, mode, tag);
+                ScheduleAck(txAck.second, mode, tag, GetSifsTime());
                 //check ACK queue, if this ACK frame is queued - erase it!
                 for (RelayQueueI it = m_ackQueue.begin(); it != m_ackQueue.end(); it++)
                     if (m_arqManager->ACKcomp(&(it->second), &(txAck.second))) {
@@ -1592,24 +2350,23 @@ namespace ns3 {
         if (CC_ENABLED)
             updateControlChannel();
 
+        //E2E ACK also confirms the hops of acknowledged frames
+        m_arqManager->ReceiveHopAck(&ackHdr);
+        SuppressHopAcks(ackHdr);
+
         //check - have I recently received this ACK?
-        for (AckCacheI it = m_ackCache.begin(); it != m_ackCache.end(); it++) {
-            if (it->expires < ns3::Simulator::Now()) {
-                NS_LOG_INFO("Expired ACK in cache - erase!");
-                it = m_ackCache.erase(it);
-            } else if (m_arqManager->ACKcomp(&(it->ack.second), &(ackHdr))) {
-                //found cached ACK, dont process it
-                NS_LOG_INFO("Duplicated ACK!");
+        if (m_ackCache.Find(ackHdr)) {
+            //found cached ACK, dont process it
+            NS_LOG_INFO("Duplicated ACK!");
+            if (m_sendAckEvent.IsRunning())
+                m_state = WAIT_TX;
+            else
                 CcaForLifs();
-                return;
-            }
+            return;
         }
 
         //store frame in ACK cache
-        StoredAck newIns;
-        newIns.ack = std::pair<Ptr<Packet>, RescuePhyHeader> (ackPkt, ackHdr);
-        newIns.expires = ns3::Simulator::Now() + m_arqManager->GetTimeoutFor(&ackHdr);
-        m_ackCache.push_front(newIns);
+        m_ackCache.Insert(ackPkt, ackHdr, m_arqManager->GetTimeoutFor(&ackHdr));
 
         if (ackHdr.GetDestination() == m_hiMac->GetAddress()) {
             //check - have I recently transmitted frame which is acknowledged?
@@ -1621,21 +2378,20 @@ namespace ns3 {
                 ackPkt->PeekPacketTag(tag);
                 m_remoteStationManager->ReportDataOk(ackHdr.GetSource(),
                         ackSnr, ackMode,
-                        tag.GetSNR(), tag.GetBER(),
+                        tag.GetSNR(), tag.IsSNRValid(), tag.GetBER(),
                         (uint16_t) retryCounter);
 
                 //check for unnecessary retransmissions in retry queue
                 if (m_pktRetryQueue.size() > 0) {
-                    for (QueueI it = m_pktRetryQueue.begin(); it != m_pktRetryQueue.end(); it++) {
+                    for (QueueI it = m_pktRetryQueue.begin(); it != m_pktRetryQueue.end();) {
                         RescueMacHeader hdr;
                         (*it)->PeekHeader(hdr);
                         if (m_arqManager->IsRetryACKed(&hdr)) {
+                            CountClassFrame(RETRY_QUEUE, *it, false);
                             it = m_pktRetryQueue.erase(it);
                             NS_LOG_INFO("Erase unnecessary frame retry!");
-                            //it++;
-                        }
-                        //else
-                        //  it++;
+                        } else
+                            it++;
                     }
                 }
 
@@ -1648,6 +2404,7 @@ namespace ns3 {
                 for (RelayQueueI it2 = m_pktRelayQueue.begin(); it2 != m_pktRelayQueue.end();) {
                     if (m_arqManager->IsFwdACKed(&(it2->second))) {
                         NS_LOG_INFO("Erase unnecessary frame copy! from: " << it2->second.GetSource() << " to: " << it2->second.GetDestination() << ", seq: " << it2->second.GetSequence());
+                        CountClassFrame(*it2, false);
                         it2 = m_pktRelayQueue.erase(it2);
                     } else
                         it2++;
@@ -1665,11 +2422,38 @@ namespace ns3 {
             }
         }
 
-        CcaForLifs();
+        //pending PART ACKs of other frames are still sent in their slots
+        if (m_sendAckEvent.IsRunning())
+            m_state = WAIT_TX;
+        else
+            CcaForLifs();
 
         return;
     }
 
+    void
+    RescueMacCsma::ReceivePartialAck(Ptr<Packet> ackPkt, RescuePhyHeader ackHdr) {
+        NS_LOG_FUNCTION("src:" << ackHdr.GetSource() <<
+                "dst:" << ackHdr.GetDestination() <<
+                "sender:" << ackHdr.GetSender() <<
+                "seq:" << ackHdr.GetSequence());
+
+        m_state = IDLE;
+        //MODIF
+        if (CC_ENABLED)
+            updateControlChannel();
+
+        if (m_arqManager->ReceiveHopAck(&ackHdr))
+            NS_LOG_INFO("GOT PART ACK - HOP TX OK! from: " << ackHdr.GetSender() << ", seq: " << ackHdr.GetSequence());
+        //the same transmission is acknowledged by another relay already
+        SuppressHopAcks(ackHdr);
+
+        if (m_sendAckEvent.IsRunning())
+            m_state = WAIT_TX;
+        else
+            CcaForLifs();
+    }
+
     void
     RescueMacCsma::ReceiveResourceReservation(Ptr<Packet> pkt, RescuePhyHeader phyHdr) {
 
@@ -1718,7 +2502,9 @@ namespace ns3 {
             return;
         } else {
             if (correctData) {
-                m_remoteStationManager->ReportRxOk(phyHdr.GetSender(), phyHdr.GetSource(), snr, mode, wasReconstructed);
+                SnrPerTag berTag;
+                bool berValid = pkt->PeekPacketTag(berTag);
+                m_remoteStationManager->ReportRxOk(phyHdr.GetSender(), phyHdr.GetSource(), snr, mode, wasReconstructed, berTag.GetBER(), berValid);
             } else {
                 m_remoteStationManager->ReportRxFail(phyHdr.GetSender(), phyHdr.GetSource(), snr, mode, wasReconstructed);
             }
@@ -1761,7 +2547,7 @@ namespace ns3 {
                         ReceiveAck(pkt, phyHdr, snr, mode);
                         break;
                     case RESCUE_PHY_PKT_TYPE_PART_ACK:
-                        //currently not supported
+                        ReceivePartialAck(pkt, phyHdr);
                         break;
                     case RESCUE_PHY_PKT_TYPE_B:
                         ReceiveBeacon(pkt, phyHdr);
@@ -31,6 +31,7 @@
 #include "ns3/simulator.h"
 #include "ns3/event-id.h"
 #include "ns3/traced-value.h"
+#include "ns3/traced-callback.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/mac48-address.h"
 
@@ -39,9 +40,12 @@
 #include "rescue-phy-header.h"
 #include "rescue-mode.h"
 #include "snr-per-tag.h"
+#include "rescue-codel.h"
+#include "rescue-ack-cache.h"
 
 #include <list>
 #include <map>
+#include <vector>
 
 namespace ns3 {
 
@@ -50,6 +54,7 @@ namespace ns3 {
     class RescueMac;
     class RescueRemoteStationManager;
     class RescueArqManager;
+    class RescueQosScheduler;
     class RescueNetDevice;
 
     /**
@@ -121,6 +126,10 @@ namespace ns3 {
          * \param arqManager RescueArqManager associated with this MAC
          */
         void SetArqManager(Ptr<RescueArqManager> arqManager);
+        /**
+         * \param scheduler RescueQosScheduler associated with this MAC (0 - no QoS scheduling)
+         */
+        void SetQosScheduler(Ptr<RescueQosScheduler> scheduler);
 
         /**
          * Assign a fixed random variable stream number to the random variables
@@ -156,6 +165,22 @@ namespace ns3 {
          * \param length the length of queues used by this MAC
          */
         void SetQueueLimits(uint32_t length);
+        /**
+         * \param target the acceptable sojourn time of DATA frames in queues (0 - AQM disabled)
+         */
+        void SetAqmTarget(Time target);
+        /**
+         * \param interval the AQM interval of sojourn time observation
+         */
+        void SetAqmInterval(Time interval);
+        /**
+         * \param size the maximal number of ACKs stored in ACK cache
+         */
+        void SetAckCacheSize(uint32_t size);
+        /**
+         * \param resolution the resolution of ACK cache expiry
+         */
+        void SetAckCacheResolution(Time resolution);
 
         /**
          * \return minimal contention window
@@ -185,6 +210,22 @@ namespace ns3 {
          * \return length the length of queues used by this MAC
          */
         uint32_t GetQueueLimits(void) const;
+        /**
+         * \return the acceptable sojourn time of DATA frames in queues (0 - AQM disabled)
+         */
+        Time GetAqmTarget(void) const;
+        /**
+         * \return the AQM interval of sojourn time observation
+         */
+        Time GetAqmInterval(void) const;
+        /**
+         * \return the maximal number of ACKs stored in ACK cache
+         */
+        uint32_t GetAckCacheSize(void) const;
+        /**
+         * \return the resolution of ACK cache expiry
+         */
+        Time GetAckCacheResolution(void) const;
 
         /**
          * \param pkt the packet to send.
@@ -293,6 +334,10 @@ namespace ns3 {
         } State;
         std::string StateToString(State state);
 
+        typedef enum {
+            NO_QUEUE, RELAY_QUEUE, RETRY_QUEUE, DATA_QUEUE
+        } DataQueueType;
+
         /**
          * Invoked to calculate control packet (e.g. ACK) TX duration
          *
@@ -331,6 +376,106 @@ namespace ns3 {
          * invoked at the end of backoff procedure to start TX
          */
         void ChannelAccessGranted();
+        /**
+         * invoked before dequeue of next frame to drop expired relayed frames
+         * and to apply AQM to the heads of DATA queues
+         */
+        void ApplyAqm();
+        /**
+         * invoked when a DATA frame is dropped from the retry or originated queue
+         * to release ARQ state of the frame if it has been sequenced already
+         *
+         * \param pkt the dropped frame
+         */
+        void ReleaseDroppedFrame(Ptr<const Packet> pkt);
+        /**
+         * invoked when channel access is granted but no frame can be sent (e.g. the queues
+         * were drained by AQM during backoff) - contend again for frames left in the queues
+         */
+        void ResumeContention();
+        /**
+         * invoked at the end of backoff procedure to start TX of DATA frame
+         * selected by QoS scheduler
+         *
+         * \param relayOnly true if only relayed frames may be selected (access after SIFS)
+         */
+        void ChannelAccessGrantedQos(bool relayOnly);
+        /**
+         * \return LIFS duration for the next frame to transmit
+         *         (LIFS of its traffic class when QoS scheduler is used)
+         */
+        Time GetAccessLifs();
+        /**
+         * \return true if the next DATA frame to transmit is relayed frame
+         *         (always true without QoS scheduler)
+         */
+        bool IsRelayScheduled();
+        /**
+         * invoked to select the next DATA frame to transmit according to QoS scheduler,
+         * the head of each traffic class is searched in relay, retry and data queue (in this order)
+         *
+         * \param tc the traffic class of selected frame
+         * \param pkt the selected frame
+         * \param dst the destination of selected frame
+         * \param size the size of selected frame (including FCS)
+         * \param relayOnly true if only relay queue should be searched
+         * \return the queue storing selected frame (NO_QUEUE if there is no frame to transmit)
+         */
+        DataQueueType SelectDataQueue(uint8_t &tc, Ptr<Packet> &pkt, Mac48Address &dst, uint32_t &size, bool relayOnly);
+        /**
+         * \param queue the queue to search
+         * \param tc the traffic class
+         * \param pkt the first frame of given class
+         * \param dst the destination of this frame
+         * \param size the size of this frame (including FCS)
+         * \return true if the frame of given class can be transmitted from given queue
+         */
+        bool FindClassHead(DataQueueType queue, uint8_t tc, Ptr<Packet> &pkt, Mac48Address &dst, uint32_t &size);
+        /**
+         * invoked to remove the first frame of given class from given queue
+         * and store it as currently transmitted frame
+         *
+         * \param queue the queue to search
+         * \param tc the traffic class
+         */
+        void DequeueClassHead(DataQueueType queue, uint8_t tc);
+        /**
+         * \param tc the traffic class
+         * \return the number of queued DATA frames (relayed, retransmitted and originated) of given class
+         */
+        uint32_t GetQueuedFrames(uint8_t tc);
+        /**
+         * invoked whenever DATA frame is added to or removed from retry or data queue
+         * to keep the numbers of queued frames of each traffic class
+         *
+         * \param queue the queue (RETRY_QUEUE or DATA_QUEUE)
+         * \param pkt the frame
+         * \param queued true if the frame was added, false if removed
+         */
+        void CountClassFrame(DataQueueType queue, Ptr<const Packet> pkt, bool queued);
+        /**
+         * invoked whenever DATA frame is added to or removed from relay queue
+         * to keep the numbers of queued frames of each traffic class
+         *
+         * \param relayPkt the frame and its PHY header
+         * \param queued true if the frame was added, false if removed
+         */
+        void CountClassFrame(const std::pair<Ptr<Packet>, RescuePhyHeader> &relayPkt, bool queued);
+        /**
+         * \param queue the queue (RELAY_QUEUE, RETRY_QUEUE or DATA_QUEUE)
+         * \param tc the traffic class
+         * \return the number of frames of given class in given queue
+         */
+        uint32_t GetClassFrames(DataQueueType queue, uint8_t tc) const;
+        /**
+         * invoked by EnqueueRelay to merge the received copy of DATA frame with its copy
+         * already stored in relay queue - only the copy with lower BER is kept
+         *
+         * \param pkt the received frame copy
+         * \param phyHdr the PHY header of this copy
+         * \return true if the copy of this frame was already queued (and the copies were merged)
+         */
+        bool MergeRelayCopy(Ptr<Packet> pkt, RescuePhyHeader phyHdr);
         /**
          * invoked to remove current packet from TX queue
          */
@@ -343,10 +488,35 @@ namespace ns3 {
          * invoked to transmit DATA frame
          */
         void SendData();
+        /**
+         * invoked to prepare originated DATA frame for transmission
+         * (assign sequence number if needed and construct PHY header)
+         *
+         * \param pkt the originated DATA frame (with MAC header)
+         * \return PHY header associated with this frame
+         */
+        RescuePhyHeader PrepareData(Ptr<Packet> pkt);
         /**
          * invoked by relay station to forward DATA frame
          */
         void SendRelayedData();
+        /**
+         * invoked to collect queued DATA frames (relayed and originated) to the same destination
+         * as the frame selected for transmission, which can be sent in one aggregated transmission
+         * not longer than MaxAggregationAirtime
+         *
+         * \param first the frame selected for transmission (relayed or originated) and its PHY header
+         * \return true if at least one frame was aggregated with the selected frame
+         */
+        bool CollectAggregate(std::pair<Ptr<Packet>, RescuePhyHeader> first);
+        /**
+         * invoked to transmit aggregated DATA frames
+         */
+        void SendAggregate();
+        /**
+         * invoked after aggregated transmission to prepare for new one
+         */
+        void SendAggregateDone();
         /**
          * invoked to transmit ACK frame
          *
@@ -354,8 +524,40 @@ namespace ns3 {
          * \param dataTxMode acknowledged DATA frame TX mode (RescueMode)
          * \param tag SnrPerTag to notify source about final SNR/PER values of packet
          *            - for possible further use for multi rate control etc.
+         * \return true if the ACK frame was passed to PHY
+         */
+        bool SendAck(RescuePhyHeader ackHdr, RescueMode dataTxMode, SnrPerTag tag);
+        /**
+         * queues ACK frame to send after the received DATA frame - ACKs of subframes of aggregated
+         * transmission are sent one after another (separated with SIFS)
+         *
+         * \param ackHdr PHY header of ACK frame to send
+         * \param dataTxMode acknowledged DATA frame TX mode (RescueMode)
+         * \param tag SnrPerTag of acknowledged DATA frame
+         * \param delay the time from the end of DATA frame to the first ACK (if no ACK is pending)
+         */
+        void ScheduleAck(RescuePhyHeader ackHdr, RescueMode dataTxMode, SnrPerTag tag, Time delay);
+        /**
+         * PART ACKs of relays are sent in slots following the longest possible ACK of the destination
+         * (sent SIFS after DATA), the slot of a relay is selected with its index among the relays
+         * of the flow, so relays which received the same frame do not collide
+         *
+         * \param phyHdr PHY header of acknowledged DATA frame
+         * \param dataTxMode acknowledged DATA frame TX mode (RescueMode)
+         * \return the time from the end of DATA frame to PART ACK of this relay
+         */
+        Time GetHopAckDelay(const RescuePhyHeader &phyHdr, RescueMode dataTxMode);
+        /**
+         * invoked when ACK frame of other node is received to cancel pending PART ACKs
+         * which acknowledge the same transmission (the hop is confirmed already)
+         *
+         * \param ackHdr PHY header of received ACK frame
+         */
+        void SuppressHopAcks(const RescuePhyHeader &ackHdr);
+        /**
+         * invoked to transmit the first of queued ACK frames
          */
-        void SendAck(RescuePhyHeader ackHdr, RescueMode dataTxMode, SnrPerTag tag);
+        void SendPendingAck();
         /**
          * invoked to pass the frame to PHY for transmission
          *
@@ -373,6 +575,14 @@ namespace ns3 {
          * \return true if transmission starts
          */
         bool SendPacket(std::pair<Ptr<Packet>, RescuePhyHeader> relayedPkt, RescueMode mode);
+        /**
+         * invoked to pass the aggregated frames to PHY for transmission
+         *
+         * \param aggregate list of packets for transmission and associated PHY headers
+         * \param mode frame TX mode (RescueMode)
+         * \return true if transmission starts
+         */
+        bool SendPacket(std::list<std::pair<Ptr<Packet>, RescuePhyHeader> > aggregate, RescueMode mode);
         /**
          * invoked when transmission was not successful to try again after LIFS period
          *
@@ -441,6 +651,13 @@ namespace ns3 {
          */
         void ReceiveAck(Ptr<Packet> ackPkt, RescuePhyHeader ackHdr,
                 double ackSnr, RescueMode ackMode);
+        /**
+         * invoked by ReceivePacketDone to process PART ACK frame (hop acknowledgement)
+         *
+         * \param ackPkt the received PART ACK packet
+         * \param ackHdr PHY header associated with the received PART ACK packet
+         */
+        void ReceivePartialAck(Ptr<Packet> ackPkt, RescuePhyHeader ackHdr);
         /**
          * invoked by ReceivePacketDone to process RESOURCE RESERVATION frame
          * currently NOT SUPPORTED
@@ -498,6 +715,7 @@ namespace ns3 {
         Ptr<RescueNetDevice> m_device; //!< Pointer to RescueNetDevice
         Ptr<RescueRemoteStationManager> m_remoteStationManager; //!< Pointer to RescueRemoteStationManager (rate control)
         Ptr<RescueArqManager> m_arqManager; //!< Pointer to RescueArqManager (ARQ control)
+        Ptr<RescueQosScheduler> m_qosScheduler; //!< Pointer to RescueQosScheduler (0 - no QoS scheduling)
         Ptr<UniformRandomVariable> m_random; //!< Provides uniform random variables.
 
         EventId m_ccaTimeoutEvent; //!< CCA procedure timeout event
@@ -515,6 +733,12 @@ namespace ns3 {
         uint16_t m_cw; //!< Current contention window
         uint8_t m_interleaver; //!< Counter to set interlever
         uint32_t m_queueLimit; //!< Maximal queue(s) size
+        Time m_maxAggregationAirtime; //!< Maximal duration of aggregated transmission (0 - aggregation disabled)
+        uint32_t m_hopAckSlots; //!< Number of PART ACK slots of relays following the ACK of the destination
+        Time m_relayedLifetime; //!< Maximal sojourn time of relayed frame in relay queue (0 - expired frames are not dropped)
+        RescueCoDel m_relayAqm; //!< AQM state of relay queue
+        RescueCoDel m_retryAqm; //!< AQM state of retry queue
+        RescueCoDel m_dataAqm; //!< AQM state of queue for newly originated frames
 
         Time m_backoffRemain; //!< Remaining BACKOFF time
         Time m_backoffStart; //!< The time of last BACKOFF counter start
@@ -540,18 +764,23 @@ namespace ns3 {
         RelayQueue m_pktRelayQueue; //!< The queue for frames to forward
         RelayQueue m_ctrlPktQueue; //!< The queue for control frames to transmit
         RelayQueue m_ackQueue; //!< The queue for ACK frames to forward
+        RelayQueue m_pktAggregate; //!< Currently transmitted aggregated DATA frames (relayed and originated)
+        std::vector<uint32_t> m_classFrames [DATA_QUEUE + 1]; //!< Numbers of queued DATA frames of each traffic class (indexed by DataQueueType)
 
-        struct StoredAck {
-            std::pair<Ptr<Packet>, RescuePhyHeader> ack; //!< The ACK packet
-            Time expires; //!< Lifetime of this ACK packet
+        RescueAckCache m_ackCache; //!< The memory to store recently forwarded ACK in case of retransmission need
+
+        struct PendingAck {
+            RescuePhyHeader ackHdr; //!< PHY header of ACK frame
+            RescueMode dataTxMode; //!< TX mode of acknowledged DATA frame
+            SnrPerTag tag; //!< SnrPerTag of acknowledged DATA frame
         };
-        typedef std::list<StoredAck> AckCache;
-        typedef std::list<StoredAck>::reverse_iterator AckCacheRI;
-        typedef std::list<StoredAck>::iterator AckCacheI;
-        AckCache m_ackCache; //!< The memory to store recently forwarded ACK in case of retransmission need
+        std::list<PendingAck> m_pendingAcks; //!< ACK frames awaiting transmission (ACKs of aggregated subframes)
 
         //bool m_resendAck; //!< to notify that pending ACK is retransmitted
 
+        TracedCallback<Ptr<const Packet>, Time> m_traceAqmDrop; //!< Trace Hookup for DATA frame dropped by AQM (with its sojourn time)
+        TracedCallback<Ptr<const Packet>, Time> m_traceSojourn; //!< Trace Hookup for sojourn time of transmitted DATA frame
+
 
 
         // for trace and performance evaluation
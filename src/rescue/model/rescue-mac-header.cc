@@ -30,12 +30,14 @@ namespace ns3 {
 
     NS_OBJECT_ENSURE_REGISTERED(RescueMacHeader);
 
-    RescueMacHeader::RescueMacHeader() {
+    RescueMacHeader::RescueMacHeader()
+    : m_coded(0) {
     }
 
     RescueMacHeader::RescueMacHeader(const Mac48Address srcAddr, const Mac48Address dstAddr, uint8_t type)
     : Header(),
     m_type(type),
+    m_coded(0),
     m_srcAddr(srcAddr),
     m_dstAddr(dstAddr),
     m_sequence(0) {
@@ -77,12 +79,18 @@ namespace ns3 {
         m_retry = 0;
     }
 
+    void
+    RescueMacHeader::SetCoded(void) {
+        m_coded = 1;
+    }
+
     void
     RescueMacHeader::SetFrameControl(uint8_t ctrl) {
         m_type = ctrl & 0x07;
         switch (m_type) {
             case RESCUE_MAC_PKT_TYPE_DATA:
                 m_retry = (ctrl >> 3) & 0x01;
+                m_coded = (ctrl >> 4) & 0x01;
                 break;
             case RESCUE_MAC_PKT_TYPE_ACK:
             case RESCUE_MAC_PKT_TYPE_B:
@@ -120,6 +128,11 @@ namespace ns3 {
         return (m_retry == 1);
     }
 
+    bool
+    RescueMacHeader::IsCoded(void) const {
+        return (m_coded == 1);
+    }
+
     uint8_t
     RescueMacHeader::GetFrameControl(void) const {
         uint8_t val = 0;
@@ -127,6 +140,7 @@ namespace ns3 {
         switch (m_type) {
             case RESCUE_MAC_PKT_TYPE_DATA:
                 val |= (m_retry << 3) & (0x01 << 3);
+                val |= (m_coded << 4) & (0x01 << 4);
                 break;
             case RESCUE_MAC_PKT_TYPE_ACK:
             case RESCUE_MAC_PKT_TYPE_B:
@@ -61,6 +61,10 @@ namespace ns3 {
          * Un-set the Retry bit in the Frame Control field.
          */
         void SetNoRetry(void);
+        /**
+         * Set the Coded bit in the Frame Control field (network-coded retransmission).
+         */
+        void SetCoded(void);
 
         /**
          * \param addr the source address field
@@ -87,6 +91,10 @@ namespace ns3 {
          * \return true if the Retry bit is set, false otherwise
          */
         bool IsRetry(void) const;
+        /**
+         * \return true if the frame carries a network-coded combination of DATA frames
+         */
+        bool IsCoded(void) const;
 
         uint8_t GetFrameControl(void) const;
 
@@ -117,6 +125,7 @@ namespace ns3 {
     private:
         uint8_t m_type; //<! type field
         uint8_t m_retry; //<! retry flag
+        uint8_t m_coded; //<! coded frame flag
         Mac48Address m_srcAddr; //<! source address field
         Mac48Address m_dstAddr; //<! destination address field
         uint16_t m_sequence; //<! sequence number field
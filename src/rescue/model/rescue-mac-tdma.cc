@@ -33,11 +33,14 @@
 #include "rescue-phy.h"
 #include "rescue-remote-station-manager.h"
 #include "rescue-arq-manager.h"
+#include "rescue-qos-scheduler.h"
 #include "rescue-mac-header.h"
 #include "rescue-mac-trailer.h"
 #include "rescue-mac-tdma.h"
 #include "snr-per-tag.h"
 
+#include "rescue-utils.h"
+
 NS_LOG_COMPONENT_DEFINE("RescueMacTdma");
 
 #undef NS_LOG_APPEND_CONTEXT
@@ -69,6 +72,7 @@ namespace ns3 {
         Clear();
         m_remoteStationManager = 0;
         m_arqManager = 0;
+        m_qosScheduler = 0;
     }
 
     void
@@ -81,6 +85,9 @@ namespace ns3 {
         m_pktRelayQueue.clear();
         m_ctrlPktQueue.clear();
         m_ackQueue.clear();
+        m_relayAqm.Reset();
+        m_retryAqm.Reset();
+        m_dataAqm.Reset();
     }
 
     TypeId
@@ -103,6 +110,23 @@ namespace ns3 {
                 UintegerValue(20),
                 MakeUintegerAccessor(&RescueMacTdma::m_queueLimit),
                 MakeUintegerChecker<uint32_t> ())
+                .AddAttribute("AqmTarget",
+                "Acceptable sojourn time of DATA frames in queues - CoDel target (0 - AQM disabled)",
+                TimeValue(Seconds(0)),
+                MakeTimeAccessor(&RescueMacTdma::SetAqmTarget,
+                &RescueMacTdma::GetAqmTarget),
+                MakeTimeChecker())
+                .AddAttribute("AqmInterval",
+                "Interval of sojourn time observation - CoDel interval",
+                TimeValue(MilliSeconds(100)),
+                MakeTimeAccessor(&RescueMacTdma::SetAqmInterval,
+                &RescueMacTdma::GetAqmInterval),
+                MakeTimeChecker())
+                .AddAttribute("RelayedLifetime",
+                "Maximal time a relayed DATA frame may wait in relay queue, then it is dropped as its source has noticed ACK timeout already (ACK enabled only, 0 - never dropped)",
+                TimeValue(MicroSeconds(15000)),
+                MakeTimeAccessor(&RescueMacTdma::m_relayedLifetime),
+                MakeTimeChecker())
                 /*.AddAttribute ("AckTimeout",
                                "ACK awaiting time",
                                TimeValue (MicroSeconds (3000)),
@@ -134,6 +158,12 @@ namespace ns3 {
                 .AddTraceSource("ForwardAck",
                 "Trace Hookup for ACK Forward",
                 MakeTraceSourceAccessor(&RescueMacTdma::m_traceAckForward))
+                .AddTraceSource("AqmDrop",
+                "Trace Hookup for DATA frame dropped by AQM or after ACK timeout expiration",
+                MakeTraceSourceAccessor(&RescueMacTdma::m_traceAqmDrop))
+                .AddTraceSource("QueueSojourn",
+                "Trace Hookup for the time spent in queue by transmitted DATA frame",
+                MakeTraceSourceAccessor(&RescueMacTdma::m_traceSojourn))
 
                 ;
         return tid;
@@ -173,6 +203,11 @@ namespace ns3 {
         m_arqManager = arqManager;
     }
 
+    void
+    RescueMacTdma::SetQosScheduler(Ptr<RescueQosScheduler> scheduler) {
+        m_qosScheduler = scheduler;
+    }
+
     void
     RescueMacTdma::SetSifsTime(Time duration) {
         m_sifs = duration;
@@ -188,6 +223,20 @@ namespace ns3 {
         m_queueLimit = length;
     }
 
+    void
+    RescueMacTdma::SetAqmTarget(Time target) {
+        m_relayAqm.SetTarget(target);
+        m_retryAqm.SetTarget(target);
+        m_dataAqm.SetTarget(target);
+    }
+
+    void
+    RescueMacTdma::SetAqmInterval(Time interval) {
+        m_relayAqm.SetInterval(interval);
+        m_retryAqm.SetInterval(interval);
+        m_dataAqm.SetInterval(interval);
+    }
+
     /*void
     RescueMacTdma::SetBasicAckTimeout (Time duration)
     {
@@ -219,6 +268,16 @@ namespace ns3 {
         return m_queueLimit;
     }
 
+    Time
+    RescueMacTdma::GetAqmTarget(void) const {
+        return m_dataAqm.GetTarget();
+    }
+
+    Time
+    RescueMacTdma::GetAqmInterval(void) const {
+        return m_dataAqm.GetInterval();
+    }
+
     /*Time
     RescueMacTdma::GetBasicAckTimeout (void) const
     {
@@ -261,6 +320,16 @@ namespace ns3 {
                     pktHdr.first->GetSize());
             Time duration = GetDataDuration(pktHdr.first, mode) + GetSifsTime();
             return duration;
+        } else if (m_qosScheduler != 0) {
+            uint8_t tc;
+            Ptr<Packet> pkt;
+            Mac48Address dst;
+            uint32_t size;
+            if (SelectDataQueue(tc, pkt, dst, size) == NO_QUEUE)
+                return Seconds(0);
+            RescueMode mode = m_remoteStationManager->GetDataTxMode(dst, pkt, size);
+            Time duration = GetDataDuration(pkt, mode) + GetSifsTime();
+            return duration;
         } else if (m_pktRelayQueue.size() != 0) {
             std::pair<Ptr<Packet>, RescuePhyHeader> pktHdr = m_pktRelayQueue.front();
             RescueMode mode = m_remoteStationManager->GetDataTxMode(pktHdr.second.GetDestination(),
@@ -379,8 +448,16 @@ namespace ns3 {
             NS_LOG_DEBUG("PACKET QUEUE LIMIT REACHED - DROP FRAME!");
             return false;
         }
+        if (m_qosScheduler != 0) {
+            uint8_t tc = m_qosScheduler->Classify(pkt);
+            if (GetQueuedFrames(tc) >= m_qosScheduler->GetQueueLimit(tc, m_queueLimit)) {
+                NS_LOG_DEBUG("TC " << (uint32_t) tc << " QUEUE LIMIT REACHED - DROP FRAME!");
+                return false;
+            }
+        }
 
         //m_traceEnqueue (m_device->GetNode ()->GetId (), m_device->GetIfIndex (), pkt);
+        RescueCoDel::SetEnqueueTime(pkt);
         m_pktQueue.push_back(pkt);
         return true;
     }
@@ -399,8 +476,16 @@ namespace ns3 {
             NS_LOG_DEBUG("PACKET RETRY QUEUE LIMIT REACHED - DROP FRAME!");
             return false;
         }
+        if (m_qosScheduler != 0) {
+            uint8_t tc = m_qosScheduler->Classify(pkt);
+            if (GetQueuedFrames(tc) >= m_qosScheduler->GetQueueLimit(tc, m_queueLimit)) {
+                NS_LOG_DEBUG("TC " << (uint32_t) tc << " QUEUE LIMIT REACHED - DROP RETRY FRAME!");
+                return false;
+            }
+        }
 
         //m_traceEnqueue (m_device->GetNode ()->GetId (), m_device->GetIfIndex (), pkt);
+        RescueCoDel::SetEnqueueTime(pkt);
         m_pktRetryQueue.push_back(pkt);
         return true;
     }
@@ -415,12 +500,22 @@ namespace ns3 {
                 "#ctrl queue:" << m_ctrlPktQueue.size() <<
                 "#ack queue:" << m_ackQueue.size() <<
                 "state:" << StateToString(m_state));
+        if (MergeRelayCopy(pkt, phyHdr))
+            return true;
         if (m_pktRelayQueue.size() >= m_queueLimit) {
             NS_LOG_DEBUG("PACKET RELAY QUEUE LIMIT REACHED - DROP FRAME!");
             return false;
         }
+        if (m_qosScheduler != 0) {
+            uint8_t tc = m_qosScheduler->Classify(pkt, phyHdr);
+            if (GetQueuedFrames(tc) >= m_qosScheduler->GetQueueLimit(tc, m_queueLimit)) {
+                NS_LOG_DEBUG("TC " << (uint32_t) tc << " QUEUE LIMIT REACHED - DROP RELAY FRAME!");
+                return false;
+            }
+        }
 
         //m_traceEnqueue (m_device->GetNode ()->GetId (), m_device->GetIfIndex (), pkt);
+        RescueCoDel::SetEnqueueTime(pkt);
         std::pair<Ptr<Packet>, RescuePhyHeader> relayPkt(pkt, phyHdr);
         NS_LOG_INFO("ENQUEUE RELAY DATA FRAME! from src: " << relayPkt.second.GetSource() << " to dst: " << relayPkt.second.GetDestination() << ", seq: " << relayPkt.second.GetSequence());
         m_pktRelayQueue.push_back(relayPkt);
@@ -469,6 +564,119 @@ namespace ns3 {
         return true;
     }
 
+    RescueMacTdma::DataQueueType
+    RescueMacTdma::SelectDataQueue(uint8_t &tc, Ptr<Packet> &pkt, Mac48Address &dst, uint32_t &size) {
+        NS_ASSERT(m_qosScheduler != 0);
+        uint8_t nClasses = m_qosScheduler->GetNClasses();
+        std::vector<DataQueueType> queues(nClasses, NO_QUEUE);
+        std::vector<uint32_t> heads(nClasses, 0);
+        DataQueueType order[3] = {RELAY_QUEUE, RETRY_QUEUE, DATA_QUEUE};
+
+        for (uint8_t c = 0; c < nClasses; c++) {
+            for (uint8_t i = 0; i < 3; i++) {
+                if (FindClassHead(order[i], c, pkt, dst, size)) {
+                    queues[c] = order[i];
+                    heads[c] = size;
+                    break;
+                }
+            }
+        }
+
+        if (!m_qosScheduler->GetNextClass(heads, tc))
+            return NO_QUEUE;
+
+        FindClassHead(queues[tc], tc, pkt, dst, size);
+        return queues[tc];
+    }
+
+    bool
+    RescueMacTdma::FindClassHead(DataQueueType queue, uint8_t tc, Ptr<Packet> &pkt, Mac48Address &dst, uint32_t &size) {
+        if (queue == RELAY_QUEUE) {
+            for (RelayQueueI it = m_pktRelayQueue.begin(); it != m_pktRelayQueue.end(); it++) {
+                if (m_qosScheduler->Classify(it->first, it->second) == tc) {
+                    pkt = it->first;
+                    dst = it->second.GetDestination();
+                    size = it->first->GetSize();
+                    return true;
+                }
+            }
+        } else if (queue == RETRY_QUEUE || queue == DATA_QUEUE) {
+            Queue &pktQueue = (queue == RETRY_QUEUE) ? m_pktRetryQueue : m_pktQueue;
+            for (QueueI it = pktQueue.begin(); it != pktQueue.end(); it++) {
+                if (m_qosScheduler->Classify(*it) == tc) {
+                    RescueMacHeader hdr;
+                    (*it)->PeekHeader(hdr);
+                    RescueMacTrailer fcs;
+                    pkt = *it;
+                    dst = hdr.GetDestination();
+                    size = (*it)->GetSize() + fcs.GetSerializedSize();
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void
+    RescueMacTdma::DequeueClassHead(DataQueueType queue, uint8_t tc) {
+        if (queue == RELAY_QUEUE) {
+            for (RelayQueueI it = m_pktRelayQueue.begin(); it != m_pktRelayQueue.end(); it++) {
+                if (m_qosScheduler->Classify(it->first, it->second) == tc) {
+                    m_pktRelay = *it;
+                    m_pktRelayQueue.erase(it);
+                    return;
+                }
+            }
+        } else if (queue == RETRY_QUEUE || queue == DATA_QUEUE) {
+            Queue &pktQueue = (queue == RETRY_QUEUE) ? m_pktRetryQueue : m_pktQueue;
+            for (QueueI it = pktQueue.begin(); it != pktQueue.end(); it++) {
+                if (m_qosScheduler->Classify(*it) == tc) {
+                    m_pktData = *it;
+                    pktQueue.erase(it);
+                    return;
+                }
+            }
+        }
+        NS_FATAL_ERROR("No frame of TC " << (uint32_t) tc << " in selected queue");
+    }
+
+    bool
+    RescueMacTdma::MergeRelayCopy(Ptr<Packet> pkt, RescuePhyHeader phyHdr) {
+        for (RelayQueueI it = m_pktRelayQueue.begin(); it != m_pktRelayQueue.end(); it++) {
+            if ((it->second.GetSource() == phyHdr.GetSource())
+                    && (it->second.GetDestination() == phyHdr.GetDestination())
+                    && (it->second.GetSequence() == phyHdr.GetSequence())) {
+                //found enqueued copy, keep the better one (a copy without BER never replaces the enqueued one)
+                SnrPerTag queuedTag, rxTag;
+                bool queuedValid = it->first->PeekPacketTag(queuedTag);
+                bool rxValid = pkt->PeekPacketTag(rxTag);
+                if (rxValid && (!queuedValid || rxTag.GetBER() < queuedTag.GetBER())) {
+                    NS_LOG_INFO("MERGE: replace enqueued frame copy with the better one! from: " << phyHdr.GetSource() << " to: " << phyHdr.GetDestination() << ", seq: " << phyHdr.GetSequence() << ", BER: " << queuedTag.GetBER() << " -> " << rxTag.GetBER());
+                    RescueCoDel::SetEnqueueTime(pkt);
+                    *it = std::pair<Ptr<Packet>, RescuePhyHeader> (pkt, phyHdr);
+                } else
+                    NS_LOG_INFO("MERGE: drop worse frame copy! from: " << phyHdr.GetSource() << " to: " << phyHdr.GetDestination() << ", seq: " << phyHdr.GetSequence() << ", BER: " << rxTag.GetBER());
+                return true;
+            }
+        }
+        return false;
+    }
+
+    uint32_t
+    RescueMacTdma::GetQueuedFrames(uint8_t tc) {
+        uint32_t frames = 0;
+        for (RelayQueueI it = m_pktRelayQueue.begin(); it != m_pktRelayQueue.end(); it++)
+            if (m_qosScheduler->Classify(it->first, it->second) == tc)
+                frames++;
+        for (QueueI it = m_pktRetryQueue.begin(); it != m_pktRetryQueue.end(); it++)
+            if (m_qosScheduler->Classify(*it) == tc)
+                frames++;
+        for (QueueI it = m_pktQueue.begin(); it != m_pktQueue.end(); it++)
+            if (m_qosScheduler->Classify(*it) == tc)
+                frames++;
+        return frames;
+    }
+
     /*void
     RescueMacTdma::Dequeue ()
     {
@@ -539,6 +747,8 @@ namespace ns3 {
                 it2++;
         }
 
+        ApplyAqm();
+
         NS_LOG_FUNCTION("#data queue:" << m_pktQueue.size() <<
                 "#retry queue:" << m_pktRetryQueue.size() <<
                 "#relay queue:" << m_pktRelayQueue.size() <<
@@ -568,6 +778,62 @@ namespace ns3 {
         }
     }
 
+    void
+    RescueMacTdma::ApplyAqm() {
+        NS_LOG_FUNCTION("");
+
+        //drop relayed frames which outlived the ACK timeout of their source
+        if (ACK_ENABLED && (m_relayedLifetime > Seconds(0))) {
+            for (RelayQueueI it = m_pktRelayQueue.begin(); it != m_pktRelayQueue.end();) {
+                Time sojourn = RescueCoDel::GetSojournTime(it->first);
+                if (sojourn > m_relayedLifetime) {
+                    NS_LOG_INFO("Drop expired frame copy! from: " << it->second.GetSource() << " to: " << it->second.GetDestination() << ", seq: " << it->second.GetSequence() << ", sojourn: " << sojourn);
+                    m_traceAqmDrop(it->first, sojourn);
+                    it = m_pktRelayQueue.erase(it);
+                } else
+                    it++;
+            }
+        }
+
+        while (m_pktRelayQueue.size() != 0) {
+            Time sojourn = RescueCoDel::GetSojournTime(m_pktRelayQueue.front().first);
+            if (!m_relayAqm.ShouldDrop(sojourn, m_pktRelayQueue.size()))
+                break;
+            NS_LOG_INFO("AQM: drop relayed frame, sojourn: " << sojourn);
+            m_traceAqmDrop(m_pktRelayQueue.front().first, sojourn);
+            m_pktRelayQueue.pop_front();
+        }
+        while (m_pktRetryQueue.size() != 0) {
+            Time sojourn = RescueCoDel::GetSojournTime(m_pktRetryQueue.front());
+            if (!m_retryAqm.ShouldDrop(sojourn, m_pktRetryQueue.size()))
+                break;
+            NS_LOG_INFO("AQM: drop retransmitted frame, sojourn: " << sojourn);
+            m_traceAqmDrop(m_pktRetryQueue.front(), sojourn);
+            ReleaseDroppedFrame(m_pktRetryQueue.front());
+            m_pktRetryQueue.pop_front();
+        }
+        while (m_pktQueue.size() != 0) {
+            Time sojourn = RescueCoDel::GetSojournTime(m_pktQueue.front());
+            if (!m_dataAqm.ShouldDrop(sojourn, m_pktQueue.size()))
+                break;
+            NS_LOG_INFO("AQM: drop originated frame, sojourn: " << sojourn);
+            m_traceAqmDrop(m_pktQueue.front(), sojourn);
+            ReleaseDroppedFrame(m_pktQueue.front());
+            m_pktQueue.pop_front();
+        }
+    }
+
+    void
+    RescueMacTdma::ReleaseDroppedFrame(Ptr<const Packet> pkt) {
+        RescueMacHeader hdr;
+        pkt->PeekHeader(hdr);
+        //frame already got its sequence number - ARQ must not await its ACK anymore
+        if (hdr.IsRetry() || (hdr.GetSequence() != 0)) {
+            NS_LOG_INFO("Release ARQ state of dropped frame to: " << hdr.GetDestination() << ", seq: " << hdr.GetSequence());
+            m_arqManager->ReportDataDrop(hdr.GetDestination(), hdr.GetSequence());
+        }
+    }
+
     void
     RescueMacTdma::ChannelAccessGranted() {
         NS_LOG_FUNCTION("");
@@ -598,6 +864,8 @@ namespace ns3 {
             m_traceCtrlTx(m_device->GetNode()->GetId(), m_device->GetIfIndex(), m_pktRelay.first, m_pktRelay.second);
 
             SendRelayedData();
+        } else if (m_qosScheduler != 0) {
+            ChannelAccessGrantedQos();
         } else if (m_pktRelayQueue.size() != 0) {
             m_state = WAIT_TX;
 
@@ -644,6 +912,39 @@ namespace ns3 {
         }
     }
 
+    void
+    RescueMacTdma::ChannelAccessGrantedQos() {
+        NS_LOG_FUNCTION("");
+
+        uint8_t tc;
+        Ptr<Packet> pkt;
+        Mac48Address dst;
+        uint32_t size;
+        DataQueueType queue = SelectDataQueue(tc, pkt, dst, size);
+        if (queue == NO_QUEUE) {
+            NS_LOG_DEBUG("No queued frames for TX");
+            return;
+        }
+
+        m_state = WAIT_TX;
+
+        m_qosScheduler->NotifyTxStart(tc, size);
+        DequeueClassHead(queue, tc);
+
+        if (queue == RELAY_QUEUE) {
+            NS_LOG_INFO("RELAY DATA FRAME (TC " << (uint32_t) tc << ")!");
+            m_traceDataRelay(m_device->GetNode()->GetId(), m_device->GetIfIndex(), m_pktRelay.first, m_pktRelay.second);
+
+            SendRelayedData();
+        } else {
+            NS_LOG_INFO("dequeue packet from " << (queue == RETRY_QUEUE ? "retry " : "") << "TX queue (TC " << (uint32_t) tc << "), size: " << m_pktData->GetSize());
+            if (queue == DATA_QUEUE)
+                m_traceDataTx(m_device->GetNode()->GetId(), m_device->GetIfIndex(), m_pktData);
+
+            SendData();
+        }
+    }
+
 
     // ----------------------- Send Functions ------------------------------
 
@@ -694,6 +995,9 @@ namespace ns3 {
 
         hdr.IsRetry() ? phyHdr.SetRetry() : phyHdr.SetNoRetry();
         phyHdr.SetCentralisedMacProtocol();
+        //mark prioritized frames, so relays without QoS tag can classify them
+        if (m_qosScheduler != 0 && m_qosScheduler->Classify(m_pktData) > 0)
+            phyHdr.SetQosEnabled();
 
         m_arqManager->ConfigurePhyHeader(&phyHdr);
 
@@ -704,6 +1008,7 @@ namespace ns3 {
             NS_LOG_DEBUG("pktData total Size: " << m_pktData->GetSize());
             //if (SendPacket (m_pktData, mode, m_interleaver))
             if (SendPacket(std::pair<Ptr<Packet>, RescuePhyHeader> (m_pktData->Copy(), phyHdr), mode)) {
+                m_traceSojourn(m_pktData, RescueCoDel::GetSojournTime(m_pktData));
                 //Time ackTimeout = GetDataDuration (m_pktData, mode) + GetSifsTime () + GetCtrlDuration (RESCUE_MAC_PKT_TYPE_ACK, mode) + GetSlotTime ();
                 Ptr<Packet> p = m_pktData->Copy();
                 m_arqManager->ReportDataTx(p);
@@ -778,6 +1083,8 @@ namespace ns3 {
         {
             m_pktRelay.second.SetSender(m_hiMac->GetAddress());
             if (SendPacket(m_pktRelay, mode)) {
+                if (m_pktRelay.second.IsDataFrame())
+                    m_traceSojourn(m_pktRelay.first, RescueCoDel::GetSojournTime(m_pktRelay.first));
             } else {
                 //StartOver ();
             }
@@ -956,7 +1263,10 @@ namespace ns3 {
             m_ackQueue.push_back(ackPkt);
             NS_LOG_DEBUG("QUEUED ACKs: " << m_ackQueue.size());
 
-            m_hiMac->ReceivePacket(pkt, phyHdr);
+            Ptr<Packet> payload = pkt->Copy();
+            if (!hdr.IsCoded())
+                m_hiMac->ReceivePacket(pkt, phyHdr);
+            m_arqManager->ReportDataRx(payload, &phyHdr, hdr.IsCoded());
         } else {
             NS_LOG_INFO("(duplicate) DROP!");
         }
@@ -978,8 +1288,7 @@ namespace ns3 {
         NS_LOG_INFO("FRAME TO RELAY!");
 
         phyHdr.SetSender(m_hiMac->GetAddress());
-        std::pair<Ptr<Packet>, RescuePhyHeader> pktRelay(pkt, phyHdr);
-        m_pktRelayQueue.push_back(pktRelay);
+        EnqueueRelay(pkt, phyHdr);
         //m_hiMac->NotifyEnqueueRelay (pkt, phyHdr.GetDestination ());
         //m_pktRelay = std::pair<Ptr<Packet>, RescuePhyHeader> (pkt, phyHdr);
 
@@ -1012,7 +1321,7 @@ namespace ns3 {
                 ackPkt->PeekPacketTag(tag);
                 m_remoteStationManager->ReportDataOk(ackHdr.GetSource(),
                         ackSnr, ackMode,
-                        tag.GetSNR(), tag.GetBER(),
+                        tag.GetSNR(), tag.IsSNRValid(), tag.GetBER(),
                         (uint16_t) retryCounter);
 
                 //check for unnecessary retransmissions in retry queue
@@ -1075,7 +1384,9 @@ namespace ns3 {
             return;
         } else {
             if (correctData) {
-                m_remoteStationManager->ReportRxOk(phyHdr.GetSender(), phyHdr.GetSource(), snr, mode, wasReconstructed);
+                SnrPerTag berTag;
+                bool berValid = pkt->PeekPacketTag(berTag);
+                m_remoteStationManager->ReportRxOk(phyHdr.GetSender(), phyHdr.GetSource(), snr, mode, wasReconstructed, berTag.GetBER(), berValid);
             } else {
                 m_remoteStationManager->ReportRxFail(phyHdr.GetSender(), phyHdr.GetSource(), snr, mode, wasReconstructed);
             }
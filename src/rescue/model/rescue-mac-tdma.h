@@ -35,6 +35,7 @@
 #include "rescue-phy-header.h"
 #include "rescue-mode.h"
 #include "snr-per-tag.h"
+#include "rescue-codel.h"
 
 #include <list>
 
@@ -45,6 +46,7 @@ namespace ns3 {
     class RescueMac;
     class RescueRemoteStationManager;
     class RescueArqManager;
+    class RescueQosScheduler;
     class RescueNetDevice;
 
     /**
@@ -94,6 +96,10 @@ namespace ns3 {
          * \param arqManager RescueArqManager associated with this MAC
          */
         void SetArqManager(Ptr<RescueArqManager> arqManager);
+        /**
+         * \param scheduler RescueQosScheduler associated with this MAC (0 - no QoS scheduling)
+         */
+        void SetQosScheduler(Ptr<RescueQosScheduler> scheduler);
 
         /**
          * \param duration the slot duration
@@ -107,6 +113,14 @@ namespace ns3 {
          * \param length the length of queues used by this MAC
          */
         void SetQueueLimits(uint32_t length);
+        /**
+         * \param target the acceptable sojourn time of DATA frames in queues (0 - AQM disabled)
+         */
+        void SetAqmTarget(Time target);
+        /**
+         * \param interval the AQM interval of sojourn time observation
+         */
+        void SetAqmInterval(Time interval);
         /**
          * \param duration the Basic ACK Timeout duration
          */
@@ -134,6 +148,14 @@ namespace ns3 {
          * \return length the length of queues used by this MAC
          */
         uint32_t GetQueueLimits(void) const;
+        /**
+         * \return the acceptable sojourn time of DATA frames in queues (0 - AQM disabled)
+         */
+        Time GetAqmTarget(void) const;
+        /**
+         * \return the AQM interval of sojourn time observation
+         */
+        Time GetAqmInterval(void) const;
         /**
          * \return duration the Basic ACK Timeout duration
          */
@@ -295,6 +317,22 @@ namespace ns3 {
          * invoked to start TX
          */
         void ChannelAccessGranted();
+        /**
+         * invoked before dequeue or report of queued frames to drop expired relayed frames
+         * and to apply AQM to the heads of DATA queues
+         */
+        void ApplyAqm();
+        /**
+         * invoked when a DATA frame is dropped from the retry or originated queue
+         * to release ARQ state of the frame if it has been sequenced already
+         *
+         * \param pkt the dropped frame
+         */
+        void ReleaseDroppedFrame(Ptr<const Packet> pkt);
+        /**
+         * invoked to start TX of DATA frame selected by QoS scheduler
+         */
+        void ChannelAccessGrantedQos();
         /**
          * invoked to transmit DATA frame
          */
@@ -317,6 +355,53 @@ namespace ns3 {
         } State;
         std::string StateToString(State state);
 
+        typedef enum {
+            NO_QUEUE, RELAY_QUEUE, RETRY_QUEUE, DATA_QUEUE
+        } DataQueueType;
+
+        /**
+         * invoked to select the next DATA frame to transmit according to QoS scheduler,
+         * the head of each traffic class is searched in relay, retry and data queue (in this order)
+         *
+         * \param tc the traffic class of selected frame
+         * \param pkt the selected frame
+         * \param dst the destination of selected frame
+         * \param size the size of selected frame (including FCS)
+         * \return the queue storing selected frame (NO_QUEUE if there is no frame to transmit)
+         */
+        DataQueueType SelectDataQueue(uint8_t &tc, Ptr<Packet> &pkt, Mac48Address &dst, uint32_t &size);
+        /**
+         * \param queue the queue to search
+         * \param tc the traffic class
+         * \param pkt the first frame of given class
+         * \param dst the destination of this frame
+         * \param size the size of this frame (including FCS)
+         * \return true if the frame of given class is stored in given queue
+         */
+        bool FindClassHead(DataQueueType queue, uint8_t tc, Ptr<Packet> &pkt, Mac48Address &dst, uint32_t &size);
+        /**
+         * invoked to remove the first frame of given class from given queue
+         * and store it as currently transmitted frame
+         *
+         * \param queue the queue to search
+         * \param tc the traffic class
+         */
+        void DequeueClassHead(DataQueueType queue, uint8_t tc);
+        /**
+         * \param tc the traffic class
+         * \return the number of queued DATA frames (relayed, retransmitted and originated) of given class
+         */
+        uint32_t GetQueuedFrames(uint8_t tc);
+        /**
+         * invoked by EnqueueRelay to merge the received copy of DATA frame with its copy
+         * already stored in relay queue - only the copy with lower BER is kept
+         *
+         * \param pkt the received frame copy
+         * \param phyHdr the PHY header of this copy
+         * \return true if the copy of this frame was already queued (and the copies were merged)
+         */
+        bool MergeRelayCopy(Ptr<Packet> pkt, RescuePhyHeader phyHdr);
+
         /**
          * invoked to remove current packet from TX queue
          */
@@ -450,6 +535,7 @@ namespace ns3 {
         Ptr<RescueNetDevice> m_device; //!< Pointer to RescueNetDevice
         Ptr<RescueRemoteStationManager> m_remoteStationManager; //!< Pointer to RescueRemoteStationManager (rate control)
         Ptr<RescueArqManager> m_arqManager; //!< Pointer to RescueArqManager (ARQ control)
+        Ptr<RescueQosScheduler> m_qosScheduler; //!< Pointer to RescueQosScheduler (0 - no QoS scheduling)
         Ptr<UniformRandomVariable> m_random; //!< Provides uniform random variables.
 
         //EventId m_ackTimeoutEvent;        //!< End-to-end ACK timeout event
@@ -468,6 +554,10 @@ namespace ns3 {
         uint16_t m_sequence; //!< Sequence counter of this MAC
         uint8_t m_interleaver; //!< Counter of set interlever
         uint32_t m_queueLimit; //!< Maximal queue(s) size
+        Time m_relayedLifetime; //!< Maximal sojourn time of relayed frame in relay queue (0 - expired frames are not dropped)
+        RescueCoDel m_relayAqm; //!< AQM state of relay queue
+        RescueCoDel m_retryAqm; //!< AQM state of retry queue
+        RescueCoDel m_dataAqm; //!< AQM state of queue for newly originated frames
 
         //Time m_basicAckTimeout;   //!< The maximal duration of ACK awaiting
         Time m_opEnd; //!< The end of current operation period
@@ -507,6 +597,8 @@ namespace ns3 {
         TracedCallback<uint32_t, uint32_t, Ptr<const Packet>, const RescuePhyHeader &> m_traceAckTx; //<! Trace Hookup for ACK TX (originated)
         TracedCallback<uint32_t, uint32_t, Ptr<const Packet>, const RescuePhyHeader &> m_traceAckForward; //<! Trace Hookup for ACK forwarding
         TracedCallback<uint32_t, uint32_t, Ptr<const Packet>, const RescuePhyHeader &> m_traceCtrlTx; //<! Trace Hookup for CTRL TX
+        TracedCallback<Ptr<const Packet>, Time> m_traceAqmDrop; //!< Trace Hookup for DATA frame dropped by AQM (with its sojourn time)
+        TracedCallback<Ptr<const Packet>, Time> m_traceSojourn; //!< Trace Hookup for sojourn time of transmitted DATA frame
 
     protected:
         virtual void DoDispose();
@@ -32,6 +32,7 @@
 #include "rescue-net-device.h"
 #include "rescue-remote-station-manager.h"
 #include "rescue-arq-manager.h"
+#include "rescue-qos-scheduler.h"
 #include "low-rescue-mac.h"
 #include "rescue-mac-csma.h"
 #include "rescue-mac-tdma.h"
@@ -57,7 +58,10 @@ namespace ns3 {
 
     RescueMac::RescueMac()
     : m_phy(0),
-    m_tdmaMac(0) {
+    m_tdmaMac(0),
+    m_neighbourSnrThreshold(0),
+    m_neighbourTimeout(Seconds(1)),
+    m_tdmaGuardInterval(Seconds(0)) {
         NS_LOG_INFO("");
         m_random = CreateObject<UniformRandomVariable> ();
         m_csmaMac = CreateObject<RescueMacCsma> ();
@@ -84,6 +88,19 @@ namespace ns3 {
     RescueMac::Clear() {
     }
 
+    std::vector<Mac48Address>
+    RescueMac::GetNeighbours(void) {
+        return m_remoteStationManager->GetNeighbours(m_neighbourSnrThreshold, m_neighbourTimeout);
+    }
+
+    bool
+    RescueMac::FitsInTdmaSlot(Time remaining) {
+        Time duration = m_tdmaMac->GetNextTxSifsDuration();
+        if (m_tdmaGuardInterval > Seconds(0) && duration > Seconds(0))
+            duration = duration - m_tdmaMac->GetSifsTime() + m_tdmaGuardInterval;
+        return duration < remaining;
+    }
+
     TypeId
     RescueMac::GetTypeId(void) {
         static TypeId tid = TypeId("ns3::RescueMac")
@@ -119,12 +136,39 @@ namespace ns3 {
                 UintegerValue(20),
                 MakeUintegerAccessor(&RescueMac::SetQueueLimits),
                 MakeUintegerChecker<uint32_t> ())
+                .AddAttribute("AqmTarget",
+                "Acceptable sojourn time of DATA frames in queues - CoDel target (0 - AQM disabled)",
+                TimeValue(Seconds(0)),
+                MakeTimeAccessor(&RescueMac::SetAqmTarget),
+                MakeTimeChecker())
+                .AddAttribute("AqmInterval",
+                "Interval of sojourn time observation - CoDel interval",
+                TimeValue(MilliSeconds(100)),
+                MakeTimeAccessor(&RescueMac::SetAqmInterval),
+                MakeTimeChecker())
                 /*.AddAttribute ("BasicAckTimeout",
                                "ACK awaiting time",
                                TimeValue (MicroSeconds (3000)),
                                MakeTimeAccessor (&RescueMac::SetBasicAckTimeout),
                                MakeTimeChecker ())*/
 
+                .AddAttribute("NeighbourSnrThreshold",
+                "Minimal averaged SNR [dB] of frames received from a station to treat it as a neighbour (spatial reuse of TDMA slots)",
+                DoubleValue(0),
+                MakeDoubleAccessor(&RescueMac::m_neighbourSnrThreshold),
+                MakeDoubleChecker<double> ())
+                .AddAttribute("NeighbourTimeout",
+                "Time after which a station not heard is no longer treated as a neighbour",
+                TimeValue(Seconds(1)),
+                MakeTimeAccessor(&RescueMac::m_neighbourTimeout),
+                MakeTimeChecker())
+                .AddAttribute("TdmaGuardInterval",
+                "Guard time kept at the end of TDMA time slot instead of SIFS (0 - SIFS is kept). "
+                "With timing advance it has to cover only the residual synchronisation error and the delay spread between stations",
+                TimeValue(Seconds(0)),
+                MakeTimeAccessor(&RescueMac::m_tdmaGuardInterval),
+                MakeTimeChecker())
+
                 .AddAttribute("CsmaMac", "The CsmaMac object",
                 PointerValue(),
                 MakePointerAccessor(&RescueMac::GetCsmaMac),
@@ -198,6 +242,28 @@ namespace ns3 {
         }
     }
 
+    Ptr<RescueRemoteStationManager>
+    RescueMac::GetRemoteStationManager(void) const {
+        return m_remoteStationManager;
+    }
+
+    void
+    RescueMac::SetQosScheduler(Ptr<RescueQosScheduler> scheduler) {
+        //NS_LOG_FUNCTION (this << scheduler);
+        m_qosScheduler = scheduler;
+        if (m_csmaMac != 0) {
+            m_csmaMac->SetQosScheduler(m_qosScheduler);
+        }
+        if (m_tdmaMac != 0) {
+            m_tdmaMac->SetQosScheduler(m_qosScheduler);
+        }
+    }
+
+    Ptr<RescueQosScheduler>
+    RescueMac::GetQosScheduler(void) const {
+        return m_qosScheduler;
+    }
+
     void
     RescueMac::SetForwardUpCb(Callback<void, Ptr<Packet>, Mac48Address, Mac48Address> cb) {
         m_forwardUpCb = cb;
@@ -264,6 +330,22 @@ namespace ns3 {
             m_tdmaMac->SetQueueLimits(length);
     }
 
+    void
+    RescueMac::SetAqmTarget(Time target) {
+        if (m_csmaMac != 0)
+            m_csmaMac->SetAqmTarget(target);
+        if (m_tdmaMac != 0)
+            m_tdmaMac->SetAqmTarget(target);
+    }
+
+    void
+    RescueMac::SetAqmInterval(Time interval) {
+        if (m_csmaMac != 0)
+            m_csmaMac->SetAqmInterval(interval);
+        if (m_tdmaMac != 0)
+            m_tdmaMac->SetAqmInterval(interval);
+    }
+
     /*void
     RescueMac::SetBasicAckTimeout (Time duration)
     {
@@ -368,6 +450,12 @@ namespace ns3 {
                 << ") does not support EnqueueRetry ()");
     }
 
+    void
+    RescueMac::EnqueueRelay(Ptr<Packet> pkt, RescuePhyHeader phyHdr) {
+        NS_FATAL_ERROR("This MAC entity (" << this << ", " << GetAddress()
+                << ") does not support EnqueueRelay ()");
+    }
+
     void
     //RescueMac::NotifyEnqueueRelay (Ptr<Packet> pkt, Mac48Address dst)
     RescueMac::NotifyEnqueuedPacket(Ptr<Packet> pkt, Mac48Address dst) {
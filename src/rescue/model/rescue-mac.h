@@ -35,6 +35,8 @@
 #include "rescue-phy-header.h"
 #include "rescue-mode.h"
 
+#include <vector>
+
 namespace ns3 {
 
     uint8_t compressMac(ns3::Mac48Address addr);
@@ -47,6 +49,7 @@ namespace ns3 {
     class RescueMacTdma;
     class RescueRemoteStationManager;
     class RescueArqManager;
+    class RescueQosScheduler;
     class RescueNetDevice;
 
     enum StationType {
@@ -89,10 +92,22 @@ namespace ns3 {
          * \param manager RescueRemoteStationManager associated with this MAC
          */
         void SetRemoteStationManager(Ptr<RescueRemoteStationManager> manager);
+        /**
+         * \return RescueRemoteStationManager associated with this MAC
+         */
+        Ptr<RescueRemoteStationManager> GetRemoteStationManager(void) const;
         /**
          * \param arqManager RescueArqManager associated with this MAC
          */
         void SetArqManager(Ptr<RescueArqManager> arqManager);
+        /**
+         * \param scheduler RescueQosScheduler associated with this MAC
+         */
+        void SetQosScheduler(Ptr<RescueQosScheduler> scheduler);
+        /**
+         * \return RescueQosScheduler associated with this MAC (0 - no QoS scheduling)
+         */
+        Ptr<RescueQosScheduler> GetQosScheduler(void) const;
         /**
          * Assign a fixed random variable stream number to the random variables
          * used by this model.  Return the number of streams (possibly zero) that
@@ -142,6 +157,14 @@ namespace ns3 {
          * \param length the length of queues used by this MAC
          */
         void SetQueueLimits(uint32_t length);
+        /**
+         * \param target the acceptable sojourn time of DATA frames in queues (0 - AQM disabled)
+         */
+        void SetAqmTarget(Time target);
+        /**
+         * \param interval the AQM interval of sojourn time observation
+         */
+        void SetAqmInterval(Time interval);
         /**
          * \param duration the Basic ACK Timeout duration
          */
@@ -211,6 +234,14 @@ namespace ns3 {
          */
         virtual void EnqueueRetry(Ptr<Packet> pkt, Mac48Address dest);
 
+        /**
+         * \param pkt the packet to send.
+         * \param phyHdr the header to send.
+         *
+         * Should be used to enqueue locally retransmitted relayed packets by ARQ manager
+         */
+        virtual void EnqueueRelay(Ptr<Packet> pkt, RescuePhyHeader phyHdr);
+
         //virtual void NotifyEnqueueRelay (Ptr<Packet> pkt, Mac48Address dest);
 
         virtual void NotifyEnqueuedPacket(Ptr<Packet> pkt, Mac48Address dest);
@@ -283,6 +314,19 @@ namespace ns3 {
         virtual void DoInitialize();
         virtual void DoDispose();
 
+        /**
+         * \return the stations heard recently with link quality above the neighbour threshold
+         */
+        std::vector<Mac48Address> GetNeighbours(void);
+        /**
+         * Checks if the next queued frame fits into the rest of TDMA time slot. If the guard interval
+         * is set, it replaces SIFS following the frame (the slot may be filled up to the guard).
+         *
+         * \param remaining the time left till the end of TDMA time slot
+         * \return true if the next frame can be transmitted in the current TDMA time slot
+         */
+        bool FitsInTdmaSlot(Time remaining);
+
         Callback <void, Ptr<Packet>, Mac48Address, Mac48Address> m_forwardUpCb; //!< The callback to invoke when a packet must be forwarded up the stack
 
         Ptr<RescuePhy> m_phy; //!< Pointer to RescuePhy (actually send/receives frames)
@@ -291,10 +335,14 @@ namespace ns3 {
         Ptr<RescueNetDevice> m_device; //!< Pointer to RescueNetDevice
         Ptr<RescueRemoteStationManager> m_remoteStationManager; //!< Pointer to RescueRemoteStationManager (rate control)
         Ptr<RescueArqManager> m_arqManager; //!< Pointer to RescueArqManager (rate control)
+        Ptr<RescueQosScheduler> m_qosScheduler; //!< Pointer to RescueQosScheduler (QoS scheduling)
         Ptr<UniformRandomVariable> m_random; //!< Provides uniform random variables.
 
         Mac48Address m_address; //!< Address of this MAC
         StationType m_type; //!< Type of this station
+        double m_neighbourSnrThreshold; //!< Minimal averaged SNR (dB) of a neighbour station
+        Time m_neighbourTimeout; //!< Time after which a silent station is no longer a neighbour
+        Time m_tdmaGuardInterval; //!< Guard time kept at the end of TDMA time slot (0 - SIFS is kept)
 
         // for trace and performance evaluation
         TracedCallback<uint32_t, uint32_t, Ptr<const Packet>, const RescueMacHeader &> m_traceEnqueue; //<! Trace Hookup for enqueue a DATA
@@ -66,39 +66,33 @@ namespace ns3 {
 
     uint32_t
     RescueMode::GetBandwidth(void) const {
-        struct RescueModeFactory::RescueModeItem *item = RescueModeFactory::GetFactory()->Get(m_uid);
-        return item->bandwidth;
+        return GetDescriptor().bandwidth;
     }
 
     uint64_t
     RescueMode::GetPhyRate(void) const {
-        struct RescueModeFactory::RescueModeItem *item = RescueModeFactory::GetFactory()->Get(m_uid);
-        return item->phyRate;
+        return GetDescriptor().phyRate;
     }
 
     uint64_t
     RescueMode::GetDataRate(void) const {
-        struct RescueModeFactory::RescueModeItem *item = RescueModeFactory::GetFactory()->Get(m_uid);
-        return item->dataRate;
+        return GetDescriptor().dataRate;
     }
 
     enum RescueCodeRate
     RescueMode::GetCodeRate(void) const {
-        struct RescueModeFactory::RescueModeItem *item = RescueModeFactory::GetFactory()->Get(m_uid);
-        return item->codingRate;
+        return GetDescriptor().codingRate;
     }
 
     uint8_t
     RescueMode::GetConstellationSize(void) const {
-        struct RescueModeFactory::RescueModeItem *item = RescueModeFactory::GetFactory()->Get(m_uid);
-        return item->constellationSize;
+        return GetDescriptor().constellationSize;
     }
 
     std::string
     RescueMode::GetUniqueName(void) const {
         // needed for ostream printing of the invalid mode
-        struct RescueModeFactory::RescueModeItem *item = RescueModeFactory::GetFactory()->Get(m_uid);
-        return item->uniqueUid;
+        return RescueModeFactory::GetFactory()->m_names[m_uid];
     }
 
     uint32_t
@@ -108,34 +102,12 @@ namespace ns3 {
 
     enum RescueModulationClass
     RescueMode::GetModulationClass() const {
-        struct RescueModeFactory::RescueModeItem *item = RescueModeFactory::GetFactory()->Get(m_uid);
-        return item->modClass;
+        return GetDescriptor().modClass;
     }
 
     double
     RescueMode::GetSpectralEfficiency(void) const {
-        struct RescueModeFactory::RescueModeItem *item = RescueModeFactory::GetFactory()->Get(m_uid);
-        switch (item->codingRate) {
-            case RESCUE_CODE_RATE_5_6:
-                return log2(item->constellationSize) * 5 / 6;
-                break;
-            case RESCUE_CODE_RATE_3_4:
-                return log2(item->constellationSize) * 3 / 4;
-                break;
-            case RESCUE_CODE_RATE_2_3:
-                return log2(item->constellationSize) * 2 / 3;
-                break;
-            case RESCUE_CODE_RATE_1_2:
-                return log2(item->constellationSize) * 1 / 2;
-                break;
-            case RESCUE_CODE_RATE_1_4:
-                return log2(item->constellationSize) * 1 / 4;
-                break;
-            case RESCUE_CODE_RATE_UNDEFINED:
-            default:
-                return 1;
-                break;
-        }
+        return GetDescriptor().spectralEfficiency;
     }
 
     RescueMode::RescueMode()
@@ -152,6 +124,10 @@ namespace ns3 {
 
     ATTRIBUTE_HELPER_CPP(RescueMode);
 
+    RescueModeDescriptor RescueModeFactory::m_descriptors[RescueModeFactory::MAX_MODES] = {
+        {0, 0, 0, RESCUE_MOD_CLASS_UNKNOWN, 0, RESCUE_CODE_RATE_UNDEFINED, 1}
+    };
+
     RescueModeFactory::RescueModeFactory() {
     }
 
@@ -164,8 +140,7 @@ namespace ns3 {
             uint8_t constellationSize) {
         RescueModeFactory *factory = GetFactory();
         uint32_t uid = factory->AllocateUid(uniqueName);
-        RescueModeItem *item = factory->Get(uid);
-        item->uniqueUid = uniqueName;
+        RescueModeDescriptor *item = &m_descriptors[uid];
         item->modClass = modClass;
         // The modulation class for this RescueMode must be valid.
         NS_ASSERT(modClass != RESCUE_MOD_CLASS_UNKNOWN);
@@ -178,37 +153,31 @@ namespace ns3 {
         switch (codingRate) {
             case RESCUE_CODE_RATE_5_6:
                 item->phyRate = dataRate * 6 / 5;
+                item->spectralEfficiency = log2(constellationSize) * 5 / 6;
                 break;
             case RESCUE_CODE_RATE_3_4:
                 item->phyRate = dataRate * 4 / 3;
+                item->spectralEfficiency = log2(constellationSize) * 3 / 4;
                 break;
             case RESCUE_CODE_RATE_2_3:
                 item->phyRate = dataRate * 3 / 2;
+                item->spectralEfficiency = log2(constellationSize) * 2 / 3;
                 break;
             case RESCUE_CODE_RATE_1_2:
                 item->phyRate = dataRate * 2 / 1;
+                item->spectralEfficiency = log2(constellationSize) * 1 / 2;
                 break;
             case RESCUE_CODE_RATE_1_4:
                 item->phyRate = dataRate * 4 / 1;
+                item->spectralEfficiency = log2(constellationSize) * 1 / 4;
                 break;
             case RESCUE_CODE_RATE_UNDEFINED:
             default:
                 item->phyRate = dataRate;
+                item->spectralEfficiency = 1;
                 break;
         }
 
-        // Check for compatibility between modulation class and coding
-        // rate. If modulation class is DSSS then coding rate must be
-        // undefined, and vice versa. I could have done this with an
-        // assertion, but it seems better to always give the error (i.e.,
-        // not only in non-optimised builds) and the cycles that extra test
-        // here costs are only suffered at simulation setup.
-        /*if ((codingRate == RESCUE_CODE_RATE_UNDEFINED) != (modClass == RESCUE_MOD_CLASS_DSSS))
-          {
-            NS_FATAL_ERROR ("Error in creation of RescueMode named " << uniqueName << std::endl
-                                                                     << "Code rate must be RESCUE_CODE_RATE_UNDEFINED iff Modulation Class is RESCUE_MOD_CLASS_DSSS");
-          }*/
-
         item->constellationSize = constellationSize;
 
         return RescueMode(uid);
@@ -216,13 +185,9 @@ namespace ns3 {
 
     RescueMode
     RescueModeFactory::Search(std::string name) {
-        RescueModeItemList::const_iterator i;
-        uint32_t j = 0;
-        for (i = m_itemList.begin(); i != m_itemList.end(); i++) {
-            if (i->uniqueUid == name) {
-                return RescueMode(j);
-            }
-            j++;
+        std::map<std::string, uint32_t>::const_iterator it = m_uids.find(name);
+        if (it != m_uids.end()) {
+            return RescueMode(it->second);
         }
 
         // If we get here then a matching RescueMode was not found above. This
@@ -230,8 +195,8 @@ namespace ns3 {
         // list of RescueModes that are supported.
         NS_LOG_UNCOND("Could not find match for RescueMode named \""
                 << name << "\". Valid options are:");
-        for (i = m_itemList.begin(); i != m_itemList.end(); i++) {
-            NS_LOG_UNCOND("  " << i->uniqueUid);
+        for (std::vector<std::string>::const_iterator i = m_names.begin(); i != m_names.end(); i++) {
+            NS_LOG_UNCOND("  " << *i);
         }
         // Empty fatal error to die. We've already unconditionally logged
         // the helpful information.
@@ -247,39 +212,26 @@ namespace ns3 {
 
     uint32_t
     RescueModeFactory::AllocateUid(std::string uniqueUid) {
-        uint32_t j = 0;
-        for (RescueModeItemList::const_iterator i = m_itemList.begin();
-                i != m_itemList.end(); i++) {
-            if (i->uniqueUid == uniqueUid) {
-                return j;
-            }
-            j++;
+        std::map<std::string, uint32_t>::const_iterator it = m_uids.find(uniqueUid);
+        if (it != m_uids.end()) {
+            return it->second;
+        }
+        uint32_t uid = m_names.size();
+        if (uid >= MAX_MODES) {
+            NS_FATAL_ERROR("Too many RescueModes, cannot create " << uniqueUid);
         }
-        uint32_t uid = m_itemList.size();
-        m_itemList.push_back(RescueModeItem());
+        m_names.push_back(uniqueUid);
+        m_uids[uniqueUid] = uid;
         return uid;
     }
 
-    struct RescueModeFactory::RescueModeItem *
-    RescueModeFactory::Get(uint32_t uid) {
-        NS_ASSERT(uid < m_itemList.size());
-        return &m_itemList[uid];
-    }
-
     RescueModeFactory *
     RescueModeFactory::GetFactory(void) {
         static bool isFirstTime = true;
         static RescueModeFactory factory;
         if (isFirstTime) {
-            uint32_t uid = factory.AllocateUid("Invalid-RescueMode");
-            RescueModeItem *item = factory.Get(uid);
-            item->uniqueUid = "Invalid-RescueMode";
-            item->bandwidth = 0;
-            item->dataRate = 0;
-            item->phyRate = 0;
-            item->modClass = RESCUE_MOD_CLASS_UNKNOWN;
-            item->constellationSize = 0;
-            item->codingRate = RESCUE_CODE_RATE_UNDEFINED;
+            //the invalid mode has statically initialized descriptor
+            factory.AllocateUid("Invalid-RescueMode");
             isFirstTime = false;
         }
         return &factory;
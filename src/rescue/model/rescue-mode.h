@@ -25,6 +25,7 @@
 #include <stdint.h>
 #include <string>
 #include <vector>
+#include <map>
 #include <ostream>
 #include "ns3/attribute-helper.h"
 
@@ -64,6 +65,23 @@ namespace ns3 {
 
     };
 
+    /**
+     * \brief characteristics of a single transmission mode
+     * \ingroup rescue
+     *
+     * Plain data kept in a static array indexed by RescueMode uid (derived values
+     * are computed once, when the mode is created).
+     */
+    struct RescueModeDescriptor {
+        uint32_t bandwidth; //!< Bandwidth (Hz)
+        uint32_t dataRate; //!< Data bit rate (bit/s)
+        uint32_t phyRate; //!< PHY bit rate (bit/s)
+        enum RescueModulationClass modClass; //!< Modulation class
+        uint8_t constellationSize; //!< Size of modulation constellation
+        enum RescueCodeRate codingRate; //!< Code rate
+        double spectralEfficiency; //!< Information bits per complex symbol
+    };
+
     /**
      * \brief represent a single transmission mode
      * \ingroup rescue
@@ -119,6 +137,10 @@ namespace ns3 {
          * (calculated as code rate * log2 (constellation size) )
          */
         double GetSpectralEfficiency() const;
+        /**
+         * \returns all characteristics of this transmission mode
+         */
+        const RescueModeDescriptor & GetDescriptor(void) const;
 
         /**
          * Create an invalid RescueMode. Calling any method on the
@@ -220,19 +242,8 @@ namespace ns3 {
         static RescueModeFactory* GetFactory();
         RescueModeFactory();
 
-        /**
-         * This is the data associated to a unique RescueMode.
-         * The integer stored in a RescueMode is in fact an index
-         * in an array of RescueModeItem objects.
-         */
-        struct RescueModeItem {
-            std::string uniqueUid;
-            uint32_t bandwidth;
-            uint32_t dataRate;
-            uint32_t phyRate;
-            enum RescueModulationClass modClass;
-            uint8_t constellationSize;
-            enum RescueCodeRate codingRate;
+        enum {
+            MAX_MODES = 64 //!< Maximal number of RescueModes (including the invalid one)
         };
 
         /**
@@ -243,27 +254,27 @@ namespace ns3 {
          */
         RescueMode Search(std::string name);
         /**
-         * Allocate a RescueModeItem from a given uniqueUid.
+         * Allocate a uid for a given uniqueUid (or return the uid already allocated for it).
          *
          * \param uniqueUid
          * \return uid
          */
         uint32_t AllocateUid(std::string uniqueUid);
-        /**
-         * Return a RescueModeItem at the given uid index.
-         *
-         * \param uid
-         * \return RescueModeItem at the given uid
-         */
-        RescueModeItem* Get(uint32_t uid);
 
         /**
-         * typedef for a vector of RescueModeItem.
+         * The integer stored in a RescueMode is in fact an index in this array
+         * (statically initialized, the entry 0 is the invalid mode)
          */
-        typedef std::vector<struct RescueModeItem> RescueModeItemList;
-        RescueModeItemList m_itemList;
+        static RescueModeDescriptor m_descriptors[MAX_MODES];
+        std::vector<std::string> m_names; //!< Unique names of RescueModes (indexed by uid)
+        std::map<std::string, uint32_t> m_uids; //!< Uids of RescueModes indexed by unique name
     };
 
+    inline const RescueModeDescriptor &
+    RescueMode::GetDescriptor(void) const {
+        return RescueModeFactory::m_descriptors[m_uid];
+    }
+
 } // namespace ns3
 
 #endif /* RESCUE_MODE_H */
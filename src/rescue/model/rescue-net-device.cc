@@ -35,6 +35,7 @@
 #include "rescue-channel.h"
 #include "rescue-remote-station-manager.h"
 #include "rescue-arq-manager.h"
+#include "rescue-qos-scheduler.h"
 
 
 NS_LOG_COMPONENT_DEFINE("RescueNetDevice");
@@ -79,6 +80,10 @@ namespace ns3 {
             m_arqManager->Dispose();
             m_arqManager = 0;
         }
+        if (m_qosScheduler) {
+            m_qosScheduler->Dispose();
+            m_qosScheduler = 0;
+        }
     }
 
     void
@@ -127,6 +132,11 @@ namespace ns3 {
                 MakePointerAccessor(&RescueNetDevice::SetArqManager,
                 &RescueNetDevice::GetArqManager),
                 MakePointerChecker<RescueArqManager> ())
+                .AddAttribute("QosScheduler", "The QoS scheduler attached to this device (none - no QoS scheduling).",
+                PointerValue(),
+                MakePointerAccessor(&RescueNetDevice::SetQosScheduler,
+                &RescueNetDevice::GetQosScheduler),
+                MakePointerChecker<RescueQosScheduler> ())
                 .AddTraceSource("Rx", "Received payload from the MAC layer.",
                 MakeTraceSourceAccessor(&RescueNetDevice::m_rxLogger))
                 .AddTraceSource("Tx", "Send payload to the MAC layer.",
@@ -168,6 +178,10 @@ namespace ns3 {
                 m_arqManager->SetupMac(m_mac);
                 NS_LOG_DEBUG("HI-MAC conected to Arq Manager");
             }
+            if (m_qosScheduler != 0) {
+                m_mac->SetQosScheduler(m_qosScheduler);
+                NS_LOG_DEBUG("HI-MAC conected to QoS Scheduler");
+            }
             m_mac->SetForwardUpCb(MakeCallback(&RescueNetDevice::ForwardUp, this));
         }
     }
@@ -238,6 +252,18 @@ namespace ns3 {
         }
     }
 
+    void
+    RescueNetDevice::SetQosScheduler(Ptr<RescueQosScheduler> scheduler) {
+        if (scheduler != 0) {
+            m_qosScheduler = scheduler;
+            NS_LOG_DEBUG("Set QOS SCHEDULER");
+            if (m_mac != 0) {
+                m_mac->SetQosScheduler(m_qosScheduler);
+                NS_LOG_DEBUG("HI-MAC conected to QoS Scheduler");
+            }
+        }
+    }
+
     void
     RescueNetDevice::SetIfIndex(uint32_t index) {
         m_ifIndex = index;
@@ -300,6 +326,11 @@ namespace ns3 {
         return m_arqManager;
     }
 
+    Ptr<RescueQosScheduler>
+    RescueNetDevice::GetQosScheduler(void) const {
+        return m_qosScheduler;
+    }
+
     Address
     RescueNetDevice::GetAddress() const {
         return m_mac->GetAddress();
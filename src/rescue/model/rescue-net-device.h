@@ -31,6 +31,7 @@ namespace ns3 {
 
     class RescueRemoteStationManager;
     class RescueArqManager;
+    class RescueQosScheduler;
     class RescueChannel;
     class RescuePhy;
     class RescueMac;
@@ -85,6 +86,10 @@ namespace ns3 {
          * \param arqManager the ARQ manager to use.
          */
         void SetArqManager(Ptr<RescueArqManager> arqManager);
+        /**
+         * \param scheduler the QoS scheduler to use.
+         */
+        void SetQosScheduler(Ptr<RescueQosScheduler> scheduler);
 
         /**
          * \return pointer to used HI-MAC
@@ -102,6 +107,10 @@ namespace ns3 {
          * \returns the ARQ manager we are currently using.
          */
         Ptr<RescueArqManager> GetArqManager(void) const;
+        /**
+         * \returns the QoS scheduler we are currently using (0 - no QoS scheduling).
+         */
+        Ptr<RescueQosScheduler> GetQosScheduler(void) const;
 
 
         // Purely virtual functions from base class
@@ -151,6 +160,7 @@ namespace ns3 {
         Ptr<RescuePhy> m_phy; //!< Pointer to RescuePhy
         Ptr<RescueRemoteStationManager> m_stationManager; //!< Pointer to RescueRemoteStationManager (rate control)
         Ptr<RescueArqManager> m_arqManager; //!< Pointer to RescueArqManager (advanced ARQ control)
+        Ptr<RescueQosScheduler> m_qosScheduler; //!< Pointer to RescueQosScheduler (QoS scheduling)
 
         uint32_t m_ifIndex;
         uint16_t m_mtu;
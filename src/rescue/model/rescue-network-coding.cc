@@ -0,0 +1,277 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 AGH Univeristy of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+#include "ns3/log.h"
+#include "ns3/assert.h"
+
+#include "rescue-network-coding.h"
+
+#include <algorithm>
+#include <iterator>
+#include <cstring>
+
+NS_LOG_COMPONENT_DEFINE("RescueNetworkCoding");
+
+namespace ns3 {
+
+    NS_OBJECT_ENSURE_REGISTERED(RescueCodedHeader);
+
+    RescueCodedHeader::RescueCodedHeader()
+    : m_base(0),
+    m_mask(0) {
+    }
+
+    RescueCodedHeader::RescueCodedHeader(uint16_t base, uint32_t mask)
+    : m_base(base),
+    m_mask(mask) {
+    }
+
+    RescueCodedHeader::~RescueCodedHeader() {
+    }
+
+    TypeId
+    RescueCodedHeader::GetTypeId(void) {
+        static TypeId tid = TypeId("ns3::RescueCodedHeader")
+                .SetParent<Header> ()
+                .AddConstructor<RescueCodedHeader> ()
+                ;
+        return tid;
+    }
+
+    TypeId
+    RescueCodedHeader::GetInstanceTypeId(void) const {
+        return GetTypeId();
+    }
+
+    void
+    RescueCodedHeader::SetBase(uint16_t base) {
+        m_base = base;
+    }
+
+    void
+    RescueCodedHeader::SetMask(uint32_t mask) {
+        m_mask = mask;
+    }
+
+    uint16_t
+    RescueCodedHeader::GetBase(void) const {
+        return m_base;
+    }
+
+    uint32_t
+    RescueCodedHeader::GetMask(void) const {
+        return m_mask;
+    }
+
+    uint32_t
+    RescueCodedHeader::GetSerializedSize(void) const {
+        return sizeof (m_base) + sizeof (m_mask);
+    }
+
+    void
+    RescueCodedHeader::Serialize(Buffer::Iterator i) const {
+        i.WriteU16(m_base);
+        i.WriteU32(m_mask);
+    }
+
+    uint32_t
+    RescueCodedHeader::Deserialize(Buffer::Iterator start) {
+        Buffer::Iterator i = start;
+        m_base = i.ReadU16();
+        m_mask = i.ReadU32();
+        return i.GetDistanceFrom(start);
+    }
+
+    void
+    RescueCodedHeader::Print(std::ostream &os) const {
+        os << "base=" << m_base << " mask=0x" << std::hex << m_mask << std::dec;
+    }
+
+
+
+    // ------------------------ Coding kernels -----------------------------
+
+    RescueNetworkCoding::Block
+    RescueNetworkCoding::ToBlock(Ptr<const Packet> pkt) {
+        uint32_t size = pkt->GetSize();
+        NS_ASSERT(size <= 0xffff);
+        std::vector<uint8_t> bytes(2 + size);
+        bytes[0] = (size >> 8) & 0xff;
+        bytes[1] = size & 0xff;
+        if (size > 0)
+            pkt->CopyData(&bytes[2], size);
+
+        Block block((bytes.size() + sizeof (uint64_t) - 1) / sizeof (uint64_t), 0);
+        std::memcpy(&block[0], &bytes[0], bytes.size());
+        return block;
+    }
+
+    Ptr<Packet>
+    RescueNetworkCoding::FromBlock(const Block &block) {
+        if (block.empty())
+            return 0;
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *> (&block[0]);
+        uint32_t size = (bytes[0] << 8) | bytes[1];
+        if (2 + size > block.size() * sizeof (uint64_t)) {
+            NS_LOG_DEBUG("malformed block, length: " << size << ", words: " << block.size());
+            return 0;
+        }
+        return Create<Packet> (bytes + 2, size);
+    }
+
+    Ptr<Packet>
+    RescueNetworkCoding::ToCodedPayload(const Block &block) {
+        if (block.empty())
+            return Create<Packet> (0);
+        return Create<Packet> (reinterpret_cast<const uint8_t *> (&block[0]), block.size() * sizeof (uint64_t));
+    }
+
+    RescueNetworkCoding::Block
+    RescueNetworkCoding::FromCodedPayload(Ptr<const Packet> pkt) {
+        Block block(pkt->GetSize() / sizeof (uint64_t), 0);
+        if (!block.empty())
+            pkt->CopyData(reinterpret_cast<uint8_t *> (&block[0]), block.size() * sizeof (uint64_t));
+        return block;
+    }
+
+    void
+    RescueNetworkCoding::XorBlock(Block &dst, const Block &src) {
+        if (src.empty())
+            return;
+        if (dst.size() < src.size())
+            dst.resize(src.size(), 0);
+        //plain word loop - vectorized by the compiler
+        uint64_t *d = &dst[0];
+        const uint64_t *s = &src[0];
+        for (uint32_t i = 0, n = src.size(); i < n; i++)
+            d[i] ^= s[i];
+    }
+
+
+
+    // ------------------------ Decoder -----------------------------
+
+    void
+    RescueCodedDecoder::AddCoded(const std::vector<uint16_t> &seqs, const RescueNetworkCoding::Block &block, DecodedList &decoded) {
+        std::list<Row> pending(1);
+        pending.front().seqs = seqs;
+        std::sort(pending.front().seqs.begin(), pending.front().seqs.end());
+        pending.front().block = block;
+        Insert(pending, decoded);
+        NS_LOG_DEBUG("coded frame of " << seqs.size() << " unknown frames, rank: " << m_rows.size() << ", decoded: " << decoded.size());
+    }
+
+    void
+    RescueCodedDecoder::AddReceived(uint16_t seq, const RescueNetworkCoding::Block &block, DecodedList &decoded) {
+        Row known;
+        known.seqs.push_back(seq);
+        known.block = block;
+
+        //rows combining received frame are reduced and inserted again (the pivot may change)
+        std::list<Row> pending;
+        for (std::list<Row>::iterator it = m_rows.begin(); it != m_rows.end();) {
+            if (Contains(*it, seq)) {
+                Combine(*it, known);
+                pending.push_back(*it);
+                it = m_rows.erase(it);
+            } else
+                it++;
+        }
+        if (!pending.empty())
+            Insert(pending, decoded);
+    }
+
+    uint32_t
+    RescueCodedDecoder::GetRank(void) const {
+        return m_rows.size();
+    }
+
+    void
+    RescueCodedDecoder::Clear(void) {
+        m_rows.clear();
+    }
+
+    void
+    RescueCodedDecoder::Combine(Row &row, const Row &other) {
+        std::vector<uint16_t> seqs;
+        std::set_symmetric_difference(row.seqs.begin(), row.seqs.end(),
+                other.seqs.begin(), other.seqs.end(),
+                std::back_inserter(seqs));
+        row.seqs.swap(seqs);
+        RescueNetworkCoding::XorBlock(row.block, other.block);
+    }
+
+    bool
+    RescueCodedDecoder::Contains(const Row &row, uint16_t seq) {
+        return std::binary_search(row.seqs.begin(), row.seqs.end(), seq);
+    }
+
+    void
+    RescueCodedDecoder::Insert(std::list<Row> &pending, DecodedList &decoded) {
+        while (!pending.empty()) {
+            Row row = pending.front();
+            pending.pop_front();
+
+            //forward elimination - pivots of stored rows appear only in their own rows
+            for (std::list<Row>::iterator it = m_rows.begin(); it != m_rows.end(); it++)
+                if (Contains(row, it->seqs.front()))
+                    Combine(row, *it);
+
+            if (row.seqs.empty()) {
+                NS_LOG_DEBUG("non-innovative combination");
+                continue;
+            }
+
+            if (row.seqs.size() == 1) {
+                //decoded - eliminate the frame from other rows
+                decoded.push_back(std::make_pair(row.seqs.front(), row.block));
+                for (std::list<Row>::iterator it = m_rows.begin(); it != m_rows.end();) {
+                    if (Contains(*it, row.seqs.front())) {
+                        Combine(*it, row);
+                        if (it->seqs.size() == 1) {
+                            pending.push_back(*it);
+                            it = m_rows.erase(it);
+                            continue;
+                        }
+                    }
+                    it++;
+                }
+                continue;
+            }
+
+            //back substitution - keep the new pivot only in the new row
+            for (std::list<Row>::iterator it = m_rows.begin(); it != m_rows.end();) {
+                if (Contains(*it, row.seqs.front())) {
+                    Combine(*it, row);
+                    if (it->seqs.size() == 1) {
+                        pending.push_back(*it);
+                        it = m_rows.erase(it);
+                        continue;
+                    }
+                }
+                it++;
+            }
+            m_rows.push_back(row);
+        }
+
+        while (m_rows.size() > MAX_CODED_ROWS)
+            m_rows.pop_front();
+    }
+
+} // namespace ns3
@@ -0,0 +1,191 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 AGH Univeristy of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+#ifndef RESCUE_NETWORK_CODING_H
+#define RESCUE_NETWORK_CODING_H
+
+#include "ns3/header.h"
+#include "ns3/packet.h"
+
+#include <stdint.h>
+#include <vector>
+#include <list>
+
+/* the largest span of sequence numbers combined in a single coded frame (width of the coding vector) */
+#define MAX_CODED_SPAN 32
+/* the maximal number of not yet decoded combinations kept per source */
+#define MAX_CODED_ROWS 64
+
+namespace ns3 {
+
+    /**
+     * \ingroup rescue
+     *
+     * Header of network-coded DATA frame (placed after RescueMacHeader with Coded bit set).
+     * The coding vector is a bitmap of frames combined (XORed) in the payload,
+     * bit i corresponds to the frame with sequence number base + i.
+     */
+    class RescueCodedHeader : public Header {
+    public:
+        RescueCodedHeader();
+        RescueCodedHeader(uint16_t base, uint32_t mask);
+        virtual ~RescueCodedHeader();
+
+        static TypeId GetTypeId(void);
+
+        /**
+         * \param base the sequence number of the first frame covered by the coding vector
+         */
+        void SetBase(uint16_t base);
+        /**
+         * \param mask the coding vector
+         */
+        void SetMask(uint32_t mask);
+        /**
+         * \return the sequence number of the first frame covered by the coding vector
+         */
+        uint16_t GetBase(void) const;
+        /**
+         * \return the coding vector
+         */
+        uint32_t GetMask(void) const;
+
+        // Inherrited methods
+        virtual uint32_t GetSerializedSize(void) const;
+        virtual void Serialize(Buffer::Iterator start) const;
+        virtual uint32_t Deserialize(Buffer::Iterator start);
+        virtual void Print(std::ostream &os) const;
+        virtual TypeId GetInstanceTypeId(void) const;
+
+    private:
+        uint16_t m_base; //!< Sequence number of the first frame covered by the coding vector
+        uint32_t m_mask; //!< Coding vector
+    };
+
+    /**
+     * \ingroup rescue
+     *
+     * Coding kernels of network-coded retransmissions (random linear coding over GF(2)).
+     * Frame payloads are kept as blocks of 64-bit words: the 16-bit payload length
+     * followed by the payload, zero-padded to the word boundary. Coding the length
+     * together with the payload allows frames of different sizes to be combined.
+     */
+    class RescueNetworkCoding {
+    public:
+        typedef std::vector<uint64_t> Block;
+
+        /**
+         * \param pkt the payload of DATA frame (without MAC header and trailer)
+         * \return the coding block of this payload
+         */
+        static Block ToBlock(Ptr<const Packet> pkt);
+        /**
+         * \param block the decoded coding block
+         * \return the payload of DATA frame (0 if the block is malformed)
+         */
+        static Ptr<Packet> FromBlock(const Block &block);
+
+        /**
+         * \param block the coded block
+         * \return the payload of coded frame (raw block)
+         */
+        static Ptr<Packet> ToCodedPayload(const Block &block);
+        /**
+         * \param pkt the payload of coded frame (after RescueCodedHeader)
+         * \return the coded block
+         */
+        static Block FromCodedPayload(Ptr<const Packet> pkt);
+
+        /**
+         * XORs the source block into the destination block, word by word
+         * (the destination is extended if shorter than the source)
+         *
+         * \param dst the destination block
+         * \param src the source block
+         */
+        static void XorBlock(Block &dst, const Block &src);
+    };
+
+    /**
+     * \ingroup rescue
+     *
+     * Per-source decoder of network-coded frames. Combinations which cannot be decoded
+     * yet are kept in reduced row echelon form (each pivot appears in its row only),
+     * so the rank grows with every innovative combination and a frame is decoded
+     * as soon as its row is reduced to a single unknown.
+     */
+    class RescueCodedDecoder {
+    public:
+        typedef std::list<std::pair<uint16_t, RescueNetworkCoding::Block> > DecodedList;
+
+        /**
+         * \param seqs the sequence numbers of frames combined in the block (not received yet)
+         * \param block the coded block (already reduced by the received frames)
+         * \param decoded the list to which decoded frames are appended
+         */
+        void AddCoded(const std::vector<uint16_t> &seqs, const RescueNetworkCoding::Block &block, DecodedList &decoded);
+        /**
+         * Eliminates the received frame from stored combinations
+         *
+         * \param seq the sequence number of received frame
+         * \param block the coding block of received frame
+         * \param decoded the list to which decoded frames are appended
+         */
+        void AddReceived(uint16_t seq, const RescueNetworkCoding::Block &block, DecodedList &decoded);
+        /**
+         * \return the number of stored (linearly independent) combinations
+         */
+        uint32_t GetRank(void) const;
+        /**
+         * Removes all stored combinations
+         */
+        void Clear(void);
+
+    private:
+
+        struct Row {
+            std::vector<uint16_t> seqs; //!< Sorted sequence numbers of unknown frames, the first one is the pivot
+            RescueNetworkCoding::Block block; //!< Combination of payloads
+        };
+
+        /**
+         * \param row the row to reduce
+         * \param other the row added (XORed) to the reduced row
+         */
+        static void Combine(Row &row, const Row &other);
+        /**
+         * \param row the row
+         * \param seq the sequence number
+         * \return true if the row combines given frame
+         */
+        static bool Contains(const Row &row, uint16_t seq);
+        /**
+         * Reduces and stores given rows, collecting decoded frames
+         *
+         * \param pending the rows to insert
+         * \param decoded the list to which decoded frames are appended
+         */
+        void Insert(std::list<Row> &pending, DecodedList &decoded);
+
+        std::list<Row> m_rows; //!< Stored combinations (reduced row echelon form)
+    };
+
+} // namespace ns3
+
+#endif /* RESCUE_NETWORK_CODING_H */
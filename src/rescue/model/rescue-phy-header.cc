@@ -23,14 +23,35 @@
 #include "ns3/address-utils.h"
 #include "rescue-phy-header.h"
 #include "ns3/log.h"
+#include "ns3/assert.h"
+
+#include <algorithm>
 
 NS_LOG_COMPONENT_DEFINE("RescuePhyHeader");
 
 namespace ns3 {
 
+    static uint32_t
+    CountOnes(uint32_t x) {
+        x = x - ((x >> 1) & 0x55555555);
+        x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+        return (((x + (x >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24;
+    }
+
+    static uint32_t
+    CountTrailingZeros(uint32_t x) {
+        //x must be non-zero
+        static const uint8_t debruijn[32] = {
+            0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8,
+            31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
+        };
+        return debruijn[((x & -x) * 0x077CB531u) >> 27];
+    }
+
     NS_OBJECT_ENSURE_REGISTERED(RescuePhyHeader);
 
     RescuePhyHeader::RescuePhyHeader() {
+        Init();
     }
 
     RescuePhyHeader::RescuePhyHeader(uint8_t type)
@@ -38,6 +59,7 @@ namespace ns3 {
     m_type(type),
     m_srcAddr(Mac48Address("00:00:00:00:00:00")),
     m_dstAddr(Mac48Address("00:00:00:00:00:00")) {
+        Init();
     }
 
     RescuePhyHeader::RescuePhyHeader(const Mac48Address srcAddr, const Mac48Address dstAddr, uint8_t type)
@@ -45,6 +67,7 @@ namespace ns3 {
     m_type(type),
     m_srcAddr(srcAddr),
     m_dstAddr(dstAddr) {
+        Init();
     }
 
     RescuePhyHeader::RescuePhyHeader(const Mac48Address srcAddr, const Mac48Address senderAddr, const Mac48Address dstAddr, uint8_t type)
@@ -53,6 +76,7 @@ namespace ns3 {
     m_srcAddr(srcAddr),
     m_senderAddr(senderAddr),
     m_dstAddr(dstAddr) {
+        Init();
     }
 
     RescuePhyHeader::RescuePhyHeader(const Mac48Address srcAddr, const Mac48Address senderAddr, const Mac48Address dstAddr,
@@ -64,6 +88,7 @@ namespace ns3 {
     m_dstAddr(dstAddr),
     m_sequence(seq),
     m_interleaver(il) {
+        Init();
     }
 
     RescuePhyHeader::RescuePhyHeader(const Mac48Address srcAddr, const Mac48Address senderAddr, const Mac48Address dstAddr,
@@ -77,6 +102,7 @@ namespace ns3 {
     m_sequence(seq),
     m_mbf(mbf),
     m_interleaver(il) {
+        Init();
     }
 
     RescuePhyHeader::RescuePhyHeader(const Mac48Address srcAddr, const Mac48Address senderAddr, const Mac48Address dstAddr,
@@ -91,6 +117,7 @@ namespace ns3 {
     m_sequence(seq),
     m_mbf(mbf),
     m_interleaver(il) {
+        Init();
     }
 
     RescuePhyHeader::RescuePhyHeader(const Mac48Address srcAddr,
@@ -102,6 +129,7 @@ namespace ns3 {
     m_beaconInterval(beaconInterval),
     m_cfpPeriod(cfpPeriod),
     m_tdmaTimeSlot(tdmaTimeSlot) {
+        Init();
     }
 
     RescuePhyHeader::RescuePhyHeader(const Mac48Address srcAddr, const Mac48Address dstAddr,
@@ -115,6 +143,14 @@ namespace ns3 {
     m_sequence(seq),
     m_mbf(mbf),
     m_interleaver(il) {
+        Init();
+    }
+
+    void
+    RescuePhyHeader::Init(void) {
+        SetBlockAckSize(DEFAULT_BLOCK_ACK_SIZE);
+        m_neighboursReport = 0;
+        m_reservationsReport = 0;
     }
 
     TypeId
@@ -237,6 +273,8 @@ namespace ns3 {
     void
     RescuePhyHeader::SetSchedulesListSize(uint8_t schedListSize) {
         m_schedListSize = schedListSize;
+        m_scheduleFlags = 0;
+        m_schedulesList.resize(schedListSize == SCHEDULES_LIST_COMPRESSED ? 0 : schedListSize);
     }
 
 
@@ -264,7 +302,7 @@ namespace ns3 {
                 m_NACKedFrames = (ctrl >> 10) & 0x1f;
                 break;
             case RESCUE_PHY_PKT_TYPE_PART_ACK:
-                //currently not suported
+                m_nACK = (ctrl >> 3) & 0x01;
                 break;
             case RESCUE_PHY_PKT_TYPE_B:
                 m_dataRate = (ctrl >> 3) & 0x03;
@@ -280,6 +318,8 @@ namespace ns3 {
                 m_useContinousAck = (ctrl >> 10) & 0x01;
                 m_qos = (ctrl >> 11) & 0x01;
                 m_nextDataRate = (ctrl >> 12) & 0x03;
+                m_neighboursReport = (ctrl >> 14) & 0x01;
+                m_reservationsReport = (ctrl >> 15) & 0x01;
                 break;
         }
     }
@@ -300,17 +340,26 @@ namespace ns3 {
     }
 
     void
-    RescuePhyHeader::SetBlockAckFlagFor(bool received, uint8_t frameNumber) {
+    RescuePhyHeader::SetBlockAckFlagFor(bool received, uint16_t frameNumber) {
+        NS_ASSERT(frameNumber < m_blockAckSize);
         if (received)
-            m_blockAck[frameNumber] = 1;
+            m_blockAck[frameNumber >> 5] |= (1u << (frameNumber & 31));
         else
-            m_blockAck[frameNumber] = 0;
+            m_blockAck[frameNumber >> 5] &= ~(1u << (frameNumber & 31));
     }
 
     void
     RescuePhyHeader::SetBlockAck(uint16_t blockAck) {
-        for (int i = 0; i < 16; i++)
-            m_blockAck[i] = (blockAck >> i) & 0x01;
+        SetBlockAckSize(16);
+        m_blockAck[0] = blockAck;
+    }
+
+    void
+    RescuePhyHeader::SetBlockAckSize(uint16_t size) {
+        size = std::min<uint16_t> (std::max<uint16_t> (size, 8), MAX_BLOCK_ACK_SIZE);
+        m_blockAckSize = (size + 7) & ~7;
+        for (int i = 0; i < BLOCK_ACK_WORDS; i++)
+            m_blockAck[i] = 0;
     }
 
     void
@@ -333,6 +382,11 @@ namespace ns3 {
         m_senderAddr = addr;
     }
 
+    void
+    RescuePhyHeader::SetTransmitter(Mac48Address addr) {
+        m_transmitterAddr = addr;
+    }
+
     void
     RescuePhyHeader::SetDestination(Mac48Address addr) {
         m_dstAddr = addr;
@@ -370,7 +424,88 @@ namespace ns3 {
 
     void
     RescuePhyHeader::SetScheduleEntry(uint8_t number, Mac48Address scheduleEntry) {
-        m_schedulesList [number] = scheduleEntry;
+        NS_ASSERT(number < m_schedulesList.size());
+        m_schedulesList[number].address = scheduleEntry;
+        m_schedulesList[number].slot = number;
+    }
+
+    void
+    RescuePhyHeader::SetScheduleEntry(uint8_t number, Mac48Address scheduleEntry, uint8_t slot) {
+        NS_ASSERT(number < m_schedulesList.size());
+        m_schedulesList[number].address = scheduleEntry;
+        m_schedulesList[number].slot = slot;
+        if (slot != number)
+            m_scheduleFlags |= SCHEDULE_FLAG_SLOTS;
+    }
+
+    void
+    RescuePhyHeader::SetNeighboursListSize(uint8_t size) {
+        NS_ASSERT(size <= MAX_NEIGHBOURS_LIST_SIZE);
+        m_neighboursReport = 1;
+        m_neighboursList.resize(size);
+    }
+
+    void
+    RescuePhyHeader::SetReservationsListSize(uint8_t size) {
+        NS_ASSERT(size <= MAX_RESERVATIONS_LIST_SIZE);
+        m_reservationsReport = 1;
+        m_reservations.resize(size);
+    }
+
+    void
+    RescuePhyHeader::SetReservationEntry(uint8_t number, Mac48Address destination, uint16_t duration, uint8_t frames) {
+        NS_ASSERT(number < MAX_RESERVATIONS_LIST_SIZE);
+        if (number >= m_reservations.size())
+            m_reservations.resize(number + 1);
+        m_reservations[number].destination = destination;
+        m_reservations[number].duration = duration;
+        m_reservations[number].frames = frames;
+    }
+
+    void
+    RescuePhyHeader::SetCompressedSchedule(uint8_t sequence, uint8_t keptRuns, bool withStart) {
+        m_schedListSize = SCHEDULES_LIST_COMPRESSED;
+        m_scheduleSequence = sequence;
+        m_keptRuns = keptRuns;
+        m_scheduleFlags = withStart ? SCHEDULE_FLAG_RUNS_START : 0;
+        m_schedulesList.clear();
+    }
+
+    void
+    RescuePhyHeader::SetStationIdsListSize(uint8_t size) {
+        NS_ASSERT(size <= MAX_STATION_IDS_LIST_SIZE);
+        m_stationIds.resize(size);
+    }
+
+    void
+    RescuePhyHeader::SetStationIdEntry(uint8_t number, uint8_t id, Mac48Address address) {
+        NS_ASSERT(number < MAX_STATION_IDS_LIST_SIZE);
+        if (number >= m_stationIds.size())
+            m_stationIds.resize(number + 1);
+        m_stationIds[number].id = id;
+        m_stationIds[number].address = address;
+    }
+
+    void
+    RescuePhyHeader::SetScheduleRunsListSize(uint8_t size) {
+        NS_ASSERT(size <= MAX_SCHEDULE_RUNS);
+        m_scheduleRuns.resize(size);
+    }
+
+    void
+    RescuePhyHeader::SetScheduleRun(uint8_t number, RescueScheduleRun run) {
+        NS_ASSERT(number < MAX_SCHEDULE_RUNS);
+        if (number >= m_scheduleRuns.size())
+            m_scheduleRuns.resize(number + 1);
+        m_scheduleRuns[number] = run;
+    }
+
+    void
+    RescuePhyHeader::SetNeighbourEntry(uint8_t number, Mac48Address neighbour) {
+        NS_ASSERT(number < MAX_NEIGHBOURS_LIST_SIZE);
+        if (number >= m_neighboursList.size())
+            m_neighboursList.resize(number + 1);
+        m_neighboursList[number] = neighbour;
     }
 
     void
@@ -504,7 +639,7 @@ namespace ns3 {
                 val |= (m_NACKedFrames << 10) & (0x1f << 10);
                 break;
             case RESCUE_PHY_PKT_TYPE_PART_ACK:
-                //currently not supported
+                val |= (m_nACK << 3) & (0x01 << 3);
                 break;
             case RESCUE_PHY_PKT_TYPE_B:
                 val |= (m_dataRate << 3) & (0x03 << 3);
@@ -520,6 +655,8 @@ namespace ns3 {
                 val |= (m_useContinousAck << 10) & (0x01 << 10);
                 val |= (m_qos << 11) & (0x01 << 11);
                 val |= (m_nextDataRate << 12) & (0x03 << 12);
+                val |= (m_neighboursReport << 14) & (0x01 << 14);
+                val |= (m_reservationsReport << 15) & (0x01 << 15);
                 break;
         }
         return val;
@@ -541,16 +678,128 @@ namespace ns3 {
     }
 
     bool
-    RescuePhyHeader::IsBlockAckFrameReceived(uint8_t frameNumber) const {
-        return (m_blockAck[frameNumber] == 1);
+    RescuePhyHeader::IsBlockAckFrameReceived(uint16_t frameNumber) const {
+        if (frameNumber >= m_blockAckSize)
+            return false;
+        return (m_blockAck[frameNumber >> 5] >> (frameNumber & 31)) & 0x01;
     }
 
     uint16_t
     RescuePhyHeader::GetBlockAck(void) const {
-        uint16_t val = 0;
-        for (int i = 0; i < 16; i++)
-            val |= (m_blockAck[i] << i) & (0x01 << i);
-        return val;
+        return m_blockAck[0] & 0xffff;
+    }
+
+    uint16_t
+    RescuePhyHeader::GetBlockAckSize(void) const {
+        return m_blockAckSize;
+    }
+
+    uint32_t
+    RescuePhyHeader::GetBlockAckWord(uint8_t word) const {
+        NS_ASSERT(word < BLOCK_ACK_WORDS);
+        return m_blockAck[word];
+    }
+
+    uint16_t
+    RescuePhyHeader::GetBlockAckMissed(uint16_t count) const {
+        count = std::min(count, m_blockAckSize);
+        uint16_t received = 0;
+        for (uint16_t w = 0; w < (count + 31) / 32; w++) {
+            uint32_t word = m_blockAck[w];
+            if (count - w * 32 < 32)
+                word &= (1u << (count - w * 32)) - 1;
+            received += CountOnes(word);
+        }
+        return count - received;
+    }
+
+    bool
+    RescuePhyHeader::IsBlockAckEqual(const RescuePhyHeader &hdr) const {
+        if (m_blockAckSize != hdr.m_blockAckSize)
+            return false;
+        for (int w = 0; w < (m_blockAckSize + 31) / 32; w++)
+            if (m_blockAck[w] != hdr.m_blockAck[w])
+                return false;
+        return true;
+    }
+
+    uint16_t
+    RescuePhyHeader::GetBlockAckRunLength(uint16_t start) const {
+        //skip frames with the same flag as the first one, word by word
+        uint32_t fill = IsBlockAckFrameReceived(start) ? 0xffffffff : 0;
+        uint16_t pos = start;
+        while (pos < m_blockAckSize) {
+            uint32_t diff = (m_blockAck[pos >> 5] ^ fill) >> (pos & 31);
+            if (diff != 0) {
+                pos += CountTrailingZeros(diff);
+                break;
+            }
+            pos = (pos & ~31) + 32;
+        }
+        return std::min(pos, m_blockAckSize) - start;
+    }
+
+    uint32_t
+    RescuePhyHeader::GetBlockAckRunsSize(void) const {
+        uint32_t runs = 0;
+        for (uint16_t pos = 0; pos < m_blockAckSize;) {
+            uint16_t len = GetBlockAckRunLength(pos);
+            runs += (len + 127) / 128; //a single run byte keeps up to 128 frames
+            pos += len;
+        }
+        return runs;
+    }
+
+    uint32_t
+    RescuePhyHeader::GetBlockAckSerializedSize(void) const {
+        return sizeof (uint8_t) + std::min<uint32_t> (GetBlockAckRunsSize(), m_blockAckSize / 8);
+    }
+
+    void
+    RescuePhyHeader::SerializeBlockAck(Buffer::Iterator &i) const {
+        //descriptor: MSB set - number of run bytes, MSB cleared - number of bitmap bytes
+        uint32_t runs = GetBlockAckRunsSize();
+        if (runs < m_blockAckSize / 8u) {
+            i.WriteU8(0x80 | runs);
+            for (uint16_t pos = 0; pos < m_blockAckSize;) {
+                uint8_t flag = IsBlockAckFrameReceived(pos) ? 0x80 : 0x00;
+                uint16_t len = GetBlockAckRunLength(pos);
+                pos += len;
+                for (; len > 128; len -= 128)
+                    i.WriteU8(flag | 127);
+                i.WriteU8(flag | (len - 1));
+            }
+        } else {
+            i.WriteU8(m_blockAckSize / 8);
+            for (uint16_t b = 0; b < m_blockAckSize / 8; b++)
+                i.WriteU8((m_blockAck[b >> 2] >> ((b & 3) * 8)) & 0xff);
+        }
+    }
+
+    void
+    RescuePhyHeader::DeserializeBlockAck(Buffer::Iterator &i) {
+        uint8_t desc = i.ReadU8();
+        if (desc & 0x80) {
+            uint8_t runs[128];
+            uint16_t size = 0;
+            for (uint8_t r = 0; r < (desc & 0x7f); r++) {
+                runs[r] = i.ReadU8();
+                size += (runs[r] & 0x7f) + 1;
+            }
+            SetBlockAckSize(size);
+            uint16_t pos = 0;
+            for (uint8_t r = 0; r < (desc & 0x7f); r++)
+                for (uint16_t len = (runs[r] & 0x7f) + 1; len > 0; len--, pos++)
+                    if ((runs[r] & 0x80) && (pos < m_blockAckSize))
+                        m_blockAck[pos >> 5] |= (1u << (pos & 31));
+        } else {
+            SetBlockAckSize(desc * 8);
+            for (uint16_t b = 0; b < desc; b++) {
+                uint32_t byte = i.ReadU8();
+                if (b < m_blockAckSize / 8)
+                    m_blockAck[b >> 2] |= byte << ((b & 3) * 8);
+            }
+        }
     }
 
     uint8_t
@@ -573,6 +822,11 @@ namespace ns3 {
         return m_senderAddr;
     }
 
+    Mac48Address
+    RescuePhyHeader::GetTransmitter(void) const {
+        return m_transmitterAddr;
+    }
+
     Mac48Address
     RescuePhyHeader::GetDestination(void) const {
         return m_dstAddr;
@@ -610,7 +864,104 @@ namespace ns3 {
 
     Mac48Address
     RescuePhyHeader::GetScheduleEntry(uint8_t number) const {
-        return m_schedulesList [number];
+        return m_schedulesList[number].address;
+    }
+
+    uint8_t
+    RescuePhyHeader::GetScheduleSlot(uint8_t number) const {
+        return m_schedulesList[number].slot;
+    }
+
+    bool
+    RescuePhyHeader::HasConcurrentSchedules(void) const {
+        if (HasCompressedSchedule())
+            return HasScheduleRunsStart();
+        return (m_scheduleFlags & SCHEDULE_FLAG_SLOTS);
+    }
+
+    bool
+    RescuePhyHeader::HasReservationsList(void) const {
+        return (m_reservationsReport == 1);
+    }
+
+    uint8_t
+    RescuePhyHeader::GetReservationsListSize(void) const {
+        return m_reservationsReport ? m_reservations.size() : 0;
+    }
+
+    Mac48Address
+    RescuePhyHeader::GetReservationDestination(uint8_t number) const {
+        return m_reservations[number].destination;
+    }
+
+    uint16_t
+    RescuePhyHeader::GetReservationDuration(uint8_t number) const {
+        return m_reservations[number].duration;
+    }
+
+    uint8_t
+    RescuePhyHeader::GetReservationFrames(uint8_t number) const {
+        return m_reservations[number].frames;
+    }
+
+    bool
+    RescuePhyHeader::HasCompressedSchedule(void) const {
+        return (m_schedListSize == SCHEDULES_LIST_COMPRESSED);
+    }
+
+    uint8_t
+    RescuePhyHeader::GetScheduleSequence(void) const {
+        return m_scheduleSequence;
+    }
+
+    uint8_t
+    RescuePhyHeader::GetKeptScheduleRuns(void) const {
+        return m_keptRuns;
+    }
+
+    bool
+    RescuePhyHeader::HasScheduleRunsStart(void) const {
+        return (m_scheduleFlags & SCHEDULE_FLAG_RUNS_START);
+    }
+
+    uint8_t
+    RescuePhyHeader::GetStationIdsListSize(void) const {
+        return m_stationIds.size();
+    }
+
+    uint8_t
+    RescuePhyHeader::GetStationIdEntryId(uint8_t number) const {
+        return m_stationIds[number].id;
+    }
+
+    Mac48Address
+    RescuePhyHeader::GetStationIdEntryAddress(uint8_t number) const {
+        return m_stationIds[number].address;
+    }
+
+    uint8_t
+    RescuePhyHeader::GetScheduleRunsListSize(void) const {
+        return m_scheduleRuns.size();
+    }
+
+    RescueScheduleRun
+    RescuePhyHeader::GetScheduleRun(uint8_t number) const {
+        return m_scheduleRuns[number];
+    }
+
+    bool
+    RescuePhyHeader::HasNeighboursList(void) const {
+        return (m_neighboursReport == 1);
+    }
+
+    uint8_t
+    RescuePhyHeader::GetNeighboursListSize(void) const {
+        return m_neighboursReport ? m_neighboursList.size() : 0;
+    }
+
+    Mac48Address
+    RescuePhyHeader::GetNeighbourEntry(uint8_t number) const {
+        return m_neighboursList[number];
     }
 
     uint32_t
@@ -635,14 +986,17 @@ namespace ns3 {
                 break;
             case RESCUE_PHY_PKT_TYPE_E2E_ACK:
                 size = sizeof (uint16_t) + //frame control
-                        sizeof (uint16_t) + //blockAck
+                        GetBlockAckSerializedSize() +
                         sizeof (m_continousAck) +
                         sizeof (Mac48Address) * 2 +
                         sizeof (m_sequence) +
                         sizeof (m_checksum);
                 break;
             case RESCUE_PHY_PKT_TYPE_PART_ACK:
-                //currently not supported
+                size = sizeof (uint16_t) + //frame control
+                        sizeof (Mac48Address) * 4 +
+                        sizeof (m_sequence) +
+                        sizeof (m_checksum);
                 break;
             case RESCUE_PHY_PKT_TYPE_B:
                 size = sizeof (uint16_t) + //frame control
@@ -651,7 +1005,7 @@ namespace ns3 {
                         sizeof (m_beaconInterval) +
                         sizeof (m_cfpPeriod) +
                         sizeof (m_tdmaTimeSlot) +
-                        sizeof (Mac48Address) * m_schedListSize +
+                        GetSchedulesSerializedSize() +
                         sizeof (m_checksum);
                 break;
             case RESCUE_PHY_PKT_TYPE_RR:
@@ -662,6 +1016,9 @@ namespace ns3 {
                         sizeof (m_sequence) +
                         sizeof (m_mbf) +
                         sizeof (m_interleaver) +
+                        (m_neighboursReport ? sizeof (uint8_t) + sizeof (Mac48Address) * m_neighboursList.size() : 0) +
+                        (m_reservationsReport ? sizeof (uint8_t) +
+                        (sizeof (Mac48Address) + sizeof (uint16_t) + sizeof (uint8_t)) * m_reservations.size() : 0) +
                         sizeof (m_checksum);
                 break;
                 break;
@@ -669,8 +1026,95 @@ namespace ns3 {
         return size;
     }
 
+    uint32_t
+    RescuePhyHeader::GetMaxSize(void) const {
+        if (m_type != RESCUE_PHY_PKT_TYPE_E2E_ACK)
+            return GetSize();
+        return GetSize() - GetBlockAckSerializedSize() + sizeof (uint8_t) + MAX_BLOCK_ACK_SIZE / 8;
+    }
+
 
 
+    uint32_t
+    RescuePhyHeader::GetSchedulesSerializedSize(void) const {
+        if (!HasCompressedSchedule())
+            return sizeof (m_scheduleFlags) +
+                sizeof (Mac48Address) * m_schedListSize +
+                (HasConcurrentSchedules() ? sizeof (uint8_t) * m_schedListSize : 0);
+        return sizeof (m_scheduleSequence) +
+                sizeof (m_scheduleFlags) +
+                sizeof (uint8_t) + //station IDs list size
+                (sizeof (uint8_t) + sizeof (Mac48Address)) * m_stationIds.size() +
+                sizeof (m_keptRuns) +
+                sizeof (uint8_t) + //runs list size
+                (HasScheduleRunsStart() ? 3 : 2) * m_scheduleRuns.size();
+    }
+
+    void
+    RescuePhyHeader::SerializeSchedules(Buffer::Iterator &i) const {
+        if (!HasCompressedSchedule()) {
+            i.WriteU8(m_scheduleFlags);
+            for (int j = 0; j < m_schedListSize; j++)
+                WriteTo(i, m_schedulesList[j].address);
+            if (HasConcurrentSchedules())
+                for (int j = 0; j < m_schedListSize; j++)
+                    i.WriteU8(m_schedulesList[j].slot);
+            return;
+        }
+        i.WriteU8(m_scheduleSequence);
+        i.WriteU8(m_scheduleFlags);
+        i.WriteU8(m_stationIds.size());
+        for (uint32_t j = 0; j < m_stationIds.size(); j++) {
+            i.WriteU8(m_stationIds[j].id);
+            WriteTo(i, m_stationIds[j].address);
+        }
+        i.WriteU8(m_keptRuns);
+        i.WriteU8(m_scheduleRuns.size());
+        for (uint32_t j = 0; j < m_scheduleRuns.size(); j++) {
+            i.WriteU8(m_scheduleRuns[j].id);
+            if (HasScheduleRunsStart())
+                i.WriteU8(m_scheduleRuns[j].start);
+            i.WriteU8(m_scheduleRuns[j].length);
+        }
+    }
+
+    void
+    RescuePhyHeader::DeserializeSchedules(Buffer::Iterator &i) {
+        if (!HasCompressedSchedule()) {
+            m_scheduleFlags = i.ReadU8();
+            m_schedulesList.resize(m_schedListSize);
+            for (int j = 0; j < m_schedListSize; j++)
+                ReadFrom(i, m_schedulesList[j].address);
+            for (int j = 0; j < m_schedListSize; j++)
+                m_schedulesList[j].slot = HasConcurrentSchedules() ? i.ReadU8() : j;
+            return;
+        }
+        m_schedulesList.clear();
+        m_scheduleSequence = i.ReadU8();
+        m_scheduleFlags = i.ReadU8();
+        //lists longer than allowed are truncated, the surplus entries are skipped
+        uint8_t size = i.ReadU8();
+        m_stationIds.resize(std::min(size, uint8_t(MAX_STATION_IDS_LIST_SIZE)));
+        for (int j = 0; j < size; j++) {
+            StationIdEntry entry;
+            entry.id = i.ReadU8();
+            ReadFrom(i, entry.address);
+            if (j < MAX_STATION_IDS_LIST_SIZE)
+                m_stationIds[j] = entry;
+        }
+        m_keptRuns = i.ReadU8();
+        size = i.ReadU8();
+        m_scheduleRuns.resize(std::min(size, uint8_t(MAX_SCHEDULE_RUNS)));
+        for (int j = 0; j < size; j++) {
+            RescueScheduleRun run;
+            run.id = i.ReadU8();
+            run.start = HasScheduleRunsStart() ? i.ReadU8() : 0;
+            run.length = i.ReadU8();
+            if (j < MAX_SCHEDULE_RUNS)
+                m_scheduleRuns[j] = run;
+        }
+    }
+
     // ------------------------ Inherrited methods -----------------------------
 
     uint32_t
@@ -694,14 +1138,18 @@ namespace ns3 {
                 i.WriteU8(m_interleaver);
                 break;
             case RESCUE_PHY_PKT_TYPE_E2E_ACK:
-                i.WriteU16(GetBlockAck());
+                SerializeBlockAck(i);
                 i.WriteU8(m_continousAck);
                 WriteTo(i, m_srcAddr);
                 WriteTo(i, m_dstAddr);
                 i.WriteU16(m_sequence);
                 break;
             case RESCUE_PHY_PKT_TYPE_PART_ACK:
-                //currently not supported
+                WriteTo(i, m_srcAddr);
+                WriteTo(i, m_senderAddr);
+                WriteTo(i, m_dstAddr);
+                WriteTo(i, m_transmitterAddr);
+                i.WriteU16(m_sequence);
                 break;
             case RESCUE_PHY_PKT_TYPE_B:
                 i.WriteU32(m_timestamp);
@@ -709,8 +1157,7 @@ namespace ns3 {
                 i.WriteU32(m_beaconInterval);
                 i.WriteU32(m_cfpPeriod);
                 i.WriteU32(m_tdmaTimeSlot);
-                for (int j = 0; j < m_schedListSize; j++)
-                    WriteTo(i, m_schedulesList[j]);
+                SerializeSchedules(i);
                 break;
             case RESCUE_PHY_PKT_TYPE_RR:
                 i.WriteU16(m_duration);
@@ -720,6 +1167,19 @@ namespace ns3 {
                 i.WriteU16(m_sequence);
                 i.WriteU16(m_mbf);
                 i.WriteU8(m_interleaver);
+                if (m_neighboursReport) {
+                    i.WriteU8(m_neighboursList.size());
+                    for (uint32_t j = 0; j < m_neighboursList.size(); j++)
+                        WriteTo(i, m_neighboursList[j]);
+                }
+                if (m_reservationsReport) {
+                    i.WriteU8(m_reservations.size());
+                    for (uint32_t j = 0; j < m_reservations.size(); j++) {
+                        WriteTo(i, m_reservations[j].destination);
+                        i.WriteU16(m_reservations[j].duration);
+                        i.WriteU8(m_reservations[j].frames);
+                    }
+                }
                 break;
         }
         i.WriteU32(m_checksum);
@@ -731,7 +1191,6 @@ namespace ns3 {
 
         uint16_t frame_control = i.ReadU16();
         SetFrameControl(frame_control);
-        uint16_t block_ack;
         switch (m_type) {
             case RESCUE_PHY_PKT_TYPE_DATA:
                 m_duration = i.ReadU16();
@@ -745,15 +1204,18 @@ namespace ns3 {
                 m_interleaver = i.ReadU8();
                 break;
             case RESCUE_PHY_PKT_TYPE_E2E_ACK:
-                block_ack = i.ReadU16();
-                SetBlockAck(block_ack);
+                DeserializeBlockAck(i);
                 m_continousAck = i.ReadU8();
                 ReadFrom(i, m_srcAddr);
                 ReadFrom(i, m_dstAddr);
                 m_sequence = i.ReadU16();
                 break;
             case RESCUE_PHY_PKT_TYPE_PART_ACK:
-                //currently not supported
+                ReadFrom(i, m_srcAddr);
+                ReadFrom(i, m_senderAddr);
+                ReadFrom(i, m_dstAddr);
+                ReadFrom(i, m_transmitterAddr);
+                m_sequence = i.ReadU16();
                 break;
             case RESCUE_PHY_PKT_TYPE_B:
                 m_timestamp = i.ReadU32();
@@ -761,8 +1223,7 @@ namespace ns3 {
                 m_beaconInterval = i.ReadU32();
                 m_cfpPeriod = i.ReadU32();
                 m_tdmaTimeSlot = i.ReadU32();
-                for (int j = 0; j < m_schedListSize; j++)
-                    ReadFrom(i, m_schedulesList[j]);
+                DeserializeSchedules(i);
                 break;
             case RESCUE_PHY_PKT_TYPE_RR:
                 m_duration = i.ReadU16();
@@ -772,6 +1233,31 @@ namespace ns3 {
                 m_sequence = i.ReadU16();
                 m_mbf = i.ReadU16();
                 m_interleaver = i.ReadU8();
+                //lists longer than allowed are truncated, the surplus entries are skipped
+                m_neighboursList.clear();
+                if (m_neighboursReport) {
+                    uint8_t size = i.ReadU8();
+                    m_neighboursList.resize(std::min(size, uint8_t(MAX_NEIGHBOURS_LIST_SIZE)));
+                    for (int j = 0; j < size; j++) {
+                        Mac48Address neighbour;
+                        ReadFrom(i, neighbour);
+                        if (j < MAX_NEIGHBOURS_LIST_SIZE)
+                            m_neighboursList[j] = neighbour;
+                    }
+                }
+                m_reservations.clear();
+                if (m_reservationsReport) {
+                    uint8_t size = i.ReadU8();
+                    m_reservations.resize(std::min(size, uint8_t(MAX_RESERVATIONS_LIST_SIZE)));
+                    for (int j = 0; j < size; j++) {
+                        ReservationEntry entry;
+                        ReadFrom(i, entry.destination);
+                        entry.duration = i.ReadU16();
+                        entry.frames = i.ReadU8();
+                        if (j < MAX_RESERVATIONS_LIST_SIZE)
+                            m_reservations[j] = entry;
+                    }
+                }
                 break;
         }
         m_checksum = i.ReadU32();
@@ -28,16 +28,43 @@
 #include "ns3/simulator.h"
 #include "ns3/mac48-address.h"
 
+#include <vector>
+
 #define RESCUE_PHY_PKT_TYPE_DATA        0 //data frame
 #define RESCUE_PHY_PKT_TYPE_E2E_ACK     1 //end-to-end acknowledgment
 #define RESCUE_PHY_PKT_TYPE_PART_ACK    2 //partial acknowledgment
 #define RESCUE_PHY_PKT_TYPE_B           3 //beacon
 #define RESCUE_PHY_PKT_TYPE_RR          4 //resource reservation
 
+#define DEFAULT_BLOCK_ACK_SIZE          16 //default length of block ACK bitmap (in frames)
+#define MAX_BLOCK_ACK_SIZE              256 //maximal length of block ACK bitmap (in frames)
+#define BLOCK_ACK_WORDS                 (MAX_BLOCK_ACK_SIZE / 32)
+#define MAX_SCHEDULES_LIST_SIZE         30 //maximal number of entries in beacon schedules list (5b size field)
+#define SCHEDULES_LIST_COMPRESSED       0x1f //schedules list size field value of compressed schedule
+#define MAX_SCHEDULE_RUNS               32 //maximal number of runs of compressed schedule
+#define SCHEDULE_FLAG_RUNS_START        0x01 //schedule flag: the runs of compressed schedule carry their first slots
+#define SCHEDULE_FLAG_SLOTS             0x02 //schedule flag: the entries of plain schedule carry their slots
+#define MAX_STATION_IDS_LIST_SIZE       32 //maximal number of station ID announcements in compressed schedule
+#define AP_STATION_ID                   0 //short ID of AP in compressed schedule
+#define NO_STATION_ID                   0xff //short ID not assigned
+#define MAX_NEIGHBOURS_LIST_SIZE        32 //maximal number of entries in neighbours list of resource reservation
+#define MAX_RESERVATIONS_LIST_SIZE      16 //maximal number of per-destination entries of cumulative resource reservation
+
 
 
 namespace ns3 {
 
+    /**
+     * \ingroup rescue
+     *
+     * Run of consecutive TDMA time slots of one station (compressed beacon schedule)
+     */
+    struct RescueScheduleRun {
+        uint8_t id; //!< Short ID of the station
+        uint8_t start; //!< Number of the first slot
+        uint8_t length; //!< Number of slots
+    };
+
     /**
      * \ingroup rescue
      *
@@ -177,7 +204,8 @@ namespace ns3 {
          * - continous ACK (1b)
          * - QoS (1b)
          * - next data rate (2b)
-         * - reserved (2b)
+         * - neighbours list (1b)
+         * - reservations list (1b)
          * BEACON frame:
          * - type (3b)
          * - supported data rates (2b)
@@ -205,11 +233,19 @@ namespace ns3 {
          * \param received true if the frame was correctly received
          * \param number of the frame in the block ACK field
          */
-        void SetBlockAckFlagFor(bool received, uint8_t frameNumber);
+        void SetBlockAckFlagFor(bool received, uint16_t frameNumber);
         /**
+         * sets 16-frame block ACK field
+         *
          * \param blockAck the block ACK flag/field
          */
         void SetBlockAck(uint16_t blockAck);
+        /**
+         * sets the length of block ACK bitmap and clears it
+         *
+         * \param size the number of frames in block ACK field (rounded up to a multiple of 8, up to MAX_BLOCK_ACK_SIZE)
+         */
+        void SetBlockAckSize(uint16_t size);
         /**
          * \param continousAck the continous ACK flag/field
          */
@@ -226,6 +262,10 @@ namespace ns3 {
          * \param addr the sender address field
          */
         void SetSender(Mac48Address addr);
+        /**
+         * \param addr the transmitter address field (sender of the frame acknowledged with PART ACK)
+         */
+        void SetTransmitter(Mac48Address addr);
         /**
          * \param addr the destination address field
          */
@@ -259,6 +299,67 @@ namespace ns3 {
          * \param scheduleEntry entry to add to the schedules TX list
          */
         void SetScheduleEntry(uint8_t number, Mac48Address scheduleEntry);
+        /**
+         * Used for concurrent (spatially reused) TDMA time slots - when several entries
+         * share one slot, the slot numbers are sent along with the schedules list
+         *
+         * \param number number of entry in the schedules list
+         * \param scheduleEntry entry to add to the schedules TX list
+         * \param slot the number of TDMA time slot assigned to the entry
+         */
+        void SetScheduleEntry(uint8_t number, Mac48Address scheduleEntry, uint8_t slot);
+        /**
+         * \param size the number of entries of neighbours list (RESOURCE RESERVATION frame),
+         * adds the neighbours list to the frame
+         */
+        void SetNeighboursListSize(uint8_t size);
+        /**
+         * Switches BEACON frame to compressed schedule: short station IDs, run-length
+         * encoded slots and delta encoding against the previous beacon
+         * (the schedules list size field carries SCHEDULES_LIST_COMPRESSED)
+         *
+         * \param sequence the sequence number of the schedule
+         * \param keptRuns the number of leading runs of the previous schedule which are repeated
+         * \param withStart true if the runs carry the numbers of their first slots (concurrent slots),
+         * otherwise each run starts at the end of the previous one
+         */
+        void SetCompressedSchedule(uint8_t sequence, uint8_t keptRuns, bool withStart);
+        /**
+         * \param size the number of station ID announcements
+         */
+        void SetStationIdsListSize(uint8_t size);
+        /**
+         * \param number number of entry in the station ID announcements list
+         * \param id the short ID assigned to the station
+         * \param address address of the station
+         */
+        void SetStationIdEntry(uint8_t number, uint8_t id, Mac48Address address);
+        /**
+         * \param size the number of runs sent explicitly (following the kept runs)
+         */
+        void SetScheduleRunsListSize(uint8_t size);
+        /**
+         * \param number number of entry in the runs list
+         * \param run the run of slots
+         */
+        void SetScheduleRun(uint8_t number, RescueScheduleRun run);
+        /**
+         * \param number number of entry in the neighbours list
+         * \param neighbour address of the neighbour station
+         */
+        void SetNeighbourEntry(uint8_t number, Mac48Address neighbour);
+        /**
+         * \param size the number of per-destination entries of cumulative RESOURCE RESERVATION frame,
+         * adds the reservations list to the frame
+         */
+        void SetReservationsListSize(uint8_t size);
+        /**
+         * \param number number of entry in the reservations list
+         * \param destination the destination of reserved transmissions
+         * \param duration the reserved TX time [us]
+         * \param frames the number of reserved frames
+         */
+        void SetReservationEntry(uint8_t number, Mac48Address destination, uint16_t duration, uint8_t frames);
         /**
          * \param checksum the checksum field
          */
@@ -401,11 +502,30 @@ namespace ns3 {
          *
          * /param frameNumber number of the frame in the block ACK field
          */
-        bool IsBlockAckFrameReceived(uint8_t frameNumber) const;
+        bool IsBlockAckFrameReceived(uint16_t frameNumber) const;
         /**
-         * \return the block ACK field value
+         * \return the first 16 flags of block ACK field
          */
         uint16_t GetBlockAck(void) const;
+        /**
+         * \return the number of frames in block ACK field
+         */
+        uint16_t GetBlockAckSize(void) const;
+        /**
+         * \param word the number of 32-bit word of block ACK bitmap
+         * \return the flags of frames 32 * word ... 32 * word + 31
+         */
+        uint32_t GetBlockAckWord(uint8_t word) const;
+        /**
+         * \param count the number of first frames of block ACK field to check
+         * \return the number of frames indicated as missed among them
+         */
+        uint16_t GetBlockAckMissed(uint16_t count) const;
+        /**
+         * \param hdr the header to compare with
+         * \return true if both block ACK fields have the same length and flags
+         */
+        bool IsBlockAckEqual(const RescuePhyHeader &hdr) const;
         /**
          * \return the continous ACK field value
          */
@@ -422,6 +542,10 @@ namespace ns3 {
          * \return the sender address field value
          */
         Mac48Address GetSender(void) const;
+        /**
+         * \return the transmitter address field value (sender of the frame acknowledged with PART ACK)
+         */
+        Mac48Address GetTransmitter(void) const;
         /**
          * \return the destination address field value
          */
@@ -456,6 +580,92 @@ namespace ns3 {
          * \return schedule entry value
          */
         Mac48Address GetScheduleEntry(uint8_t number) const;
+        /**
+         * \param number the number of demanded entry
+         *
+         * \return the number of TDMA time slot assigned to the entry
+         */
+        uint8_t GetScheduleSlot(uint8_t number) const;
+        /**
+         * \return true if some TDMA time slots are shared by several entries of the schedules list
+         */
+        bool HasConcurrentSchedules(void) const;
+        /**
+         * \return true if RESOURCE RESERVATION frame carries the neighbours list
+         */
+        bool HasNeighboursList(void) const;
+        /**
+         * \return true if BEACON frame carries compressed schedule
+         */
+        bool HasCompressedSchedule(void) const;
+        /**
+         * \return the sequence number of compressed schedule
+         */
+        uint8_t GetScheduleSequence(void) const;
+        /**
+         * \return the number of leading runs repeated from the previous schedule
+         */
+        uint8_t GetKeptScheduleRuns(void) const;
+        /**
+         * \return true if the runs carry the numbers of their first slots
+         */
+        bool HasScheduleRunsStart(void) const;
+        /**
+         * \return the number of station ID announcements
+         */
+        uint8_t GetStationIdsListSize(void) const;
+        /**
+         * \param number the number of demanded entry
+         * \return the short ID of the announced station
+         */
+        uint8_t GetStationIdEntryId(uint8_t number) const;
+        /**
+         * \param number the number of demanded entry
+         * \return address of the announced station
+         */
+        Mac48Address GetStationIdEntryAddress(uint8_t number) const;
+        /**
+         * \return the number of runs sent explicitly
+         */
+        uint8_t GetScheduleRunsListSize(void) const;
+        /**
+         * \param number the number of demanded entry
+         * \return the run of slots (start of the run is valid only if the runs carry it)
+         */
+        RescueScheduleRun GetScheduleRun(uint8_t number) const;
+        /**
+         * \return the number of entries of neighbours list
+         */
+        uint8_t GetNeighboursListSize(void) const;
+        /**
+         * \param number the number of demanded entry
+         *
+         * \return address of the neighbour station
+         */
+        Mac48Address GetNeighbourEntry(uint8_t number) const;
+        /**
+         * \return true if RESOURCE RESERVATION frame carries the reservations list (cumulative reservation)
+         */
+        bool HasReservationsList(void) const;
+        /**
+         * \return the number of entries of reservations list
+         */
+        uint8_t GetReservationsListSize(void) const;
+        /**
+         * \param number the number of demanded entry
+         * \return the destination of reserved transmissions
+         */
+        Mac48Address GetReservationDestination(uint8_t number) const;
+        /**
+         * \param number the number of demanded entry
+         * \return the reserved TX time [us]
+         */
+        uint16_t GetReservationDuration(uint8_t number) const;
+        /**
+         * \param number the number of demanded entry
+         * \return the number of reserved frames
+         */
+        uint8_t GetReservationFrames(uint8_t number) const;
         /**
          * \return the QoS field value
          */
@@ -465,6 +675,11 @@ namespace ns3 {
          * \return the size of this header
          */
         uint32_t GetSize(void) const;
+        /**
+         * \return the size of this header with the longest possible block ACK field
+         *         (the size of other frame types does not depend on their content)
+         */
+        uint32_t GetMaxSize(void) const;
 
         // Inherrited methods
         virtual uint32_t GetSerializedSize(void) const;
@@ -474,6 +689,57 @@ namespace ns3 {
         virtual TypeId GetInstanceTypeId(void) const;
 
     private:
+        /**
+         * Sets the fields common to all constructors to their defaults
+         */
+        void Init(void);
+        /**
+         * \param start the number of the first frame of the run
+         * \return the number of consecutive frames with the same flag as the first one
+         */
+        uint16_t GetBlockAckRunLength(uint16_t start) const;
+        /**
+         * \return the number of bytes of run-length encoded block ACK field
+         */
+        uint32_t GetBlockAckRunsSize(void) const;
+        /**
+         * \return the number of bytes of serialized block ACK field
+         */
+        uint32_t GetBlockAckSerializedSize(void) const;
+        void SerializeBlockAck(Buffer::Iterator &i) const;
+        /**
+         * \return the number of bytes of serialized schedules list (plain or compressed)
+         */
+        uint32_t GetSchedulesSerializedSize(void) const;
+        void SerializeSchedules(Buffer::Iterator &i) const;
+        void DeserializeSchedules(Buffer::Iterator &i);
+        void DeserializeBlockAck(Buffer::Iterator &i);
+
+        /**
+         * Entry of plain schedules list
+         */
+        struct ScheduleEntry {
+            Mac48Address address; //!< Address of the scheduled station
+            uint8_t slot; //!< TDMA time slot of the entry
+        };
+
+        /**
+         * Station ID announcement of compressed schedule
+         */
+        struct StationIdEntry {
+            uint8_t id; //!< Short ID of the station
+            Mac48Address address; //!< Address of the station
+        };
+
+        /**
+         * Per-destination entry of cumulative resource reservation
+         */
+        struct ReservationEntry {
+            Mac48Address destination; //!< Destination of reserved transmissions
+            uint16_t duration; //!< Reserved TX time [us]
+            uint8_t frames; //!< Number of reserved frames
+        };
+
         // ....................CTRL field - subfields/flags values.............
         uint8_t m_type; //<! type field
         uint8_t m_dataRate; //<! data rate field (supported data rate in Beacon frame)
@@ -489,24 +755,35 @@ namespace ns3 {
         int8_t m_channel; //<! channel number field
         int8_t m_txPower; //<! TX power field
         int8_t m_schedListSize; //<! schedules list size field (the number of entries in the schedules list)
+        uint8_t m_neighboursReport; //<! neighbours list field/flag (1-neighbours list is present)
 
         // ....................header fields values............................
         uint16_t m_duration; //<! duration field
         uint16_t m_nextDuration; //<! next duration field
         uint32_t m_beaconRep; //<! beacon repetition field
-        uint8_t m_blockAck [16]; //<! block ACK field
+        uint32_t m_blockAck [BLOCK_ACK_WORDS]; //<! block ACK field (bitmap, frame 0 in the lowest bit of the first word)
+        uint16_t m_blockAckSize; //<! number of frames in block ACK field
         uint8_t m_continousAck; //<! continous ACK field/flag
         uint32_t m_timestamp; //<! timestamp field
         Mac48Address m_srcAddr; //<! source address field
         Mac48Address m_senderAddr; //<! sender address field
         Mac48Address m_dstAddr; //<! destination address field
+        Mac48Address m_transmitterAddr; //<! transmitter address field (PART ACK only)
         uint16_t m_sequence; //<! sequence number field
         uint16_t m_mbf; //<! interleaver field
         uint8_t m_interleaver; //<! interleaver field
         uint32_t m_beaconInterval; //<! beacon interval field
         uint32_t m_cfpPeriod; //<! CFP period field
         uint32_t m_tdmaTimeSlot; //<! TDMA time slot field
-        Mac48Address m_schedulesList [32]; //<! schedules list field (?)
+        std::vector<ScheduleEntry> m_schedulesList; //<! schedules list field (slots sent only for concurrent slots)
+        uint8_t m_scheduleSequence; //<! sequence number of compressed schedule
+        uint8_t m_scheduleFlags; //<! flags of schedules list (runs with start slots, entries with slots)
+        uint8_t m_keptRuns; //<! number of runs repeated from the previous compressed schedule
+        std::vector<StationIdEntry> m_stationIds; //<! station ID announcements
+        std::vector<RescueScheduleRun> m_scheduleRuns; //<! explicitly sent runs
+        std::vector<Mac48Address> m_neighboursList; //<! neighbours list field
+        uint8_t m_reservationsReport; //<! reservations list field/flag (1-reservations list is present)
+        std::vector<ReservationEntry> m_reservations; //<! reservations list field
         uint32_t m_checksum; //<! checksum field
     };
 
@@ -27,6 +27,8 @@
 #include "ns3/double.h"
 #include "ns3/boolean.h"
 #include "ns3/mac48-address.h"
+#include "ns3/header.h"
+#include "ns3/tag.h"
 
 #include "rescue-mac.h"
 #include "rescue-mac-csma.h"
@@ -46,6 +48,208 @@ NS_LOG_COMPONENT_DEFINE("RescuePhy");
 #define Min(a,b) ((a < b) ? a : b)
 #define Max(a,b) ((a > b) ? a : b)
 
+/***************************************************************
+ *           Aggregation delimiter and tag
+ ***************************************************************/
+
+namespace ns3 {
+
+    /**
+     * Delimiter preceding each subframe (PHY header + MAC frame) of aggregated transmission
+     * (length of the subframe and reserved octets, all sent on air).
+     */
+    class RescueAggregationHeader : public Header {
+    public:
+        RescueAggregationHeader();
+        RescueAggregationHeader(uint16_t length);
+
+        void SetLength(uint16_t length);
+        uint16_t GetLength(void) const;
+
+        static TypeId GetTypeId(void);
+        virtual TypeId GetInstanceTypeId(void) const;
+        virtual void Print(std::ostream &os) const;
+        virtual uint32_t GetSerializedSize(void) const;
+        virtual void Serialize(Buffer::Iterator start) const;
+        virtual uint32_t Deserialize(Buffer::Iterator start);
+    private:
+        uint16_t m_length; //!< Length of the subframe (PHY header + MAC frame)
+    };
+
+    NS_OBJECT_ENSURE_REGISTERED(RescueAggregationHeader);
+
+    RescueAggregationHeader::RescueAggregationHeader()
+    : m_length(0) {
+    }
+
+    RescueAggregationHeader::RescueAggregationHeader(uint16_t length)
+    : m_length(length) {
+    }
+
+    void
+    RescueAggregationHeader::SetLength(uint16_t length) {
+        m_length = length;
+    }
+
+    uint16_t
+    RescueAggregationHeader::GetLength(void) const {
+        return m_length;
+    }
+
+    TypeId
+    RescueAggregationHeader::GetTypeId(void) {
+        static TypeId tid = TypeId("ns3::RescueAggregationHeader")
+                .SetParent<Header> ()
+                .AddConstructor<RescueAggregationHeader> ()
+                ;
+        return tid;
+    }
+
+    TypeId
+    RescueAggregationHeader::GetInstanceTypeId(void) const {
+        return GetTypeId();
+    }
+
+    void
+    RescueAggregationHeader::Print(std::ostream &os) const {
+        os << "length=" << m_length;
+    }
+
+    uint32_t
+    RescueAggregationHeader::GetSerializedSize(void) const {
+        return 2 * sizeof (uint16_t);
+    }
+
+    void
+    RescueAggregationHeader::Serialize(Buffer::Iterator start) const {
+        start.WriteHtolsbU16(m_length);
+        start.WriteU16(0);
+    }
+
+    uint32_t
+    RescueAggregationHeader::Deserialize(Buffer::Iterator start) {
+        m_length = start.ReadLsbtohU16();
+        start.ReadU16();
+        return GetSerializedSize();
+    }
+
+    /**
+     * Packet tags of the subframes are lost when the subframes are concatenated, so they are
+     * attached (as byte tags) to the octets of subframe delimiter - simulation side information,
+     * it does not change the size of transmitted data.
+     *
+     * \param subframe the subframe with packet tags to carry
+     * \param delimiter the packet holding only delimiter of the subframe
+     */
+    static void
+    CarryPacketTags(Ptr<const Packet> subframe, Ptr<Packet> delimiter) {
+        PacketTagIterator it = subframe->GetPacketTagIterator();
+        while (it.HasNext()) {
+            PacketTagIterator::Item item = it.Next();
+            if (!item.GetTypeId().HasConstructor())
+                continue;
+            Callback<ObjectBase *> constructor = item.GetTypeId().GetConstructor();
+            Tag *tag = dynamic_cast<Tag *> (constructor());
+            NS_ASSERT(tag != 0);
+            item.GetTag(*tag);
+            delimiter->AddByteTag(*tag);
+            delete tag;
+        }
+    }
+
+    /**
+     * Restores packet tags of the subframe carried by its delimiter
+     *
+     * \param delimiter the fragment holding only delimiter of the subframe
+     * \param subframe the subframe to restore packet tags to
+     */
+    static void
+    RestorePacketTags(Ptr<const Packet> delimiter, Ptr<Packet> subframe) {
+        //the fragment inherits packet tags of the whole aggregate, only tags of the subframe are kept
+        subframe->RemoveAllPacketTags();
+        ByteTagIterator it = delimiter->GetByteTagIterator();
+        while (it.HasNext()) {
+            ByteTagIterator::Item item = it.Next();
+            Callback<ObjectBase *> constructor = item.GetTypeId().GetConstructor();
+            Tag *tag = dynamic_cast<Tag *> (constructor());
+            NS_ASSERT(tag != 0);
+            item.GetTag(*tag);
+            subframe->AddPacketTag(*tag);
+            delete tag;
+        }
+    }
+
+    /**
+     * Tag marking aggregated transmission (holds the number of subframes)
+     */
+    class RescueAggregationTag : public Tag {
+    public:
+        RescueAggregationTag();
+        RescueAggregationTag(uint16_t subframes);
+
+        uint16_t GetNSubframes(void) const;
+
+        static TypeId GetTypeId(void);
+        virtual TypeId GetInstanceTypeId(void) const;
+        virtual uint32_t GetSerializedSize(void) const;
+        virtual void Serialize(TagBuffer i) const;
+        virtual void Deserialize(TagBuffer i);
+        virtual void Print(std::ostream &os) const;
+    private:
+        uint16_t m_subframes; //!< Number of aggregated subframes
+    };
+
+    NS_OBJECT_ENSURE_REGISTERED(RescueAggregationTag);
+
+    RescueAggregationTag::RescueAggregationTag()
+    : m_subframes(0) {
+    }
+
+    RescueAggregationTag::RescueAggregationTag(uint16_t subframes)
+    : m_subframes(subframes) {
+    }
+
+    uint16_t
+    RescueAggregationTag::GetNSubframes(void) const {
+        return m_subframes;
+    }
+
+    TypeId
+    RescueAggregationTag::GetTypeId(void) {
+        static TypeId tid = TypeId("ns3::RescueAggregationTag")
+                .SetParent<Tag> ()
+                .AddConstructor<RescueAggregationTag> ()
+                ;
+        return tid;
+    }
+
+    TypeId
+    RescueAggregationTag::GetInstanceTypeId(void) const {
+        return GetTypeId();
+    }
+
+    uint32_t
+    RescueAggregationTag::GetSerializedSize(void) const {
+        return sizeof (uint16_t);
+    }
+
+    void
+    RescueAggregationTag::Serialize(TagBuffer i) const {
+        i.WriteU16(m_subframes);
+    }
+
+    void
+    RescueAggregationTag::Deserialize(TagBuffer i) {
+        m_subframes = i.ReadU16();
+    }
+
+    void
+    RescueAggregationTag::Print(std::ostream &os) const {
+        os << "subframes=" << m_subframes;
+    }
+
+} // namespace ns3
+
 namespace ns3 {
 
     NS_OBJECT_ENSURE_REGISTERED(RescuePhy);
@@ -59,6 +263,7 @@ namespace ns3 {
         m_state = IDLE;
         m_csBusy = false;
         m_rxBusy = false;
+        m_rxAggregate = false;
         m_csBusyEnd = Seconds(0);
         m_rxBusyEnd = Seconds(0);
         m_random = CreateObject<UniformRandomVariable> ();
@@ -309,6 +514,44 @@ namespace ns3 {
         return true;
     }
 
+    bool
+    RescuePhy::SendPacket(std::list<std::pair<Ptr<Packet>, RescuePhyHeader> > aggregate, RescueMode mode) {
+        NS_LOG_FUNCTION("v3 dst:" << aggregate.front().second.GetDestination() <<
+                "subframes:" << aggregate.size());
+        // RX might be interrupted by TX, but not vice versa
+        if (m_state == TX) {
+            NS_LOG_DEBUG("Already in transmission mode");
+            return false;
+        }
+
+        m_state = TX;
+        Time txDuration = CalTxDuration(aggregate, mode);
+
+        m_lowMac->SetTxDuration(txDuration);
+
+        NS_LOG_DEBUG("Tx will finish at " << (Simulator::Now() + txDuration).GetSeconds() <<
+                " (" << txDuration.GetNanoSeconds() << "ns), txPower: " << m_txPower);
+
+        //each subframe is preceded by its delimiter and keeps its own PHY header
+        Ptr<Packet> p = Create<Packet> ();
+        for (std::list<std::pair<Ptr<Packet>, RescuePhyHeader> >::iterator it = aggregate.begin(); it != aggregate.end(); it++) {
+            Ptr<Packet> subframe = it->first->Copy();
+            Ptr<Packet> delimiter = Create<Packet> ();
+            delimiter->AddHeader(RescueAggregationHeader(it->second.GetSize() + subframe->GetSize()));
+            CarryPacketTags(subframe, delimiter);
+
+            subframe->AddHeader(it->second);
+            p->AddAtEnd(delimiter);
+            p->AddAtEnd(subframe);
+        }
+        p->AddPacketTag(RescueAggregationTag(aggregate.size()));
+
+        // forward to CHANNEL
+        m_channel->SendPacket(Ptr<RescuePhy> (this), p, m_txPower, mode, txDuration);
+
+        return true;
+    }
+
     void
     RescuePhy::SendPacketDone(Ptr<Packet> pkt) {
         NS_LOG_FUNCTION("");
@@ -394,135 +637,169 @@ namespace ns3 {
             //MODIF
             m_traceRecv(pkt, sinr);
 
-            RescuePhyHeader hdr;
-            pkt->RemoveHeader(hdr);
-
             std::vector<double> snr_db;
             std::vector<double> linkPER;
             snr_db.push_back(sinr);
             linkPER.push_back(0.0);
 
-            bool correct = true;
-
             //Check if number of errors in preamble is equal to 0
-            int preambleBits = GetPhyPreambleDuration(mode).GetMicroSeconds() * GetPhyPreambleMode(mode).GetDataRate() / 1000000;
-            correct = (0 == (BlackBox_no2::CalculateRescueBitErrorNumber(snr_db, linkPER,
-                    GetPhyPreambleMode(mode).GetConstellationSize(),
-                    GetPhyPreambleMode(mode).GetSpectralEfficiency(),
+            const RescueModeDescriptor &preambleMode = GetPhyPreambleMode(mode).GetDescriptor();
+            int preambleBits = GetPhyPreambleDuration(mode).GetMicroSeconds() * preambleMode.dataRate / 1000000;
+            bool correctPreamble = (0 == (BlackBox_no2::CalculateRescueBitErrorNumber(snr_db, linkPER,
+                    preambleMode.constellationSize,
+                    preambleMode.spectralEfficiency,
                     preambleBits)));
 
-            //Check if number of errors in PHY header is equal to 0
-            correct = (correct && (0 == (BlackBox_no2::CalculateRescueBitErrorNumber(snr_db, linkPER,
-                    GetPhyHeaderMode(mode).GetConstellationSize(),
-                    GetPhyHeaderMode(mode).GetSpectralEfficiency(),
-                    8 * hdr.GetSize()))));
-
-            NS_LOG_DEBUG("mode=" << mode <<
-                    ", snr=" << sinr <<
-                    ", size=" << pkt->GetSize());
-
             //MODIF 4
             m_updateSNR(sinr);
 
-            if (correct) //is the PHY header complete
-            {
-                //PHY HEADER CORRECTLY RECEIVED
-                NS_LOG_INFO("PHY HDR CORRECT");
-                m_state = IDLE;
+            RescueAggregationTag aggTag;
+            if (pkt->RemovePacketTag(aggTag)) {
+                //AGGREGATED TRANSMISSION - process each subframe separately
+                NS_LOG_INFO("AGGREGATED FRAME, subframes: " << aggTag.GetNSubframes());
+                bool correctSubframe = false;
+                m_rxAggregate = true;
+                for (uint16_t i = 0; i < aggTag.GetNSubframes(); i++) {
+                    RescueAggregationHeader delimiter;
+                    Ptr<Packet> delimiterPkt = pkt->CreateFragment(0, delimiter.GetSerializedSize());
+                    pkt->RemoveHeader(delimiter);
+                    Ptr<Packet> subframe = pkt->CreateFragment(0, delimiter.GetLength());
+                    pkt->RemoveAtStart(delimiter.GetLength());
+                    RestorePacketTags(delimiterPkt, subframe);
+
+                    correctSubframe = ReceiveFrameDone(subframe, mode, sinr, noiseW, correctPreamble) || correctSubframe;
+                }
+                m_rxAggregate = false;
+                if (correctSubframe)
+                    return;
+            } else if (ReceiveFrameDone(pkt, mode, sinr, noiseW, correctPreamble)) {
+                return;
+            }
+        } else if (!m_csBusy) {
+            RescuePhyHeader hdr;
+            pkt->RemoveHeader(hdr);
+            m_lowMac->ReceivePacketDone(this, pkt, hdr, sinr, mode, false, false, false); //to notify unusable frame
+        }
 
-                NS_LOG_FUNCTION("src:" << hdr.GetSource() <<
-                        "sender:" << hdr.GetSender() <<
-                        "dst:" << hdr.GetDestination() <<
-                        "seq:" << hdr.GetSequence());
+        if (!m_csBusy) // set MAC state IDLE
+        {
+            m_state = IDLE;
+        }
+    }
 
-                if (hdr.GetType() != RESCUE_PHY_PKT_TYPE_DATA) //CONTROL FRAME - no payload processing
-                {
-                    m_lowMac->ReceivePacketDone(this, pkt, hdr, sinr, mode, true, true, false);
-                } else //PER (and SNR?) tag must be updated
-                {
-                    SnrPerTag tag;
-                    double prev_ber = (pkt->PeekPacketTag(tag) ? tag.GetBER() : 0); //packet (payload) bit error rate
-                    double snr = (pkt->PeekPacketTag(tag) ? tag.GetSNR() : (m_txPower - m_channel->WToDbm(noiseW))); //packet SNR (if not recorded, use maximal possible value)
-                    NS_LOG_DEBUG("BER from previous hops: " << prev_ber << ", min SNR on route: " << snr);
-
-                    std::vector<double> linkBER;
-                    linkBER.push_back(prev_ber);
-                    double current_ber = BlackBox_no1::CalculateRescueBitErrorRate(snr_db, linkBER,
-                            mode.GetConstellationSize(),
-                            mode.GetSpectralEfficiency());
-                    NS_LOG_DEBUG("BER after last hop (from BlackBox_no1): " << current_ber);
+    bool
+    RescuePhy::ReceiveFrameDone(Ptr<Packet> pkt, RescueMode mode, double sinr, double noiseW, bool correctPreamble) {
+        NS_LOG_FUNCTION("sinr:" << sinr << "size:" << pkt->GetSize());
 
-                    //NS_LOG_DEBUG ("data rate: " << mode.GetDataRate () << " phy rate: " << mode.GetPhyRate () << " constellation size: " << (int)mode.GetConstellationSize () << " spectralEfficiency: " << mode.GetSpectralEfficiency ());
+        RescuePhyHeader hdr;
+        pkt->RemoveHeader(hdr);
 
-                    if (hdr.GetDestination() != m_mac->GetAddress()) //RELAY THIS FRAME? - no payload processing but PER tag must be updated
-                    {
-                        //update packet tag
-                        tag.SetSNR(Min(sinr, snr)); //not shure what to do - store minimal snr?!?
-                        tag.SetBER(current_ber);
-                        pkt->ReplacePacketTag(tag);
+        std::vector<double> snr_db;
+        std::vector<double> linkPER;
+        snr_db.push_back(sinr);
+        linkPER.push_back(0.0);
 
-                        if (m_useLOTF) //LOTF used, is the BER sufficient?
-                        {
-                            correct = (current_ber <= m_berThr);
-                            NS_LOG_INFO("FRAME " << (correct ? "CORRECT" : "DAMAGED") << " [because ber <= m_berThr]");
-                        } else //no LOTF, is the payload correct
-                        {
-                            correct = (0 == (BlackBox_no2::CalculateRescueBitErrorNumber(snr_db, linkBER,
-                                    mode.GetConstellationSize(),
-                                    mode.GetSpectralEfficiency(),
-                                    8 * pkt->GetSize())));
-                            NS_LOG_INFO("FRAME " << (correct ? "CORRECT" : "DAMAGED") << " [BlackBox_no2 " << (correct ? "does not detect" : "detects") << " errors]");
-                        }
+        //Check if number of errors in PHY header is equal to 0
+        const RescueModeDescriptor &hdrMode = GetPhyHeaderMode(mode).GetDescriptor();
+        bool correct = (correctPreamble && (0 == (BlackBox_no2::CalculateRescueBitErrorNumber(snr_db, linkPER,
+                hdrMode.constellationSize,
+                hdrMode.spectralEfficiency,
+                8 * hdr.GetSize()))));
+
+        NS_LOG_DEBUG("mode=" << mode <<
+                ", snr=" << sinr <<
+                ", size=" << pkt->GetSize());
+
+        if (correct) //is the PHY header complete
+        {
+            //PHY HEADER CORRECTLY RECEIVED
+            NS_LOG_INFO("PHY HDR CORRECT");
+            m_state = IDLE;
+
+            NS_LOG_FUNCTION("src:" << hdr.GetSource() <<
+                    "sender:" << hdr.GetSender() <<
+                    "dst:" << hdr.GetDestination() <<
+                    "seq:" << hdr.GetSequence());
+
+            if (hdr.GetType() != RESCUE_PHY_PKT_TYPE_DATA) //CONTROL FRAME - no payload processing
+            {
+                m_lowMac->ReceivePacketDone(this, pkt, hdr, sinr, mode, true, true, false);
+            } else //PER (and SNR?) tag must be updated
+            {
+                SnrPerTag tag;
+                double prev_ber = (pkt->PeekPacketTag(tag) ? tag.GetBER() : 0); //packet (payload) bit error rate
+                double snr = ((pkt->PeekPacketTag(tag) && tag.IsSNRValid()) ? tag.GetSNR() : (m_txPower - m_channel->WToDbm(noiseW))); //packet SNR (if not recorded, use maximal possible value)
+                NS_LOG_DEBUG("BER from previous hops: " << prev_ber << ", min SNR on route: " << snr);
+
+                std::vector<double> linkBER;
+                linkBER.push_back(prev_ber);
+                double current_ber = BlackBox_no1::CalculateRescueBitErrorRate(snr_db, linkBER,
+                        mode.GetConstellationSize(),
+                        mode.GetSpectralEfficiency());
+                NS_LOG_DEBUG("BER after last hop (from BlackBox_no1): " << current_ber);
+
+                //NS_LOG_DEBUG ("data rate: " << mode.GetDataRate () << " phy rate: " << mode.GetPhyRate () << " constellation size: " << (int)mode.GetConstellationSize () << " spectralEfficiency: " << mode.GetSpectralEfficiency ());
 
-                        m_lowMac->ReceivePacketDone(this, pkt, hdr,
-                                sinr, mode, true,
-                                correct,
-                                false); //(ber < BER THRESHOLD) - inform MAC about BER - not forward if BER > BER THRESHOLD - unusable frame
-                    } else //DATA FRAME DESTINED FOR THIS DEVICE
+                if (hdr.GetDestination() != m_mac->GetAddress()) //RELAY THIS FRAME? - no payload processing but PER tag must be updated
+                {
+                    //update packet tag
+                    tag.SetSNR(Min(sinr, snr)); //not shure what to do - store minimal snr?!?
+                    tag.SetBER(current_ber);
+                    pkt->ReplacePacketTag(tag);
+
+                    if (m_useLOTF) //LOTF used, is the BER sufficient?
+                    {
+                        correct = (current_ber <= m_berThr);
+                        NS_LOG_INFO("FRAME " << (correct ? "CORRECT" : "DAMAGED") << " [because ber <= m_berThr]");
+                    } else //no LOTF, is the payload correct
                     {
-                        //is the payload complete?
                         correct = (0 == (BlackBox_no2::CalculateRescueBitErrorNumber(snr_db, linkBER,
                                 mode.GetConstellationSize(),
                                 mode.GetSpectralEfficiency(),
                                 8 * pkt->GetSize())));
                         NS_LOG_INFO("FRAME " << (correct ? "CORRECT" : "DAMAGED") << " [BlackBox_no2 " << (correct ? "does not detect" : "detects") << " errors]");
+                    }
 
-                        if (correct) {
-                            //no errors - just forward up
-                            RemoveFrameCopies(hdr);
-                            m_lowMac->ReceivePacketDone(this, pkt, hdr, sinr, mode, true, true, false);
-                        } else if ((m_useLOTF)
-                                && (current_ber <= m_berThr)) //BER > BER THRESHOLD - unusable frame
+                    m_lowMac->ReceivePacketDone(this, pkt, hdr,
+                            sinr, mode, true,
+                            correct,
+                            false); //(ber < BER THRESHOLD) - inform MAC about BER - not forward if BER > BER THRESHOLD - unusable frame
+                } else //DATA FRAME DESTINED FOR THIS DEVICE
+                {
+                    //is the payload complete?
+                    correct = (0 == (BlackBox_no2::CalculateRescueBitErrorNumber(snr_db, linkBER,
+                            mode.GetConstellationSize(),
+                            mode.GetSpectralEfficiency(),
+                            8 * pkt->GetSize())));
+                    NS_LOG_INFO("FRAME " << (correct ? "CORRECT" : "DAMAGED") << " [BlackBox_no2 " << (correct ? "does not detect" : "detects") << " errors]");
+
+                    if (correct) {
+                        //no errors - just forward up
+                        RemoveFrameCopies(hdr);
+                        m_lowMac->ReceivePacketDone(this, pkt, hdr, sinr, mode, true, true, false);
+                    } else if ((m_useLOTF)
+                            && (current_ber <= m_berThr)) //BER > BER THRESHOLD - unusable frame
+                    {
+                        NS_LOG_INFO("PHY HDR OK!, DATA: DAMAGED!");
+                        if (AddFrameCopy(pkt, hdr, sinr, prev_ber, mode)) //STOR FRAME COPY - check: is it the first one?
                         {
-                            NS_LOG_INFO("PHY HDR OK!, DATA: DAMAGED!");
-                            if (AddFrameCopy(pkt, hdr, sinr, prev_ber, mode)) //STOR FRAME COPY - check: is it the first one?
-                            {
-                                //it is NOT first copy - try to restore data using previously stored frame copies and notify
-                                m_lowMac->ReceivePacketDone(this, pkt, hdr, sinr, mode, true, IsRestored(hdr), true);
-                            } else {
-                                //it is first copy - just notify MAC
-                                m_lowMac->ReceivePacketDone(this, pkt, hdr, sinr, mode, true, false, true);
-                            }
+                            //it is NOT first copy - try to restore data using previously stored frame copies and notify
+                            m_lowMac->ReceivePacketDone(this, pkt, hdr, sinr, mode, true, IsRestored(hdr), true);
                         } else {
-                            NS_LOG_INFO("PHY HDR OK!, DATA: UNUSABLE (BER >=" << m_berThr << ") - DROP IT!");
+                            //it is first copy - just notify MAC
+                            m_lowMac->ReceivePacketDone(this, pkt, hdr, sinr, mode, true, false, true);
                         }
+                    } else {
+                        NS_LOG_INFO("PHY HDR OK!, DATA: UNUSABLE (BER >=" << m_berThr << ") - DROP IT!");
                     }
                 }
-                return;
-            } else {
-                //to notify unusable frame
-                m_lowMac->ReceivePacketDone(this, pkt, hdr, sinr, mode, false, false, false);
-                NS_LOG_INFO("PHY HDR DAMAGED!");
             }
-        } else if (!m_csBusy) {
-            RescuePhyHeader hdr;
-            pkt->RemoveHeader(hdr);
-            m_lowMac->ReceivePacketDone(this, pkt, hdr, sinr, mode, false, false, false); //to notify unusable frame
-        }
-
-        if (!m_csBusy) // set MAC state IDLE
-        {
-            m_state = IDLE;
+            return true;
+        } else {
+            //to notify unusable frame
+            m_lowMac->ReceivePacketDone(this, pkt, hdr, sinr, mode, false, false, false);
+            NS_LOG_INFO("PHY HDR DAMAGED!");
+            return false;
         }
     }
 
@@ -663,6 +940,11 @@ namespace ns3 {
         return false;
     }
 
+    bool
+    RescuePhy::IsReceivingAggregate(void) const {
+        return m_rxAggregate;
+    }
+
     Time
     RescuePhy::CalTxDuration(uint32_t basicSize, uint32_t dataSize, RescueMode basicMode, RescueMode dataMode, uint16_t type, bool centralised) {
         NS_LOG_FUNCTION("basicSize: " << basicSize << "dataSize: " << dataSize << "basicMode: " << basicMode << "dataMode: " << dataMode << "type:" << type << "centralised: " << (centralised ? "YES" : "NO"));
@@ -670,8 +952,8 @@ namespace ns3 {
         RescuePhyHeader hdr = RescuePhyHeader(type);
         centralised ? hdr.SetCentralisedMacProtocol() : hdr.SetDistributedMacProtocol();
         NS_LOG_FUNCTION("hdr size: " << hdr.GetSize());
-        double_t txHdrTime = (double) (hdr.GetSize() + basicSize) * 8.0 / basicMode.GetDataRate();
-        double_t txMpduTime = (double) (dataSize + m_trailerSize) * 8.0 / dataMode.GetDataRate();
+        double_t txHdrTime = (double) (hdr.GetSize() + basicSize) * 8.0 / basicMode.GetDescriptor().dataRate;
+        double_t txMpduTime = (double) (dataSize + m_trailerSize) * 8.0 / dataMode.GetDescriptor().dataRate;
         return m_preambleDuration + Seconds(txHdrTime) + Seconds(txMpduTime);
     }
 
@@ -679,11 +961,32 @@ namespace ns3 {
     RescuePhy::CalTxDuration(uint32_t basicSize, uint32_t dataSize, RescueMode basicMode, RescueMode dataMode) {
         NS_LOG_FUNCTION("basicSize: " << basicSize << "dataSize: " << dataSize << "basicMode: " << basicMode << "dataMode: " << dataMode);
         //for TX time calculation when PhyHdr is alreade constructed
-        double_t txHdrTime = (double) basicSize * 8.0 / basicMode.GetDataRate();
-        double_t txMpduTime = (double) (dataSize + m_trailerSize) * 8.0 / dataMode.GetDataRate();
+        double_t txHdrTime = (double) basicSize * 8.0 / basicMode.GetDescriptor().dataRate;
+        double_t txMpduTime = (double) (dataSize + m_trailerSize) * 8.0 / dataMode.GetDescriptor().dataRate;
         return m_preambleDuration + Seconds(txHdrTime) + Seconds(txMpduTime);
     }
 
+    Time
+    RescuePhy::CalTxDuration(std::list<std::pair<Ptr<Packet>, RescuePhyHeader> > aggregate, RescueMode mode) {
+        NS_LOG_FUNCTION("subframes: " << aggregate.size() << "dataMode: " << mode);
+        //preamble is transmitted only once for the whole aggregate
+        Time txDuration = m_preambleDuration;
+        for (std::list<std::pair<Ptr<Packet>, RescuePhyHeader> >::iterator it = aggregate.begin(); it != aggregate.end(); it++) {
+            txDuration += CalSubframeTxDuration(it->second.GetSize(), it->first->GetSize(),
+                    GetPhyHeaderMode(mode), mode);
+        }
+        return txDuration;
+    }
+
+    Time
+    RescuePhy::CalSubframeTxDuration(uint32_t basicSize, uint32_t dataSize, RescueMode basicMode, RescueMode dataMode) {
+        NS_LOG_FUNCTION("basicSize: " << basicSize << "dataSize: " << dataSize << "basicMode: " << basicMode << "dataMode: " << dataMode);
+        //delimiter and PHY header are sent with basic mode, no preamble
+        double_t txHdrTime = (double) (RescueAggregationHeader().GetSerializedSize() + basicSize) * 8.0 / basicMode.GetDescriptor().dataRate;
+        double_t txMpduTime = (double) (dataSize + m_trailerSize) * 8.0 / dataMode.GetDescriptor().dataRate;
+        return Seconds(txHdrTime) + Seconds(txMpduTime);
+    }
+
     int64_t
     RescuePhy::AssignStreams(int64_t stream) {
         NS_LOG_FUNCTION(this << stream);
@@ -27,6 +27,8 @@
 #include "ns3/event-id.h"
 #include "ns3/random-variable-stream.h"
 
+#include <list>
+
 #include "rescue-mac.h"
 #include "low-rescue-mac.h"
 //#include "rescue-mac-csma.h"
@@ -141,6 +143,15 @@ namespace ns3 {
          * \return true if transmission was started
          */
         bool SendPacket(std::pair<Ptr<Packet>, RescuePhyHeader> relayedPkt, RescueMode mode);
+        /**
+         * Invoked to start AGGREGATED frame transmission - all subframes are sent
+         * in one PHY transmission (one preamble), each of them keeps its own PHY header
+         *
+         * \param aggregate list of packets for transmission and associated PHY headers
+         * \param mode the transmission mode to use to send these packets
+         * \return true if transmission was started
+         */
+        bool SendPacket(std::list<std::pair<Ptr<Packet>, RescuePhyHeader> > aggregate, RescueMode mode);
         /**
          * This method is called to end frame transmission
          *
@@ -169,6 +180,10 @@ namespace ns3 {
          * \return true if PHY is idle
          */
         bool IsIdle();
+        /**
+         * \return true while the subframes of aggregated transmission are passed to MAC
+         */
+        bool IsReceivingAggregate(void) const;
         /**
          * Used for TX time calculation when PhyHdr is not constructed yet
          *
@@ -192,6 +207,26 @@ namespace ns3 {
          *          the transmission of these bytes.
          */
         Time CalTxDuration(uint32_t basicSize, uint32_t dataSize, RescueMode basicMode, RescueMode dataMode);
+        /**
+         * Used for TX time calculation of aggregated transmission
+         *
+         * \param aggregate list of packets and associated PHY headers
+         * \param mode the data TX mode (RescueMode)
+         * \return the total amount of time this PHY will stay busy for
+         *          the transmission of all subframes.
+         */
+        Time CalTxDuration(std::list<std::pair<Ptr<Packet>, RescuePhyHeader> > aggregate, RescueMode mode);
+        /**
+         * Used for TX time calculation of a single subframe of aggregated transmission
+         * (subframe delimiter and PHY header included, preamble excluded)
+         *
+         * \param basicSize the number of bytes to send with basic mode (usually PHY header size)
+         * \param dataSize the number of bytes in the packet to send with data rate (payload size)
+         * \param basicMode the basic TX mode (RescueMode)
+         * \param dataMode the data TX mode (RescueMode)
+         * \return the amount of time added to aggregated transmission by this subframe
+         */
+        Time CalSubframeTxDuration(uint32_t basicSize, uint32_t dataSize, RescueMode basicMode, RescueMode dataMode);
 
         /**
          * \param mode data TX mode (RescueMode)
@@ -287,6 +322,18 @@ namespace ns3 {
          */
         double CalculateCI(double prevCI, double llr, uint32_t symbols);
 
+        /**
+         * Processes the end of single frame reception (also used for each subframe
+         * of aggregated transmission). Return true if PHY header was correctly received.
+         *
+         * \param pkt the received packet (including PHY header)
+         * \param mode the transmission mode of the received packet
+         * \param sinr signal-to-noise/interference ratio of received frame in dB
+         * \param noiseW noise plus interference in W
+         * \param correctPreamble true if the preamble was correctly received
+         * \return true if PHY header was correctly received
+         */
+        bool ReceiveFrameDone(Ptr<Packet> pkt, RescueMode mode, double sinr, double noiseW, bool correctPreamble);
         /**
          * Removes stored fram copies.
          *
@@ -338,6 +385,7 @@ namespace ns3 {
         Time m_csBusyEnd; //!< Expected time when channel become idle
         bool m_rxBusy; //!< Busy channel indicator (true = channel busy)
         Time m_rxBusyEnd; //!< Expected time when channel become idle
+        bool m_rxAggregate; //!< True while the subframes of aggregated transmission are passed to MAC
 
         Ptr<Packet> m_pktRx; //!< Currently received packet
 
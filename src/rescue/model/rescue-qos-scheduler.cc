@@ -0,0 +1,178 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 AGH Univeristy of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+
+#include "ns3/log.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/assert.h"
+
+#include "rescue-qos-scheduler.h"
+#include "rescue-qos-tag.h"
+
+#include <algorithm>
+
+NS_LOG_COMPONENT_DEFINE("RescueQosScheduler");
+
+namespace ns3 {
+
+    NS_OBJECT_ENSURE_REGISTERED(RescueQosScheduler);
+
+    TypeId
+    RescueQosScheduler::GetTypeId(void) {
+        static TypeId tid = TypeId("ns3::RescueQosScheduler")
+                .SetParent<Object> ()
+                .AddConstructor<RescueQosScheduler> ()
+                .AddAttribute("Policy",
+                "The policy used to select the traffic class to serve",
+                EnumValue(RescueQosScheduler::STRICT_PRIORITY),
+                MakeEnumAccessor(&RescueQosScheduler::m_policy),
+                MakeEnumChecker(RescueQosScheduler::STRICT_PRIORITY, "StrictPriority",
+                RescueQosScheduler::WFQ, "Wfq"))
+                .AddAttribute("NClasses",
+                "The number of traffic classes",
+                UintegerValue(2),
+                MakeUintegerAccessor(&RescueQosScheduler::SetNClasses,
+                &RescueQosScheduler::GetNClasses),
+                MakeUintegerChecker<uint8_t> (1))
+                ;
+        return tid;
+    }
+
+    RescueQosScheduler::RescueQosScheduler()
+    : m_policy(STRICT_PRIORITY),
+    m_virtualTime(0) {
+        NS_LOG_FUNCTION("");
+        SetNClasses(2);
+    }
+
+    RescueQosScheduler::~RescueQosScheduler() {
+        NS_LOG_FUNCTION("");
+    }
+
+    void
+    RescueQosScheduler::SetNClasses(uint8_t n) {
+        NS_LOG_FUNCTION("classes:" << (uint32_t) n);
+        NS_ASSERT(n > 0);
+        ClassParameters params;
+        params.cwMin = 0;
+        params.cwMax = 0;
+        params.lifs = Seconds(0);
+        params.queueLimit = 0;
+        params.weight = 1.0;
+        m_classes.resize(n, params);
+        m_finish.resize(n, m_virtualTime);
+    }
+
+    uint8_t
+    RescueQosScheduler::GetNClasses(void) const {
+        return m_classes.size();
+    }
+
+    void
+    RescueQosScheduler::SetClassParameters(uint8_t tc, uint32_t cwMin, uint32_t cwMax, Time lifs, uint32_t queueLimit, double weight) {
+        NS_LOG_FUNCTION("tc:" << (uint32_t) tc << "cwMin:" << cwMin << "cwMax:" << cwMax <<
+                "lifs:" << lifs << "queue limit:" << queueLimit << "weight:" << weight);
+        if (tc >= m_classes.size())
+            NS_FATAL_ERROR("Traffic class " << (uint32_t) tc << " not configured (NClasses = " << m_classes.size() << ")");
+        NS_ASSERT(weight > 0);
+        m_classes[tc].cwMin = cwMin;
+        m_classes[tc].cwMax = cwMax;
+        m_classes[tc].lifs = lifs;
+        m_classes[tc].queueLimit = queueLimit;
+        m_classes[tc].weight = weight;
+    }
+
+    uint8_t
+    RescueQosScheduler::Classify(Ptr<const Packet> pkt) const {
+        RescueQosTag tag;
+        if (pkt->PeekPacketTag(tag))
+            return std::min<uint32_t> (tag.GetTrafficClass(), m_classes.size() - 1);
+        return 0;
+    }
+
+    uint8_t
+    RescueQosScheduler::Classify(Ptr<const Packet> pkt, const RescuePhyHeader &phyHdr) const {
+        RescueQosTag tag;
+        if (pkt->PeekPacketTag(tag))
+            return std::min<uint32_t> (tag.GetTrafficClass(), m_classes.size() - 1);
+        return (phyHdr.IsQosEnabled() ? m_classes.size() - 1 : 0);
+    }
+
+    uint32_t
+    RescueQosScheduler::GetCw(uint8_t tc, uint32_t cw) const {
+        NS_ASSERT(tc < m_classes.size());
+        if (m_classes[tc].cwMin != 0)
+            cw = std::max(cw, m_classes[tc].cwMin);
+        if (m_classes[tc].cwMax != 0)
+            cw = std::min(cw, m_classes[tc].cwMax);
+        return cw;
+    }
+
+    Time
+    RescueQosScheduler::GetLifs(uint8_t tc, Time lifs) const {
+        NS_ASSERT(tc < m_classes.size());
+        return (m_classes[tc].lifs != Seconds(0) ? m_classes[tc].lifs : lifs);
+    }
+
+    uint32_t
+    RescueQosScheduler::GetQueueLimit(uint8_t tc, uint32_t queueLimit) const {
+        NS_ASSERT(tc < m_classes.size());
+        return (m_classes[tc].queueLimit != 0 ? m_classes[tc].queueLimit : queueLimit);
+    }
+
+    bool
+    RescueQosScheduler::GetNextClass(const std::vector<uint32_t> &heads, uint8_t &tc) const {
+        NS_ASSERT(heads.size() == m_classes.size());
+        bool found = false;
+        double minFinish = 0;
+
+        //iterate from the highest class, so ties are resolved in favour of higher priority
+        for (int c = heads.size() - 1; c >= 0; c--) {
+            if (heads[c] == 0)
+                continue;
+            if (m_policy == STRICT_PRIORITY) {
+                tc = c;
+                return true;
+            }
+            double finish = GetFinishTime(c, heads[c]);
+            if (!found || finish < minFinish) {
+                minFinish = finish;
+                tc = c;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    void
+    RescueQosScheduler::NotifyTxStart(uint8_t tc, uint32_t size) {
+        NS_LOG_FUNCTION("tc:" << (uint32_t) tc << "size:" << size);
+        NS_ASSERT(tc < m_classes.size());
+        double finish = GetFinishTime(tc, size);
+        m_finish[tc] = finish;
+        m_virtualTime = finish;
+    }
+
+    double
+    RescueQosScheduler::GetFinishTime(uint8_t tc, uint32_t size) const {
+        return std::max(m_virtualTime, m_finish[tc]) + size / m_classes[tc].weight;
+    }
+
+} // namespace ns3
@@ -0,0 +1,152 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 AGH Univeristy of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+
+#ifndef RESCUE_QOS_SCHEDULER_H
+#define RESCUE_QOS_SCHEDULER_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+
+#include "rescue-phy-header.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+    /**
+     * \ingroup rescue
+     *
+     * Schedules DATA frames (relayed, retransmitted and originated) of different
+     * traffic classes queued in lower MAC (CSMA and TDMA). ACK and control frames
+     * are always served first, independently of the scheduler. Higher traffic class
+     * means higher priority. The traffic class of a frame is read from RescueQosTag,
+     * for relayed frames without the tag the QoS flag of PHY header is used
+     * (set flag maps to the highest class).
+     *
+     * Each class may have its own contention parameters (CWmin, CWmax, LIFS) and queue
+     * limit (EDCA-like); zero values mean that the setting of lower MAC is used.
+     */
+    class RescueQosScheduler : public Object {
+    public:
+
+        enum Policy {
+            STRICT_PRIORITY, //!< always serve the highest backlogged class
+            WFQ //!< weighted fair queuing (self-clocked) between backlogged classes
+        };
+
+        static TypeId GetTypeId(void);
+
+        RescueQosScheduler();
+        virtual ~RescueQosScheduler();
+
+        /**
+         * \param n the number of traffic classes
+         */
+        void SetNClasses(uint8_t n);
+        /**
+         * \return the number of traffic classes
+         */
+        uint8_t GetNClasses(void) const;
+
+        /**
+         * \param tc the traffic class to configure
+         * \param cwMin the minimal contention window of this class (0 - use MAC setting)
+         * \param cwMax the maximal contention window of this class (0 - use MAC setting)
+         * \param lifs the LIFS duration of this class (0 - use MAC setting)
+         * \param queueLimit the maximal number of queued DATA frames of this class (0 - use MAC setting)
+         * \param weight the WFQ weight of this class
+         */
+        void SetClassParameters(uint8_t tc, uint32_t cwMin, uint32_t cwMax, Time lifs, uint32_t queueLimit, double weight);
+
+        /**
+         * \param pkt the originated (or retransmitted) DATA frame
+         * \return the traffic class of this frame
+         */
+        uint8_t Classify(Ptr<const Packet> pkt) const;
+        /**
+         * \param pkt the relayed DATA frame
+         * \param phyHdr the PHY header associated with this frame
+         * \return the traffic class of this frame
+         */
+        uint8_t Classify(Ptr<const Packet> pkt, const RescuePhyHeader &phyHdr) const;
+
+        /**
+         * \param tc the traffic class
+         * \param cw the contention window selected by MAC / remote station manager
+         * \return the contention window limited to the bounds of this class
+         */
+        uint32_t GetCw(uint8_t tc, uint32_t cw) const;
+        /**
+         * \param tc the traffic class
+         * \param lifs the LIFS duration of MAC
+         * \return the LIFS duration of this class
+         */
+        Time GetLifs(uint8_t tc, Time lifs) const;
+        /**
+         * \param tc the traffic class
+         * \param queueLimit the queue limit of MAC
+         * \return the maximal number of queued DATA frames of this class
+         */
+        uint32_t GetQueueLimit(uint8_t tc, uint32_t queueLimit) const;
+
+        /**
+         * Selects the class to serve (does not change the scheduler state)
+         *
+         * \param heads the size of head-of-line frame of each class (0 - class not backlogged)
+         * \param tc the selected traffic class
+         * \return true if any class is backlogged
+         */
+        bool GetNextClass(const std::vector<uint32_t> &heads, uint8_t &tc) const;
+        /**
+         * Invoked by MAC when the frame of the given class is dequeued for transmission
+         *
+         * \param tc the traffic class
+         * \param size the size of transmitted frame
+         */
+        void NotifyTxStart(uint8_t tc, uint32_t size);
+
+    private:
+
+        struct ClassParameters {
+            uint32_t cwMin; //!< Minimal contention window (0 - MAC setting)
+            uint32_t cwMax; //!< Maximal contention window (0 - MAC setting)
+            Time lifs; //!< LIFS duration (0 - MAC setting)
+            uint32_t queueLimit; //!< Queue limit (0 - MAC setting)
+            double weight; //!< WFQ weight
+        };
+
+        /**
+         * \param tc the traffic class
+         * \param size the size of head-of-line frame
+         * \return the virtual finish time of this frame
+         */
+        double GetFinishTime(uint8_t tc, uint32_t size) const;
+
+        Policy m_policy; //!< Scheduling policy
+        std::vector<ClassParameters> m_classes; //!< Parameters of traffic classes
+        std::vector<double> m_finish; //!< Virtual finish time of last served frame of each class (WFQ)
+        double m_virtualTime; //!< Current virtual time (WFQ)
+    };
+
+} // namespace ns3
+
+#endif /* RESCUE_QOS_SCHEDULER_H */
@@ -0,0 +1,87 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 AGH Univeristy of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+
+#include "rescue-qos-tag.h"
+#include "ns3/tag.h"
+#include "ns3/uinteger.h"
+
+namespace ns3 {
+
+    NS_OBJECT_ENSURE_REGISTERED(RescueQosTag)
+    ;
+
+    TypeId
+    RescueQosTag::GetTypeId(void) {
+        static TypeId tid = TypeId("ns3::RescueQosTag")
+                .SetParent<Tag> ()
+                .AddConstructor<RescueQosTag> ()
+                .AddAttribute("TrafficClass", "The traffic class of the packet",
+                UintegerValue(0),
+                MakeUintegerAccessor(&RescueQosTag::GetTrafficClass),
+                MakeUintegerChecker<uint8_t> ())
+                ;
+        return tid;
+    }
+
+    TypeId
+    RescueQosTag::GetInstanceTypeId(void) const {
+        return GetTypeId();
+    }
+
+    RescueQosTag::RescueQosTag()
+    : m_tc(0) {
+    }
+
+    RescueQosTag::RescueQosTag(uint8_t tc)
+    : m_tc(tc) {
+    }
+
+    uint32_t
+    RescueQosTag::GetSerializedSize(void) const {
+        return sizeof (uint8_t);
+    }
+
+    void
+    RescueQosTag::Serialize(TagBuffer i) const {
+        i.WriteU8(m_tc);
+    }
+
+    void
+    RescueQosTag::Deserialize(TagBuffer i) {
+        m_tc = i.ReadU8();
+    }
+
+    void
+    RescueQosTag::Print(std::ostream &os) const {
+        os << "tc=" << (uint32_t) m_tc;
+    }
+
+    void
+    RescueQosTag::SetTrafficClass(uint8_t tc) {
+        m_tc = tc;
+    }
+
+    uint8_t
+    RescueQosTag::GetTrafficClass(void) const {
+        return m_tc;
+    }
+
+
+}
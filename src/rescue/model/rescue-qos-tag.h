@@ -0,0 +1,79 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 AGH Univeristy of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+
+#ifndef RESCUE_QOS_TAG_H
+#define RESCUE_QOS_TAG_H
+
+#include "ns3/packet.h"
+
+namespace ns3 {
+
+    class Tag;
+
+    /**
+     * \ingroup rescue
+     * \brief Tag keeping the traffic class of a given frame
+     *
+     * The tag should be attached to the packet by the application (before
+     * it is passed to RescueNetDevice). Higher traffic class means higher priority.
+     */
+
+    class RescueQosTag : public Tag {
+    public:
+        static TypeId GetTypeId(void);
+        virtual TypeId GetInstanceTypeId(void) const;
+
+        /**
+         * Create a RescueQosTag with the default traffic class = 0 (best effort)
+         */
+        RescueQosTag();
+
+        /**
+         * Create a RescueQosTag with the given traffic class
+         * \param tc the given traffic class
+         */
+        RescueQosTag(uint8_t tc);
+
+        /**
+         * Set the traffic class to the given value.
+         *
+         * \param tc the value of the traffic class to set
+         */
+        void SetTrafficClass(uint8_t tc);
+        /**
+         * Return the traffic class.
+         *
+         * \return the traffic class
+         */
+        uint8_t GetTrafficClass(void) const;
+
+        // Inherrited methods
+        virtual uint32_t GetSerializedSize(void) const;
+        virtual void Serialize(TagBuffer i) const;
+        virtual void Deserialize(TagBuffer i);
+        virtual void Print(std::ostream &os) const;
+
+    private:
+        uint8_t m_tc; //!< traffic class
+    };
+
+
+}
+#endif /* RESCUE_QOS_TAG_H */
@@ -25,6 +25,7 @@
 #include "ns3/boolean.h"
 #include "ns3/double.h"
 #include "ns3/uinteger.h"
+#include "ns3/nstime.h"
 #include "ns3/trace-source-accessor.h"
 
 #include "rescue-remote-station-manager.h"
@@ -32,6 +33,10 @@
 #include "rescue-mac.h"
 #include "rescue-mac-header.h"
 
+#include <algorithm>
+
+#define STATION_STATE_BLOCK 16 //number of remote station states allocated at once
+
 NS_LOG_COMPONENT_DEFINE("RescueRemoteStationManager");
 
 #undef NS_LOG_APPEND_CONTEXT
@@ -155,6 +160,11 @@ namespace ns3 {
                 RescueModeValue(),
                 MakeRescueModeAccessor(&RescueRemoteStationManager::m_nonUnicastMode),
                 MakeRescueModeChecker())
+                .AddAttribute("StationAgingTime", "The time after which the state of a remote station which is not used"
+                " is removed (0 - stations are never removed).",
+                TimeValue(Seconds(0)),
+                MakeTimeAccessor(&RescueRemoteStationManager::m_stationAgingTime),
+                MakeTimeChecker())
                 /*.AddTraceSource ("MacTxDataFailed",
                                  "The transmission of a data packet by the MAC layer has failed",
                                  MakeTraceSourceAccessor (&RescueRemoteStationManager::m_macTxDataFailed))
@@ -165,7 +175,8 @@ namespace ns3 {
         return tid;
     }
 
-    RescueRemoteStationManager::RescueRemoteStationManager() {
+    RescueRemoteStationManager::RescueRemoteStationManager()
+    : m_lastAging(Seconds(0)) {
     }
 
     RescueRemoteStationManager::~RescueRemoteStationManager() {
@@ -174,14 +185,16 @@ namespace ns3 {
     void
     RescueRemoteStationManager::DoDispose(void) {
         NS_LOG_FUNCTION("");
-        for (StationStates::const_iterator i = m_states.begin(); i != m_states.end(); i++) {
-            delete (*i);
+        for (uint32_t i = 0; i < m_table.GetCapacity(); i++) {
+            RescueStationTable::Entry *entry = m_table.GetEntry(i);
+            if (entry != 0)
+                delete entry->station;
         }
-        m_states.clear();
-        for (Stations::const_iterator i = m_stations.begin(); i != m_stations.end(); i++) {
-            delete (*i);
-        }
-        m_stations.clear();
+        m_table.Clear();
+        for (std::vector<RescueRemoteStationState *>::const_iterator i = m_stateBlocks.begin(); i != m_stateBlocks.end(); i++)
+            delete [] (*i);
+        m_stateBlocks.clear();
+        m_freeStates.clear();
     }
 
     void
@@ -371,12 +384,13 @@ namespace ns3 {
     }
 
     void
-    RescueRemoteStationManager::ReportDataOk(Mac48Address address, double ackSnr, RescueMode ackMode, double dataSnr, double dataPer, uint32_t retryCounter) {
+    RescueRemoteStationManager::ReportDataOk(Mac48Address address, double ackSnr, RescueMode ackMode, double dataSnr, bool dataSnrValid, double dataPer, uint32_t retryCounter) {
         NS_ASSERT(!address.IsGroup());
         RescueRemoteStation *station = Lookup(address);
-        station->m_state->m_info.NotifyTxSuccess(retryCounter);
+        //SNR stored in ACK (SnrPerTag) is the minimal SNR of DATA route (if recorded)
+        station->m_state->m_info.NotifyTxSuccessSNR(retryCounter, dataSnrValid ? std::min(ackSnr, dataSnr) : ackSnr);
         //station->m_src = 0;
-        DoReportDataOk(station, ackSnr, ackMode, dataSnr, dataPer);
+        DoReportDataOk(station, ackSnr, ackMode, dataSnr, dataSnrValid, dataPer);
     }
 
     void
@@ -391,13 +405,14 @@ namespace ns3 {
 
     void
     RescueRemoteStationManager::ReportRxOk(Mac48Address senderAddress, Mac48Address sourceAddress,
-            double rxSnr, RescueMode txMode, bool wasReconstructed) {
+            double rxSnr, RescueMode txMode, bool wasReconstructed, double rxBer, bool rxBerValid) {
         /*if (address.IsGroup ())
           {
             return;
           }*/
         RescueRemoteStation *senderStation = Lookup(senderAddress);
         RescueRemoteStation *sourceStation = Lookup(sourceAddress);
+        senderStation->m_state->m_info.NotifyRxOk(rxSnr, rxBer, rxBerValid, wasReconstructed);
         DoReportRxOk(senderStation, sourceStation,
                 rxSnr, txMode, wasReconstructed);
     }
@@ -411,6 +426,7 @@ namespace ns3 {
           }*/
         RescueRemoteStation *senderStation = Lookup(senderAddress);
         RescueRemoteStation *sourceStation = Lookup(sourceAddress);
+        senderStation->m_state->m_info.NotifyRxFailed(rxSnr);
         DoReportRxFail(senderStation, sourceStation,
                 rxSnr, txMode, wasReconstructed);
     }
@@ -586,36 +602,100 @@ namespace ns3 {
         return state->m_info;
     }
 
+    RescueStationTable::Entry *
+    RescueRemoteStationManager::LookupEntry(Mac48Address address) const {
+        RescueRemoteStationManager *self = const_cast<RescueRemoteStationManager *> (this);
+        RescueStationTable::Entry *entry = self->m_table.Find(address);
+        if (entry == 0) {
+            self->AgeStations();
+            entry = self->m_table.Insert(address);
+            entry->state = self->AllocateState(address);
+        }
+        if (m_stationAgingTime > Seconds(0))
+            entry->lastUsed = Simulator::Now();
+        return entry;
+    }
+
     RescueRemoteStationState *
     RescueRemoteStationManager::LookupState(Mac48Address address) const {
-        for (StationStates::const_iterator i = m_states.begin(); i != m_states.end(); i++) {
-            if ((*i)->m_address == address) {
-                return (*i);
-            }
+        return LookupEntry(address)->state;
+    }
+
+    RescueRemoteStation *
+    RescueRemoteStationManager::Lookup(Mac48Address address) const {
+        RescueStationTable::Entry *entry = LookupEntry(address);
+        if (entry->station == 0) {
+            RescueRemoteStation *station = DoCreateStation();
+            station->m_state = entry->state;
+            //station->m_src = 0;
+            entry->station = station;
+        }
+        return entry->station;
+    }
+
+    RescueRemoteStationState *
+    RescueRemoteStationManager::AllocateState(Mac48Address address) {
+        if (m_freeStates.empty()) {
+            RescueRemoteStationState *block = new RescueRemoteStationState [STATION_STATE_BLOCK];
+            m_stateBlocks.push_back(block);
+            for (uint32_t i = STATION_STATE_BLOCK; i > 0; i--)
+                m_freeStates.push_back(&block[i - 1]);
         }
-        RescueRemoteStationState *state = new RescueRemoteStationState();
+        RescueRemoteStationState *state = m_freeStates.back();
+        m_freeStates.pop_back();
         state->m_state = RescueRemoteStationState::BRAND_NEW;
         state->m_address = address;
+        state->m_operationalRateSet.clear();
         state->m_operationalRateSet.push_back(GetDefaultMode());
-        const_cast<RescueRemoteStationManager *> (this)->m_states.push_back(state);
+        state->m_info = RescueRemoteStationInfo();
         return state;
     }
 
-    RescueRemoteStation *
-    RescueRemoteStationManager::Lookup(Mac48Address address) const {
-        for (Stations::const_iterator i = m_stations.begin(); i != m_stations.end(); i++) {
-            if ((*i)->m_state->m_address == address) {
-                return (*i);
-            }
+    void
+    RescueRemoteStationManager::AgeStations(void) {
+        Time now = Simulator::Now();
+        if (m_stationAgingTime == Seconds(0) || now - m_lastAging < m_stationAgingTime)
+            return;
+        m_lastAging = now;
+        //the manager is the only owner of stations and states: pointers to them are passed to subclasses
+        //for the time of a single call and never stored, and the stations used by the current call were
+        //looked up now, so they are never idle
+        std::vector<Mac48Address> idle;
+        for (uint32_t i = 0; i < m_table.GetCapacity(); i++) {
+            RescueStationTable::Entry *entry = m_table.GetEntry(i);
+            if (entry != 0 && now - entry->lastUsed >= m_stationAgingTime)
+                idle.push_back(entry->state->m_address);
         }
-        RescueRemoteStationState *state = LookupState(address);
+        //removal moves other entries of the table, so they are found again by address
+        for (std::vector<Mac48Address>::const_iterator it = idle.begin(); it != idle.end(); it++) {
+            NS_LOG_DEBUG("remove idle station: " << *it);
+            RescueStationTable::Entry *entry = m_table.Find(*it);
+            delete entry->station;
+            m_freeStates.push_back(entry->state);
+            m_table.Remove(entry);
+        }
+    }
 
-        RescueRemoteStation *station = DoCreateStation();
-        station->m_state = state;
-        //station->m_src = 0;
-        // XXX
-        const_cast<RescueRemoteStationManager *> (this)->m_stations.push_back(station);
-        return station;
+    uint32_t
+    RescueRemoteStationManager::GetNStations(void) const {
+        return m_table.GetSize();
+    }
+
+    std::vector<Mac48Address>
+    RescueRemoteStationManager::GetNeighbours(double minSnr, Time maxAge) {
+        std::vector<Mac48Address> neighbours;
+        for (uint32_t i = 0; i < m_table.GetCapacity(); i++) {
+            RescueStationTable::Entry *entry = m_table.GetEntry(i);
+            if (entry == 0)
+                continue;
+            const RescueRemoteStationInfo &info = entry->state->m_info;
+            if (entry->state->m_address.IsGroup() || !info.HasRxSnr() || info.GetRxSnr() < minSnr)
+                continue;
+            if (maxAge > Seconds(0) && Simulator::Now() - info.GetLastRxTime() > maxAge)
+                continue;
+            neighbours.push_back(entry->state->m_address);
+        }
+        return neighbours;
     }
 
     RescueMode
@@ -625,10 +705,13 @@ namespace ns3 {
 
     void
     RescueRemoteStationManager::Reset(void) {
-        for (Stations::const_iterator i = m_stations.begin(); i != m_stations.end(); i++) {
-            delete (*i);
+        for (uint32_t i = 0; i < m_table.GetCapacity(); i++) {
+            RescueStationTable::Entry *entry = m_table.GetEntry(i);
+            if (entry != 0) {
+                delete entry->station;
+                entry->station = 0;
+            }
         }
-        m_stations.clear();
         m_bssBasicRateSet.clear();
         m_bssBasicRateSet.push_back(m_defaultTxMode);
     }
@@ -708,14 +791,29 @@ namespace ns3 {
     RescueRemoteStationInfo::RescueRemoteStationInfo()
     : m_memoryTime(Seconds(1.0)),
     m_lastUpdate(Seconds(0.0)),
-    m_failAvg(0.0) {
+    m_failAvg(0.0),
+    m_snrAvg(0.0),
+    m_snrValid(false),
+    m_lastSnrUpdate(Seconds(0.0)),
+    m_rxSnrAvg(0.0),
+    m_rxSnrValid(false),
+    m_rxFailAvg(0.0),
+    m_rxReconstructedAvg(0.0),
+    m_rxBerAvg(0.0),
+    m_rxBerValid(false),
+    m_lastRxUpdate(Seconds(0.0)) {
     }
 
     double
     RescueRemoteStationInfo::CalculateAveragingCoefficient() {
-        double retval = std::exp((double) (m_lastUpdate.GetMicroSeconds() - Simulator::Now().GetMicroSeconds())
+        return CalculateAveragingCoefficient(m_lastUpdate);
+    }
+
+    double
+    RescueRemoteStationInfo::CalculateAveragingCoefficient(Time &lastUpdate) const {
+        double retval = std::exp((double) (lastUpdate.GetMicroSeconds() - Simulator::Now().GetMicroSeconds())
                 / (double) m_memoryTime.GetMicroSeconds());
-        m_lastUpdate = Simulator::Now();
+        lastUpdate = Simulator::Now();
         return retval;
     }
 
@@ -727,10 +825,32 @@ namespace ns3 {
 
     void
     RescueRemoteStationInfo::NotifyTxSuccessSNR(uint32_t retryCounter, double snr) {
-        double coefficient = CalculateAveragingCoefficient();
-        m_failAvg = (double) retryCounter / (1 + (double) retryCounter) * (1.0 - coefficient) + coefficient * m_failAvg;
+        NotifyTxSuccess(retryCounter);
+
+        double coefficient = CalculateAveragingCoefficient(m_lastSnrUpdate);
+        m_snrAvg = m_snrValid ? snr * (1.0 - coefficient) + coefficient * m_snrAvg : snr;
+        m_snrValid = true;
+    }
+
+    void
+    RescueRemoteStationInfo::NotifyRxOk(double snr, double ber, bool berValid, bool wasReconstructed) {
+        double coefficient = CalculateAveragingCoefficient(m_lastRxUpdate);
+        m_rxSnrAvg = m_rxSnrValid ? snr * (1.0 - coefficient) + coefficient * m_rxSnrAvg : snr;
+        m_rxSnrValid = true;
+        m_rxFailAvg = coefficient * m_rxFailAvg;
+        m_rxReconstructedAvg = (wasReconstructed ? 1.0 : 0.0) * (1.0 - coefficient) + coefficient * m_rxReconstructedAvg;
+        if (berValid) {
+            m_rxBerAvg = m_rxBerValid ? ber * (1.0 - coefficient) + coefficient * m_rxBerAvg : ber;
+            m_rxBerValid = true;
+        }
+    }
 
-        m_snrAvg = snr / (1 + snr) * (1.0 - coefficient) + coefficient * m_snrAvg; //?
+    void
+    RescueRemoteStationInfo::NotifyRxFailed(double snr) {
+        double coefficient = CalculateAveragingCoefficient(m_lastRxUpdate);
+        m_rxSnrAvg = m_rxSnrValid ? snr * (1.0 - coefficient) + coefficient * m_rxSnrAvg : snr;
+        m_rxSnrValid = true;
+        m_rxFailAvg = (1.0 - coefficient) + coefficient * m_rxFailAvg;
     }
 
     void
@@ -743,4 +863,44 @@ namespace ns3 {
     RescueRemoteStationInfo::GetFrameErrorRate() const {
         return m_failAvg;
     }
+
+    bool
+    RescueRemoteStationInfo::HasTxSnr() const {
+        return m_snrValid;
+    }
+
+    double
+    RescueRemoteStationInfo::GetTxSnr() const {
+        return m_snrAvg;
+    }
+
+    bool
+    RescueRemoteStationInfo::HasRxSnr() const {
+        return m_rxSnrValid;
+    }
+
+    double
+    RescueRemoteStationInfo::GetRxSnr() const {
+        return m_rxSnrAvg;
+    }
+
+    double
+    RescueRemoteStationInfo::GetRxErrorRate() const {
+        return m_rxFailAvg;
+    }
+
+    double
+    RescueRemoteStationInfo::GetReconstructionRate() const {
+        return m_rxReconstructedAvg;
+    }
+
+    double
+    RescueRemoteStationInfo::GetRxBer() const {
+        return m_rxBerAvg;
+    }
+
+    Time
+    RescueRemoteStationInfo::GetLastRxTime() const {
+        return m_lastRxUpdate;
+    }
 } // namespace ns3
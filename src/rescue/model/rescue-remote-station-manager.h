@@ -28,6 +28,7 @@
 #include "ns3/object.h"
 #include "ns3/nstime.h"
 #include "rescue-mode.h"
+#include "rescue-station-table.h"
 
 namespace ns3 {
 
@@ -42,6 +43,11 @@ namespace ns3 {
      *
      * Structure is similar to struct sta_info in Linux kernel (see
      * net/mac80211/sta_info.h)
+     *
+     * Link quality is tracked separately for both directions: TX (this station -> remote
+     * station, from ACK feedback) and RX (remote station -> this station, from all frames
+     * received or overheard from the remote station). All estimates are exponentially
+     * decayed with the memory time, updates are O(1).
      */
     class RescueRemoteStationInfo {
     public:
@@ -53,11 +59,50 @@ namespace ns3 {
          * success transmission.
          */
         void NotifyTxSuccess(uint32_t retryCounter);
+        /**
+         * \brief Updates average frame error rate and TX link SNR when data
+         * was transmitted successfully.
+         * \param retryCounter is src value at the moment of
+         * success transmission.
+         * \param snr the SNR (dB) of the ACK (or of DATA route if it was lower)
+         */
         void NotifyTxSuccessSNR(uint32_t retryCounter, double snr);
         /// Updates average frame error rate when final data has failed.
         void NotifyTxFailed();
+        /**
+         * Updates RX link statistics when a frame from the remote station was received correctly.
+         *
+         * \param snr the SNR (dB) of the frame
+         * \param ber the BER stored in the frame
+         * \param berValid true if the frame carried its BER
+         * \param wasReconstructed true if the frame was received using joint decoding
+         */
+        void NotifyRxOk(double snr, double ber, bool berValid, bool wasReconstructed);
+        /**
+         * Updates RX link statistics when a frame from the remote station was damaged
+         * (PHY header received correctly).
+         *
+         * \param snr the SNR (dB) of the frame
+         */
+        void NotifyRxFailed(double snr);
         /// Return frame error rate (probability that frame is corrupted due to transmission error).
         double GetFrameErrorRate() const;
+        /// Return true if the SNR of TX link is known
+        bool HasTxSnr() const;
+        /// Return averaged SNR (dB) of TX link (ACKs received from the remote station and their DATA routes)
+        double GetTxSnr() const;
+        /// Return true if the SNR of RX link is known
+        bool HasRxSnr() const;
+        /// Return averaged SNR (dB) of RX link (all frames received from the remote station)
+        double GetRxSnr() const;
+        /// Return averaged ratio of damaged frames received from the remote station
+        double GetRxErrorRate() const;
+        /// Return averaged ratio of correct frames which required joint decoding
+        double GetReconstructionRate() const;
+        /// Return averaged BER stored in correct frames received from the remote station (0 if not known)
+        double GetRxBer() const;
+        /// Return time of the last update of RX link statistics
+        Time GetLastRxTime() const;
 
     private:
         /**
@@ -68,14 +113,39 @@ namespace ns3 {
          * \return average coefficient for frame error rate
          */
         double CalculateAveragingCoefficient();
+        /**
+         * \brief Calculate averaging coefficient for a group of statistics. Depends on time of the last update.
+         *
+         * \param lastUpdate time of the last update of the statistics (reset to current time)
+         * \return average coefficient (weight of previous average)
+         */
+        double CalculateAveragingCoefficient(Time &lastUpdate) const;
         /// averaging coefficient depends on the memory time
         Time m_memoryTime;
         /// when last update has occured
         Time m_lastUpdate;
         /// moving percentage of failed frames
         double m_failAvg;
-        /// average SNR(?)
+        /// average SNR of TX link
         double m_snrAvg;
+        /// true if SNR of TX link is known
+        bool m_snrValid;
+        /// when last update of TX link SNR has occured
+        Time m_lastSnrUpdate;
+        /// average SNR of RX link
+        double m_rxSnrAvg;
+        /// true if SNR of RX link is known
+        bool m_rxSnrValid;
+        /// moving percentage of damaged received frames
+        double m_rxFailAvg;
+        /// moving percentage of correct frames received using joint decoding
+        double m_rxReconstructedAvg;
+        /// average BER of received frames
+        double m_rxBerAvg;
+        /// true if BER of received frames is known
+        bool m_rxBerValid;
+        /// when last update of RX link statistics has occured
+        Time m_lastRxUpdate;
     };
 
     /**
@@ -306,8 +376,9 @@ namespace ns3 {
          * \param ackSnr the SNR of the ACK we received
          * \param ackMode the RescueMode the receiver used to send the ACK
          * \param dataSnr the SNR of the DATA we sent
+         * \param dataSnrValid true if dataSnr was recorded on the route of the DATA
          */
-        void ReportDataOk(Mac48Address address, double ackSnr, RescueMode ackMode, double dataSnr, double dataPer, uint32_t retryCounter);
+        void ReportDataOk(Mac48Address address, double ackSnr, RescueMode ackMode, double dataSnr, bool dataSnrValid, double dataPer, uint32_t retryCounter);
         /**
          * Should be invoked after calling ReportDataFailed if
          * NeedDataRetransmission returns false
@@ -322,11 +393,13 @@ namespace ns3 {
          * \param rxSnr the snr of the packet received
          * \param txMode the transmission mode used for the packet received
          * \param wasReconstructed true if the frame was received using joint decoding
+         * \param rxBer the BER stored in the frame
+         * \param rxBerValid true if the frame carried its BER
          *
          * Should be invoked whenever a packet is successfully received.
          */
         void ReportRxOk(Mac48Address senderAddress, Mac48Address sourceAddress,
-                double rxSnr, RescueMode txMode, bool wasReconstructed);
+                double rxSnr, RescueMode txMode, bool wasReconstructed, double rxBer = 0, bool rxBerValid = false);
         /**
          * \param senderAddress sender station address
          * \param sourceAddress source station address
@@ -399,6 +472,17 @@ namespace ns3 {
          */
         uint32_t GetRetryCount(const Mac48Address address) const;
 
+        /**
+         * \return the number of known remote stations
+         */
+        uint32_t GetNStations(void) const;
+        /**
+         * \param minSnr the minimal averaged SNR (dB) of frames received from a neighbour
+         * \param maxAge the maximal time since the last frame received from a neighbour (0 - no limit)
+         * \return the addresses of stations heard with sufficient link quality
+         */
+        std::vector<Mac48Address> GetNeighbours(double minSnr, Time maxAge);
+
     protected:
         virtual void DoDispose(void);
         /**
@@ -495,10 +579,11 @@ namespace ns3 {
          * \param ackSnr the SNR of the ACK we received
          * \param ackMode the RescueMode the receiver used to send the ACK
          * \param dataSnr the SNR of the DATA we sent
+         * \param dataSnrValid true if dataSnr was recorded on the route of the DATA
          */
         virtual void DoReportDataOk(RescueRemoteStation *station,
                 double ackSnr, RescueMode ackMode,
-                double dataSnr, double dataPer) = 0;
+                double dataSnr, bool dataSnrValid, double dataPer) = 0;
         /**
          * This method is a pure virtual method that must be implemented by the sub-class.
          * This allows different types of RescueRemoteStationManager to respond differently,
@@ -533,6 +618,14 @@ namespace ns3 {
                 RescueRemoteStation *sourceStation,
                 double rxSnr, RescueMode txMode, bool wasReconstructed) = 0;
 
+        /**
+         * Return the table entry of the station associated with the given address,
+         * the entry (with its state) is created for unknown station.
+         *
+         * \param address the address of the station
+         * \return the table entry corresponding to the address
+         */
+        RescueStationTable::Entry* LookupEntry(Mac48Address address) const;
         /**
          * Return the state of the station associated with the given address.
          *
@@ -554,16 +647,21 @@ namespace ns3 {
         uint32_t GetControlCw(Mac48Address address);
 
         /**
-         * A vector of RescueRemoteStations
+         * \param address the address of the station
+         * \return the state of brand new station (taken from the pool of states)
          */
-        typedef std::vector <RescueRemoteStation *> Stations;
+        RescueRemoteStationState* AllocateState(Mac48Address address);
         /**
-         * A vector of RescueRemoteStationStates
+         * Removes stations not looked up for StationAgingTime (checked at most once
+         * per StationAgingTime, when a new station is added), their states return to the pool
          */
-        typedef std::vector <RescueRemoteStationState *> StationStates;
+        void AgeStations(void);
 
-        StationStates m_states; //!< States of known stations
-        Stations m_stations; //!< Information for each known stations
+        RescueStationTable m_table; //!< Known stations (with their states)
+        std::vector<RescueRemoteStationState *> m_stateBlocks; //!< Blocks of pooled station states
+        std::vector<RescueRemoteStationState *> m_freeStates; //!< Pooled station states not used by any station
+        Time m_stationAgingTime; //!< Time after which idle station is removed (0 - never)
+        Time m_lastAging; //!< Time of the last removal of idle stations
         /**
          * This is a pointer to the RescuePhy associated with this
          * RescueRemoteStationManager that is set on call to
@@ -642,6 +740,9 @@ namespace ns3 {
      * of association status if we are in an infrastructure
      * network and to perform the selection of tx parameters
      * on a per-packet basis.
+     *
+     * Stations are owned by RescueRemoteStationManager, which removes idle ones,
+     * so subclasses must not keep pointers to them after the call they were passed to.
      */
     struct RescueRemoteStation {
         RescueRemoteStationState *m_state; //!< Remote station state
@@ -0,0 +1,101 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 AGH Univeristy of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+
+#include "ns3/log.h"
+
+#include "rescue-rtt-estimator.h"
+
+#include <algorithm>
+
+NS_LOG_COMPONENT_DEFINE("RescueRttEstimator");
+
+namespace ns3 {
+
+    RescueRttEstimator::RescueRttEstimator()
+    : m_srtt(Seconds(0)),
+    m_rttVar(Seconds(0)),
+    m_initialRto(MicroSeconds(15000)),
+    m_minRto(MicroSeconds(1000)),
+    m_maxRto(MicroSeconds(60000)),
+    m_backoff(0),
+    m_hasSamples(false) {
+    }
+
+    void
+    RescueRttEstimator::SetInitialRto(Time rto) {
+        m_initialRto = rto;
+    }
+
+    void
+    RescueRttEstimator::SetBounds(Time minRto, Time maxRto) {
+        m_minRto = minRto;
+        m_maxRto = maxRto;
+    }
+
+    void
+    RescueRttEstimator::Update(Time sample) {
+        if (!m_hasSamples) {
+            m_srtt = sample;
+            m_rttVar = TimeStep(sample.GetTimeStep() / 2);
+            m_hasSamples = true;
+        } else {
+            //RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - sample|, SRTT = 7/8 SRTT + 1/8 sample
+            int64_t err = sample.GetTimeStep() - m_srtt.GetTimeStep();
+            if (err < 0)
+                err = -err;
+            m_rttVar = TimeStep((3 * m_rttVar.GetTimeStep() + err) / 4);
+            m_srtt = TimeStep((7 * m_srtt.GetTimeStep() + sample.GetTimeStep()) / 8);
+        }
+        m_backoff = 0;
+        NS_LOG_DEBUG("RTT sample: " << sample << ", SRTT: " << m_srtt << ", RTTVAR: " << m_rttVar << ", RTO: " << GetRto());
+    }
+
+    void
+    RescueRttEstimator::Backoff(void) {
+        //further doublings would exceed the upper bound anyway
+        if (m_backoff < 16)
+            m_backoff++;
+    }
+
+    Time
+    RescueRttEstimator::GetRto(void) const {
+        Time rto = m_hasSamples ? TimeStep(m_srtt.GetTimeStep() + 4 * m_rttVar.GetTimeStep()) : m_initialRto;
+        rto = std::max(rto, m_minRto);
+        for (uint8_t i = 0; (i < m_backoff) && (rto < m_maxRto); i++)
+            rto = TimeStep(2 * rto.GetTimeStep());
+        return std::min(rto, m_maxRto);
+    }
+
+    Time
+    RescueRttEstimator::GetSrtt(void) const {
+        return m_srtt;
+    }
+
+    Time
+    RescueRttEstimator::GetRttVar(void) const {
+        return m_rttVar;
+    }
+
+    bool
+    RescueRttEstimator::HasSamples(void) const {
+        return m_hasSamples;
+    }
+
+} // namespace ns3
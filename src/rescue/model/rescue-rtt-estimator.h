@@ -0,0 +1,94 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 AGH Univeristy of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+
+#ifndef RESCUE_RTT_ESTIMATOR_H
+#define RESCUE_RTT_ESTIMATOR_H
+
+#include "ns3/nstime.h"
+
+#include <stdint.h>
+
+namespace ns3 {
+
+    /**
+     * \ingroup rescue
+     *
+     * Round trip time estimator of a single destination (Jacobson/Karels algorithm).
+     * The smoothed RTT and RTT variation are updated with samples measured between
+     * the transmission of a DATA frame and the reception of its ACK, the ACK timeout
+     * (RTO) is computed as SRTT + 4 * RTTVAR, bounded by the minimum and maximum RTO.
+     * Each ACK timeout doubles the RTO (exponential backoff) until the next valid sample.
+     */
+    class RescueRttEstimator {
+    public:
+        RescueRttEstimator();
+
+        /**
+         * \param rto the RTO used before the first sample is measured
+         */
+        void SetInitialRto(Time rto);
+        /**
+         * \param minRto the lower bound of RTO
+         * \param maxRto the upper bound of RTO (also limits the backoff)
+         */
+        void SetBounds(Time minRto, Time maxRto);
+
+        /**
+         * Updates the estimation with RTT sample (the backoff is cleared). Samples should
+         * be taken only for frames transmitted once (Karn's algorithm).
+         *
+         * \param sample the measured round trip time
+         */
+        void Update(Time sample);
+        /**
+         * Doubles the RTO after ACK timeout
+         */
+        void Backoff(void);
+
+        /**
+         * \return the current ACK timeout (including backoff)
+         */
+        Time GetRto(void) const;
+        /**
+         * \return the smoothed round trip time (0 before the first sample)
+         */
+        Time GetSrtt(void) const;
+        /**
+         * \return the round trip time variation (0 before the first sample)
+         */
+        Time GetRttVar(void) const;
+        /**
+         * \return true if at least one sample was measured
+         */
+        bool HasSamples(void) const;
+
+    private:
+        Time m_srtt; //!< Smoothed round trip time
+        Time m_rttVar; //!< Round trip time variation
+        Time m_initialRto; //!< RTO used before the first sample
+        Time m_minRto; //!< Lower bound of RTO
+        Time m_maxRto; //!< Upper bound of RTO
+        uint8_t m_backoff; //!< Number of RTO doublings since the last valid sample
+        bool m_hasSamples; //!< True after the first sample
+    };
+
+} // namespace ns3
+
+#endif /* RESCUE_RTT_ESTIMATOR_H */
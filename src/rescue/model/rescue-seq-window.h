@@ -0,0 +1,142 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 AGH Univeristy of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+
+#ifndef RESCUE_SEQ_WINDOW_H
+#define RESCUE_SEQ_WINDOW_H
+
+#define SEQ_WINDOW_SIZE 512
+
+#include <stdint.h>
+
+namespace ns3 {
+
+    /**
+     * \ingroup rescue
+     *
+     * Per-peer state of sequence numbers used by ARQ, kept in a ring of SEQ_WINDOW_SIZE
+     * entries (sequence number modulo the ring size) instead of the array covering whole
+     * sequence space. Each entry is tagged with its sequence number and marked in a bitmap
+     * of stored entries, so the sequences which are not stored (never used or overwritten
+     * by the sequence further than SEQ_WINDOW_SIZE) read as default state.
+     *
+     * SEQ_WINDOW_SIZE is a power of two not lower than twice the maximal send window,
+     * so all frames of the current window and the recently acknowledged ones are kept.
+     */
+    template <typename T>
+    class RescueSeqWindow {
+    public:
+
+        RescueSeqWindow() {
+            Clear();
+        }
+
+        /**
+         * Removes all stored entries
+         */
+        void Clear(void) {
+            for (uint16_t i = 0; i < SEQ_WINDOW_SIZE / 32; i++)
+                m_stored[i] = 0;
+        }
+
+        /**
+         * \param seq the sequence number
+         * \return true if the state of given sequence number is stored
+         */
+        bool IsStored(uint16_t seq) const {
+            uint16_t idx = seq & (SEQ_WINDOW_SIZE - 1);
+            return (m_stored[idx >> 5] & (1u << (idx & 31))) && (m_seq[idx] == seq);
+        }
+
+        /**
+         * \param seq the sequence number
+         * \return the state of given sequence number (default state if not stored)
+         */
+        const T& Get(uint16_t seq) const {
+            return IsStored(seq) ? m_entries[seq & (SEQ_WINDOW_SIZE - 1)] : m_default;
+        }
+
+        /**
+         * \param seq the sequence number
+         * \return the state of given sequence number to modify (the slot is taken over
+         *         from older sequence number and reset to default state if needed)
+         */
+        T& operator[](uint16_t seq) {
+            uint16_t idx = seq & (SEQ_WINDOW_SIZE - 1);
+            if (!IsStored(seq)) {
+                m_entries[idx] = m_default;
+                m_seq[idx] = seq;
+                m_stored[idx >> 5] |= (1u << (idx & 31));
+            }
+            return m_entries[idx];
+        }
+
+        /**
+         * \param seq the sequence number
+         * \return the state of older sequence number stored in the ring slot of given
+         *         sequence number, which would be taken over by operator[] (0 if none)
+         */
+        T* GetTakenOver(uint16_t seq) {
+            uint16_t idx = seq & (SEQ_WINDOW_SIZE - 1);
+            if ((m_stored[idx >> 5] & (1u << (idx & 31))) && (m_seq[idx] != seq))
+                return &m_entries[idx];
+            return 0;
+        }
+
+        /**
+         * \param seq the sequence number whose state should be reset to default
+         */
+        void Forget(uint16_t seq) {
+            if (IsStored(seq)) {
+                uint16_t idx = seq & (SEQ_WINDOW_SIZE - 1);
+                m_stored[idx >> 5] &= ~(1u << (idx & 31));
+            }
+        }
+
+        /**
+         * Resets the state of all sequence numbers from given range (modulo sequence space)
+         * to default. Only the ring entries are scanned, so the cost does not depend
+         * on the size of the range.
+         *
+         * \param first the first sequence number of the range
+         * \param last the last sequence number of the range
+         */
+        void ForgetRange(uint16_t first, uint16_t last) {
+            uint16_t span = last - first;
+            for (uint16_t w = 0; w < SEQ_WINDOW_SIZE / 32; w++) {
+                if (m_stored[w] == 0)
+                    continue;
+                for (uint16_t b = 0; b < 32; b++) {
+                    uint16_t idx = (w << 5) + b;
+                    if ((m_stored[w] & (1u << b)) && (uint16_t(m_seq[idx] - first) <= span))
+                        m_stored[w] &= ~(1u << b);
+                }
+            }
+        }
+
+    private:
+        T m_entries [SEQ_WINDOW_SIZE]; //!< Ring of sequence states
+        uint16_t m_seq [SEQ_WINDOW_SIZE]; //!< Sequence number of each ring entry
+        uint32_t m_stored [SEQ_WINDOW_SIZE / 32]; //!< Bitmap of stored ring entries
+        T m_default; //!< Default state of not stored sequence
+    };
+
+} // namespace ns3
+
+#endif /* RESCUE_SEQ_WINDOW_H */
@@ -0,0 +1,141 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 AGH Univeristy of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+
+#include "rescue-station-table.h"
+
+NS_LOG_COMPONENT_DEFINE("RescueStationTable");
+
+namespace ns3 {
+
+    RescueStationTable::RescueStationTable()
+    : m_mask(INITIAL_CAPACITY - 1),
+    m_size(0) {
+        Entry empty = {0, 0, 0, Seconds(0)};
+        m_slots.assign(INITIAL_CAPACITY, empty);
+    }
+
+    uint64_t
+    RescueStationTable::GetKey(Mac48Address address) {
+        uint8_t buf[6];
+        address.CopyTo(buf);
+        uint64_t key = 0;
+        for (uint8_t i = 0; i < 6; i++)
+            key = (key << 8) | buf[i];
+        return key | OCCUPIED;
+    }
+
+    uint32_t
+    RescueStationTable::GetSlot(uint64_t key) const {
+        //Fibonacci hashing - stations of the same vendor differ in the lowest bytes only
+        return (uint32_t) ((key * 0x9E3779B97F4A7C15ULL) >> 32) & m_mask;
+    }
+
+    RescueStationTable::Entry *
+    RescueStationTable::Find(Mac48Address address) {
+        uint64_t key = GetKey(address);
+        for (uint32_t i = GetSlot(key);; i = (i + 1) & m_mask) {
+            if (m_slots[i].key == key)
+                return &m_slots[i];
+            if (m_slots[i].key == 0)
+                return 0;
+        }
+    }
+
+    RescueStationTable::Entry *
+    RescueStationTable::Insert(Mac48Address address) {
+        NS_ASSERT(Find(address) == 0);
+        if ((m_size + 1) * 4 > (m_mask + 1) * 3)
+            Grow();
+        uint64_t key = GetKey(address);
+        uint32_t i = GetSlot(key);
+        while (m_slots[i].key != 0)
+            i = (i + 1) & m_mask;
+        m_slots[i].key = key;
+        m_slots[i].state = 0;
+        m_slots[i].station = 0;
+        m_slots[i].lastUsed = Seconds(0);
+        m_size++;
+        return &m_slots[i];
+    }
+
+    void
+    RescueStationTable::Remove(Entry *entry) {
+        NS_ASSERT(entry >= &m_slots[0] && entry <= &m_slots[m_mask] && entry->key != 0);
+        uint32_t hole = entry - &m_slots[0];
+        //shift back following entries of the probe sequence which may not be reached otherwise
+        for (uint32_t i = (hole + 1) & m_mask; m_slots[i].key != 0; i = (i + 1) & m_mask) {
+            uint32_t home = GetSlot(m_slots[i].key);
+            if (((i - home) & m_mask) >= ((i - hole) & m_mask)) {
+                m_slots[hole] = m_slots[i];
+                hole = i;
+            }
+        }
+        m_slots[hole].key = 0;
+        m_slots[hole].state = 0;
+        m_slots[hole].station = 0;
+        m_size--;
+    }
+
+    void
+    RescueStationTable::Clear(void) {
+        Entry empty = {0, 0, 0, Seconds(0)};
+        m_slots.assign(INITIAL_CAPACITY, empty);
+        m_mask = INITIAL_CAPACITY - 1;
+        m_size = 0;
+    }
+
+    uint32_t
+    RescueStationTable::GetSize(void) const {
+        return m_size;
+    }
+
+    uint32_t
+    RescueStationTable::GetCapacity(void) const {
+        return m_mask + 1;
+    }
+
+    RescueStationTable::Entry *
+    RescueStationTable::GetEntry(uint32_t i) {
+        NS_ASSERT(i <= m_mask);
+        return m_slots[i].key != 0 ? &m_slots[i] : 0;
+    }
+
+    void
+    RescueStationTable::Grow(void) {
+        std::vector<Entry> old;
+        old.swap(m_slots);
+        Entry empty = {0, 0, 0, Seconds(0)};
+        m_slots.assign(old.size() * 2, empty);
+        m_mask = m_slots.size() - 1;
+        NS_LOG_DEBUG("station table grows to " << m_slots.size() << " slots");
+        for (std::vector<Entry>::const_iterator it = old.begin(); it != old.end(); it++) {
+            if (it->key == 0)
+                continue;
+            uint32_t i = GetSlot(it->key);
+            while (m_slots[i].key != 0)
+                i = (i + 1) & m_mask;
+            m_slots[i] = *it;
+        }
+    }
+
+} // namespace ns3
@@ -0,0 +1,119 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 AGH Univeristy of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+
+#ifndef RESCUE_STATION_TABLE_H
+#define RESCUE_STATION_TABLE_H
+
+#include "ns3/mac48-address.h"
+#include "ns3/nstime.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+    struct RescueRemoteStation;
+    struct RescueRemoteStationState;
+
+    /**
+     * \ingroup rescue
+     *
+     * Open addressing (linear probing) hash table of remote stations keyed by 48-bit
+     * address. Entries are kept inline in a power-of-two array, the table grows when
+     * the load exceeds 3/4 and removal uses backward shift (no tombstones), so lookup
+     * cost does not depend on the number of known stations.
+     */
+    class RescueStationTable {
+    public:
+
+        struct Entry {
+            uint64_t key; //!< Address of the station with OCCUPIED flag (0 - empty slot)
+            RescueRemoteStationState *state; //!< Remote station state
+            RescueRemoteStation *station; //!< Remote station (0 - not created yet)
+            Time lastUsed; //!< Time of the last lookup of this station
+        };
+
+        RescueStationTable();
+
+        /**
+         * \param address the address of the station
+         * \return the entry of the station (0 if not found)
+         */
+        Entry* Find(Mac48Address address);
+        /**
+         * Inserts new (empty) entry, the address must not be in the table.
+         * Pointers to other entries are invalidated.
+         *
+         * \param address the address of the station
+         * \return the inserted entry
+         */
+        Entry* Insert(Mac48Address address);
+        /**
+         * Removes the entry, other entries may be moved to its slot.
+         *
+         * \param entry the entry to remove
+         */
+        void Remove(Entry *entry);
+        /**
+         * Removes all entries (station and state objects are not deleted)
+         */
+        void Clear(void);
+
+        /**
+         * \return the number of stations in the table
+         */
+        uint32_t GetSize(void) const;
+        /**
+         * \return the number of slots of the table
+         */
+        uint32_t GetCapacity(void) const;
+        /**
+         * \param i the slot index (lower than capacity)
+         * \return the entry stored in the slot (0 if the slot is empty)
+         */
+        Entry* GetEntry(uint32_t i);
+
+    private:
+        static const uint64_t OCCUPIED = 1ULL << 63; //!< Flag of occupied slot
+        static const uint32_t INITIAL_CAPACITY = 16; //!< Initial number of slots
+
+        /**
+         * \param address the address of the station
+         * \return the key of the station
+         */
+        static uint64_t GetKey(Mac48Address address);
+        /**
+         * \param key the key of the station
+         * \return the home slot of the key
+         */
+        uint32_t GetSlot(uint64_t key) const;
+        /**
+         * Doubles the number of slots and reinserts all entries
+         */
+        void Grow(void);
+
+        std::vector<Entry> m_slots; //!< Slots of the table
+        uint32_t m_mask; //!< Number of slots - 1
+        uint32_t m_size; //!< Number of occupied slots
+    };
+
+} // namespace ns3
+
+#endif /* RESCUE_STATION_TABLE_H */
@@ -0,0 +1,300 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 AGH Univeristy of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+
+#include "ns3/log.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/assert.h"
+
+#include "rescue-tdma-scheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+NS_LOG_COMPONENT_DEFINE("RescueTdmaScheduler");
+
+namespace ns3 {
+
+    NS_OBJECT_ENSURE_REGISTERED(RescueTdmaScheduler);
+
+    TypeId
+    RescueTdmaScheduler::GetTypeId(void) {
+        static TypeId tid = TypeId("ns3::RescueTdmaScheduler")
+                .SetParent<Object> ()
+                .AddConstructor<RescueTdmaScheduler> ()
+                .AddAttribute("Policy",
+                "The policy used to distribute TDMA time slots between stations",
+                EnumValue(RescueTdmaScheduler::PROPORTIONAL_FAIR),
+                MakeEnumAccessor(&RescueTdmaScheduler::m_policy),
+                MakeEnumChecker(RescueTdmaScheduler::FIFO, "Fifo",
+                RescueTdmaScheduler::PROPORTIONAL_FAIR, "ProportionalFair",
+                RescueTdmaScheduler::MAX_THROUGHPUT, "MaxThroughput"))
+                .AddAttribute("AveragingWeight",
+                "The weight of the last CFP in the average number of slots obtained by a station (proportional fair policy)",
+                DoubleValue(0.1),
+                MakeDoubleAccessor(&RescueTdmaScheduler::m_averagingWeight),
+                MakeDoubleChecker<double> (0, 1))
+                .AddAttribute("SpatialReuse",
+                "If true, stations which do not interfere (basing on reported neighbour sets) may share slots",
+                BooleanValue(false),
+                MakeBooleanAccessor(&RescueTdmaScheduler::m_spatialReuse),
+                MakeBooleanChecker())
+                .AddAttribute("IdleSchedules",
+                "The number of consecutive schedules without demand after which the state of a station is removed",
+                UintegerValue(10),
+                MakeUintegerAccessor(&RescueTdmaScheduler::m_maxIdleSchedules),
+                MakeUintegerChecker<uint32_t> (1))
+                ;
+        return tid;
+    }
+
+    RescueTdmaScheduler::RescueTdmaScheduler()
+    : m_policy(PROPORTIONAL_FAIR),
+    m_averagingWeight(0.1),
+    m_spatialReuse(false),
+    m_maxIdleSchedules(10),
+    m_order(0) {
+        NS_LOG_FUNCTION("");
+    }
+
+    RescueTdmaScheduler::~RescueTdmaScheduler() {
+        NS_LOG_FUNCTION("");
+    }
+
+    RescueTdmaScheduler::StationState &
+    RescueTdmaScheduler::GetState(Mac48Address address) {
+        std::map<Mac48Address, StationState>::iterator it = m_stations.find(address);
+        if (it == m_stations.end()) {
+            StationState state;
+            state.demand = Seconds(0);
+            state.rate = 1;
+            state.avgSlots = 0;
+            state.firstOrder = 0;
+            state.lastOrder = 0;
+            state.neighboursKnown = false;
+            state.idleSchedules = 0;
+            it = m_stations.insert(std::make_pair(address, state)).first;
+        }
+        return it->second;
+    }
+
+    void
+    RescueTdmaScheduler::AddDemand(Mac48Address address, Time duration) {
+        NS_LOG_FUNCTION(address << duration);
+        StationState &state = GetState(address);
+        m_order++;
+        if (state.demand == Seconds(0))
+            state.firstOrder = m_order;
+        state.lastOrder = m_order;
+        state.demand += duration;
+    }
+
+    Time
+    RescueTdmaScheduler::GetDemand(Mac48Address address) const {
+        std::map<Mac48Address, StationState>::const_iterator it = m_stations.find(address);
+        return (it != m_stations.end()) ? it->second.demand : Seconds(0);
+    }
+
+    void
+    RescueTdmaScheduler::SetLinkRate(Mac48Address address, double rate) {
+        std::map<Mac48Address, StationState>::iterator it = m_stations.find(address);
+        if (it != m_stations.end())
+            it->second.rate = rate;
+    }
+
+    void
+    RescueTdmaScheduler::SetNeighbours(Mac48Address address, const std::vector<Mac48Address> &neighbours) {
+        NS_LOG_FUNCTION(address << neighbours.size());
+        StationState &state = GetState(address);
+        state.neighboursKnown = true;
+        state.neighbours = std::set<Mac48Address> (neighbours.begin(), neighbours.end());
+    }
+
+    bool
+    RescueTdmaScheduler::HigherPriority(const Candidate &a, const Candidate &b) {
+        if (a.priority != b.priority)
+            return a.priority > b.priority;
+        return a.state->firstOrder < b.state->firstOrder;
+    }
+
+    bool
+    RescueTdmaScheduler::EarlierReservation(const Candidate &a, const Candidate &b) {
+        return a.state->lastOrder < b.state->lastOrder;
+    }
+
+    bool
+    RescueTdmaScheduler::Conflict(const Candidate &a, const Candidate &b) const {
+        if (!m_spatialReuse || !a.state->neighboursKnown || !b.state->neighboursKnown)
+            return true;
+        const std::set<Mac48Address> &na = a.state->neighbours;
+        const std::set<Mac48Address> &nb = b.state->neighbours;
+        if (na.count(b.address) || nb.count(a.address))
+            return true;
+        //hidden stations - common neighbour
+        const std::set<Mac48Address> &smaller = (na.size() < nb.size()) ? na : nb;
+        const std::set<Mac48Address> &larger = (na.size() < nb.size()) ? nb : na;
+        for (std::set<Mac48Address>::const_iterator it = smaller.begin(); it != smaller.end(); it++)
+            if (larger.count(*it))
+                return true;
+        return false;
+    }
+
+    uint32_t
+    RescueTdmaScheduler::Place(uint32_t c, uint32_t count, const std::vector<Candidate> &candidates,
+            std::vector<std::vector<uint32_t> > &slots) const {
+        uint32_t placed = 0;
+        for (uint32_t s = 0; s < slots.size() && placed < count; s++) {
+            bool usable = true;
+            for (std::vector<uint32_t>::iterator it = slots[s].begin(); it != slots[s].end() && usable; it++)
+                usable = (*it != c) && !Conflict(candidates[c], candidates[*it]);
+            if (usable) {
+                slots[s].push_back(c);
+                placed++;
+            }
+        }
+        return placed;
+    }
+
+    std::vector<RescueTdmaScheduler::Assignment>
+    RescueTdmaScheduler::Schedule(uint32_t nSlots, Time slot, uint32_t maxEntries) {
+        NS_LOG_FUNCTION(nSlots << slot << maxEntries);
+        NS_ASSERT(slot > Seconds(0));
+        NS_ASSERT(maxEntries >= nSlots);
+
+        std::vector<Candidate> candidates;
+        uint64_t totalNeeded = 0;
+        for (std::map<Mac48Address, StationState>::iterator it = m_stations.begin(); it != m_stations.end(); it++) {
+            StationState &state = it->second;
+            if (state.demand == Seconds(0))
+                continue;
+            Candidate c;
+            c.state = &state;
+            c.address = it->first;
+            c.needed = (uint32_t) ((state.demand.GetTimeStep() + slot.GetTimeStep() - 1) / slot.GetTimeStep());
+            c.allocated = 0;
+            switch (m_policy) {
+                case PROPORTIONAL_FAIR:
+                    c.priority = state.rate / std::max(state.avgSlots, 1.0 / (nSlots + 1));
+                    break;
+                case MAX_THROUGHPUT:
+                    c.priority = state.rate;
+                    break;
+                case FIFO:
+                default:
+                    c.priority = 0; //ties are ordered by the first reservation
+                    break;
+            }
+            totalNeeded += c.needed;
+            candidates.push_back(c);
+        }
+        std::sort(candidates.begin(), candidates.end(), &RescueTdmaScheduler::HigherPriority);
+
+        uint32_t left = nSlots;
+        if (totalNeeded <= nSlots) {
+            //all demands may be served
+            for (std::vector<Candidate>::iterator it = candidates.begin(); it != candidates.end(); it++)
+                it->allocated = it->needed;
+            left -= totalNeeded;
+        } else {
+            if (m_policy == PROPORTIONAL_FAIR) {
+                //shares proportional to demand weighted by PF metric
+                double totalWeight = 0;
+                for (std::vector<Candidate>::iterator it = candidates.begin(); it != candidates.end(); it++)
+                    totalWeight += it->priority * it->needed;
+                for (std::vector<Candidate>::iterator it = candidates.begin(); it != candidates.end(); it++) {
+                    uint32_t share = (totalWeight > 0) ? (uint32_t) std::floor(nSlots * it->priority * it->needed / totalWeight) : 0;
+                    it->allocated = std::min(std::min(share, it->needed), left);
+                    left -= it->allocated;
+                }
+            }
+            //remaining slots in order of priority
+            for (std::vector<Candidate>::iterator it = candidates.begin(); it != candidates.end() && left > 0; it++) {
+                uint32_t extra = std::min(it->needed - it->allocated, left);
+                it->allocated += extra;
+                left -= extra;
+            }
+        }
+
+        //place the stations in order of their reservations
+        for (uint32_t c = 0; c < candidates.size(); c++)
+            candidates[c].rank = c;
+        std::sort(candidates.begin(), candidates.end(), &RescueTdmaScheduler::EarlierReservation);
+        std::vector<std::vector<uint32_t> > slots(nSlots);
+        uint32_t entries = 0;
+        for (uint32_t c = 0; c < candidates.size(); c++) {
+            uint32_t placed = Place(c, candidates[c].allocated, candidates, slots);
+            NS_ASSERT(placed == candidates[c].allocated);
+            entries += placed;
+        }
+        if (m_spatialReuse) {
+            //slots left free of conflicts serve the remaining demands in order of priority
+            std::vector<uint32_t> order(candidates.size());
+            for (uint32_t c = 0; c < candidates.size(); c++)
+                order[candidates[c].rank] = c;
+            for (uint32_t k = 0; k < order.size() && entries < maxEntries; k++) {
+                Candidate &cand = candidates[order[k]];
+                uint32_t extra = std::min(cand.needed - cand.allocated, maxEntries - entries);
+                uint32_t placed = Place(order[k], extra, candidates, slots);
+                cand.allocated += placed;
+                entries += placed;
+            }
+        }
+
+        std::vector<Assignment> schedule;
+        schedule.reserve(entries);
+        for (uint32_t s = 0; s < nSlots; s++)
+            for (std::vector<uint32_t>::iterator it = slots[s].begin(); it != slots[s].end(); it++) {
+                Assignment a;
+                a.address = candidates[*it].address;
+                a.slot = s;
+                schedule.push_back(a);
+            }
+        for (std::vector<Candidate>::iterator it = candidates.begin(); it != candidates.end(); it++)
+            NS_LOG_DEBUG("station: " << it->address << ", demand: " << it->state->demand << ", needed slots: " << it->needed
+                << ", allocated slots: " << it->allocated << ", priority: " << it->priority);
+
+        //update statistics, the demands are reported again during the next beacon interval
+        for (std::map<Mac48Address, StationState>::iterator it = m_stations.begin(); it != m_stations.end(); it++)
+            it->second.avgSlots *= (1 - m_averagingWeight);
+        for (std::vector<Candidate>::iterator it = candidates.begin(); it != candidates.end(); it++)
+            it->state->avgSlots += m_averagingWeight * it->allocated;
+        for (std::map<Mac48Address, StationState>::iterator it = m_stations.begin(); it != m_stations.end();) {
+            StationState &state = it->second;
+            state.idleSchedules = (state.demand == Seconds(0)) ? state.idleSchedules + 1 : 0;
+            state.demand = Seconds(0);
+            if (state.idleSchedules >= m_maxIdleSchedules) {
+                NS_LOG_DEBUG("remove idle station: " << it->first);
+                m_stations.erase(it++);
+            } else
+                it++;
+        }
+
+        return schedule;
+    }
+
+    void
+    RescueTdmaScheduler::Clear(void) {
+        m_stations.clear();
+        m_order = 0;
+    }
+
+} // namespace ns3
@@ -0,0 +1,174 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 AGH Univeristy of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+
+#ifndef RESCUE_TDMA_SCHEDULER_H
+#define RESCUE_TDMA_SCHEDULER_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/mac48-address.h"
+
+#include <stdint.h>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace ns3 {
+
+    /**
+     * \ingroup rescue
+     *
+     * Centralised scheduler of TDMA time slots (used by AP to build the schedule of CFP).
+     * Demands of stations are collected from resource reservations (queue reports) received
+     * during the beacon interval, at each beacon the slots of CFP are distributed between
+     * stations with non-zero demand:
+     * - FIFO: stations are served fully in order of their first reservation,
+     * - PROPORTIONAL_FAIR: slots are shared in proportion to demand weighted by the ratio
+     *   of link rate to the average number of slots obtained by the station,
+     * - MAX_THROUGHPUT: stations of the best links are served fully first.
+     * Each station may obtain several consecutive slots. Stations are placed in the schedule
+     * in order of their last reservation (e.g. ACK slot of a destination after DATA slot of its source).
+     * The schedule is computed in O(S log S) for S stations with non-zero demand.
+     * The state of a station which reserved no time in IdleSchedules consecutive schedules
+     * is removed, so the set of stations follows the active ones.
+     *
+     * With spatial reuse enabled, the conflict graph of stations is built from their neighbour
+     * sets (two stations conflict if they are neighbours or share a neighbour, stations with
+     * unknown neighbourhood conflict with all others). Slots are assigned by greedy colouring:
+     * each station takes the earliest slots not used by conflicting stations, the slots left
+     * free of conflicts serve the remaining demands in order of priority.
+     */
+    class RescueTdmaScheduler : public Object {
+    public:
+
+        enum Policy {
+            FIFO, //!< serve stations in order of reservations
+            PROPORTIONAL_FAIR, //!< demand-proportional sharing weighted by PF metric
+            MAX_THROUGHPUT //!< serve the stations of the best links first
+        };
+
+        /**
+         * Single entry of the schedule
+         */
+        struct Assignment {
+            Mac48Address address; //!< Owner of the slot
+            uint8_t slot; //!< Number of the slot in CFP
+        };
+
+        static TypeId GetTypeId(void);
+
+        RescueTdmaScheduler();
+        virtual ~RescueTdmaScheduler();
+
+        /**
+         * \param address the station which reserves time
+         * \param duration the reserved TX time
+         */
+        void AddDemand(Mac48Address address, Time duration);
+        /**
+         * \param address the station
+         * \return the TX time reserved by the station for the next CFP
+         */
+        Time GetDemand(Mac48Address address) const;
+        /**
+         * \param address the station
+         * \param rate the estimated rate of the link of the station (e.g. spectral efficiency)
+         */
+        void SetLinkRate(Mac48Address address, double rate);
+        /**
+         * \param address the station
+         * \param neighbours the stations which interfere with the station (used for spatial reuse)
+         */
+        void SetNeighbours(Mac48Address address, const std::vector<Mac48Address> &neighbours);
+        /**
+         * Distributes slots between stations and clears the demands (stations report
+         * their whole backlog again during the next beacon interval)
+         *
+         * \param nSlots the number of slots of CFP
+         * \param slot the duration of a single slot
+         * \param maxEntries the maximal number of entries of the schedule (not less than nSlots)
+         * \return the schedule ordered by slots (the slots are used without gaps)
+         */
+        std::vector<Assignment> Schedule(uint32_t nSlots, Time slot, uint32_t maxEntries);
+        /**
+         * Removes all demands and statistics
+         */
+        void Clear(void);
+
+    private:
+
+        struct StationState {
+            Time demand; //!< TX time reserved for the next CFP
+            double rate; //!< Estimated link rate
+            double avgSlots; //!< Average number of slots obtained in CFP (for PF)
+            uint64_t firstOrder; //!< Order of the first reservation since the last schedule
+            uint64_t lastOrder; //!< Order of the last reservation since the last schedule
+            bool neighboursKnown; //!< True if the neighbour set was reported
+            uint32_t idleSchedules; //!< Consecutive schedules without demand
+            std::set<Mac48Address> neighbours; //!< Interfering stations
+        };
+
+        /**
+         * Candidate station of a single schedule
+         */
+        struct Candidate {
+            StationState *state;
+            Mac48Address address;
+            double priority; //!< Policy dependent priority (higher - served earlier)
+            uint32_t needed; //!< Slots needed to serve the whole demand
+            uint32_t allocated; //!< Allocated slots
+            uint32_t rank; //!< Position in order of priority
+        };
+
+        static bool HigherPriority(const Candidate &a, const Candidate &b);
+        static bool EarlierReservation(const Candidate &a, const Candidate &b);
+
+        /**
+         * \param address the station
+         * \return the state of the station (created if needed)
+         */
+        StationState & GetState(Mac48Address address);
+        /**
+         * \return true if the stations may not transmit in the same slot
+         */
+        bool Conflict(const Candidate &a, const Candidate &b) const;
+        /**
+         * Assigns the earliest slots not used by conflicting stations
+         *
+         * \param c the index of the candidate
+         * \param count the number of slots to assign
+         * \param candidates all candidates
+         * \param slots the candidates using each slot
+         * \return the number of assigned slots
+         */
+        uint32_t Place(uint32_t c, uint32_t count, const std::vector<Candidate> &candidates,
+                std::vector<std::vector<uint32_t> > &slots) const;
+
+        Policy m_policy; //!< Scheduling policy
+        double m_averagingWeight; //!< Weight of the last CFP in the average number of slots (PF)
+        bool m_spatialReuse; //!< True if non-conflicting stations may share slots
+        uint32_t m_maxIdleSchedules; //!< Consecutive schedules without demand after which the station state is removed
+        std::map<Mac48Address, StationState> m_stations; //!< States of stations
+        uint64_t m_order; //!< Reservation counter
+    };
+
+} // namespace ns3
+
+#endif /* RESCUE_TDMA_SCHEDULER_H */
@@ -0,0 +1,290 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 AGH Univeristy of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/assert.h"
+
+#include "rescue-timer-wheel.h"
+
+#include <algorithm>
+
+NS_LOG_COMPONENT_DEFINE("RescueTimerWheel");
+
+namespace ns3 {
+
+    RescueTimerWheel::RescueTimerWheel()
+    : m_free(NO_ENTRY),
+    m_tick(0),
+    m_resolution(MicroSeconds(100)),
+    m_order(0),
+    m_size(0),
+    m_cancelled(0),
+    m_expiring(false) {
+        for (uint32_t i = 0; i <= WHEEL_SLOTS; i++)
+            m_slots[i] = NO_ENTRY;
+        for (uint32_t i = 0; i < WHEEL_SLOTS / 32; i++)
+            m_busy[i] = 0;
+    }
+
+    RescueTimerWheel::~RescueTimerWheel() {
+        CancelAll();
+    }
+
+    void
+    RescueTimerWheel::SetResolution(Time resolution) {
+        NS_ASSERT(resolution > Seconds(0));
+        NS_ASSERT(m_size == 0);
+        m_resolution = resolution;
+    }
+
+    Time
+    RescueTimerWheel::GetResolution(void) const {
+        return m_resolution;
+    }
+
+    RescueTimerWheel::Handle
+    RescueTimerWheel::Arm(Time delay, Ptr<EventImpl> event) {
+        NS_ASSERT(delay >= Seconds(0));
+        if (m_size == 0)
+            m_tick = GetTick(Simulator::Now());
+
+        if (m_free == NO_ENTRY) {
+            Entry e;
+            e.generation = 0;
+            e.slot = NO_ENTRY;
+            e.next = NO_ENTRY;
+            m_entries.push_back(e);
+            m_free = m_entries.size() - 1;
+        }
+        int32_t idx = m_free;
+        Entry &e = m_entries[idx];
+        m_free = e.next;
+
+        e.event = event;
+        e.deadline = Simulator::Now() + delay;
+        e.order = m_order++;
+        e.generation++;
+        Link(idx);
+        m_size++;
+
+        if (!m_expiring && (!m_event.IsRunning() || (e.deadline < m_eventTime))) {
+            //new nearest deadline
+            if (m_event.IsRunning())
+                m_event.Cancel();
+            m_eventTime = e.deadline;
+            m_event = Simulator::Schedule(delay, &RescueTimerWheel::Expire, this);
+        }
+        return (Handle(e.generation) << 32) | Handle(idx + 1);
+    }
+
+    void
+    RescueTimerWheel::Cancel(Handle handle) {
+        if (!IsRunning(handle))
+            return;
+        int32_t idx = (handle & 0xffffffff) - 1;
+        Unlink(idx);
+        m_entries[idx].event = 0;
+        m_entries[idx].slot = NO_ENTRY;
+        m_entries[idx].next = m_free;
+        m_free = idx;
+        m_size--;
+        m_cancelled++;
+        //simulator event is left scheduled, it only reschedules itself if no timeout is due
+    }
+
+    bool
+    RescueTimerWheel::IsRunning(Handle handle) const {
+        if (handle == 0)
+            return false;
+        uint32_t idx = (handle & 0xffffffff) - 1;
+        return (idx < m_entries.size())
+                && (m_entries[idx].slot != NO_ENTRY)
+                && (m_entries[idx].generation == uint32_t(handle >> 32));
+    }
+
+    void
+    RescueTimerWheel::CancelAll(void) {
+        if (m_event.IsRunning())
+            m_event.Cancel();
+        m_free = NO_ENTRY;
+        for (int32_t i = m_entries.size() - 1; i >= 0; i--) {
+            m_entries[i].event = 0;
+            m_entries[i].slot = NO_ENTRY;
+            m_entries[i].next = m_free;
+            m_free = i;
+        }
+        for (uint32_t i = 0; i <= WHEEL_SLOTS; i++)
+            m_slots[i] = NO_ENTRY;
+        for (uint32_t i = 0; i < WHEEL_SLOTS / 32; i++)
+            m_busy[i] = 0;
+        m_size = 0;
+    }
+
+    uint32_t
+    RescueTimerWheel::GetSize(void) const {
+        return m_size;
+    }
+
+    uint64_t
+    RescueTimerWheel::GetArmedCount(void) const {
+        return m_order;
+    }
+
+    uint64_t
+    RescueTimerWheel::GetCancelledCount(void) const {
+        return m_cancelled;
+    }
+
+    uint32_t
+    RescueTimerWheel::GetMemoryUsage(void) const {
+        return sizeof (*this) + m_entries.capacity() * sizeof (Entry);
+    }
+
+    uint64_t
+    RescueTimerWheel::GetTick(Time t) const {
+        return t.GetTimeStep() / m_resolution.GetTimeStep();
+    }
+
+    void
+    RescueTimerWheel::Link(int32_t idx) {
+        Entry &e = m_entries[idx];
+        uint64_t tick = GetTick(e.deadline);
+        NS_ASSERT(tick >= m_tick);
+        int32_t slot = (tick - m_tick < WHEEL_SLOTS) ? int32_t(tick & (WHEEL_SLOTS - 1)) : int32_t(OVERFLOW_SLOT);
+        e.slot = slot;
+        e.prev = NO_ENTRY;
+        e.next = m_slots[slot];
+        if (e.next != NO_ENTRY)
+            m_entries[e.next].prev = idx;
+        m_slots[slot] = idx;
+        if (slot != OVERFLOW_SLOT)
+            m_busy[slot >> 5] |= (1u << (slot & 31));
+    }
+
+    void
+    RescueTimerWheel::Unlink(int32_t idx) {
+        Entry &e = m_entries[idx];
+        if (e.prev != NO_ENTRY)
+            m_entries[e.prev].next = e.next;
+        else
+            m_slots[e.slot] = e.next;
+        if (e.next != NO_ENTRY)
+            m_entries[e.next].prev = e.prev;
+        if ((e.slot != OVERFLOW_SLOT) && (m_slots[e.slot] == NO_ENTRY))
+            m_busy[e.slot >> 5] &= ~(1u << (e.slot & 31));
+    }
+
+    void
+    RescueTimerWheel::Migrate(void) {
+        int32_t idx = m_slots[OVERFLOW_SLOT];
+        while (idx != NO_ENTRY) {
+            int32_t next = m_entries[idx].next;
+            if (GetTick(m_entries[idx].deadline) - m_tick < WHEEL_SLOTS) {
+                Unlink(idx);
+                Link(idx);
+            }
+            idx = next;
+        }
+    }
+
+    bool
+    RescueTimerWheel::ExpiryOrder::operator()(int32_t a, int32_t b) const {
+        const Entry &ea = (*entries)[a];
+        const Entry &eb = (*entries)[b];
+        if (ea.deadline != eb.deadline)
+            return ea.deadline < eb.deadline;
+        return ea.order < eb.order;
+    }
+
+    void
+    RescueTimerWheel::Expire(void) {
+        Time now = Simulator::Now();
+        m_tick = GetTick(now);
+        Migrate();
+
+        //collect all due timeouts (all of them are in the slot of current tick)
+        std::vector<int32_t> due;
+        int32_t slot = m_tick & (WHEEL_SLOTS - 1);
+        for (int32_t idx = m_slots[slot]; idx != NO_ENTRY; idx = m_entries[idx].next)
+            if (m_entries[idx].deadline <= now)
+                due.push_back(idx);
+        ExpiryOrder order;
+        order.entries = &m_entries;
+        std::sort(due.begin(), due.end(), order);
+
+        std::vector<Ptr<EventImpl> > events;
+        for (std::vector<int32_t>::iterator it = due.begin(); it != due.end(); it++) {
+            events.push_back(m_entries[*it].event);
+            Unlink(*it);
+            m_entries[*it].event = 0;
+            m_entries[*it].slot = NO_ENTRY;
+            m_entries[*it].next = m_free;
+            m_free = *it;
+            m_size--;
+        }
+        NS_LOG_DEBUG("expired timeouts: " << events.size() << ", armed timeouts: " << m_size);
+
+        //invoked events may arm or cancel other timeouts
+        m_expiring = true;
+        for (std::vector<Ptr<EventImpl> >::iterator it = events.begin(); it != events.end(); it++)
+            (*it)->Invoke();
+        m_expiring = false;
+
+        ScheduleNext();
+    }
+
+    void
+    RescueTimerWheel::ScheduleNext(void) {
+        if (m_event.IsRunning())
+            m_event.Cancel();
+        if (m_size == 0)
+            return;
+
+        Migrate();
+        bool found = false;
+        Time next;
+        //the first non-empty slot holds the nearest deadline
+        for (uint32_t i = 0; (i < WHEEL_SLOTS) && !found; i++) {
+            uint32_t slot = (m_tick + i) & (WHEEL_SLOTS - 1);
+            if (m_busy[slot >> 5] == 0) {
+                i += 31 - (slot & 31); //skip empty word of bitmap
+                continue;
+            }
+            if (!(m_busy[slot >> 5] & (1u << (slot & 31))))
+                continue;
+            for (int32_t idx = m_slots[slot]; idx != NO_ENTRY; idx = m_entries[idx].next)
+                if (!found || (m_entries[idx].deadline < next)) {
+                    next = m_entries[idx].deadline;
+                    found = true;
+                }
+        }
+        if (!found)
+            for (int32_t idx = m_slots[OVERFLOW_SLOT]; idx != NO_ENTRY; idx = m_entries[idx].next)
+                if (!found || (m_entries[idx].deadline < next)) {
+                    next = m_entries[idx].deadline;
+                    found = true;
+                }
+        NS_ASSERT(found);
+        m_eventTime = next;
+        m_event = Simulator::Schedule(next - Simulator::Now(), &RescueTimerWheel::Expire, this);
+    }
+
+} // namespace ns3
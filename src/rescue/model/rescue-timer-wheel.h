@@ -0,0 +1,165 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 AGH Univeristy of Science and Technology
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+ *
+ * Author: Lukasz Prasnal <prasnal@kt.agh.edu.pl>
+ */
+
+#ifndef RESCUE_TIMER_WHEEL_H
+#define RESCUE_TIMER_WHEEL_H
+
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/event-impl.h"
+#include "ns3/ptr.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+    /**
+     * \ingroup rescue
+     *
+     * Timing wheel for large number of timeouts (e.g. ARQ timers of many frames and peers).
+     * Armed timeouts are kept in a pool and linked into wheel slots according to their
+     * deadline (timeouts beyond the wheel range are kept in overflow list), only a single
+     * simulator event is scheduled for the nearest deadline. Timeouts are armed and cancelled
+     * in O(1) by handle and fire at their exact deadlines (timeouts with the same deadline
+     * in order of arming).
+     */
+    class RescueTimerWheel {
+    public:
+        typedef uint64_t Handle; //!< Timeout handle (0 - no timeout)
+
+        RescueTimerWheel();
+        ~RescueTimerWheel();
+
+        /**
+         * \param resolution the duration of a single slot of the wheel (no timeouts may be armed)
+         */
+        void SetResolution(Time resolution);
+        /**
+         * \return the duration of a single slot of the wheel
+         */
+        Time GetResolution(void) const;
+
+        /**
+         * \param delay the delay after which the event expires
+         * \param event the event to invoke (e.g. created by MakeEvent)
+         * \return the handle of armed timeout
+         */
+        Handle Arm(Time delay, Ptr<EventImpl> event);
+        /**
+         * \param handle the handle of timeout to cancel (ignored if already expired or cancelled)
+         */
+        void Cancel(Handle handle);
+        /**
+         * \param handle the timeout handle
+         * \return true if the timeout is armed and has not expired yet
+         */
+        bool IsRunning(Handle handle) const;
+        /**
+         * Cancels all armed timeouts
+         */
+        void CancelAll(void);
+        /**
+         * \return the number of armed timeouts
+         */
+        uint32_t GetSize(void) const;
+        /**
+         * \return the number of timeouts armed since creation
+         */
+        uint64_t GetArmedCount(void) const;
+        /**
+         * \return the number of timeouts cancelled before expiry since creation
+         */
+        uint64_t GetCancelledCount(void) const;
+        /**
+         * \return the number of bytes used by the wheel and its pool of timeout entries
+         */
+        uint32_t GetMemoryUsage(void) const;
+
+    private:
+
+        enum {
+            WHEEL_BITS = 8,
+            WHEEL_SLOTS = 1 << WHEEL_BITS, //!< Number of wheel slots
+            OVERFLOW_SLOT = WHEEL_SLOTS, //!< Slot of timeouts beyond the wheel range
+            NO_ENTRY = -1 //!< Index of non-existing entry / slot of free entry
+        };
+
+        struct Entry {
+            Ptr<EventImpl> event; //!< The event to invoke
+            Time deadline; //!< Expiration time
+            uint64_t order; //!< Arming order (for timeouts with the same deadline)
+            uint32_t generation; //!< Generation of this entry (to detect stale handles)
+            int32_t slot; //!< Slot of this entry (NO_ENTRY - free entry)
+            int32_t prev; //!< Previous entry in slot
+            int32_t next; //!< Next entry in slot (or in free list)
+        };
+
+        /**
+         * Orders expired entries by deadline and arming order
+         */
+        struct ExpiryOrder {
+            const std::vector<Entry> *entries;
+            bool operator()(int32_t a, int32_t b) const;
+        };
+
+        /**
+         * \param t the time
+         * \return the tick (slot number) of the wheel
+         */
+        uint64_t GetTick(Time t) const;
+        /**
+         * Links the entry into the slot matching its deadline
+         */
+        void Link(int32_t idx);
+        /**
+         * Removes the entry from its slot
+         */
+        void Unlink(int32_t idx);
+        /**
+         * Moves timeouts from overflow list to wheel slots when they get into the wheel range
+         */
+        void Migrate(void);
+        /**
+         * Invoked by simulator event at the nearest deadline
+         */
+        void Expire(void);
+        /**
+         * Schedules simulator event for the nearest deadline
+         */
+        void ScheduleNext(void);
+
+        std::vector<Entry> m_entries; //!< Pool of timeout entries
+        int32_t m_free; //!< Head of the list of free entries
+        int32_t m_slots[WHEEL_SLOTS + 1]; //!< Heads of slot lists (and overflow list)
+        uint32_t m_busy[WHEEL_SLOTS / 32]; //!< Bitmap of non-empty wheel slots
+        uint64_t m_tick; //!< Current tick of the wheel
+        Time m_resolution; //!< Duration of a single slot
+        uint64_t m_order; //!< Arming counter
+        uint32_t m_size; //!< Number of armed timeouts
+        uint64_t m_cancelled; //!< Number of cancelled timeouts
+        bool m_expiring; //!< True while expired events are invoked
+        EventId m_event; //!< Simulator event for the nearest deadline
+        Time m_eventTime; //!< Time of scheduled simulator event
+    };
+
+} // namespace ns3
+
+#endif /* RESCUE_TIMER_WHEEL_H */
@@ -59,18 +59,20 @@ namespace ns3 {
     SnrPerTag::SnrPerTag()
     : m_snr(0),
     //m_per (0),
-    m_ber(0) {
+    m_ber(0),
+    m_snrValid(false) {
     }
 
     SnrPerTag::SnrPerTag(double snr, /*double per,*/ double ber)
     : m_snr(snr),
     //m_per (per),
-    m_ber(ber) {
+    m_ber(ber),
+    m_snrValid(true) {
     }
 
     uint32_t
     SnrPerTag::GetSerializedSize(void) const {
-        return 2 * sizeof (double);
+        return 2 * sizeof (double) + 1;
     }
 
     void
@@ -78,6 +80,7 @@ namespace ns3 {
         i.WriteDouble(m_snr);
         //i.WriteDouble (m_per);
         i.WriteDouble(m_ber);
+        i.WriteU8(m_snrValid ? 1 : 0);
     }
 
     void
@@ -85,16 +88,23 @@ namespace ns3 {
         m_snr = i.ReadDouble();
         //m_per = i.ReadDouble ();
         m_ber = i.ReadDouble();
+        m_snrValid = (i.ReadU8() != 0);
     }
 
     void
     SnrPerTag::Print(std::ostream &os) const {
-        os << "snr=" << m_snr << /*" per=" << m_per <<*/ " ber=" << m_ber;
+        os << "snr=";
+        if (m_snrValid)
+            os << m_snr;
+        else
+            os << "n/a";
+        os << /*" per=" << m_per <<*/ " ber=" << m_ber;
     }
 
     void
     SnrPerTag::SetSNR(double snr) {
         m_snr = snr;
+        m_snrValid = true;
     }
 
     /*void
@@ -113,6 +123,11 @@ namespace ns3 {
         return m_snr;
     }
 
+    bool
+    SnrPerTag::IsSNRValid(void) const {
+        return m_snrValid;
+    }
+
     /*double
     SnrPerTag::GetPER (void) const
     {
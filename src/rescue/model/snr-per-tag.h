@@ -41,7 +41,8 @@ namespace ns3 {
         virtual TypeId GetInstanceTypeId(void) const;
 
         /**
-         * Create a SnrPerTag with the default SNR = 0 and PER = 0
+         * Create a SnrPerTag with the default SNR = 0 and PER = 0,
+         * the SNR is marked as not recorded
          */
         SnrPerTag();
 
@@ -54,7 +55,7 @@ namespace ns3 {
         SnrPerTag(double snr, /*double per,*/ double ber);
 
         /**
-         * Set the SNR to the given value.
+         * Set the SNR to the given value and mark it as recorded.
          *
          * \param per the value of the SNR to set
          */
@@ -77,6 +78,13 @@ namespace ns3 {
          * \return the SNR value
          */
         double GetSNR(void) const;
+        /**
+         * Return whether the SNR was recorded (SNR in dB may be <= 0,
+         * so its value cannot tell this).
+         *
+         * \return true if the SNR was set, false otherwise
+         */
+        bool IsSNRValid(void) const;
         /**
          * Return the PER value.
          *
@@ -100,6 +108,7 @@ namespace ns3 {
         double m_snr; //!< SNR value
         //double m_per;  //!< PER value
         double m_ber; //!< BER value
+        bool m_snrValid; //!< true if m_snr was recorded
     };
 
 
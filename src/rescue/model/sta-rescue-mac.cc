@@ -45,7 +45,17 @@ namespace ns3 {
     NS_OBJECT_ENSURE_REGISTERED(StaRescueMac);
 
     StaRescueMac::StaRescueMac()
-    : RescueMac() {
+    : RescueMac(),
+    m_reportNeighbours(false),
+    m_reservationInterval(Seconds(0)),
+    m_reservationThreshold(0),
+    m_pendingFrames(0),
+    m_stationId(NO_STATION_ID),
+    m_lastScheduleSequence(0),
+    m_lastRunsValid(false),
+    m_timingAdvance(false),
+    m_propagationDelay(Seconds(0)),
+    m_propagationDelayValid(false) {
         NS_LOG_INFO("");
         SetTypeOfStation(STA);
         m_tdmaMac = CreateObject<RescueMacTdma> ();
@@ -91,6 +101,10 @@ namespace ns3 {
         for (std::map<uint8_t, Timer>::iterator it = m_slotAwaitingTimers.begin(); it != m_slotAwaitingTimers.end(); it++)
             if (it->second.IsRunning())
                 it->second.Cancel();
+        if (m_reservationTimer.IsRunning())
+            m_reservationTimer.Cancel();
+        m_pendingReservations.clear();
+        m_pendingFrames = 0;
     }
 
     TypeId
@@ -98,6 +112,26 @@ namespace ns3 {
         static TypeId tid = TypeId("ns3::StaRescueMac")
                 .SetParent<RescueMac> ()
                 .AddConstructor<StaRescueMac> ()
+                .AddAttribute("ReportNeighbours",
+                "If true, resource reservations carry the list of neighbour stations (used by AP for spatial reuse of TDMA time slots)",
+                BooleanValue(false),
+                MakeBooleanAccessor(&StaRescueMac::m_reportNeighbours),
+                MakeBooleanChecker())
+                .AddAttribute("ReservationInterval",
+                "Time of collecting reservations before cumulative RESOURCE RESERVATION frame is sent (0 - sent at the end of CFP)",
+                TimeValue(Seconds(0)),
+                MakeTimeAccessor(&StaRescueMac::m_reservationInterval),
+                MakeTimeChecker())
+                .AddAttribute("ReservationThreshold",
+                "The number of reserved frames which triggers cumulative RESOURCE RESERVATION frame (0 - no threshold, 1 - frame per reservation)",
+                UintegerValue(0),
+                MakeUintegerAccessor(&StaRescueMac::m_reservationThreshold),
+                MakeUintegerChecker<uint32_t> ())
+                .AddAttribute("TimingAdvance",
+                "If true, propagation delay from AP is estimated from beacon timestamps and TDMA time slots are started earlier by the round trip delay",
+                BooleanValue(false),
+                MakeBooleanAccessor(&StaRescueMac::m_timingAdvance),
+                MakeBooleanChecker())
                 ;
         return tid;
     }
@@ -138,6 +172,12 @@ namespace ns3 {
         m_tdmaMac->EnqueueRetry(pkt, dst);
     }
 
+    void
+    StaRescueMac::EnqueueRelay(Ptr<Packet> pkt, RescuePhyHeader phyHdr) {
+        NS_LOG_FUNCTION("");
+        m_tdmaMac->EnqueueRelay(pkt, phyHdr);
+    }
+
     void
     StaRescueMac::EnqueueAck(Ptr<Packet> pkt, RescuePhyHeader ackHdr) {
         NS_LOG_FUNCTION("");
@@ -157,38 +197,87 @@ namespace ns3 {
     void
     StaRescueMac::GenerateResourceReservationFor(Ptr<Packet> pktData) {
         NS_LOG_FUNCTION("");
-        Ptr<Packet> pkt = Create<Packet> (0);
-        RescueMacHeader hdr = RescueMacHeader(m_address, m_apAddress, RESCUE_MAC_PKT_TYPE_RR);
-        pkt->AddHeader(hdr);
-        //m_traceEnqueue (m_device->GetNode ()->GetId (), m_device->GetIfIndex (), pkt, hdr);
-        RescuePhyHeader phyHdr = RescuePhyHeader(m_address, m_apAddress, RESCUE_PHY_PKT_TYPE_RR);
-
+        //reservations are collected per destination and sent in one cumulative RESOURCE RESERVATION frame
         RescueMacHeader dataHdr;
         pktData->PeekHeader(dataHdr);
         RescueMode nextMode = m_remoteStationManager->GetDataTxMode(dataHdr.GetDestination(), pktData, pktData->GetSize());
-        phyHdr.SetNextDataRate(0);
-        phyHdr.SetNextDuration(uint16_t((m_tdmaMac->GetDataDuration(pktData, nextMode)).GetMicroSeconds()));
-
-        m_csmaMac->EnqueueCtrl(pkt, phyHdr);
+        Time duration = m_tdmaMac->GetDataDuration(pktData, nextMode) + m_tdmaMac->GetSifsTime();
+
+        std::map<Mac48Address, PendingReservation>::iterator it = m_pendingReservations.find(dataHdr.GetDestination());
+        if (it == m_pendingReservations.end()) {
+            if (m_pendingReservations.size() >= MAX_RESERVATIONS_LIST_SIZE)
+                GenerateTdmaTimeSlotReservation();
+            PendingReservation reservation;
+            reservation.duration = Seconds(0);
+            reservation.frames = 0;
+            it = m_pendingReservations.insert(std::make_pair(dataHdr.GetDestination(), reservation)).first;
+        }
+        it->second.duration += duration;
+        it->second.frames++;
+        m_pendingFrames++;
+
+        NS_LOG_DEBUG("reservation for: " << dataHdr.GetDestination() << ", tx time: " << duration << ", pending frames: " << m_pendingFrames);
+
+        if ((m_reservationThreshold > 0 && m_pendingFrames >= m_reservationThreshold)
+                || it->second.frames == 0xff)
+            GenerateTdmaTimeSlotReservation();
+        else if (m_reservationInterval > Seconds(0) && !m_reservationTimer.IsRunning()) {
+            m_reservationTimer.SetDelay(m_reservationInterval);
+            m_reservationTimer.SetFunction(&StaRescueMac::GenerateTdmaTimeSlotReservation, this);
+            m_reservationTimer.Schedule();
+        }
     }
 
     void
     StaRescueMac::GenerateTdmaTimeSlotReservation() {
         NS_LOG_FUNCTION("");
+        if (m_reservationTimer.IsRunning())
+            m_reservationTimer.Cancel();
+        if (m_pendingReservations.empty())
+            return;
+
         Ptr<Packet> pkt = Create<Packet> (0);
         RescueMacHeader hdr = RescueMacHeader(m_address, m_apAddress, RESCUE_MAC_PKT_TYPE_RR);
         pkt->AddHeader(hdr);
         //m_traceEnqueue (m_device->GetNode ()->GetId (), m_device->GetIfIndex (), pkt, hdr);
         RescuePhyHeader phyHdr = RescuePhyHeader(m_address, m_apAddress, RESCUE_PHY_PKT_TYPE_RR);
 
-        //RescueMode nextMode = m_remoteStationManager->GetDataTxMode (hdr.GetDestination (), pktData, pktData->GetSize ());
+        //cumulative reservation - TX time requested per destination
+        Time total = Seconds(0);
+        uint8_t size = 0;
+        for (std::map<Mac48Address, PendingReservation>::iterator it = m_pendingReservations.begin();
+                it != m_pendingReservations.end() && size < MAX_RESERVATIONS_LIST_SIZE; it++) {
+            phyHdr.SetReservationEntry(size++, it->first,
+                    uint16_t(std::min(it->second.duration.GetMicroSeconds(), int64_t(0xffff))),
+                    uint8_t(it->second.frames));
+            total += it->second.duration;
+        }
+        phyHdr.SetReservationsListSize(size);
         phyHdr.SetNextDataRate(0);
+        phyHdr.SetNextDuration(uint16_t(std::min(total.GetMicroSeconds(), int64_t(0xffff))));
+        AddNeighboursList(phyHdr);
+
+        NS_LOG_INFO("GENERATE RESOURCE RESERVATION FRAME, destinations: " << (int) size << ", frames: " << m_pendingFrames << ", reserved TX time: " << total);
 
-        NS_LOG_INFO("GENERATE RESOURCE RESERVATION FRAME");
+        m_pendingReservations.clear();
+        m_pendingFrames = 0;
 
         m_csmaMac->EnqueueCtrl(pkt, phyHdr);
     }
 
+    void
+    StaRescueMac::AddNeighboursList(RescuePhyHeader &phyHdr) {
+        if (!m_reportNeighbours)
+            return;
+        std::vector<Mac48Address> neighbours = GetNeighbours();
+        uint8_t size = 0;
+        for (std::vector<Mac48Address>::iterator it = neighbours.begin(); it != neighbours.end() && size < MAX_NEIGHBOURS_LIST_SIZE; it++)
+            if (*it != m_apAddress)
+                phyHdr.SetNeighbourEntry(size++, *it);
+        phyHdr.SetNeighboursListSize(size);
+        NS_LOG_DEBUG("neighbours reported: " << (int) size);
+    }
+
     void
     StaRescueMac::StartTDMAtimeSlot() {
         NS_LOG_FUNCTION("");
@@ -200,14 +289,14 @@ namespace ns3 {
 
         m_phy->NotifyCFP();
         m_tdmaMac->StartOperation();
-        if (m_tdmaMac->GetNextTxSifsDuration() < m_tdmaTimeSlot)
+        if (FitsInTdmaSlot(m_tdmaTimeSlot))
             m_tdmaMac->ChannelAccessGranted();
     }
 
     void
     StaRescueMac::NotifySendPacketDone() {
         NS_LOG_FUNCTION("");
-        if (m_tdmaMac->GetNextTxSifsDuration() < m_currentSlotTimer.GetDelayLeft())
+        if (FitsInTdmaSlot(m_currentSlotTimer.GetDelayLeft()))
             m_tdmaMac->ChannelAccessGranted();
     }
 
@@ -240,16 +329,18 @@ namespace ns3 {
         m_channel = phyHdr.GetChannel();
         m_txPower = phyHdr.GetTxPower();
         m_schedulesNumber = phyHdr.GetSchedulesListSize();
-        //phyHdr.GetTimestamp ();
         m_beaconInterval = MicroSeconds(phyHdr.GetBeaconInterval());
         m_cfpDuration = MicroSeconds(phyHdr.GetCfpPeriod());
         m_tdmaTimeSlot = MicroSeconds(phyHdr.GetTdmaTimeSlot());
+        if (m_timingAdvance)
+            EstimatePropagationDelay(phyHdr);
 
         NS_LOG_INFO("BEACON RECEIVED from: " << m_apAddress);
         NS_LOG_FUNCTION("beaconInterval: " << phyHdr.GetBeaconInterval() <<
                 "cfpDuration: " << phyHdr.GetCfpPeriod() <<
                 "tdmaTimeSlot: " << phyHdr.GetTdmaTimeSlot() <<
-                "schedules: " << (int) m_schedulesNumber);
+                "schedules: " << (int) m_schedulesNumber <<
+                "concurrent slots: " << (phyHdr.HasConcurrentSchedules() ? "YES" : "NO"));
 
         //start timers
         if (m_beaconTimer.IsRunning()) {
@@ -266,20 +357,98 @@ namespace ns3 {
         m_cfpTimer.SetFunction(&StaRescueMac::CfpEnd, this);
         m_cfpTimer.Schedule();
 
+        if (phyHdr.HasCompressedSchedule()) {
+            DecodeCompressedSchedule(phyHdr);
+            return;
+        }
+        m_lastRunsValid = false;
+
         for (uint8_t i = 0; i < m_schedulesNumber; i++)
-            if (phyHdr.GetScheduleEntry(i) == m_address) {
-                NS_LOG_INFO("TDMA TIME SLOT (no. " << (int) i << ") OBTAINED!");
-                //TDMA time slot was assigned, start awaiting counter
-                std::pair<uint8_t, Timer> newTimer(i, Timer(Timer::CANCEL_ON_DESTROY));
-                std::pair < std::map<uint8_t, Timer>::iterator, bool> newIns = m_slotAwaitingTimers.insert(newTimer);
-
-                if (newIns.first->second.IsRunning())
-                    newIns.first->second.Cancel();
-
-                newIns.first->second.SetDelay(m_tdmaMac->GetSifsTime() + i * m_tdmaTimeSlot);
-                newIns.first->second.SetFunction(&StaRescueMac::StartTDMAtimeSlot, this);
-                newIns.first->second.Schedule();
+            if (phyHdr.GetScheduleEntry(i) == m_address)
+                AwaitTdmaTimeSlot(phyHdr.GetScheduleSlot(i));
+    }
+
+    void
+    StaRescueMac::DecodeCompressedSchedule(const RescuePhyHeader &phyHdr) {
+        NS_LOG_FUNCTION("");
+        for (uint8_t i = 0; i < phyHdr.GetStationIdsListSize(); i++)
+            if (phyHdr.GetStationIdEntryAddress(i) == m_address && m_stationId != phyHdr.GetStationIdEntryId(i)) {
+                m_stationId = phyHdr.GetStationIdEntryId(i);
+                NS_LOG_INFO("SHORT ID ASSIGNED: " << (int) m_stationId);
             }
+
+        //runs repeated from the previous schedule can be used only if it was received
+        uint8_t kept = phyHdr.GetKeptScheduleRuns();
+        if (kept > 0 && (!m_lastRunsValid
+                || uint8_t(m_lastScheduleSequence + 1) != phyHdr.GetScheduleSequence()
+                || kept > m_lastRuns.size())) {
+            NS_LOG_INFO("PREVIOUS SCHEDULE UNKNOWN, SKIPPING CFP");
+            m_lastRunsValid = false;
+            return;
+        }
+        m_lastRuns.resize(kept);
+        for (uint8_t i = 0; i < phyHdr.GetScheduleRunsListSize(); i++) {
+            RescueScheduleRun run = phyHdr.GetScheduleRun(i);
+            if (!phyHdr.HasScheduleRunsStart())
+                run.start = m_lastRuns.empty() ? 0 : m_lastRuns.back().start + m_lastRuns.back().length;
+            m_lastRuns.push_back(run);
+        }
+        m_lastScheduleSequence = phyHdr.GetScheduleSequence();
+        m_lastRunsValid = true;
+
+        if (m_stationId == NO_STATION_ID)
+            return;
+        for (std::vector<RescueScheduleRun>::iterator it = m_lastRuns.begin(); it != m_lastRuns.end(); it++)
+            if (it->id == m_stationId)
+                for (uint32_t slot = it->start; slot < uint32_t(it->start + it->length); slot++)
+                    AwaitTdmaTimeSlot(slot);
+    }
+
+    void
+    StaRescueMac::EstimatePropagationDelay(const RescuePhyHeader &phyHdr) {
+        NS_LOG_FUNCTION("");
+        //the timestamp has microsecond resolution (and wraps around), the elapsed time is counted modulo 2^32 us
+        //and the mean truncation error of the timestamp (half of microsecond) is compensated
+        Time now = Simulator::Now();
+        Time elapsed = MicroSeconds(uint32_t(uint32_t(now.GetMicroSeconds()) - phyHdr.GetTimestamp()))
+                + (now - MicroSeconds(now.GetMicroSeconds()));
+        Time beaconTxDuration = m_tdmaMac->GetCtrlDuration(phyHdr, m_remoteStationManager->GetCtrlTxMode());
+        Time delay = elapsed - beaconTxDuration - NanoSeconds(500);
+        if (delay < Seconds(0))
+            delay = Seconds(0);
+        if (delay > m_tdmaMac->GetSifsTime() + m_tdmaTimeSlot) {
+            NS_LOG_DEBUG("implausible propagation delay: " << delay << ", ignored");
+            return;
+        }
+
+        //smoothed (weight of new sample: 1/8) to average out the timestamp truncation
+        if (m_propagationDelayValid)
+            m_propagationDelay = NanoSeconds((7 * m_propagationDelay.GetNanoSeconds() + delay.GetNanoSeconds()) / 8);
+        else
+            m_propagationDelay = delay;
+        m_propagationDelayValid = true;
+        NS_LOG_DEBUG("propagation delay sample: " << delay << ", estimate: " << m_propagationDelay);
+    }
+
+    void
+    StaRescueMac::AwaitTdmaTimeSlot(uint8_t slot) {
+        NS_LOG_INFO("TDMA TIME SLOT (no. " << (int) slot << ") OBTAINED!");
+        //TDMA time slot was assigned, start awaiting counter
+        std::pair<uint8_t, Timer> newTimer(slot, Timer(Timer::CANCEL_ON_DESTROY));
+        std::pair < std::map<uint8_t, Timer>::iterator, bool> newIns = m_slotAwaitingTimers.insert(newTimer);
+
+        if (newIns.first->second.IsRunning())
+            newIns.first->second.Cancel();
+
+        Time delay = m_tdmaMac->GetSifsTime() + slot * m_tdmaTimeSlot;
+        if (m_timingAdvance && m_propagationDelayValid) {
+            //beacon was received one propagation delay late and own frames reach AP one propagation delay late
+            Time advance = 2 * m_propagationDelay;
+            delay = (delay > advance) ? delay - advance : Seconds(0);
+        }
+        newIns.first->second.SetDelay(delay);
+        newIns.first->second.SetFunction(&StaRescueMac::StartTDMAtimeSlot, this);
+        newIns.first->second.Schedule();
     }
 
 
@@ -299,13 +468,15 @@ namespace ns3 {
     StaRescueMac::CfpEnd() {
         NS_LOG_FUNCTION("");
         NS_LOG_INFO("CFP ENDED");
+        //queue report - the whole backlog is reported again and replaces reservations still pending
+        m_pendingReservations.clear();
+        m_pendingFrames = 0;
         m_tdmaMac->ReportQueuedFrames();
+        if (m_reservationInterval == Seconds(0))
+            GenerateTdmaTimeSlotReservation();
         m_phy->NotifyCP();
         m_tdmaMac->StopOperation();
         m_csmaMac->StartOperation(m_beaconTimer.GetDelayLeft());
-
-        //if (m_tdmaMac->GetNextTxSifsDuration () > 0)
-        //  GenerateTdmaTimeSlotReservation ();
     }
 
     void
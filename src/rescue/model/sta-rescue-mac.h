@@ -33,6 +33,7 @@
 #include "rescue-mac-header.h"
 
 #include <list>
+#include <vector>
 
 namespace ns3 {
 
@@ -78,6 +79,14 @@ namespace ns3 {
          */
         virtual void EnqueueRetry(Ptr<Packet> pkt, Mac48Address dest);
 
+        /**
+         * \param pkt the packet to send.
+         * \param phyHdr the header to send.
+         *
+         * Should be used to enqueue locally retransmitted relayed packets by ARQ manager
+         */
+        virtual void EnqueueRelay(Ptr<Packet> pkt, RescuePhyHeader phyHdr);
+
         //virtual void NotifyEnqueueRelay (Ptr<Packet> pkt, Mac48Address dest);
 
         virtual void NotifyEnqueuedPacket(Ptr<Packet> pkt, Mac48Address dest);
@@ -120,8 +129,51 @@ namespace ns3 {
         virtual void NotifySendPacketDone(void);
 
     private:
+        /**
+         * Pending reservation for a single destination
+         */
+        struct PendingReservation {
+            Time duration; //!< Reserved TX time (including SIFS)
+            uint32_t frames; //!< Number of reserved frames
+        };
+
+        /**
+         * Adds the frame to pending reservations (cumulative RESOURCE RESERVATION frame is sent
+         * when the threshold is reached)
+         *
+         * \param pktData the queued frame
+         */
         void GenerateResourceReservationFor(Ptr<Packet> pktData);
+        /**
+         * Sends cumulative RESOURCE RESERVATION frame with all pending reservations
+         */
         void GenerateTdmaTimeSlotReservation();
+        /**
+         * Adds the list of neighbour stations to RESOURCE RESERVATION frame (if reporting is enabled)
+         *
+         * \param phyHdr PHY header of RESOURCE RESERVATION frame
+         */
+        void AddNeighboursList(RescuePhyHeader &phyHdr);
+        /**
+         * Decodes compressed schedule of the beacon and starts awaiting assigned slots
+         *
+         * \param phyHdr PHY header of the beacon
+         */
+        void DecodeCompressedSchedule(const RescuePhyHeader &phyHdr);
+        /**
+         * Estimates propagation delay from AP basing on the beacon timestamp (taken at the start
+         * of beacon TX) and the time of beacon reception
+         *
+         * \param phyHdr PHY header of the beacon
+         */
+        void EstimatePropagationDelay(const RescuePhyHeader &phyHdr);
+        /**
+         * Starts awaiting TDMA time slot. With timing advance the slot is started earlier by
+         * the round trip propagation delay, so that transmissions reach AP aligned to its slot boundaries.
+         *
+         * \param slot the number of TDMA time slot assigned to this station in current CFP
+         */
+        void AwaitTdmaTimeSlot(uint8_t slot);
 
         void StartTDMAtimeSlot(void);
 
@@ -136,8 +188,22 @@ namespace ns3 {
         Time m_beaconInterval; //<! beacon interval duration
         Time m_cfpDuration; //<! Contention Free Period duration
         Time m_tdmaTimeSlot; //<! TDMA time slot duration
+        bool m_reportNeighbours; //<! true if neighbour stations are reported to AP (spatial reuse of TDMA slots)
+        Time m_reservationInterval; //<! time of collecting reservations (0 - until the end of CFP)
+        uint32_t m_reservationThreshold; //<! number of frames triggering cumulative reservation (0 - no threshold)
+        std::map<Mac48Address, PendingReservation> m_pendingReservations; //<! reservations not sent yet (per destination)
+        uint32_t m_pendingFrames; //<! number of frames of pending reservations
+        Timer m_reservationTimer; //<! expires at the end of reservations collecting interval
 
         uint8_t m_schedulesNumber; //<! Number of schedules in current CFP
+        uint8_t m_stationId; //<! short ID assigned by AP (compressed schedule)
+        std::vector<RescueScheduleRun> m_lastRuns; //<! runs of the last decoded compressed schedule
+        uint8_t m_lastScheduleSequence; //<! sequence number of the last decoded compressed schedule
+        bool m_lastRunsValid; //<! true if the last compressed schedule was decoded
+
+        bool m_timingAdvance; //<! true if TDMA time slots are advanced by the round trip propagation delay
+        Time m_propagationDelay; //<! smoothed estimate of propagation delay from AP
+        bool m_propagationDelayValid; //<! true if propagation delay was estimated
 
         Timer m_beaconTimer;
         Timer m_cfpTimer;